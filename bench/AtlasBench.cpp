@@ -0,0 +1,141 @@
+#include "Bench.h"
+#include "graphics/TextureAtlas.h"
+#include <imgui.h>
+#include <cstdint>
+
+namespace {
+
+constexpr int COLUMNS = 8;
+constexpr int ROWS = 5;
+constexpr int THUMBNAIL_SIZE = 96;
+constexpr int BADGE_SIZE = 24;
+
+// Texture ids the draw commands carry; nothing is uploaded
+constexpr intptr_t FONT_TEXTURE = 1;
+constexpr intptr_t ATLAS_TEXTURE = 100;       // + page
+constexpr intptr_t IMAGE_TEXTURE = 1000;      // + image, one texture each
+
+struct Placed {
+    ImTextureID texture;
+    ImVec2 uv0;
+    ImVec2 uv1;
+};
+
+struct FrameStats {
+    int drawCalls = 0;
+    int vertices = 0;
+};
+
+// As Application counts them: commands that draw, callbacks aside
+FrameStats CountDrawCalls(const ImDrawData* drawData) {
+    FrameStats stats;
+    for (int i = 0; i < drawData->CmdListsCount; ++i) {
+        const ImDrawList* list = drawData->CmdLists[i];
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            if (!cmd.UserCallback && cmd.ElemCount > 0) {
+                ++stats.drawCalls;
+            }
+        }
+        stats.vertices += list->VtxBuffer.Size;
+    }
+    return stats;
+}
+
+// A product grid: a thumbnail per card with a badge on it, and optionally
+// a name under it, as real ImGui widgets so ImGui's own command merging
+// decides the count
+FrameStats DrawGrid(const std::vector<Placed>& thumbnails, const std::vector<Placed>& badges, bool labels) {
+    FrameStats stats;
+    // The first frame of a new window may lay out without drawing
+    for (int frame = 0; frame < 2; ++frame) {
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+        ImGui::Begin("Products", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoSavedSettings);
+        for (size_t i = 0; i < thumbnails.size(); ++i) {
+            if (i % COLUMNS != 0) {
+                ImGui::SameLine();
+            }
+            ImGui::BeginGroup();
+            ImVec2 corner = ImGui::GetCursorScreenPos();
+            ImGui::Image(thumbnails[i].texture, ImVec2(THUMBNAIL_SIZE, THUMBNAIL_SIZE), thumbnails[i].uv0,
+                         thumbnails[i].uv1);
+            ImGui::GetWindowDrawList()->AddImage(badges[i].texture, corner,
+                                                 ImVec2(corner.x + BADGE_SIZE, corner.y + BADGE_SIZE),
+                                                 badges[i].uv0, badges[i].uv1);
+            if (labels) {
+                ImGui::Text("Product %zu", i);
+            }
+            ImGui::EndGroup();
+        }
+        ImGui::End();
+        ImGui::Render();
+        stats = CountDrawCalls(ImGui::GetDrawData());
+    }
+    return stats;
+}
+
+} // namespace
+
+// Draw calls of a 40-card product grid with each image its own texture vs
+// packed into TextureAtlas pages, counted from ImGui's draw data; no GPU
+int BenchAtlasDrawCalls() {
+    const int cards = COLUMNS * ROWS;
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(1280, 720);
+    io.DeltaTime = 1.0f / 60.0f;
+    unsigned char* fontPixels = nullptr;
+    int fontWidth = 0;
+    int fontHeight = 0;
+    io.Fonts->AddFontDefault();
+    io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+    io.Fonts->SetTexID((ImTextureID)FONT_TEXTURE);
+
+    // The same images both ways; the atlas only changes texture and UVs
+    TextureAtlas atlas;
+    std::vector<uint8_t> pixels(size_t(THUMBNAIL_SIZE) * THUMBNAIL_SIZE * 4, 0x80);
+    std::vector<Placed> separateThumbnails, separateBadges, atlasThumbnails, atlasBadges;
+    const float scale = 1.0f / atlas.GetPageSize();
+    auto place = [&](const std::string& name, int size, intptr_t separateId, std::vector<Placed>& separate,
+                     std::vector<Placed>& atlased) {
+        separate.push_back({(ImTextureID)separateId, ImVec2(0, 0), ImVec2(1, 1)});
+        const AtlasEntry* entry = atlas.Insert(name, pixels.data(), size, size, uint32_t(size) * 4);
+        if (!entry) {
+            return false;
+        }
+        atlased.push_back({(ImTextureID)(ATLAS_TEXTURE + entry->page),
+                           ImVec2(entry->x * scale, entry->y * scale),
+                           ImVec2((entry->x + entry->width) * scale, (entry->y + entry->height) * scale)});
+        return true;
+    };
+    bool placed = true;
+    for (int i = 0; i < cards; ++i) {
+        placed = placed && place("thumbnail" + std::to_string(i), THUMBNAIL_SIZE, IMAGE_TEXTURE + i * 2,
+                                 separateThumbnails, atlasThumbnails);
+        placed = placed && place("badge" + std::to_string(i), BADGE_SIZE, IMAGE_TEXTURE + i * 2 + 1,
+                                 separateBadges, atlasBadges);
+    }
+    if (!placed) {
+        std::printf("  the atlas rejected an image\n");
+        ImGui::DestroyContext();
+        return 1;
+    }
+
+    std::printf("  %d cards, %dx%d thumbnail + %dx%d badge each, %d atlas page(s)\n", cards, THUMBNAIL_SIZE,
+                THUMBNAIL_SIZE, BADGE_SIZE, BADGE_SIZE, atlas.GetPageCount());
+    std::printf("  %-18s %-18s %10s %10s\n", "layout", "textures", "draw calls", "vertices");
+    for (bool labels : {false, true}) {
+        FrameStats separate = DrawGrid(separateThumbnails, separateBadges, labels);
+        FrameStats atlased = DrawGrid(atlasThumbnails, atlasBadges, labels);
+        const char* layout = labels ? "images + labels" : "images";
+        std::printf("  %-18s %-18s %10d %10d\n", layout, "one per image", separate.drawCalls, separate.vertices);
+        std::printf("  %-18s %-18s %10d %10d\n", layout, "atlas pages", atlased.drawCalls, atlased.vertices);
+    }
+
+    ImGui::DestroyContext();
+    return 0;
+}
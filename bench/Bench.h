@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Helpers shared by the benchmarks in this directory. Every benchmark
+// prints its own table to stdout and returns 0, or non-zero if it could
+// not run (missing assets and the like).
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline int64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+inline double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Value below which fraction p of the samples lie; sorts samples
+inline int64_t Percentile(std::vector<int64_t>& samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+// Median of several runs of fn, in milliseconds
+template <typename Fn>
+double MedianMilliseconds(int runs, Fn&& fn) {
+    std::vector<int64_t> samples;
+    for (int i = 0; i < runs; ++i) {
+        int64_t start = NowNanos();
+        fn();
+        samples.push_back(NowNanos() - start);
+    }
+    return Percentile(samples, 0.5) / 1e6;
+}
+
+// Scratch directory for files a benchmark writes, emptied first
+inline std::filesystem::path ScratchDir(const char* name) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "BigAppBench" / name;
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
+} // namespace bench
+
+// Benchmarks, run by name from BenchMain.cpp
+int BenchLogger();
+int BenchLogFormat();
+int BenchLoggerDisabled();
+int BenchConfig();
+int BenchLocalization();
+int BenchGlyphRanges();
+int BenchFontCache();
+int BenchFontBuild();
+int BenchMips();
+int BenchAtlasDrawCalls();
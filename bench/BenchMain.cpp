@@ -0,0 +1,47 @@
+#include "Bench.h"
+#include <cstring>
+
+namespace {
+
+struct BenchEntry {
+    const char* name;
+    const char* description;
+    int (*run)();
+};
+
+const BenchEntry BENCHMARKS[] = {
+    {"logger", "LOG_INFO producer latency, writer thread vs synchronous writes", BenchLogger},
+    {"logger-disabled", "Disabled LOG_* calls in a loop, compiled out vs off at runtime", BenchLoggerDisabled},
+    {"logformat", "LOG_INFO cost per call and bytes per record, text vs binary log", BenchLogFormat},
+    {"config", "Config::Load, JSON parse vs binary snapshot", BenchConfig},
+    {"i18n", "T() lookups of a LoginScreen frame, flat catalog vs string map", BenchLocalization},
+    {"glyphs", "UI font atlas, generated glyph ranges vs ChineseFull", BenchGlyphRanges},
+    {"fontcache", "Font atlas startup, build + store vs cache load", BenchFontCache},
+    {"fontbuild", "Font atlas build time and speedup by thread count", BenchFontBuild},
+    {"mips", "Mip chain generation, scalar vs SSE2 vs AVX2 kernels", BenchMips},
+    {"atlas", "Draw calls of a product image grid, one texture per image vs atlas pages", BenchAtlasDrawCalls},
+};
+
+} // namespace
+
+// Usage: BigAppBench [name...]   (no names runs everything)
+int main(int argc, char** argv) {
+    int failures = 0;
+    for (const BenchEntry& entry : BENCHMARKS) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || std::strcmp(argv[i], entry.name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+        std::printf("== %s: %s\n", entry.name, entry.description);
+        if (entry.run() != 0) {
+            std::printf("-- %s failed\n", entry.name);
+            ++failures;
+        }
+        std::printf("\n");
+    }
+    return failures;
+}
@@ -0,0 +1,39 @@
+#include "Bench.h"
+#include "core/Config.h"
+#include <fstream>
+
+namespace {
+
+constexpr int RUNS = 200;
+
+} // namespace
+
+int BenchConfig() {
+    std::filesystem::path dir = bench::ScratchDir("config");
+    std::string path = (dir / "config.json").string();
+    std::string cachePath = path + ".cache";
+
+    // Every setting present, as the app itself writes the file
+    Config& config = Config::Instance();
+    if (!config.Save(path)) {
+        return 1;
+    }
+    uintmax_t jsonBytes = std::filesystem::file_size(path);
+
+    // Cold: no cache, so the JSON is parsed and the cache written
+    double cold = bench::MedianMilliseconds(RUNS, [&] {
+        std::filesystem::remove(cachePath);
+        config.Load(path);
+    });
+
+    // Warm: the cache from the previous load is mapped instead
+    config.Load(path);
+    double warm = bench::MedianMilliseconds(RUNS, [&] {
+        config.Load(path);
+    });
+
+    std::printf("config.json %llu bytes, median of %d loads\n", static_cast<unsigned long long>(jsonBytes), RUNS);
+    std::printf("%-34s %8.3f ms\n", "JSON parse + cache write (cold)", cold);
+    std::printf("%-34s %8.3f ms\n", "binary snapshot (warm)", warm);
+    return 0;
+}
@@ -0,0 +1,218 @@
+#include "Bench.h"
+#include "ui/FontAtlasBuilder.h"
+#include "ui/FontAtlasCache.h"
+#include <imgui.h>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// Generated at build time by tools/GlyphRangeScanner, as in FontManager
+#if __has_include("UiGlyphRanges.inc")
+const ImWchar UI_GLYPH_RANGES[] = {
+#include "UiGlyphRanges.inc"
+    0
+};
+#define HAVE_UI_GLYPH_RANGES 1
+#endif
+
+// FontManager's font paths, under the source tree's assets
+const char* FONT_FILES[] = {
+    "fonts/NotoSansSC-Regular.otf",
+    "fonts/NotoSansSC-Regular.ttf",
+    "fonts/NotoSansCJKsc-Regular.otf"
+};
+
+constexpr float FONT_SIZE = 18.0f;
+constexpr int RUNS = 3;
+
+std::string FindFont() {
+    for (const char* file : FONT_FILES) {
+        std::string path = std::string(BENCH_ASSETS_DIR) + "/" + file;
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec)) {
+            return path;
+        }
+    }
+    return std::string();
+}
+
+struct AtlasStats {
+    int glyphs = 0;
+    int width = 0;
+    int height = 0;
+    double buildMs = 0.0;
+};
+
+// Bake the UI font with ImGui's own builder, so only the ranges differ
+bool BuildAtlas(const std::string& fontPath, const ImWchar* ranges, AtlasStats& stats) {
+    bool built = true;
+    stats.buildMs = bench::MedianMilliseconds(RUNS, [&] {
+        ImFontAtlas atlas;
+        built = built && atlas.AddFontFromFileTTF(fontPath.c_str(), FONT_SIZE, nullptr, ranges) && atlas.Build();
+        stats.glyphs = atlas.Fonts.empty() ? 0 : atlas.Fonts[0]->Glyphs.Size;
+        stats.width = atlas.TexWidth;
+        stats.height = atlas.TexHeight;
+    });
+    return built;
+}
+
+// The atlas FontManager builds: the UI font over the generated ranges,
+// rasterized by fontbuild's threaded builder
+bool BuildUiAtlas(const std::string& fontPath, const ImWchar* ranges, ImFontAtlas& atlas) {
+    if (!atlas.AddFontFromFileTTF(fontPath.c_str(), FONT_SIZE, nullptr, ranges)) {
+        return false;
+    }
+    atlas.FontBuilderIO = fontbuild::GetBuilderIO();
+    return atlas.Build();
+}
+
+void PrintStats(const char* label, const AtlasStats& stats) {
+    std::printf("  %-22s %6d glyphs  %5dx%-5d %7.1f MB  %8.1f ms\n", label, stats.glyphs, stats.width,
+                stats.height, stats.width * static_cast<double>(stats.height) / (1024 * 1024), stats.buildMs);
+}
+
+} // namespace
+
+// UI font atlas with the generated glyph ranges vs GetGlyphRangesChineseFull():
+// glyph count, texture size (alpha8, as FontManager uploads it) and median build time
+int BenchGlyphRanges() {
+#ifndef HAVE_UI_GLYPH_RANGES
+    std::printf("  UiGlyphRanges.inc not generated; build the UiGlyphRanges target\n");
+    return 1;
+#else
+    std::string fontPath = FindFont();
+    if (fontPath.empty()) {
+        std::printf("  no UI font under %s/fonts\n", BENCH_ASSETS_DIR);
+        return 1;
+    }
+
+    ImFontAtlas ranges;
+    AtlasStats generated;
+    AtlasStats full;
+    if (!BuildAtlas(fontPath, UI_GLYPH_RANGES, generated) ||
+        !BuildAtlas(fontPath, ranges.GetGlyphRangesChineseFull(), full)) {
+        std::printf("  could not build an atlas from %s\n", fontPath.c_str());
+        return 1;
+    }
+
+    std::printf("  %s, %.0f px, median of %d builds\n", fontPath.c_str(), FONT_SIZE, RUNS);
+    PrintStats("generated ranges", generated);
+    PrintStats("ChineseFull", full);
+    return 0;
+#endif
+}
+
+// Font atlas at startup: built from the font file and written to the
+// cache (a first launch) vs restored from that cache (every later one)
+int BenchFontCache() {
+#ifndef HAVE_UI_GLYPH_RANGES
+    std::printf("  UiGlyphRanges.inc not generated; build the UiGlyphRanges target\n");
+    return 1;
+#else
+    std::string fontPath = FindFont();
+    if (fontPath.empty()) {
+        std::printf("  no UI font under %s/fonts\n", BENCH_ASSETS_DIR);
+        return 1;
+    }
+
+    std::string cachePath = (bench::ScratchDir("fontcache") / "fonts.atlas").string();
+    uint64_t key = fontcache::HashFontFile(fontPath, fontcache::BaseKey());
+
+    bool ok = true;
+    double coldMs = bench::MedianMilliseconds(RUNS, [&] {
+        ImFontAtlas atlas;
+        ok = ok && BuildUiAtlas(fontPath, UI_GLYPH_RANGES, atlas) && fontcache::Store(cachePath, key, &atlas);
+    });
+    int glyphs = 0;
+    double warmMs = bench::MedianMilliseconds(RUNS, [&] {
+        ImFontAtlas atlas;
+        ok = ok && fontcache::Load(cachePath, key, &atlas);
+        glyphs = atlas.Fonts.empty() ? 0 : atlas.Fonts[0]->Glyphs.Size;
+    });
+    if (!ok) {
+        std::printf("  could not build or cache an atlas from %s\n", fontPath.c_str());
+        return 1;
+    }
+
+    std::error_code ec;
+    std::printf("  %s, %d glyphs, cache %.1f KB, median of %d\n", fontPath.c_str(), glyphs,
+                std::filesystem::file_size(cachePath, ec) / 1024.0, RUNS);
+    std::printf("  cold (build + store)  %8.1f ms\n", coldMs);
+    std::printf("  warm (load)           %8.1f ms\n", warmMs);
+    return 0;
+#endif
+}
+
+// fontbuild's threaded rasterization: build time and speedup over one
+// thread per thread count, on FontManager's ranges and on ChineseFull's
+// 20k+ glyphs. Every atlas must match the single-threaded one.
+int BenchFontBuild() {
+#ifndef HAVE_UI_GLYPH_RANGES
+    std::printf("  UiGlyphRanges.inc not generated; build the UiGlyphRanges target\n");
+    return 1;
+#else
+    std::string fontPath = FindFont();
+    if (fontPath.empty()) {
+        std::printf("  no UI font under %s/fonts\n", BENCH_ASSETS_DIR);
+        return 1;
+    }
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores > 0 ? cores : 1);
+
+    ImFontAtlas rangeSource;
+    struct RangeSet {
+        const char* name;
+        const ImWchar* ranges;
+    };
+    const RangeSet rangeSets[] = {
+        {"generated ranges", UI_GLYPH_RANGES},
+        {"ChineseFull", rangeSource.GetGlyphRangesChineseFull()},
+    };
+
+    std::printf("  %s, %.0f px, %d cores, median of %d\n", fontPath.c_str(), FONT_SIZE, cores, RUNS);
+    int result = 0;
+    for (const RangeSet& set : rangeSets) {
+        std::vector<unsigned char> serialPixels;
+        double serialMs = 0.0;
+        for (int threads : threadCounts) {
+            fontbuild::SetThreadCount(threads);
+            bool built = true;
+            bool identical = true;
+            double ms = bench::MedianMilliseconds(RUNS, [&] {
+                ImFontAtlas atlas;
+                built = built && BuildUiAtlas(fontPath, set.ranges, atlas);
+                size_t size = size_t(atlas.TexWidth) * atlas.TexHeight;
+                if (!built || !atlas.TexPixelsAlpha8) {
+                    built = false;
+                } else if (serialPixels.empty()) {
+                    serialPixels.assign(atlas.TexPixelsAlpha8, atlas.TexPixelsAlpha8 + size);
+                } else {
+                    identical = identical && serialPixels.size() == size &&
+                                std::memcmp(serialPixels.data(), atlas.TexPixelsAlpha8, size) == 0;
+                }
+            });
+            if (!built) {
+                std::printf("  could not build an atlas from %s\n", fontPath.c_str());
+                fontbuild::SetThreadCount(0);
+                return 1;
+            }
+            if (threads == 1) {
+                serialMs = ms;
+            }
+            std::printf("  %-18s %3d threads  %8.1f ms  %5.2fx%s\n", set.name, threads, ms, serialMs / ms,
+                        identical ? "" : "  DIFFERS from 1 thread");
+            if (!identical) {
+                result = 1;
+            }
+        }
+    }
+    fontbuild::SetThreadCount(0);
+    return result;
+#endif
+}
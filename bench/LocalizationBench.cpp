@@ -0,0 +1,94 @@
+#include "Bench.h"
+#include "i18n/Localization.h"
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+
+namespace {
+
+constexpr int FRAMES = 200000;
+
+// What LoginScreen looks up per frame on its card key tab
+const i18n::Key FRAME_KEYS[] = {
+    I18N_KEY("app_name"),
+    I18N_KEY("login.tab_cardkey"),
+    I18N_KEY("login.tab_account"),
+    I18N_KEY("login.tab_register"),
+    I18N_KEY("login.tab_password"),
+    I18N_KEY("login.input_cardkey"),
+    I18N_KEY("login.input_cardkey"),
+    I18N_KEY("login.btn_login"),
+};
+
+// The lookup T() replaced: string keys in a node map, and a std::string
+// built from the literal on every call
+class StringMapCatalog {
+public:
+    bool Load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        nlohmann::json j;
+        file >> j;
+        Flatten("", j);
+        return true;
+    }
+
+    const char* Get(const std::string& key) const {
+        auto it = m_strings.find(key);
+        return it != m_strings.end() ? it->second.c_str() : "";
+    }
+
+private:
+    void Flatten(const std::string& prefix, const nlohmann::json& object) {
+        for (auto& [key, value] : object.items()) {
+            std::string fullKey = prefix.empty() ? key : prefix + "." + key;
+            if (value.is_string()) {
+                m_strings[fullKey] = value.get<std::string>();
+            } else if (value.is_object()) {
+                Flatten(fullKey, value);
+            }
+        }
+    }
+
+    std::unordered_map<std::string, std::string> m_strings;
+};
+
+} // namespace
+
+int BenchLocalization() {
+    std::string langDir = std::string(BENCH_ASSETS_DIR) + "/lang";
+    i18n::Localization& localization = i18n::Localization::Instance();
+    localization.SetBasePath(langDir);
+    StringMapCatalog strings;
+    if (!localization.LoadLanguage("en-US") || !strings.Load(langDir + "/en-US.json")) {
+        return 1;
+    }
+
+    constexpr size_t keysPerFrame = sizeof(FRAME_KEYS) / sizeof(FRAME_KEYS[0]);
+    uintptr_t sink = 0;
+
+    int64_t start = bench::NowNanos();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        localization.BeginFrame();
+        for (const i18n::Key& key : FRAME_KEYS) {
+            sink += reinterpret_cast<uintptr_t>(i18n::T(key));
+        }
+    }
+    double flat = double(bench::NowNanos() - start) / FRAMES;
+
+    start = bench::NowNanos();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        for (const i18n::Key& key : FRAME_KEYS) {
+            sink += reinterpret_cast<uintptr_t>(strings.Get(key.text));
+        }
+    }
+    double map = double(bench::NowNanos() - start) / FRAMES;
+
+    std::printf("LoginScreen card key tab, %zu lookups per frame, %d frames\n", keysPerFrame, FRAMES);
+    std::printf("%-36s %8.1f ns/frame\n", "T(I18N_KEY) flat catalog", flat);
+    std::printf("%-36s %8.1f ns/frame\n", "string key, unordered_map (before)", map);
+    std::printf("(checksum %zx)\n", static_cast<size_t>(sink & 0xFFFF));
+    return 0;
+}
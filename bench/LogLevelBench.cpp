@@ -0,0 +1,55 @@
+// Built as a non-Debug launcher build is: LOG_DEBUG compiled out
+#undef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 1
+
+#include "Bench.h"
+#include "core/Logger.h"
+
+namespace {
+
+constexpr int CALLS = 100000000;
+
+int g_evaluated = 0;
+
+// The argument's side effect shows whether a skipped call evaluated it
+int Evaluate(int value) {
+    ++g_evaluated;
+    return value;
+}
+
+} // namespace
+
+// A disabled LOG_* call in a tight loop: removed by LOGGER_MIN_LEVEL, and
+// compiled in but below Logger's runtime level
+int BenchLoggerDisabled() {
+    Logger& logger = Logger::Instance();
+    LogLevel previous = LogLevel::Error;
+    for (LogLevel level : {LogLevel::Warning, LogLevel::Info, LogLevel::Debug}) {
+        previous = logger.IsEnabled(level) ? level : previous;
+    }
+    logger.SetMinLevel(LogLevel::Warning);
+
+    g_evaluated = 0;
+    auto start = bench::Clock::now();
+    for (int i = 0; i < CALLS; ++i) {
+        LOG_DEBUG("debug %d", Evaluate(i));
+    }
+    double strippedMs = bench::MillisecondsSince(start);
+    int strippedEvaluated = g_evaluated;
+
+    g_evaluated = 0;
+    start = bench::Clock::now();
+    for (int i = 0; i < CALLS; ++i) {
+        LOG_INFO("info %d", Evaluate(i));
+    }
+    double runtimeMs = bench::MillisecondsSince(start);
+    int runtimeEvaluated = g_evaluated;
+
+    logger.SetMinLevel(previous);
+
+    std::printf("%d calls, LOGGER_MIN_LEVEL %d, runtime level Warning\n", CALLS, LOGGER_MIN_LEVEL);
+    std::printf("%-32s %10s %16s\n", "", "ns/call", "args evaluated");
+    std::printf("%-32s %10.3f %16d\n", "LOG_DEBUG (compiled out)", strippedMs * 1e6 / CALLS, strippedEvaluated);
+    std::printf("%-32s %10.3f %16d\n", "LOG_INFO (off at runtime)", runtimeMs * 1e6 / CALLS, runtimeEvaluated);
+    return strippedEvaluated == 0 && runtimeEvaluated == 0 ? 0 : 1;
+}
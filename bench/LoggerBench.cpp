@@ -0,0 +1,176 @@
+#include "Bench.h"
+#include "core/Logger.h"
+#include <cstdarg>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr int THREADS = 4;
+constexpr int RECORDS_PER_THREAD = 20000;
+
+// The path Logger replaced: format, timestamp, write and flush on the
+// calling thread. The original had no lock; one is added here so the
+// threads don't interleave inside a line.
+class SyncLogger {
+public:
+    explicit SyncLogger(const std::string& path)
+        : m_file(path, std::ios::out | std::ios::trunc) {
+    }
+
+    void Info(const char* format, ...) {
+        char buffer[1024];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        time_t now = time(nullptr);
+        struct tm timeinfo;
+        localtime_s(&timeinfo, &now);
+        char timeStr[32];
+        strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+        char entry[1200];
+        snprintf(entry, sizeof(entry), "[%s] [INFO] %s\n", timeStr, buffer);
+        m_file << entry;
+        m_file.flush();
+    }
+
+private:
+    std::ofstream m_file;
+    std::mutex m_mutex;
+};
+
+// Per-call latency of log(thread, i) from THREADS threads at once
+template <typename LogFn>
+std::vector<int64_t> MeasureProducers(LogFn log) {
+    std::vector<std::vector<int64_t>> perThread(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<int64_t>& samples = perThread[t];
+            samples.reserve(RECORDS_PER_THREAD);
+            for (int i = 0; i < RECORDS_PER_THREAD; ++i) {
+                int64_t start = bench::NowNanos();
+                log(t, i);
+                samples.push_back(bench::NowNanos() - start);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int64_t> samples;
+    for (const std::vector<int64_t>& part : perThread) {
+        samples.insert(samples.end(), part.begin(), part.end());
+    }
+    return samples;
+}
+
+void PrintRow(const char* label, std::vector<int64_t>& samples) {
+    int64_t p50 = bench::Percentile(samples, 0.50);
+    int64_t p99 = bench::Percentile(samples, 0.99);
+    int64_t p999 = bench::Percentile(samples, 0.999);
+    std::printf("%-22s %10.2f %10.2f %10.2f %10.2f\n", label, p50 / 1e3, p99 / 1e3, p999 / 1e3,
+                samples.back() / 1e3);
+}
+
+} // namespace
+
+int BenchLogger() {
+    std::filesystem::path dir = bench::ScratchDir("logger");
+
+    Logger& logger = Logger::Instance();
+    logger.SetLogFile((dir / "async.log").string());
+    // Every record counts: no per-site throttling, no drops
+    LogRateLimit unlimited;
+    unlimited.perSecond = 0;
+    unlimited.coalesceRepeats = false;
+    logger.SetRateLimit(unlimited);
+    logger.SetOverflowPolicy(LogOverflow::Block);
+
+    std::vector<int64_t> async = MeasureProducers([](int thread, int i) {
+        LOG_INFO("bench thread %d record %d value %.3f", thread, i, i * 0.5);
+    });
+    logger.Flush();
+
+    SyncLogger sync((dir / "sync.log").string());
+    std::vector<int64_t> direct = MeasureProducers([&](int thread, int i) {
+        sync.Info("bench thread %d record %d value %.3f", thread, i, i * 0.5);
+    });
+
+    std::printf("%d threads x %d records, microseconds per call\n", THREADS, RECORDS_PER_THREAD);
+    std::printf("%-22s %10s %10s %10s %10s\n", "", "p50", "p99", "p99.9", "max");
+    PrintRow("LOG_INFO (queued)", async);
+    PrintRow("synchronous write", direct);
+    std::printf("dropped %llu\n", static_cast<unsigned long long>(logger.GetDroppedCount()));
+    return 0;
+}
+
+// LOG_INFO into a text log vs a .blog: mean producer cost per call, the
+// end-to-end cost per record until it is on disk, and bytes per record.
+// Logger::Info, which still runs vsnprintf on the calling thread, is the
+// producer-side baseline the deferred formatting replaced.
+int BenchLogFormat() {
+    constexpr int BURSTS = 50;
+    constexpr int BURST = 8000;   // Fits the queue, so no call waits for the writer
+    std::filesystem::path dir = bench::ScratchDir("logformat");
+
+    Logger& logger = Logger::Instance();
+    LogRateLimit unlimited;
+    unlimited.perSecond = 0;
+    unlimited.coalesceRepeats = false;
+    logger.SetRateLimit(unlimited);
+    logger.SetOverflowPolicy(LogOverflow::Block);
+
+    struct Mode {
+        const char* label;
+        const char* file;
+        LogFileFormat format;
+        bool varargs;
+    };
+    const Mode modes[] = {
+        {"LOG_INFO, text", "bench.log", LogFileFormat::Text, false},
+        {"LOG_INFO, binary", "bench.blog", LogFileFormat::Binary, false},
+        {"Logger::Info, text", "varargs.log", LogFileFormat::Text, true},
+    };
+
+    std::printf("%d records, bursts of %d\n", BURSTS * BURST, BURST);
+    std::printf("%-22s %12s %14s %12s\n", "", "ns/call", "ns/record e2e", "bytes/record");
+    for (const Mode& mode : modes) {
+        std::filesystem::path path = dir / mode.file;
+        logger.SetLogFile(path.string(), mode.format);
+
+        double callMs = 0.0;
+        double totalMs = 0.0;
+        for (int burst = 0; burst < BURSTS; ++burst) {
+            auto start = bench::Clock::now();
+            for (int i = 0; i < BURST; ++i) {
+                int frame = burst * BURST + i;
+                if (mode.varargs) {
+                    logger.Info("Frame %d: %d draw calls, %.3f ms on %s", frame, 120 + frame % 7,
+                                16.6 + frame % 5 * 0.1, "Products");
+                } else {
+                    LOG_INFO("Frame %d: %d draw calls, %.3f ms on %s", frame, 120 + frame % 7,
+                             16.6 + frame % 5 * 0.1, "Products");
+                }
+            }
+            callMs += bench::MillisecondsSince(start);
+            logger.Flush();
+            totalMs += bench::MillisecondsSince(start);
+        }
+
+        std::error_code ec;
+        double records = double(BURSTS) * BURST;
+        std::printf("%-22s %12.1f %14.1f %12.1f\n", mode.label, callMs * 1e6 / records, totalMs * 1e6 / records,
+                    std::filesystem::file_size(path, ec) / records);
+    }
+    logger.SetLogFile((dir / "idle.log").string());
+    std::printf("dropped %llu\n", static_cast<unsigned long long>(logger.GetDroppedCount()));
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "Bench.h"
+#include "graphics/MipGenerator.h"
+#include <random>
+
+namespace {
+
+constexpr int RUNS = 5;
+
+DecodedImage MakeImage(int width, int height) {
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(size_t(width) * height * 4);
+    std::mt19937 random(1);
+    for (uint8_t& byte : image.pixels) {
+        byte = uint8_t(random());
+    }
+    image.levels.push_back({width, height, uint32_t(width) * 4, 0, image.pixels.size()});
+    return image;
+}
+
+} // namespace
+
+// Full mip chain of one image per kernel, color conversion included, and
+// the speedup over the scalar reference
+int BenchMips() {
+    const int sizes[][2] = {{2048, 2048}, {1920, 1080}, {1023, 767}};
+    const MipKernel kernels[] = {MipKernel::Scalar, MipKernel::Sse2, MipKernel::Avx2};
+    const char* names[] = {"scalar", "SSE2", "AVX2"};
+
+    std::printf("  best kernel here: %s, median of %d\n", names[int(GetBestMipKernel())], RUNS);
+    for (const auto& size : sizes) {
+        const DecodedImage source = MakeImage(size[0], size[1]);
+        double scalarMs = 0.0;
+        for (MipKernel kernel : kernels) {
+            std::vector<DecodedImage> copies(RUNS, source);
+            int run = 0;
+            double ms = bench::MedianMilliseconds(RUNS, [&] { GenerateMips(copies[run++], false, kernel); });
+            if (kernel == MipKernel::Scalar) {
+                scalarMs = ms;
+            }
+            std::printf("  %4dx%-4d %-6s %7.1f ms  %5.2fx\n", size[0], size[1], names[int(kernel)], ms, scalarMs / ms);
+        }
+    }
+    return 0;
+}
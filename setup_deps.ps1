@@ -12,10 +12,11 @@ if (!(Test-Path "external")) {
 
 Set-Location "external"
 
-# Clone ImGui
+# Clone ImGui. Pinned: the font atlas code uses 1.91's builder and glyph
+# tables, which 1.92 replaced (see src/ui/FontManager.cpp)
 if (!(Test-Path "imgui")) {
     Write-Host "Downloading ImGui..." -ForegroundColor Yellow
-    git clone --depth 1 https://github.com/ocornut/imgui.git
+    git clone --depth 1 --branch v1.91.9 https://github.com/ocornut/imgui.git
 } else {
     Write-Host "ImGui already exists, skipping..." -ForegroundColor Green
 }
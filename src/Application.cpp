@@ -3,7 +3,12 @@
 #include "ui/IconsFontAwesome6.h"
 #include "ui/DebugController.h"
 #include "ui/StyleUI.h"
+#include "ui/FontManager.h"
+#include "ui/SdfText.h"
+#include "graphics/TextureManager.h"
 #include "i18n/Localization.h"
+#include "core/Logger.h"
+#include "core/Config.h"
 
 #include <imgui.h>
 #include <imgui_impl_win32.h>
@@ -16,6 +21,23 @@
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
+namespace {
+
+// DrawIndexed calls the DX11 backend makes for draw data; callbacks draw nothing
+int CountDrawCalls(const ImDrawData* drawData) {
+    int count = 0;
+    for (int i = 0; i < drawData->CmdListsCount; ++i) {
+        for (const ImDrawCmd& cmd : drawData->CmdLists[i]->CmdBuffer) {
+            if (!cmd.UserCallback && cmd.ElemCount > 0) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace
+
 Application::Application() {
     m_dx11 = std::make_unique<DX11Context>();
     m_videoPlayer = std::make_unique<VideoPlayer>();
@@ -97,6 +119,7 @@ bool Application::Initialize(HINSTANCE hInstance, int width, int height, const w
     if (!m_dx11->Initialize(m_hwnd, width, height)) {
         return false;
     }
+    TextureManager::Instance().Initialize(m_dx11->GetDevice());
 
     // Initialize ImGui
     if (!InitializeImGui()) {
@@ -109,9 +132,22 @@ bool Application::Initialize(HINSTANCE hInstance, int width, int height, const w
     // Initialize blur effect
     InitializeBlurEffect();
 
-    // Load default language
+    // Settings; edits to config.json are picked up while running
+    Config::Instance().Load();
+
+    // Texture settings change on whatever thread publishes them (the
+    // watcher, for file edits); Render() applies them on this one
+    auto onTextureSettings = [this](const ConfigSnapshot&) { m_textureSettingsChanged = true; };
+    m_textureSubscriptions[0] = Config::Instance().Subscribe(settings::TextureAtlasEnabled, onTextureSettings);
+    m_textureSubscriptions[1] = Config::Instance().Subscribe(settings::TextureBudgetMB, onTextureSettings);
+    ApplyTextureSettings();
+    Config::Instance().StartWatching();
+    Config::Instance().StartAutoSave();
+
+    // Load default language now; find the others in the background
     i18n::Localization::Instance().SetBasePath("assets/lang");
-    i18n::SetLanguage("zh-CN");
+    i18n::Localization::Instance().LoadLanguage("zh-CN");
+    i18n::Localization::Instance().RequestLanguageScan();
 
     // Show window
     ShowWindow(m_hwnd, SW_SHOWDEFAULT);
@@ -135,40 +171,12 @@ bool Application::InitializeImGui() {
     ImGui_ImplWin32_Init(m_hwnd);
     ImGui_ImplDX11_Init(m_dx11->GetDevice(), m_dx11->GetContext());
 
-    // Load fonts - try multiple paths
-    const char* fontPaths[] = {
-        "assets/fonts/NotoSansSC-Regular.otf",
-        "assets/fonts/NotoSansSC-Regular.ttf",
-        "assets/fonts/NotoSansCJKsc-Regular.otf"
-    };
-
-    ImFont* font = nullptr;
-    for (const char* fontPath : fontPaths) {
-        font = io.Fonts->AddFontFromFileTTF(
-            fontPath,
-            18.0f,
-            nullptr,
-            io.Fonts->GetGlyphRangesChineseFull()
-        );
-        if (font) break;
-    }
-
-    if (!font) {
-        // Fallback to default font
-        font = io.Fonts->AddFontDefault();
-    }
-
-    // Load FontAwesome icons and merge with main font
-    static const ImWchar icons_ranges[] = { ICON_MIN_FA, ICON_MAX_FA, 0 };
-    ImFontConfig icons_config;
-    icons_config.MergeMode = true;
-    icons_config.PixelSnapH = true;
-    io.Fonts->AddFontFromFileTTF(
-        "assets/fonts/fa-solid-900.ttf",
-        14.0f,
-        &icons_config,
-        icons_ranges
-    );
+    // UI font with the glyphs the UI uses baked, plus icons; other
+    // characters are added on first use
+    FontManager::Instance().LoadFonts(io, m_dx11->GetContext());
+
+    // Large text (headings) drawn from distance fields at any size
+    SdfText::Instance().Initialize(m_dx11->GetDevice(), m_dx11->GetContext(), FontManager::Instance().GetFontPath());
 
     // Apply custom theme
     Theme::Apply();
@@ -460,6 +468,9 @@ int Application::Run() {
 }
 
 void Application::Update() {
+    // Localized text handed out last frame is no longer referenced
+    i18n::Localization::Instance().BeginFrame();
+
     // Calculate delta time
     LARGE_INTEGER currentTime;
     QueryPerformanceCounter(&currentTime);
@@ -511,6 +522,10 @@ void Application::Update() {
 }
 
 void Application::Render() {
+    // Glyph LRU frame and newly typed characters
+    FontManager::Instance().BeginFrame();
+    SdfText::Instance().BeginFrame();
+
     // Start ImGui frame
     ImGui_ImplDX11_NewFrame();
     ImGui_ImplWin32_NewFrame();
@@ -603,14 +618,47 @@ void Application::Render() {
         m_debugController->Render(m_loginScreen.get());
     }
 
+    // Upload glyphs rasterized while building the UI, and decoded images
+    FontManager::Instance().EndFrame();
+    SdfText::Instance().EndFrame();
+    if (m_textureSettingsChanged.exchange(false)) {
+        ApplyTextureSettings();
+    }
+    TextureManager::Instance().Update();
+
     // Render ImGui
     ImGui::Render();
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
+    // Draw calls per frame, to compare graphics.textureAtlas on and off
+    if (m_state == AppState::Products) {
+        int drawCalls = CountDrawCalls(ImGui::GetDrawData());
+        if (drawCalls != m_productsDrawCalls) {
+            m_productsDrawCalls = drawCalls;
+            const TextureAtlasStats* atlas = TextureManager::Instance().GetAtlasStats();
+            LOG_DEBUG("Products screen: %d draw calls (texture atlas %s, %llu images in it)", drawCalls,
+                      TextureManager::Instance().IsAtlasEnabled() ? "on" : "off",
+                      static_cast<unsigned long long>(atlas ? atlas->inserted - atlas->removed : 0));
+        }
+    }
+
     // Present
     m_dx11->EndFrame();
 }
 
+void Application::ApplyTextureSettings() {
+    TextureManager& textures = TextureManager::Instance();
+    bool atlas = Config::Instance().Get(settings::TextureAtlasEnabled);
+    int32_t budgetMB = Config::Instance().Get(settings::TextureBudgetMB);
+
+    textures.SetAtlasEnabled(atlas);
+    TextureBudget budget = textures.GetBudget();
+    budget.gpuBytes = uint64_t(budgetMB) * 1024 * 1024;
+    textures.SetBudget(budget);
+    LOG_INFO("Textures: atlas %s for new loads, GPU budget %d MB",
+             textures.IsAtlasEnabled() ? "on" : "off", budgetMB);
+}
+
 void Application::OnResize(int width, int height) {
     if (width > 0 && height > 0 && m_dx11 && m_dx11->GetDevice()) {
         m_width = width;
@@ -631,6 +679,8 @@ void Application::Shutdown() {
         m_videoPlayer->Shutdown();
     }
 
+    SdfText::Instance().Shutdown();
+    TextureManager::Instance().Shutdown();
     ShutdownImGui();
     m_dx11->Cleanup();
 
@@ -638,6 +688,17 @@ void Application::Shutdown() {
         DestroyWindow(m_hwnd);
         m_hwnd = nullptr;
     }
+
+    Config::Instance().StopAutoSave();
+    Config::Instance().StopWatching();
+    for (uint32_t& subscription : m_textureSubscriptions) {
+        Config::Instance().Unsubscribe(subscription);
+        subscription = 0;
+    }
+    i18n::Localization::Instance().Shutdown();
+
+    // Drain queued log records before static destruction
+    Logger::Instance().Shutdown();
 }
 
 LRESULT CALLBACK Application::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
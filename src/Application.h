@@ -10,6 +10,8 @@
 #include "ui/DebugController.h"
 #include "ui/HUDOverlay.h"
 #include <Windows.h>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -39,6 +41,9 @@ private:
 
     void OnResize(int width, int height);
 
+    // graphics.textureAtlas and graphics.textureBudgetMB to TextureManager
+    void ApplyTextureSettings();
+
     // Window
     HWND m_hwnd = nullptr;
     HINSTANCE m_hInstance = nullptr;
@@ -78,6 +83,12 @@ private:
 
     // Debug info
     std::wstring m_videoStatus;
+    int m_productsDrawCalls = -1;   // Last count logged for the Products screen
+
+    // Config subscriptions for the texture settings, and whether they
+    // changed since the last frame
+    uint32_t m_textureSubscriptions[2] = {};
+    std::atomic<bool> m_textureSettingsChanged{false};
 
     // Window controls config
     bool m_showMaximizeButton = true;
@@ -1,66 +1,918 @@
 #include "Config.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t WATCH_POLL_MS = 1000;     // Polling fallback interval
+constexpr uint32_t RELOAD_SETTLE_MS = 100;   // Editors save in several steps
+constexpr int SAVE_ATTEMPTS = 3;             // Saves that find the file edited under them before giving up
+constexpr int RELOAD_ATTEMPTS = 3;           // Reload reads a setter may race before one holds the lock
+
+// Snapshot last seen by this thread (Config is a singleton)
+struct SnapshotCache {
+    uint64_t generation = 0;
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+};
+thread_local SnapshotCache t_snapshotCache;
+
+// "a.b.c" -> the node at j["a"]["b"]["c"], nullptr if any part is missing
+const nlohmann::json* FindPath(const nlohmann::json& root, std::string_view path) {
+    const nlohmann::json* node = &root;
+    while (!path.empty()) {
+        size_t dot = path.find('.');
+        std::string part(path.substr(0, dot));
+        if (!node->is_object() || !node->contains(part)) {
+            return nullptr;
+        }
+        node = &(*node)[part];
+        path = (dot == std::string_view::npos) ? std::string_view() : path.substr(dot + 1);
+    }
+    return node;
+}
+
+// Settings ordered by JSON path. Keys that share a prefix end up next to
+// each other, so each object is opened and closed exactly once.
+const std::array<size_t, SETTING_COUNT>& SettingsByPath() {
+    static const std::array<size_t, SETTING_COUNT> order = [] {
+        std::array<size_t, SETTING_COUNT> result;
+        for (size_t i = 0; i < SETTING_COUNT; ++i) {
+            result[i] = i;
+        }
+        std::sort(result.begin(), result.end(), [](size_t a, size_t b) {
+            return strcmp(SETTING_INFO[a].key, SETTING_INFO[b].key) < 0;
+        });
+        return result;
+    }();
+    return order;
+}
+
+void AppendJsonString(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+// Writes the settings table straight to JSON text (2-space indent, keys
+// sorted), with no intermediate DOM
+void SerializeSnapshot(const ConfigSnapshot& snapshot, std::string& out) {
+    out = "{";
+    std::vector<std::string_view> open;   // Path of the object being written
+    bool needComma = false;
+
+    auto newLine = [&](size_t depth) {
+        out += '\n';
+        out.append(2 * depth, ' ');
+    };
+
+    for (size_t index : SettingsByPath()) {
+        const SettingInfo& info = SETTING_INFO[index];
+        SettingId id = static_cast<SettingId>(index);
+
+        std::vector<std::string_view> parts;
+        std::string_view path = info.key;
+        for (size_t dot; (dot = path.find('.')) != std::string_view::npos; path.remove_prefix(dot + 1)) {
+            parts.push_back(path.substr(0, dot));
+        }
+        std::string_view leaf = path;
+
+        size_t common = 0;
+        while (common < open.size() && common < parts.size() && open[common] == parts[common]) {
+            ++common;
+        }
+        while (open.size() > common) {
+            open.pop_back();
+            newLine(open.size() + 1);
+            out += '}';
+            needComma = true;
+        }
+        for (size_t p = common; p < parts.size(); ++p) {
+            if (needComma) out += ',';
+            newLine(open.size() + 1);
+            AppendJsonString(out, parts[p]);
+            out += ": {";
+            open.push_back(parts[p]);
+            needComma = false;
+        }
+
+        if (needComma) out += ',';
+        newLine(open.size() + 1);
+        AppendJsonString(out, leaf);
+        out += ": ";
+
+        char number[32];
+        switch (info.type) {
+            case SettingType::Bool:
+                out += snapshot.GetBool(id) ? "true" : "false";
+                break;
+            case SettingType::Int:
+                snprintf(number, sizeof(number), "%d", snapshot.GetInt(id));
+                out += number;
+                break;
+            case SettingType::Float:
+                // Enough digits to read back the same float; keep it a float
+                snprintf(number, sizeof(number), "%.9g", snapshot.GetFloat(id));
+                out += number;
+                if (!strpbrk(number, ".eEn")) {
+                    out += ".0";
+                }
+                break;
+            case SettingType::String:
+                AppendJsonString(out, snapshot.GetString(id));
+                break;
+        }
+        needComma = true;
+    }
+
+    while (!open.empty()) {
+        open.pop_back();
+        newLine(open.size() + 1);
+        out += '}';
+    }
+    out += "\n}\n";
+}
+
+// Write contents and make sure they reached the disk before returning
+bool WriteFileDurably(const std::string& path, const std::string& contents) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(fs::path(path).wstring().c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD written = 0;
+    bool ok = WriteFile(file, contents.data(), static_cast<DWORD>(contents.size()), &written, nullptr) &&
+              written == contents.size() &&
+              FlushFileBuffers(file);
+    CloseHandle(file);
+    return ok;
+#else
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size() &&
+              fflush(file) == 0 &&
+              fsync(fileno(file)) == 0;
+    return (fclose(file) == 0) && ok;
+#endif
+}
+
+// Atomic replace: anyone opening to sees the old or the new file, never a mix
+bool RenameOver(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExW(fs::path(from).wstring().c_str(), fs::path(to).wstring().c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// <config>.cache: the resolved settings of one config file, so an
+// unchanged file is never parsed again. Host byte order.
+constexpr char CACHE_MAGIC[4] = {'C', 'F', 'G', 'C'};
+constexpr uint32_t CACHE_VERSION = 1;
+const char* CACHE_SUFFIX = ".cache";
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t schemaHash;        // SETTING_INFO keys, types and defaults
+    uint64_t sourceSize;
+    int64_t sourceWriteTime;
+    uint64_t sourceHash;
+    uint64_t bodyHash;          // Slots + strings; catches a torn write
+    uint32_t settingCount;
+    uint32_t stringBytes;
+};
+
+struct CacheSlot {
+    uint8_t present;            // Set by the file; absent settings keep the base value
+    uint8_t type;
+    uint16_t reserved;
+    uint32_t value;             // bool / int32 / float bits
+    uint32_t stringOffset;
+    uint32_t stringLength;
+};
+
+// A cache written by a build with different settings is ignored
+uint64_t SchemaHash() {
+    static const uint64_t hash = [] {
+        uint64_t h = FNV1A_OFFSET_BASIS;
+        for (const SettingInfo& info : SETTING_INFO) {
+            h = HashBytes(info.key, strlen(info.key) + 1, h);
+            h = HashBytes(&info.type, sizeof(info.type), h);
+            h = HashBytes(&info.defaultBool, sizeof(info.defaultBool), h);
+            h = HashBytes(&info.defaultInt, sizeof(info.defaultInt), h);
+            h = HashBytes(&info.defaultFloat, sizeof(info.defaultFloat), h);
+            h = HashBytes(info.defaultString, strlen(info.defaultString) + 1, h);
+        }
+        return h;
+    }();
+    return hash;
+}
+
+bool LoadCache(const std::string& path, uint64_t size, fs::file_time_type writeTime,
+               const ConfigSnapshot& base, ConfigSnapshot& out, uint64_t& contentHash) {
+    MappedFile cache;
+    if (!cache.Open(path + CACHE_SUFFIX) || cache.GetSize() < sizeof(CacheHeader)) {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, cache.GetData(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.schemaHash != SchemaHash() ||
+        header.settingCount != SETTING_COUNT ||
+        header.sourceSize != size ||
+        header.sourceWriteTime != static_cast<int64_t>(writeTime.time_since_epoch().count())) {
+        return false;
+    }
+
+    const size_t slotBytes = SETTING_COUNT * sizeof(CacheSlot);
+    const unsigned char* body = cache.GetData() + sizeof(header);
+    size_t bodySize = slotBytes + header.stringBytes;
+    if (cache.GetSize() != sizeof(header) + bodySize || HashBytes(body, bodySize) != header.bodyHash) {
+        return false;
+    }
+
+    // Same size and mtime; make sure the bytes are the same too
+    MappedFile source;
+    if (!source.Open(path) || source.GetSize() != size ||
+        HashBytes(source.GetData(), source.GetSize()) != header.sourceHash) {
+        return false;
+    }
+
+    ConfigSnapshot result = base;
+    const char* strings = reinterpret_cast<const char*>(body + slotBytes);
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        CacheSlot slot;
+        std::memcpy(&slot, body + i * sizeof(CacheSlot), sizeof(slot));
+        if (!slot.present) {
+            continue;
+        }
+        if (slot.type != static_cast<uint8_t>(SETTING_INFO[i].type)) {
+            return false;
+        }
+
+        SettingId id = static_cast<SettingId>(i);
+        switch (SETTING_INFO[i].type) {
+            case SettingType::Bool:
+                result.SetBool(id, slot.value != 0);
+                break;
+            case SettingType::Int: {
+                int32_t value;
+                std::memcpy(&value, &slot.value, sizeof(value));
+                result.SetInt(id, value);
+                break;
+            }
+            case SettingType::Float: {
+                float value;
+                std::memcpy(&value, &slot.value, sizeof(value));
+                result.SetFloat(id, value);
+                break;
+            }
+            case SettingType::String:
+                if (static_cast<uint64_t>(slot.stringOffset) + slot.stringLength > header.stringBytes) {
+                    return false;
+                }
+                result.SetString(id, std::string_view(strings + slot.stringOffset, slot.stringLength));
+                break;
+        }
+    }
+
+    out = std::move(result);
+    contentHash = header.sourceHash;
+    return true;
+}
+
+void StoreCache(const std::string& path, uint64_t size, fs::file_time_type writeTime, uint64_t contentHash,
+                const ConfigSnapshot& snapshot, const std::vector<uint8_t>& present) {
+    std::string body(SETTING_COUNT * sizeof(CacheSlot), '\0');
+    std::string strings;
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        SettingId id = static_cast<SettingId>(i);
+        CacheSlot slot = {};
+        slot.present = present[i];
+        slot.type = static_cast<uint8_t>(SETTING_INFO[i].type);
+        switch (SETTING_INFO[i].type) {
+            case SettingType::Bool:
+                slot.value = snapshot.GetBool(id) ? 1 : 0;
+                break;
+            case SettingType::Int: {
+                int32_t value = snapshot.GetInt(id);
+                std::memcpy(&slot.value, &value, sizeof(value));
+                break;
+            }
+            case SettingType::Float: {
+                float value = snapshot.GetFloat(id);
+                std::memcpy(&slot.value, &value, sizeof(value));
+                break;
+            }
+            case SettingType::String: {
+                std::string_view text = snapshot.GetString(id);
+                slot.stringOffset = static_cast<uint32_t>(strings.size());
+                slot.stringLength = static_cast<uint32_t>(text.size());
+                strings.append(text.data(), text.size());
+                break;
+            }
+        }
+        std::memcpy(&body[i * sizeof(CacheSlot)], &slot, sizeof(slot));
+    }
+    body += strings;
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.schemaHash = SchemaHash();
+    header.sourceSize = size;
+    header.sourceWriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    header.sourceHash = contentHash;
+    header.bodyHash = HashBytes(body.data(), body.size());
+    header.settingCount = static_cast<uint32_t>(SETTING_COUNT);
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+
+    // Only a cache: no sync, and a failure just means parsing next time
+    std::string cachePath = path + CACHE_SUFFIX;
+    std::string tempPath = cachePath + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(body.data(), body.size());
+        if (!file) {
+            file.close();
+            fs::remove(tempPath, ec);
+            return;
+        }
+    }
+    if (!RenameOver(tempPath, cachePath)) {
+        fs::remove(tempPath, ec);
+    }
+}
+
+} // namespace
 
 Config& Config::Instance() {
     static Config instance;
     return instance;
 }
 
+Config::Config() {
+    m_current = std::make_shared<ConfigSnapshot>();
+}
+
+Config::~Config() {
+    StopAutoSave();
+    StopWatching();
+}
+
 bool Config::Load(const std::string& path) {
-    std::ifstream file(path);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    auto snapshot = std::make_shared<ConfigSnapshot>();
+    uint64_t contentHash = 0;
+    fs::file_time_type writeTime;
+    if (!ReadSource(path, CurrentSnapshot(), *snapshot, contentHash, writeTime)) {
+        return false;
+    }
+
+    m_loadedWriteTime = writeTime;
+    m_diskPath = path;
+    m_diskHash = contentHash;
+    // An explicit load replaces what was set, saved or not
+    std::fill(m_unsaved.begin(), m_unsaved.end(), uint8_t(0));
+    Publish(std::move(snapshot));
+    return true;
+}
+
+bool Config::ReadSource(const std::string& path, const ConfigSnapshot& base, ConfigSnapshot& out,
+                        uint64_t& contentHash, fs::file_time_type& writeTime) {
+    std::error_code ec;
+    writeTime = fs::last_write_time(path, ec);
+    uint64_t size = ec ? 0 : fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+
+    if (LoadCache(path, size, writeTime, base, out, contentHash)) {
+        return true;
+    }
+
+    std::vector<uint8_t> present;
+    if (!ParseFile(path, base, out, contentHash, present)) {
+        return false;
+    }
+    StoreCache(path, size, writeTime, contentHash, out, present);
+    return true;
+}
+
+bool Config::ParseFile(const std::string& path, const ConfigSnapshot& base, ConfigSnapshot& out,
+                       uint64_t& contentHash, std::vector<uint8_t>& present) {
+    std::ifstream file(path, std::ios::binary);
     if (!file.is_open()) {
         return false;
     }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 
     try {
-        nlohmann::json j;
-        file >> j;
+        nlohmann::json j = nlohmann::json::parse(text);
 
-        if (j.contains("api") && j["api"].contains("baseUrl")) {
-            m_apiBaseUrl = j["api"]["baseUrl"].get<std::string>();
-        }
+        ConfigSnapshot result = base;
+        std::vector<uint8_t> found(SETTING_COUNT, 0);
 
-        if (j.contains("ui")) {
-            if (j["ui"].contains("language")) {
-                m_language = j["ui"]["language"].get<std::string>();
+        // Missing keys, wrong JSON types and values the setting's rule
+        // rejects all keep the base value
+        for (size_t i = 0; i < SETTING_COUNT; ++i) {
+            SettingId id = static_cast<SettingId>(i);
+            const SettingInfo& info = SETTING_INFO[i];
+            const nlohmann::json* node = FindPath(j, info.key);
+            if (!node) {
+                continue;
             }
-            if (j["ui"].contains("scale")) {
-                m_uiScale = j["ui"]["scale"].get<float>();
+
+            switch (info.type) {
+                case SettingType::Bool:
+                    found[i] = node->is_boolean() && result.SetBool(id, node->get<bool>());
+                    break;
+                case SettingType::Int:
+                    found[i] = node->is_number_integer() && result.SetInt(id, node->get<int32_t>());
+                    break;
+                case SettingType::Float:
+                    found[i] = node->is_number() && result.SetFloat(id, node->get<float>());
+                    break;
+                case SettingType::String:
+                    found[i] = node->is_string() && result.SetString(id, node->get_ref<const std::string&>());
+                    break;
             }
         }
 
-        if (j.contains("video") && j["video"].contains("loginBackground")) {
-            m_loginVideoPath = j["video"]["loginBackground"].get<std::string>();
+        out = std::move(result);
+        present = std::move(found);
+        contentHash = HashBytes(text.data(), text.size());
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool Config::Save(const std::string& path) {
+    // One save at a time: they share the temp file
+    std::lock_guard<std::mutex> saveLock(m_saveMutex);
+
+    for (int attempt = 0; attempt < SAVE_ATTEMPTS; ++attempt) {
+        bool conflict = false;
+        if (WriteSnapshot(*GetSnapshot(), path, conflict)) {
+            return true;
         }
+        // Edited on disk since we last looked. Take that edit, with the
+        // unsaved settings put back on top, and write the result.
+        if (!conflict || !ReloadIfChanged(path)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool Config::WriteSnapshot(const ConfigSnapshot& snapshot, const std::string& path, bool& conflict) {
+    // Serializing and syncing happen outside m_writeMutex, so setters
+    // don't wait on the disk flush
+    std::string text;
+    SerializeSnapshot(snapshot, text);
+    uint64_t hash = HashBytes(text.data(), text.size());
 
-        if (j.contains("updates") && j["updates"].contains("checkOnStartup")) {
-            m_checkUpdatesOnStartup = j["updates"]["checkOnStartup"].get<bool>();
+    std::error_code ec;
+    fs::file_time_type expectedWriteTime;
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        if (path == m_diskPath && hash == m_diskHash) {
+            MarkSaved(snapshot);
+            return true;
         }
+        expectedWriteTime = m_loadedWriteTime;
+    }
 
-        return true;
+    // A crash before the rename leaves the old file untouched
+    std::string tempPath = path + ".tmp";
+    if (!WriteFileDurably(tempPath, text)) {
+        fs::remove(tempPath, ec);
+        return false;
     }
-    catch (const std::exception&) {
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    // Don't overwrite an edit made on disk with older in-memory state
+    if (path == m_diskPath && fs::last_write_time(path, ec) != expectedWriteTime && !ec) {
+        fs::remove(tempPath, ec);
+        conflict = true;
+        return false;
+    }
+
+    if (!RenameOver(tempPath, path)) {
+        fs::remove(tempPath, ec);
         return false;
     }
+
+    // Our own write holds nothing new; don't let the watcher reparse it
+    m_diskPath = path;
+    m_diskHash = hash;
+    m_loadedWriteTime = fs::last_write_time(path, ec);
+    MarkSaved(snapshot);
+
+    // Every setting is in the file we just wrote
+    StoreCache(path, text.size(), m_loadedWriteTime, hash, snapshot, std::vector<uint8_t>(SETTING_COUNT, 1));
+    return true;
 }
 
-bool Config::Save(const std::string& path) {
-    nlohmann::json j;
+bool Config::StartAutoSave(const std::string& path, uint32_t debounceMs) {
+    StopAutoSave();
 
-    j["api"]["baseUrl"] = m_apiBaseUrl;
+    {
+        std::lock_guard<std::mutex> lock(m_autoSaveMutex);
+        m_autoSavePath = path;
+        m_autoSaveDebounceMs = debounceMs;
+        m_autoSavePending = false;
+    }
+    m_autoSaving.store(true, std::memory_order_release);
+    m_autoSaver = std::thread(&Config::AutoSaveLoop, this);
+    return true;
+}
 
-    j["ui"]["language"] = m_language;
-    j["ui"]["scale"] = m_uiScale;
+void Config::StopAutoSave() {
+    if (!m_autoSaving.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
 
-    j["video"]["loginBackground"] = m_loginVideoPath;
+    {
+        std::lock_guard<std::mutex> lock(m_autoSaveMutex);
+    }
+    m_autoSaveCv.notify_all();
 
-    j["updates"]["checkOnStartup"] = m_checkUpdatesOnStartup;
+    if (m_autoSaver.joinable()) {
+        m_autoSaver.join();
+    }
+}
 
-    std::ofstream file(path);
-    if (!file.is_open()) {
+void Config::ScheduleAutoSave() {
+    if (!m_autoSaving.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    {
+        // Each change pushes the deadline out, so a burst of Set() calls
+        // is written once
+        std::lock_guard<std::mutex> lock(m_autoSaveMutex);
+        m_autoSavePending = true;
+        m_autoSaveDeadline = std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(m_autoSaveDebounceMs);
+    }
+    m_autoSaveCv.notify_one();
+}
+
+void Config::AutoSaveLoop() {
+    std::unique_lock<std::mutex> lock(m_autoSaveMutex);
+    for (;;) {
+        bool running = m_autoSaving.load(std::memory_order_acquire);
+        if (!m_autoSavePending) {
+            if (!running) {
+                break;
+            }
+            m_autoSaveCv.wait(lock, [this] {
+                return m_autoSavePending || !m_autoSaving.load(std::memory_order_acquire);
+            });
+            continue;
+        }
+
+        // Stopping writes immediately; otherwise wait out the debounce
+        if (running && std::chrono::steady_clock::now() < m_autoSaveDeadline) {
+            m_autoSaveCv.wait_until(lock, m_autoSaveDeadline);
+            continue;
+        }
+
+        m_autoSavePending = false;
+        std::string path = m_autoSavePath;
+        lock.unlock();
+        Save(path);
+        lock.lock();
+    }
+}
+
+std::shared_ptr<const ConfigSnapshot> Config::GetSnapshot() const {
+    CurrentSnapshot();
+    return t_snapshotCache.snapshot;
+}
+
+const ConfigSnapshot& Config::CurrentSnapshot() const {
+    // Only the first read after a publish loads m_current, and that load is
+    // atomic: a reader never waits for a writer
+    SnapshotCache& cache = t_snapshotCache;
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+    if (cache.generation != generation) {
+        cache.snapshot = std::atomic_load_explicit(&m_current, std::memory_order_acquire);
+        cache.generation = generation;
+    }
+    return *cache.snapshot;
+}
+
+uint32_t Config::Subscribe(SettingId setting, ConfigChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    uint32_t id = m_nextSubscriptionId++;
+    m_subscriptions.push_back({id, setting, std::make_shared<ConfigChangeCallback>(std::move(callback))});
+    return id;
+}
+
+void Config::Unsubscribe(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+    for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it) {
+        if (it->id == id) {
+            m_subscriptions.erase(it);
+            return;
+        }
+    }
+}
+
+bool Config::Set(SettingKey<bool> key, bool value) {
+    return Modify([&](ConfigSnapshot& s) { return s.SetBool(key.id, value); });
+}
+
+bool Config::Set(SettingKey<int32_t> key, int32_t value) {
+    return Modify([&](ConfigSnapshot& s) { return s.SetInt(key.id, value); });
+}
+
+bool Config::Set(SettingKey<float> key, float value) {
+    return Modify([&](ConfigSnapshot& s) { return s.SetFloat(key.id, value); });
+}
+
+bool Config::Set(SettingKey<std::string> key, std::string_view value) {
+    return Modify([&](ConfigSnapshot& s) { return s.SetString(key.id, value); });
+}
+
+bool Config::Modify(const std::function<bool(ConfigSnapshot&)>& edit) {
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        const ConfigSnapshot& previous = CurrentSnapshot();
+        auto snapshot = std::make_shared<ConfigSnapshot>(previous);
+        if (!edit(*snapshot)) {
+            return false;
+        }
+        for (size_t i = 0; i < SETTING_COUNT; ++i) {
+            if (!previous.Equals(static_cast<SettingId>(i), *snapshot)) {
+                m_unsaved[i] = 1;
+            }
+        }
+        if (!Publish(std::move(snapshot))) {
+            return true;
+        }
+    }
+    ScheduleAutoSave();
+    return true;
+}
+
+bool Config::Publish(std::shared_ptr<const ConfigSnapshot> snapshot) {
+    std::vector<SettingId> changed;
+    const ConfigSnapshot& previous = CurrentSnapshot();
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        SettingId id = static_cast<SettingId>(i);
+        if (!previous.Equals(id, *snapshot)) {
+            changed.push_back(id);
+        }
+    }
+    if (changed.empty()) {
         return false;
     }
 
-    file << j.dump(2);
+    // Pointer first: a reader that sees the new generation loads at least
+    // this snapshot
+    std::atomic_store_explicit(&m_current, snapshot, std::memory_order_release);
+    m_generation.fetch_add(1, std::memory_order_release);
+
+    // Call outside the lock so callbacks may (un)subscribe. They run under
+    // m_writeMutex, so they must not change settings themselves.
+    std::vector<std::shared_ptr<ConfigChangeCallback>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+        for (const Subscription& subscription : m_subscriptions) {
+            for (SettingId id : changed) {
+                if (subscription.setting == id) {
+                    callbacks.push_back(subscription.callback);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const auto& callback : callbacks) {
+        (*callback)(*snapshot);
+    }
+    return true;
+}
+
+bool Config::StartWatching(const std::string& path) {
+    StopWatching();
+
+    m_watchPath = path;
+    {
+        // Load() may not have run; treat the file as it is now as loaded
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        if (m_loadedWriteTime == fs::file_time_type()) {
+            std::error_code ec;
+            m_loadedWriteTime = fs::last_write_time(path, ec);
+        }
+    }
+
+#ifdef _WIN32
+    m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!m_stopEvent) {
+        return false;
+    }
+#endif
+
+    m_watching.store(true, std::memory_order_release);
+    m_watcher = std::thread(&Config::WatchLoop, this);
     return true;
 }
+
+void Config::StopWatching() {
+    if (!m_watching.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+#ifdef _WIN32
+    SetEvent(static_cast<HANDLE>(m_stopEvent));
+#endif
+    {
+        std::lock_guard<std::mutex> lock(m_watchMutex);
+    }
+    m_watchCv.notify_all();
+
+    if (m_watcher.joinable()) {
+        m_watcher.join();
+    }
+
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(m_stopEvent));
+    m_stopEvent = nullptr;
+#endif
+}
+
+void Config::WatchLoop() {
+#ifdef _WIN32
+    // Directory change notifications; fall through to polling if the
+    // directory can't be watched (e.g. some network shares)
+    std::error_code ec;
+    fs::path directory = fs::absolute(m_watchPath, ec).parent_path();
+    HANDLE change = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+
+    if (change != INVALID_HANDLE_VALUE) {
+        HANDLE stopEvent = static_cast<HANDLE>(m_stopEvent);
+        HANDLE handles[] = { change, stopEvent };
+
+        while (m_watching.load(std::memory_order_acquire)) {
+            if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                break;
+            }
+            if (WaitForSingleObject(stopEvent, RELOAD_SETTLE_MS) == WAIT_OBJECT_0) {
+                break;
+            }
+            // Re-arm before reading so a save during the reload isn't missed
+            if (!FindNextChangeNotification(change)) {
+                break;
+            }
+            ReloadIfChanged(m_watchPath);
+        }
+
+        FindCloseChangeNotification(change);
+        return;
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(m_watchMutex);
+    while (m_watching.load(std::memory_order_acquire)) {
+        m_watchCv.wait_for(lock, std::chrono::milliseconds(WATCH_POLL_MS), [this] {
+            return !m_watching.load(std::memory_order_acquire);
+        });
+        if (!m_watching.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        lock.unlock();
+        ReloadIfChanged(m_watchPath);
+        lock.lock();
+    }
+}
+
+bool Config::ReloadIfChanged(const std::string& path) {
+    // Parsed here and outside m_writeMutex, so a setter doesn't wait on
+    // the file. A half-written file fails to parse and is picked up again
+    // on the next change.
+    for (int attempt = 1;; ++attempt) {
+        std::error_code ec;
+        fs::file_time_type writeTime = fs::last_write_time(path, ec);
+        if (ec) {
+            // Deleted, or mid-rename by an editor
+            return false;
+        }
+
+        // Setters that keep racing the read would starve it, so the last
+        // attempt holds the lock throughout. By then the earlier attempts
+        // have left a binary cache to read instead of the JSON.
+        bool holdLock = attempt == RELOAD_ATTEMPTS;
+        std::unique_lock<std::mutex> lock(m_writeMutex);
+        if (writeTime == m_loadedWriteTime) {
+            return true;
+        }
+        std::shared_ptr<const ConfigSnapshot> base = GetSnapshot();
+        uint64_t generation = m_generation.load(std::memory_order_relaxed);
+        fs::file_time_type loadedWriteTime = m_loadedWriteTime;
+        if (!holdLock) {
+            lock.unlock();
+        }
+
+        auto snapshot = std::make_shared<ConfigSnapshot>();
+        uint64_t contentHash = 0;
+        if (!ReadSource(path, *base, *snapshot, contentHash, writeTime)) {
+            return false;
+        }
+
+        if (!holdLock) {
+            lock.lock();
+            // A setter published or a save landed meanwhile: go again on
+            // top of that
+            if (m_generation.load(std::memory_order_relaxed) != generation ||
+                m_loadedWriteTime != loadedWriteTime) {
+                continue;
+            }
+        }
+
+        // Changes not saved yet win over the file; the next save writes
+        // them into it
+        KeepUnsaved(*base, *snapshot);
+        bool unsaved = std::find(m_unsaved.begin(), m_unsaved.end(), uint8_t(1)) != m_unsaved.end();
+
+        m_loadedWriteTime = writeTime;
+        m_diskPath = path;
+        m_diskHash = contentHash;
+        Publish(std::move(snapshot));
+        lock.unlock();
+
+        if (unsaved) {
+            ScheduleAutoSave();
+        }
+        return true;
+    }
+}
+
+void Config::KeepUnsaved(const ConfigSnapshot& from, ConfigSnapshot& to) const {
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        if (m_unsaved[i]) {
+            to.CopyFrom(static_cast<SettingId>(i), from);
+        }
+    }
+}
+
+void Config::MarkSaved(const ConfigSnapshot& saved) {
+    const ConfigSnapshot& current = CurrentSnapshot();
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        if (m_unsaved[i] && current.Equals(static_cast<SettingId>(i), saved)) {
+            m_unsaved[i] = 0;
+        }
+    }
+}
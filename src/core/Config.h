@@ -1,41 +1,164 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <nlohmann/json.hpp>
+#include "Settings.h"
+
+// Called with the newly published snapshot on the thread that published it
+// (the watcher thread for file reloads)
+using ConfigChangeCallback = std::function<void(const ConfigSnapshot& snapshot)>;
 
 class Config {
 public:
     static Config& Instance();
 
     bool Load(const std::string& path = "config.json");
+
+    // Writes the current settings to a temp file, syncs it and renames it
+    // over path, so a crash leaves either the old or the new file. Skipped
+    // when the bytes would match what was last loaded or saved. If the file
+    // was edited on disk meanwhile, that edit is loaded first and the
+    // settings Set() since the last save are written on top of it.
     bool Save(const std::string& path = "config.json");
 
-    // API settings
-    std::string GetApiBaseUrl() const { return m_apiBaseUrl; }
-    void SetApiBaseUrl(const std::string& url) { m_apiBaseUrl = url; }
+    // Save Set() changes in the background once no further change has
+    // arrived for debounceMs
+    bool StartAutoSave(const std::string& path = "config.json", uint32_t debounceMs = 500);
+    // Writes any pending change, then stops the background writer
+    void StopAutoSave();
+
+    // Reload the file in the background whenever it changes on disk
+    bool StartWatching(const std::string& path = "config.json");
+    void StopWatching();
 
-    // UI settings
-    std::string GetLanguage() const { return m_language; }
-    void SetLanguage(const std::string& lang) { m_language = lang; }
+    // Current snapshot. Never waits on a writer, and doesn't allocate or
+    // touch the shared pointer unless a change was published since this
+    // thread's last call.
+    std::shared_ptr<const ConfigSnapshot> GetSnapshot() const;
 
-    float GetUiScale() const { return m_uiScale; }
-    void SetUiScale(float scale) { m_uiScale = scale; }
+    // Read one setting, e.g. Get(settings::UiScale). A string_view result
+    // stays valid until this thread reads Config again after a change;
+    // hold a GetSnapshot() for anything longer-lived.
+    template <typename T>
+    typename SettingTraits<T>::Read Get(SettingKey<T> key) const { return CurrentSnapshot().Get(key); }
 
-    // Video settings
-    std::string GetLoginVideoPath() const { return m_loginVideoPath; }
-    void SetLoginVideoPath(const std::string& path) { m_loginVideoPath = path; }
+    // Publishes a new snapshot; false if the setting's rule rejects value
+    bool Set(SettingKey<bool> key, bool value);
+    bool Set(SettingKey<int32_t> key, int32_t value);
+    bool Set(SettingKey<float> key, float value);
+    bool Set(SettingKey<std::string> key, std::string_view value);
 
-    // Update settings
-    bool GetCheckUpdatesOnStartup() const { return m_checkUpdatesOnStartup; }
-    void SetCheckUpdatesOnStartup(bool check) { m_checkUpdatesOnStartup = check; }
+    // Invoke callback whenever the setting changes. Returns an id for
+    // Unsubscribe.
+    template <typename T>
+    uint32_t Subscribe(SettingKey<T> key, ConfigChangeCallback callback) { return Subscribe(key.id, std::move(callback)); }
+    uint32_t Subscribe(SettingId id, ConfigChangeCallback callback);
+    void Unsubscribe(uint32_t id);
 
 private:
-    Config() = default;
-    ~Config() = default;
-
-    std::string m_apiBaseUrl = "https://api.example.com/v1";
-    std::string m_language = "zh-CN";
-    float m_uiScale = 1.0f;
-    std::string m_loginVideoPath = "assets/videos/login_bg.mp4";
-    bool m_checkUpdatesOnStartup = true;
+    Config();
+    ~Config();
+
+    // This thread's cached snapshot, refreshed when m_generation moves
+    const ConfigSnapshot& CurrentSnapshot() const;
+
+    // Copy-on-write edit of the current snapshot, then Publish and queue an
+    // auto-save. The edit returns false to reject the change.
+    bool Modify(const std::function<bool(ConfigSnapshot&)>& edit);
+
+    // Swap in a new snapshot and notify subscribers of the settings that
+    // differ from the previous one. Returns false (publishing nothing) if
+    // nothing differs. Caller holds m_writeMutex.
+    bool Publish(std::shared_ptr<const ConfigSnapshot> snapshot);
+
+    // Resolve path on top of base: from the binary cache next to it
+    // (<path>.cache) when the file's size, mtime and content hash still
+    // match, otherwise by parsing the JSON and rewriting the cache.
+    // contentHash receives the hash of the file's bytes, writeTime its mtime.
+    static bool ReadSource(const std::string& path, const ConfigSnapshot& base, ConfigSnapshot& out,
+                           uint64_t& contentHash, std::filesystem::file_time_type& writeTime);
+
+    // Parse path on top of base; false leaves out untouched. present marks
+    // the settings the file set.
+    static bool ParseFile(const std::string& path, const ConfigSnapshot& base, ConfigSnapshot& out,
+                          uint64_t& contentHash, std::vector<uint8_t>& present);
+
+    // Serialize and atomically replace path; see Save. conflict is set when
+    // path changed on disk since it was last loaded or saved, in which case
+    // nothing is written.
+    bool WriteSnapshot(const ConfigSnapshot& snapshot, const std::string& path, bool& conflict);
+    void ScheduleAutoSave();
+    void AutoSaveLoop();
+
+    void WatchLoop();
+
+    // Publish path's contents if it changed since it was last loaded or
+    // saved, keeping unsaved Set() changes on top. True once the file is
+    // current, false if it can't be read or parsed.
+    bool ReloadIfChanged(const std::string& path);
+
+    // Copy the settings in m_unsaved from one snapshot into another.
+    // Caller holds m_writeMutex.
+    void KeepUnsaved(const ConfigSnapshot& from, ConfigSnapshot& to) const;
+    // Clear m_unsaved for the settings whose current value is the one in
+    // saved. Caller holds m_writeMutex.
+    void MarkSaved(const ConfigSnapshot& saved);
+
+    struct Subscription {
+        uint32_t id;
+        SettingId setting;
+        std::shared_ptr<ConfigChangeCallback> callback;
+    };
+
+    // Published snapshot, swapped with std::atomic_store. Readers cache it
+    // per thread and only atomic_load it again when m_generation moves.
+    std::shared_ptr<const ConfigSnapshot> m_current;
+    std::atomic<uint64_t> m_generation{1};
+
+    // Serializes writers (setters, Load, reloads)
+    std::mutex m_writeMutex;
+
+    std::vector<Subscription> m_subscriptions;
+    uint32_t m_nextSubscriptionId = 1;
+    std::mutex m_subscriptionMutex;
+
+    // What is on disk, as of the last load or save. Guarded by m_writeMutex.
+    std::string m_diskPath;
+    uint64_t m_diskHash = 0;
+    std::filesystem::file_time_type m_loadedWriteTime;
+
+    // Settings Set() changed that no save has written yet; reloads keep
+    // them. Guarded by m_writeMutex.
+    std::vector<uint8_t> m_unsaved = std::vector<uint8_t>(SETTING_COUNT, 0);
+
+    // One save at a time (they share the temp file)
+    std::mutex m_saveMutex;
+
+    // Background saving
+    std::string m_autoSavePath;
+    uint32_t m_autoSaveDebounceMs = 0;
+    bool m_autoSavePending = false;
+    std::chrono::steady_clock::time_point m_autoSaveDeadline;
+    std::thread m_autoSaver;
+    std::atomic<bool> m_autoSaving{false};
+    std::mutex m_autoSaveMutex;
+    std::condition_variable m_autoSaveCv;
+
+    // File watcher
+    std::string m_watchPath;
+    std::thread m_watcher;
+    std::atomic<bool> m_watching{false};
+    std::mutex m_watchMutex;
+    std::condition_variable m_watchCv;
+    void* m_stopEvent = nullptr;   // HANDLE, wakes the watcher on Windows
 };
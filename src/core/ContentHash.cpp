@@ -0,0 +1,196 @@
+#include "ContentHash.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CONTENT_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t PRIME32_1 = 0x9E3779B1u;
+constexpr uint32_t PRIME32_2 = 0x85EBCA77u;
+constexpr uint32_t PRIME32_3 = 0xC2B2AE3Du;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+constexpr size_t LANES = 8;
+constexpr size_t STRIPE_BYTES = LANES * 8;
+constexpr size_t STRIPES_PER_BLOCK = 16;
+constexpr size_t BLOCK_BYTES = STRIPE_BYTES * STRIPES_PER_BLOCK;
+
+// Stripe n of a block is keyed by SECRET[n .. n + 7]; the scramble and the
+// final merge use the lanes past those
+constexpr size_t SECRET_LANES = STRIPES_PER_BLOCK + LANES + LANES;
+
+struct Secret {
+    uint64_t lanes[SECRET_LANES];
+};
+
+constexpr Secret MakeSecret() {
+    // splitmix64, so the key has no structure the data could line up with
+    Secret secret = {};
+    uint64_t state = PRIME64_1;
+    for (size_t i = 0; i < SECRET_LANES; ++i) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        secret.lanes[i] = z ^ (z >> 31);
+    }
+    return secret;
+}
+
+constexpr Secret SECRET = MakeSecret();
+constexpr const uint64_t* SCRAMBLE_KEY = SECRET.lanes + STRIPES_PER_BLOCK;
+constexpr const uint64_t* MERGE_KEY = SECRET.lanes + STRIPES_PER_BLOCK + LANES;
+
+uint64_t Mul128Fold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    uint64_t low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    uint64_t aLow = a & 0xFFFFFFFFu, aHigh = a >> 32;
+    uint64_t bLow = b & 0xFFFFFFFFu, bHigh = b >> 32;
+    uint64_t lowLow = aLow * bLow;
+    uint64_t highLow = aHigh * bLow;
+    uint64_t lowHigh = aLow * bHigh;
+    uint64_t highHigh = aHigh * bHigh;
+    uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFFu) + lowHigh;
+    uint64_t high = (highLow >> 32) + (cross >> 32) + highHigh;
+    uint64_t low = (cross << 32) | (lowLow & 0xFFFFFFFFu);
+    return low ^ high;
+#endif
+}
+
+uint64_t Read64(const unsigned char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;   // Little-endian on every target this builds for
+}
+
+// Reference; the SSE2 loops below must leave the same lanes
+void AccumulateScalar(uint64_t* acc, const unsigned char* data, size_t stripes, const uint64_t* key) {
+    for (size_t s = 0; s < stripes; ++s) {
+        const unsigned char* in = data + s * STRIPE_BYTES;
+        for (size_t i = 0; i < LANES; ++i) {
+            uint64_t value = Read64(in + i * 8);
+            uint64_t keyed = value ^ key[s + i];
+            acc[i ^ 1] += value;
+            acc[i] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+        }
+    }
+}
+
+void ScrambleScalar(uint64_t* acc) {
+    for (size_t i = 0; i < LANES; ++i) {
+        uint64_t value = acc[i];
+        value ^= value >> 47;
+        value ^= SCRAMBLE_KEY[i];
+        acc[i] = value * PRIME32_1;
+    }
+}
+
+#ifdef CONTENT_HASH_SSE2
+
+void AccumulateSse2(uint64_t* acc, const unsigned char* data, size_t stripes, const uint64_t* key) {
+    __m128i lanes[LANES / 2];
+    for (size_t i = 0; i < LANES / 2; ++i) {
+        lanes[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+    }
+    for (size_t s = 0; s < stripes; ++s) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(data + s * STRIPE_BYTES);
+        const __m128i* k = reinterpret_cast<const __m128i*>(key + s);
+        for (size_t i = 0; i < LANES / 2; ++i) {
+            __m128i value = _mm_loadu_si128(in + i);
+            __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(k + i));
+            // Low half of each lane times its high half
+            __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            // The data goes to the neighbouring lane, as in the scalar loop
+            __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, swapped));
+        }
+    }
+    for (size_t i = 0; i < LANES / 2; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, lanes[i]);
+    }
+}
+
+void ScrambleSse2(uint64_t* acc) {
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+    for (size_t i = 0; i < LANES / 2; ++i) {
+        __m128i* lane = reinterpret_cast<__m128i*>(acc) + i;
+        __m128i value = _mm_loadu_si128(lane);
+        value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+        value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(SCRAMBLE_KEY) + i));
+        // 64 x 32 bit multiply from two 32 x 32 -> 64
+        __m128i low = _mm_mul_epu32(value, prime);
+        __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+        _mm_storeu_si128(lane, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+    }
+}
+
+#endif
+
+uint64_t Avalanche(uint64_t hash) {
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9ull;
+    return hash ^ (hash >> 32);
+}
+
+template <void (*Accumulate)(uint64_t*, const unsigned char*, size_t, const uint64_t*), void (*Scramble)(uint64_t*)>
+uint64_t Hash(const void* data, size_t size, uint64_t seed) {
+    alignas(16) uint64_t acc[LANES] = {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+    };
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    size_t blocks = size / BLOCK_BYTES;
+    for (size_t b = 0; b < blocks; ++b) {
+        Accumulate(acc, bytes + b * BLOCK_BYTES, STRIPES_PER_BLOCK, SECRET.lanes);
+        Scramble(acc);
+    }
+
+    // Whole stripes left, then the rest zero-padded to one more; the
+    // length in the merge tells the padding from real zeros
+    const unsigned char* tail = bytes + blocks * BLOCK_BYTES;
+    size_t tailSize = size - blocks * BLOCK_BYTES;
+    size_t stripes = tailSize / STRIPE_BYTES;
+    Accumulate(acc, tail, stripes, SECRET.lanes);
+    if (size_t rest = tailSize - stripes * STRIPE_BYTES) {
+        alignas(16) unsigned char last[STRIPE_BYTES] = {};
+        std::memcpy(last, tail + stripes * STRIPE_BYTES, rest);
+        Accumulate(acc, last, 1, SECRET.lanes + stripes);
+    }
+
+    uint64_t hash = size * PRIME64_1 ^ seed;
+    for (size_t i = 0; i < LANES; i += 2) {
+        hash += Mul128Fold64(acc[i] ^ MERGE_KEY[i], acc[i + 1] ^ MERGE_KEY[i + 1]);
+    }
+    return Avalanche(hash);
+}
+
+} // namespace
+
+uint64_t HashContent(const void* data, size_t size, uint64_t seed) {
+#ifdef CONTENT_HASH_SSE2
+    return Hash<AccumulateSse2, ScrambleSse2>(data, size, seed);
+#else
+    return Hash<AccumulateScalar, ScrambleScalar>(data, size, seed);
+#endif
+}
+
+uint64_t HashContentScalar(const void* data, size_t size, uint64_t seed) {
+    return Hash<AccumulateScalar, ScrambleScalar>(data, size, seed);
+}
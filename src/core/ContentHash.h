@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit hash for bulk data such as decoded images, after XXH3's long-input
+// loop: eight 64-bit lanes, each stripe of 64 bytes folded in with one
+// 32x32->64 multiply per lane, lanes scrambled every 1 KB. SSE2 does two
+// lanes per instruction, so it runs at close to memory speed. Not
+// compatible with xxHash itself, and not for anything adversarial.
+uint64_t HashContent(const void* data, size_t size, uint64_t seed = 0);
+
+// The same hash without SIMD; the reference HashContent() must match
+uint64_t HashContentScalar(const void* data, size_t size, uint64_t seed = 0);
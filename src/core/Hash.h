@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a, 64-bit. Fast for the short inputs it's used on (log arguments,
+// settings files); not for anything adversarial.
+constexpr uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV1A_PRIME = 1099511628211ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+// Same hash over text, usable at compile time (localization keys)
+constexpr uint64_t HashString(std::string_view text, uint64_t hash = FNV1A_OFFSET_BASIS) {
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
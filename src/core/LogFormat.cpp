@@ -0,0 +1,312 @@
+#include "LogFormat.h"
+#include <cstdio>
+#include <cstring>
+
+namespace logfmt {
+
+namespace {
+
+constexpr int FIELD_NONE = -1;
+constexpr int FIELD_STAR = -2;
+
+// One parsed %-conversion
+struct Spec {
+    char flags[8] = {};
+    int width = FIELD_NONE;
+    int precision = FIELD_NONE;
+    char conversion = 0;
+    ArgKind kind = ArgKind::Int32;
+};
+
+ArgKind IntKindForSize(size_t size) {
+    return size == 8 ? ArgKind::Int64 : ArgKind::Int32;
+}
+
+// Parses the conversion starting just after '%'. Advances p past it.
+bool ParseSpec(const char*& p, const char* end, Spec& spec) {
+    size_t flagCount = 0;
+    while (p < end && std::strchr("-+ #0'", *p)) {
+        if (flagCount + 1 < sizeof(spec.flags)) {
+            spec.flags[flagCount++] = *p;
+        }
+        ++p;
+    }
+
+    auto parseField = [&](int& field) {
+        if (p < end && *p == '*') {
+            field = FIELD_STAR;
+            ++p;
+            return;
+        }
+        if (p < end && *p >= '0' && *p <= '9') {
+            field = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                field = field * 10 + (*p - '0');
+                ++p;
+            }
+        }
+    };
+
+    parseField(spec.width);
+    if (p < end && *p == '.') {
+        ++p;
+        spec.precision = 0;
+        parseField(spec.precision);
+    }
+
+    // Length modifier
+    enum class Length { None, Short, Long, LongLong, Size, LongDouble, I32 } length = Length::None;
+    if (p < end) {
+        switch (*p) {
+            case 'h':
+                length = Length::Short;
+                ++p;
+                if (p < end && *p == 'h') ++p;
+                break;
+            case 'l':
+                length = Length::Long;
+                ++p;
+                if (p < end && *p == 'l') {
+                    length = Length::LongLong;
+                    ++p;
+                }
+                break;
+            case 'j':
+                length = Length::LongLong;
+                ++p;
+                break;
+            case 'z':
+            case 't':
+                length = Length::Size;
+                ++p;
+                break;
+            case 'L':
+                length = Length::LongDouble;
+                ++p;
+                break;
+            case 'I':
+                // MSVC: I, I32, I64
+                ++p;
+                if (end - p >= 2 && p[0] == '6' && p[1] == '4') {
+                    length = Length::LongLong;
+                    p += 2;
+                } else if (end - p >= 2 && p[0] == '3' && p[1] == '2') {
+                    length = Length::I32;
+                    p += 2;
+                } else {
+                    length = Length::Size;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (p >= end) {
+        return false;
+    }
+    spec.conversion = *p++;
+
+    switch (spec.conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            switch (length) {
+                case Length::Long:     spec.kind = IntKindForSize(sizeof(long)); break;
+                case Length::LongLong: spec.kind = ArgKind::Int64; break;
+                case Length::Size:     spec.kind = IntKindForSize(sizeof(size_t)); break;
+                case Length::LongDouble: return false;
+                default:               spec.kind = ArgKind::Int32; break;
+            }
+            return true;
+        case 'c':
+            if (length != Length::None) return false;  // Wide char
+            spec.kind = ArgKind::Int32;
+            return true;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (length == Length::LongDouble) return false;
+            spec.kind = ArgKind::Double;
+            return true;
+        case 's':
+            if (length != Length::None) return false;  // Wide string
+            spec.kind = ArgKind::String;
+            return true;
+        case 'p':
+            spec.kind = ArgKind::Pointer;
+            return true;
+        default:
+            // %n, %S, %C and anything unknown
+            return false;
+    }
+}
+
+template <typename T>
+bool ReadArg(const unsigned char*& args, const unsigned char* end, T& value) {
+    if (static_cast<size_t>(end - args) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, args, sizeof(T));
+    args += sizeof(T);
+    return true;
+}
+
+template <typename T>
+void AppendFormatted(std::string& out, const char* spec, T value) {
+    char stackBuffer[256];
+    int needed = std::snprintf(stackBuffer, sizeof(stackBuffer), spec, value);
+    if (needed <= 0) {
+        return;
+    }
+    if (static_cast<size_t>(needed) < sizeof(stackBuffer)) {
+        out.append(stackBuffer, static_cast<size_t>(needed));
+        return;
+    }
+    size_t offset = out.size();
+    out.resize(offset + static_cast<size_t>(needed) + 1);
+    std::snprintf(&out[offset], static_cast<size_t>(needed) + 1, spec, value);
+    out.resize(offset + static_cast<size_t>(needed));
+}
+
+} // namespace
+
+bool RenderFormat(const char* format, size_t formatLength,
+                  const ArgKind* kinds, size_t count,
+                  const unsigned char* args, size_t argSize,
+                  std::string& out) {
+    const char* p = format;
+    const char* end = format + formatLength;
+    const unsigned char* argEnd = args + argSize;
+    size_t argIndex = 0;
+
+    auto nextKind = [&](ArgKind expected) {
+        return argIndex < count && kinds[argIndex++] == expected;
+    };
+
+    while (p < end) {
+        const char* literal = p;
+        while (p < end && *p != '%') {
+            ++p;
+        }
+        out.append(literal, static_cast<size_t>(p - literal));
+        if (p >= end) {
+            break;
+        }
+
+        ++p;
+        if (p < end && *p == '%') {
+            out += '%';
+            ++p;
+            continue;
+        }
+
+        Spec spec;
+        if (!ParseSpec(p, end, spec)) {
+            return false;
+        }
+
+        int32_t width = spec.width;
+        int32_t precision = spec.precision;
+        if (spec.width == FIELD_STAR && (!nextKind(ArgKind::Int32) || !ReadArg(args, argEnd, width))) {
+            return false;
+        }
+        if (spec.precision == FIELD_STAR && (!nextKind(ArgKind::Int32) || !ReadArg(args, argEnd, precision))) {
+            return false;
+        }
+        if (argIndex >= count) {
+            return false;
+        }
+
+        // Integer widths follow the writer's platform (e.g. %ld is 32-bit on
+        // Windows), so trust the recorded kind for any integer conversion
+        ArgKind kind = kinds[argIndex++];
+        bool isInteger = spec.kind == ArgKind::Int32 || spec.kind == ArgKind::Int64;
+        bool kindMatches = isInteger ? (kind == ArgKind::Int32 || kind == ArgKind::Int64) : kind == spec.kind;
+        if (!kindMatches) {
+            return false;
+        }
+
+        // Rebuild the conversion with resolved width/precision and a length
+        // modifier that matches the captured size on this platform
+        char specText[64];
+        int written = std::snprintf(specText, sizeof(specText), "%%%s", spec.flags);
+        if (width != FIELD_NONE) {
+            written += std::snprintf(specText + written, sizeof(specText) - written, "%d", width);
+        }
+        if (precision != FIELD_NONE) {
+            written += std::snprintf(specText + written, sizeof(specText) - written, ".%d", precision);
+        }
+        bool isSigned = spec.conversion == 'd' || spec.conversion == 'i';
+
+        switch (kind) {
+            case ArgKind::Int32: {
+                int32_t value;
+                if (!ReadArg(args, argEnd, value)) return false;
+                std::snprintf(specText + written, sizeof(specText) - written, "%c", spec.conversion);
+                if (isSigned || spec.conversion == 'c') {
+                    AppendFormatted(out, specText, static_cast<int>(value));
+                } else {
+                    AppendFormatted(out, specText, static_cast<unsigned int>(value));
+                }
+                break;
+            }
+            case ArgKind::Int64: {
+                int64_t value;
+                if (!ReadArg(args, argEnd, value)) return false;
+                if (spec.conversion == 'c') {
+                    // A character passed as a 64-bit integer; %llc isn't a conversion
+                    std::snprintf(specText + written, sizeof(specText) - written, "c");
+                    AppendFormatted(out, specText, static_cast<int>(value));
+                    break;
+                }
+                std::snprintf(specText + written, sizeof(specText) - written, "ll%c", spec.conversion);
+                if (isSigned) {
+                    AppendFormatted(out, specText, static_cast<long long>(value));
+                } else {
+                    AppendFormatted(out, specText, static_cast<unsigned long long>(value));
+                }
+                break;
+            }
+            case ArgKind::Double: {
+                double value;
+                if (!ReadArg(args, argEnd, value)) return false;
+                std::snprintf(specText + written, sizeof(specText) - written, "%c", spec.conversion);
+                AppendFormatted(out, specText, value);
+                break;
+            }
+            case ArgKind::Pointer: {
+                uint64_t value;
+                if (!ReadArg(args, argEnd, value)) return false;
+                std::snprintf(specText + written, sizeof(specText) - written, "p");
+                AppendFormatted(out, specText, reinterpret_cast<void*>(static_cast<uintptr_t>(value)));
+                break;
+            }
+            case ArgKind::String: {
+                uint32_t length;
+                if (!ReadArg(args, argEnd, length) || static_cast<size_t>(argEnd - args) < length) {
+                    return false;
+                }
+                const char* text = reinterpret_cast<const char*>(args);
+                args += length;
+                if (width == FIELD_NONE && precision == FIELD_NONE) {
+                    out.append(text, length);
+                } else {
+                    std::string value(text, length);
+                    std::snprintf(specText + written, sizeof(specText) - written, "s");
+                    AppendFormatted(out, specText, value.c_str());
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+const char* LevelName(uint8_t level) {
+    switch (level) {
+        case 0:  return "DEBUG";
+        case 1:  return "INFO";
+        case 2:  return "WARN";
+        case 3:  return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+} // namespace logfmt
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Shared by Logger (deferred formatting, .blog output) and the offline
+// LogDecoder tool. Keep this free of platform headers.
+namespace logfmt {
+
+// How a printf conversion's argument is captured
+enum class ArgKind : uint8_t {
+    Int32,
+    Int64,
+    Double,
+    Pointer,   // Stored as 8 bytes regardless of platform
+    String     // u32 length + bytes (no terminator)
+};
+
+constexpr size_t MAX_ARGS = 16;
+
+// printf-style rendering of captured argument bytes. Length modifiers are
+// rewritten from the captured kinds, so a file written on one platform
+// renders correctly on another. Returns false on malformed argument data.
+bool RenderFormat(const char* format, size_t formatLength,
+                  const ArgKind* kinds, size_t count,
+                  const unsigned char* args, size_t argSize,
+                  std::string& out);
+
+const char* LevelName(uint8_t level);
+
+// ---------------------------------------------------------------------------
+// Compile-time side: checks a literal format against the C++ argument types
+// of a LOG_* call and decides how each argument is captured.
+
+enum class ArgClass : uint8_t {
+    Integer,
+    Float,
+    String,
+    Pointer,
+    Invalid
+};
+
+template <typename T>
+constexpr ArgClass ClassOf() {
+    using U = std::remove_cv_t<std::decay_t<T>>;
+    if constexpr (std::is_integral_v<U> || std::is_enum_v<U>) {
+        return sizeof(U) <= 8 ? ArgClass::Integer : ArgClass::Invalid;
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return sizeof(U) <= sizeof(double) ? ArgClass::Float : ArgClass::Invalid;
+    } else if constexpr (std::is_same_v<U, char*> || std::is_same_v<U, const char*> ||
+                         std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>) {
+        return ArgClass::String;
+    } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+        return ArgClass::Pointer;
+    } else {
+        return ArgClass::Invalid;
+    }
+}
+
+template <size_t N>
+struct CompiledFormat {
+    bool ok = false;
+    ArgKind kinds[N == 0 ? 1 : N] = {};
+};
+
+// Walks the format the same way printf does. Integer arguments are
+// captured at their own width, so length modifiers only need to be
+// syntactically valid; RenderFormat rewrites them from the captured kind.
+template <typename... Args>
+constexpr CompiledFormat<sizeof...(Args)> CompileFormat(const char* format) {
+    constexpr size_t count = sizeof...(Args);
+    constexpr ArgClass classes[] = {ClassOf<Args>()..., ArgClass::Invalid};
+    constexpr size_t sizes[] = {sizeof(std::decay_t<Args>)..., 0};
+    constexpr bool pointers[] = {(std::is_pointer_v<std::decay_t<Args>> ||
+                                  std::is_null_pointer_v<std::decay_t<Args>>)..., false};
+
+    CompiledFormat<count> result;
+    size_t arg = 0;
+    const char* p = format;
+
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+    auto takeStar = [&]() {
+        if (arg >= count || classes[arg] != ArgClass::Integer || sizes[arg] > 4) {
+            return false;
+        }
+        result.kinds[arg++] = ArgKind::Int32;
+        return true;
+    };
+
+    while (*p) {
+        if (*p++ != '%') {
+            continue;
+        }
+        if (*p == '%') {
+            ++p;
+            continue;
+        }
+
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') {
+            ++p;
+        }
+        if (*p == '*') {
+            if (!takeStar()) return result;
+            ++p;
+        }
+        while (isDigit(*p)) ++p;
+        if (*p == '.') {
+            ++p;
+            if (*p == '*') {
+                if (!takeStar()) return result;
+                ++p;
+            }
+            while (isDigit(*p)) ++p;
+        }
+        while (*p == 'h' || *p == 'l' || *p == 'j' || *p == 'z' || *p == 't') {
+            ++p;
+        }
+        if (*p == 'I') {
+            // MSVC: I, I32, I64
+            ++p;
+            if ((p[0] == '3' && p[1] == '2') || (p[0] == '6' && p[1] == '4')) {
+                p += 2;
+            }
+        }
+
+        char conversion = *p;
+        if (conversion == '\0' || arg >= count) {
+            return result;
+        }
+        ++p;
+
+        switch (conversion) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+                if (classes[arg] != ArgClass::Integer) return result;
+                result.kinds[arg] = sizes[arg] <= 4 ? ArgKind::Int32 : ArgKind::Int64;
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if (classes[arg] != ArgClass::Float) return result;
+                result.kinds[arg] = ArgKind::Double;
+                break;
+            case 's':
+                if (classes[arg] != ArgClass::String) return result;
+                result.kinds[arg] = ArgKind::String;
+                break;
+            case 'p':
+                if (!pointers[arg]) return result;
+                result.kinds[arg] = ArgKind::Pointer;
+                break;
+            default:
+                // %n, wide conversions and anything unknown
+                return result;
+        }
+        ++arg;
+    }
+
+    result.ok = arg == count;
+    return result;
+}
+
+inline std::string_view AsStringView(const char* text) { return text ? text : "(null)"; }
+inline std::string_view AsStringView(const std::string& text) { return text; }
+inline std::string_view AsStringView(std::string_view text) { return text; }
+
+// Byte encoding of one captured argument, selected by its compiled kind
+template <ArgKind Kind>
+struct ArgWriter;
+
+template <>
+struct ArgWriter<ArgKind::Int32> {
+    template <typename T> static size_t Size(const T&) { return sizeof(int32_t); }
+    template <typename T> static unsigned char* Put(unsigned char* out, const T& value) {
+        int32_t v = static_cast<int32_t>(value);
+        std::memcpy(out, &v, sizeof(v));
+        return out + sizeof(v);
+    }
+};
+
+template <>
+struct ArgWriter<ArgKind::Int64> {
+    template <typename T> static size_t Size(const T&) { return sizeof(int64_t); }
+    template <typename T> static unsigned char* Put(unsigned char* out, const T& value) {
+        int64_t v = static_cast<int64_t>(value);
+        std::memcpy(out, &v, sizeof(v));
+        return out + sizeof(v);
+    }
+};
+
+template <>
+struct ArgWriter<ArgKind::Double> {
+    template <typename T> static size_t Size(const T&) { return sizeof(double); }
+    template <typename T> static unsigned char* Put(unsigned char* out, const T& value) {
+        double v = static_cast<double>(value);
+        std::memcpy(out, &v, sizeof(v));
+        return out + sizeof(v);
+    }
+};
+
+template <>
+struct ArgWriter<ArgKind::Pointer> {
+    template <typename T> static size_t Size(const T&) { return sizeof(uint64_t); }
+    template <typename T> static unsigned char* Put(unsigned char* out, const T& value) {
+        uint64_t v = reinterpret_cast<uintptr_t>(static_cast<const volatile void*>(value));
+        std::memcpy(out, &v, sizeof(v));
+        return out + sizeof(v);
+    }
+};
+
+template <>
+struct ArgWriter<ArgKind::String> {
+    template <typename T> static size_t Size(const T& value) {
+        return sizeof(uint32_t) + AsStringView(value).size();
+    }
+    template <typename T> static unsigned char* Put(unsigned char* out, const T& value) {
+        std::string_view text = AsStringView(value);
+        uint32_t length = static_cast<uint32_t>(text.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), text.data(), text.size());
+        return out + sizeof(length) + text.size();
+    }
+};
+
+// .blog file layout (host byte order):
+//   SessionHeader, then a stream of tagged entries.
+//   TAG_FORMAT: u16 id, u8 argCount, ArgKind[argCount], u32 length, bytes
+//   TAG_RECORD: u8 level, u16 formatId, i64 monotonic ns, u32 argBytes, args
+// A new SessionHeader starts each time the file is (re)opened for append;
+// format ids are only valid within their session.
+constexpr char BLOG_MAGIC[4] = {'B', 'L', 'O', 'G'};
+constexpr uint32_t BLOG_VERSION = 1;
+constexpr uint8_t TAG_FORMAT = 'F';
+constexpr uint8_t TAG_RECORD = 'R';
+
+// Format id 0 is reserved for pre-rendered messages: one String argument
+constexpr uint16_t PREFORMATTED_ID = 0;
+constexpr const char* PREFORMATTED_FORMAT = "%s";
+
+#pragma pack(push, 1)
+struct SessionHeader {
+    char magic[4];
+    uint32_t version;
+    int64_t wallBaseMicros;   // Wall clock (µs since Unix epoch) at monoBaseNanos
+    int64_t monoBaseNanos;
+};
+#pragma pack(pop)
+
+// Memory-mapped log segment (.lseg): fixed-size file starting with this
+// header. Only the first commitOffset bytes after the header hold complete
+// records (text lines or a .blog stream, per contentFormat); the writer
+// bumps commitOffset after each record is copied in.
+constexpr char SEGMENT_MAGIC[4] = {'L', 'S', 'E', 'G'};
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr uint32_t SEGMENT_HEADER_SIZE = 64;
+constexpr uint32_t SEGMENT_CONTENT_TEXT = 0;
+constexpr uint32_t SEGMENT_CONTENT_BINARY = 1;
+
+struct SegmentHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t segmentSize;     // Whole file, header included
+    uint64_t sequence;        // Increases by one per segment; oldest is evicted first
+    uint32_t contentFormat;
+    uint32_t reserved;
+    uint64_t commitOffset;
+    uint8_t padding[SEGMENT_HEADER_SIZE - 40];
+};
+static_assert(sizeof(SegmentHeader) == SEGMENT_HEADER_SIZE, "SegmentHeader layout");
+
+} // namespace logfmt
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Bounded multi-producer / single-consumer queue of variable-length records.
+//
+// Storage is a ring of fixed-size slots. A record occupies one or more
+// consecutive slots; producers claim them with a single CAS on the enqueue
+// position, copy their bytes in and publish by bumping per-slot sequence
+// numbers (Vyukov-style). The single consumer releases slots in order, so a
+// free last slot implies all slots before it are free too.
+class LogQueue {
+public:
+    static constexpr size_t SLOT_SIZE = 64;
+
+    // slotCount is rounded up to a power of two
+    explicit LogQueue(size_t slotCount);
+
+    size_t GetCapacityBytes() const { return m_slotCount * SLOT_SIZE; }
+
+    // Copy head + body into the queue as one record. Returns false if the
+    // queue is currently too full (or the record can never fit).
+    bool TryPush(const void* head, size_t headSize, const void* body, size_t bodySize) {
+        size_t total = headSize + bodySize;
+        size_t slots = (total + SLOT_SIZE - 1) / SLOT_SIZE;
+        if (slots == 0 || slots > m_slotCount) {
+            return false;
+        }
+
+        uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t last = pos + slots - 1;
+            uint64_t seq = m_sequences[last & m_mask].load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(last);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + slots, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Consumer has not released these slots yet
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        CopyIn(pos, 0, head, headSize);
+        CopyIn(pos, headSize, body, bodySize);
+
+        // Publish back to front so the first slot becoming visible means the
+        // whole record is visible
+        for (size_t i = slots; i-- > 0;) {
+            m_sequences[(pos + i) & m_mask].store(pos + i + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Consumer side. Calls fn(data, size) for every published record, where
+    // size is the slot-rounded span (callers store their own exact length in
+    // the head). Returns the number of records drained.
+    template <typename Fn>
+    size_t Drain(Fn&& fn, size_t maxRecords = SIZE_MAX) {
+        size_t count = 0;
+        while (count < maxRecords) {
+            uint64_t pos = m_dequeuePos;
+            uint64_t seq = m_sequences[pos & m_mask].load(std::memory_order_acquire);
+            if (seq != pos + 1) {
+                break;
+            }
+
+            // Every record starts with its total byte size
+            uint32_t size = 0;
+            std::memcpy(&size, SlotData(pos), sizeof(size));
+            size_t slots = (size + SLOT_SIZE - 1) / SLOT_SIZE;
+
+            size_t first = static_cast<size_t>(pos & m_mask);
+            if (first + slots <= m_slotCount) {
+                fn(SlotData(pos), slots * SLOT_SIZE);
+            } else {
+                // Record wraps around the end of the ring
+                m_scratch.resize(slots * SLOT_SIZE);
+                size_t tail = (m_slotCount - first) * SLOT_SIZE;
+                std::memcpy(m_scratch.data(), SlotData(pos), tail);
+                std::memcpy(m_scratch.data() + tail, m_data.get(), slots * SLOT_SIZE - tail);
+                fn(m_scratch.data(), m_scratch.size());
+            }
+
+            for (size_t i = 0; i < slots; ++i) {
+                m_sequences[(pos + i) & m_mask].store(pos + i + m_slotCount, std::memory_order_release);
+            }
+            m_dequeuePos = pos + slots;
+            ++count;
+        }
+        return count;
+    }
+
+    bool IsEmpty() const {
+        uint64_t seq = m_sequences[m_dequeuePos & m_mask].load(std::memory_order_acquire);
+        return seq != m_dequeuePos + 1;
+    }
+
+private:
+    unsigned char* SlotData(uint64_t pos) const {
+        return m_data.get() + static_cast<size_t>(pos & m_mask) * SLOT_SIZE;
+    }
+
+    void CopyIn(uint64_t pos, size_t offset, const void* src, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        size_t ringBytes = m_slotCount * SLOT_SIZE;
+        size_t start = (static_cast<size_t>(pos & m_mask) * SLOT_SIZE + offset) & (ringBytes - 1);
+        size_t first = (size < ringBytes - start) ? size : ringBytes - start;
+        std::memcpy(m_data.get() + start, src, first);
+        if (first < size) {
+            std::memcpy(m_data.get(), static_cast<const unsigned char*>(src) + first, size - first);
+        }
+    }
+
+    size_t m_slotCount = 0;
+    uint64_t m_mask = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_sequences;
+    std::unique_ptr<unsigned char[]> m_data;
+
+    alignas(64) std::atomic<uint64_t> m_enqueuePos{0};
+    alignas(64) uint64_t m_dequeuePos = 0;
+    std::vector<unsigned char> m_scratch;
+};
+
+inline LogQueue::LogQueue(size_t slotCount) {
+    m_slotCount = 1;
+    while (m_slotCount < slotCount) {
+        m_slotCount <<= 1;
+    }
+    m_mask = m_slotCount - 1;
+
+    m_sequences.reset(new std::atomic<uint64_t>[m_slotCount]);
+    for (size_t i = 0; i < m_slotCount; ++i) {
+        m_sequences[i].store(i, std::memory_order_relaxed);
+    }
+    m_data.reset(new unsigned char[m_slotCount * SLOT_SIZE]);
+}
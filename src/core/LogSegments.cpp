@@ -0,0 +1,299 @@
+#include "LogSegments.h"
+#include "LogFormat.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t MIN_SEGMENT_SIZE = 64 * 1024;
+const char* SEGMENT_EXTENSION = ".lseg";
+
+logfmt::SegmentHeader* HeaderOf(unsigned char* view) {
+    return reinterpret_cast<logfmt::SegmentHeader*>(view);
+}
+
+// "<prefix>.<digits>.lseg" -> sequence, 0 if the name doesn't match
+uint64_t ParseSequence(const std::string& fileName, const std::string& prefix) {
+    std::string extension = SEGMENT_EXTENSION;
+    if (fileName.size() <= prefix.size() + 1 + extension.size() ||
+        fileName.compare(0, prefix.size(), prefix) != 0 ||
+        fileName[prefix.size()] != '.' ||
+        fileName.compare(fileName.size() - extension.size(), extension.size(), extension) != 0) {
+        return 0;
+    }
+
+    uint64_t sequence = 0;
+    for (size_t i = prefix.size() + 1; i < fileName.size() - extension.size(); ++i) {
+        char c = fileName[i];
+        if (c < '0' || c > '9') {
+            return 0;
+        }
+        sequence = sequence * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return sequence;
+}
+
+} // namespace
+
+LogSegmentStore::~LogSegmentStore() {
+    Close();
+}
+
+bool LogSegmentStore::Open(const LogSegmentConfig& config, uint32_t contentFormat) {
+    Close();
+
+    m_config = config;
+    m_config.segmentSize = std::max(m_config.segmentSize, MIN_SEGMENT_SIZE);
+    m_config.maxSegments = std::max<uint32_t>(m_config.maxSegments, 1);
+    m_contentFormat = contentFormat;
+    m_sequences.clear();
+
+    std::error_code ec;
+    fs::create_directories(m_config.directory, ec);
+    if (!fs::is_directory(m_config.directory, ec)) {
+        return false;
+    }
+
+    for (const auto& entry : fs::directory_iterator(m_config.directory, ec)) {
+        uint64_t sequence = ParseSequence(entry.path().filename().string(), m_config.prefix);
+        if (sequence != 0) {
+            m_sequences.push_back(sequence);
+        }
+    }
+    std::sort(m_sequences.begin(), m_sequences.end());
+
+    // A smaller maxSegments than the last run's applies right away
+    EvictOldSegments();
+
+    // Continue in the newest segment if it's intact and holds the same
+    // kind of content
+    if (!m_sequences.empty() && MapSegment(m_sequences.back(), false)) {
+        logfmt::SegmentHeader* header = HeaderOf(m_view);
+        uint64_t capacity = header->segmentSize - logfmt::SEGMENT_HEADER_SIZE;
+        if (header->contentFormat == m_contentFormat && header->commitOffset <= capacity) {
+            // Anything past the commit offset is a record that was being
+            // copied in when the process died
+            unsigned char* tail = m_view + logfmt::SEGMENT_HEADER_SIZE + header->commitOffset;
+            std::memset(tail, 0, static_cast<size_t>(capacity - header->commitOffset));
+            return true;
+        }
+        UnmapSegment();
+    }
+
+    return Rotate();
+}
+
+void LogSegmentStore::Close() {
+    if (m_view) {
+        Flush();
+    }
+    UnmapSegment();
+}
+
+size_t LogSegmentStore::GetCapacity() const {
+    // A recovered segment keeps the size it was created with
+    uint64_t size = m_view ? HeaderOf(m_view)->segmentSize : m_config.segmentSize;
+    return static_cast<size_t>(size - logfmt::SEGMENT_HEADER_SIZE);
+}
+
+size_t LogSegmentStore::GetFreeBytes() const {
+    if (!m_view) {
+        return 0;
+    }
+    const logfmt::SegmentHeader* header = HeaderOf(m_view);
+    return static_cast<size_t>(header->segmentSize - logfmt::SEGMENT_HEADER_SIZE - header->commitOffset);
+}
+
+bool LogSegmentStore::IsEmpty() const {
+    return m_view && HeaderOf(m_view)->commitOffset == 0;
+}
+
+bool LogSegmentStore::Append(const void* data, size_t size) {
+    if (!m_view || size > GetFreeBytes()) {
+        return false;
+    }
+
+    logfmt::SegmentHeader* header = HeaderOf(m_view);
+    std::memcpy(m_view + logfmt::SEGMENT_HEADER_SIZE + header->commitOffset, data, size);
+
+    // Record bytes first, then the commit that makes them part of the log
+    std::atomic_thread_fence(std::memory_order_release);
+    header->commitOffset += size;
+    return true;
+}
+
+bool LogSegmentStore::Rotate() {
+    UnmapSegment();
+
+    uint64_t sequence = m_sequences.empty() ? 1 : m_sequences.back() + 1;
+    if (!MapSegment(sequence, true)) {
+        return false;
+    }
+    m_sequences.push_back(sequence);
+    EvictOldSegments();
+    return true;
+}
+
+#ifdef _WIN32
+
+void LogSegmentStore::Flush() {
+    if (m_view) {
+        FlushViewOfFile(m_view, 0);
+    }
+}
+
+bool LogSegmentStore::MapSegment(uint64_t sequence, bool create) {
+    std::wstring path = SegmentPath(sequence).wstring();
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    uint64_t size = m_config.segmentSize;
+    if (!create) {
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) ||
+            static_cast<uint64_t>(fileSize.QuadPart) < logfmt::SEGMENT_HEADER_SIZE) {
+            CloseHandle(file);
+            return false;
+        }
+        size = static_cast<uint64_t>(fileSize.QuadPart);
+    }
+
+    // Mapping a new file at this size extends it with zeros
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size));
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_view = static_cast<unsigned char*>(view);
+    m_viewSize = static_cast<size_t>(size);
+    return InitHeader(sequence, create);
+}
+
+void LogSegmentStore::UnmapSegment() {
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+        m_viewSize = 0;
+    }
+    if (m_mapping) {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+        m_mapping = nullptr;
+    }
+    if (m_file) {
+        CloseHandle(static_cast<HANDLE>(m_file));
+        m_file = nullptr;
+    }
+}
+
+#else
+
+void LogSegmentStore::Flush() {
+    if (m_view) {
+        msync(m_view, m_viewSize, MS_ASYNC);
+    }
+}
+
+// The mapping outlives the descriptor, so only the view is kept
+bool LogSegmentStore::MapSegment(uint64_t sequence, bool create) {
+    std::string path = SegmentPath(sequence).string();
+    int fd = open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    uint64_t size = m_config.segmentSize;
+    if (create) {
+        // Extends the new file with zeros
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            return false;
+        }
+    } else {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < logfmt::SEGMENT_HEADER_SIZE) {
+            close(fd);
+            return false;
+        }
+        size = static_cast<uint64_t>(info.st_size);
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    m_view = static_cast<unsigned char*>(view);
+    m_viewSize = static_cast<size_t>(size);
+    return InitHeader(sequence, create);
+}
+
+void LogSegmentStore::UnmapSegment() {
+    if (m_view) {
+        munmap(m_view, m_viewSize);
+        m_view = nullptr;
+        m_viewSize = 0;
+    }
+}
+
+#endif
+
+bool LogSegmentStore::InitHeader(uint64_t sequence, bool create) {
+    logfmt::SegmentHeader* header = HeaderOf(m_view);
+    if (create) {
+        std::memset(header, 0, sizeof(*header));
+        std::memcpy(header->magic, logfmt::SEGMENT_MAGIC, sizeof(header->magic));
+        header->version = logfmt::SEGMENT_VERSION;
+        header->segmentSize = m_viewSize;
+        header->sequence = sequence;
+        header->contentFormat = m_contentFormat;
+        header->commitOffset = 0;
+    } else if (std::memcmp(header->magic, logfmt::SEGMENT_MAGIC, sizeof(header->magic)) != 0 ||
+               header->version != logfmt::SEGMENT_VERSION ||
+               header->segmentSize != m_viewSize) {
+        UnmapSegment();
+        return false;
+    }
+    return true;
+}
+
+void LogSegmentStore::EvictOldSegments() {
+    while (m_sequences.size() > m_config.maxSegments) {
+        std::error_code ec;
+        fs::remove(SegmentPath(m_sequences.front()), ec);
+        m_sequences.pop_front();
+    }
+}
+
+fs::path LogSegmentStore::SegmentPath(uint64_t sequence) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), ".%06llu", static_cast<unsigned long long>(sequence));
+    return fs::path(m_config.directory) / (m_config.prefix + name + SEGMENT_EXTENSION);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+
+struct LogSegmentConfig {
+    std::string directory = "logs";
+    std::string prefix = "launcher";
+    uint64_t segmentSize = 4 * 1024 * 1024;  // Bytes per segment file, header included
+    uint32_t maxSegments = 8;                // Oldest segments beyond this are deleted
+};
+
+// Rotating set of fixed-size, memory-mapped log files (<prefix>.<seq>.lseg).
+// Appending is a memcpy into the mapping followed by a commit-offset bump,
+// so whatever was appended survives a process crash; the OS writes the
+// dirty pages back. Not thread-safe: owned by the logger's writer.
+class LogSegmentStore {
+public:
+    LogSegmentStore() = default;
+    ~LogSegmentStore();
+
+    LogSegmentStore(const LogSegmentStore&) = delete;
+    LogSegmentStore& operator=(const LogSegmentStore&) = delete;
+
+    // Scans the directory, evicts the oldest segments beyond maxSegments,
+    // recovers the newest (dropping any partial trailing record) and
+    // continues in it if the content format matches; otherwise starts a
+    // new segment
+    bool Open(const LogSegmentConfig& config, uint32_t contentFormat);
+    void Close();
+
+    bool IsOpen() const { return m_view != nullptr; }
+
+    // Bytes a single record can occupy in an empty segment
+    size_t GetCapacity() const;
+    size_t GetFreeBytes() const;
+
+    // True when nothing has been committed to the current segment yet
+    bool IsEmpty() const;
+
+    // Copies one complete record in and commits it. Returns false (writing
+    // nothing) if it doesn't fit in the current segment.
+    bool Append(const void* data, size_t size);
+
+    // Starts the next segment and evicts the oldest beyond maxSegments
+    bool Rotate();
+
+    // Asks the OS to write the mapped pages to disk
+    void Flush();
+
+private:
+    bool MapSegment(uint64_t sequence, bool create);
+    // Writes a new segment's header, or checks an existing one's
+    bool InitHeader(uint64_t sequence, bool create);
+    void UnmapSegment();
+    void EvictOldSegments();
+    std::filesystem::path SegmentPath(uint64_t sequence) const;
+
+    LogSegmentConfig m_config;
+    uint32_t m_contentFormat = 0;
+
+    // Sequences of segments on disk, oldest first
+    std::deque<uint64_t> m_sequences;
+
+    void* m_file = nullptr;      // HANDLE
+    void* m_mapping = nullptr;   // HANDLE
+    unsigned char* m_view = nullptr;
+    size_t m_viewSize = 0;
+};
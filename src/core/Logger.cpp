@@ -1,124 +1,775 @@
 #include "Logger.h"
-#include <cstdarg>
+#include "LogQueue.h"
+#include "Hash.h"
+#include <cstring>
 #include <ctime>
+#include <chrono>
+
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+
+// Fixed part of every queued record; the argument bytes follow it
+struct Logger::RecordHead {
+    uint32_t size;       // Head + body bytes (LogQueue reads this first)
+    uint16_t formatId;
+    uint8_t level;
+    uint8_t reserved;
+    int64_t timestamp;   // Monotonic nanoseconds
+};
+
+// Token bucket and repeat tracking for one LOG_* call site
+struct Logger::SiteState {
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    uint8_t level = 0;
+    bool hasLast = false;
+    uint64_t lastHash = 0;     // Argument bytes of the last record written
+    double tokens = 0.0;
+    int64_t lastRefill = 0;    // 0 = bucket not filled yet
+    int64_t lastWritten = 0;   // Timestamp of the record that started the repeat run
+    uint64_t repeats = 0;      // Suppressed since the last summary
+    uint64_t rateLimited = 0;
+};
+
+namespace {
+
+constexpr size_t QUEUE_SLOTS = 16384;          // 1 MB of queued records
+constexpr size_t BATCH_WRITE_SIZE = 64 * 1024; // Hand the file this much at a time
+constexpr uint32_t WRITER_POLL_MS = 10;        // Max latency before a record is drained
+constexpr uint32_t SUPPRESSED_REPORT_MS = 5000; // Summarize suppressed records of quiet call sites
+constexpr int64_t SUPPRESSED_REPORT_NANOS = int64_t(SUPPRESSED_REPORT_MS) * 1000000;
+
+const char* REPEAT_FORMAT = "Last message repeated %llu times (%s)";
+const char* RATE_LIMIT_FORMAT = "%llu messages rate limited (%s)";
+
+int64_t NowMonotonicNanos() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t NowWallMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+void AppendPod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
 
 Logger& Logger::Instance() {
     static Logger instance;
     return instance;
 }
 
+Logger::Logger() {
+    m_wallBaseMicros = NowWallMicros();
+    m_monoBaseNanos = NowMonotonicNanos();
+
+    // Id 0 carries messages that were formatted at the call site
+    m_formats = std::make_unique<FormatEntry[]>(MAX_FORMATS);
+    m_formats[logfmt::PREFORMATTED_ID].format = logfmt::PREFORMATTED_FORMAT;
+    m_formats[logfmt::PREFORMATTED_ID].length = static_cast<uint32_t>(strlen(logfmt::PREFORMATTED_FORMAT));
+    m_formats[logfmt::PREFORMATTED_ID].argCount = 1;
+    m_formats[logfmt::PREFORMATTED_ID].kinds[0] = logfmt::ArgKind::String;
+    m_formatCount = 1;
+
+    m_sites = std::make_unique<SiteState[]>(MAX_FORMATS);
+    const logfmt::ArgKind summaryKinds[] = {logfmt::ArgKind::Int64, logfmt::ArgKind::String};
+    m_repeatFormatId = RegisterFormat(REPEAT_FORMAT, summaryKinds, 2);
+    m_rateLimitFormatId = RegisterFormat(RATE_LIMIT_FORMAT, summaryKinds, 2);
+    SetRateLimit(LogRateLimit());
+
+    m_queue = std::make_unique<LogQueue>(QUEUE_SLOTS);
+    m_running.store(true, std::memory_order_release);
+    m_writer = std::thread(&Logger::WriterLoop, this);
+}
+
 Logger::~Logger() {
+    Shutdown();
     if (m_file.is_open()) {
         m_file.close();
     }
+    m_segments.reset();
 }
 
-void Logger::SetLogFile(const std::string& path) {
+void Logger::SetLogFile(const std::string& path, LogFileFormat format) {
+    // Anything already queued belongs to the previous file
+    Flush();
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_segments.reset();
     if (m_file.is_open()) {
         m_file.close();
     }
-    m_file.open(path, std::ios::out | std::ios::app);
+    m_file.open(path, std::ios::out | std::ios::app | std::ios::binary);
+    m_fileFormat = format;
+    m_formatWritten.assign(MAX_FORMATS, false);
+
+    if (format == LogFileFormat::Binary && m_file.is_open()) {
+        std::string header;
+        AppendSessionHeader(header);
+        m_file.write(header.data(), header.size());
+    }
+}
+
+bool Logger::SetLogSegments(const LogSegmentConfig& config, LogFileFormat format) {
+    Flush();
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+
+    m_segments = std::make_unique<LogSegmentStore>();
+    uint32_t content = (format == LogFileFormat::Binary) ? logfmt::SEGMENT_CONTENT_BINARY : logfmt::SEGMENT_CONTENT_TEXT;
+    if (!m_segments->Open(config, content)) {
+        m_segments.reset();
+        return false;
+    }
+
+    m_fileFormat = format;
+    m_formatWritten.assign(MAX_FORMATS, false);
+    // Even a recovered segment needs a fresh session: format ids are per process
+    m_segmentSessionPending = true;
+    return true;
+}
+
+void Logger::SetClock(int64_t (*now)()) {
+    m_clock.store(now, std::memory_order_relaxed);
+}
+
+int64_t Logger::Now() const {
+    int64_t (*clock)() = m_clock.load(std::memory_order_relaxed);
+    return clock ? clock() : NowMonotonicNanos();
+}
+
+void Logger::SetFlushPolicy(const LogFlushPolicy& policy) {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_flushPolicy = policy;
+}
+
+void Logger::SetRateLimit(const LogRateLimit& limit) {
+    m_ratePerSecond.store(limit.perSecond, std::memory_order_relaxed);
+    m_rateBurst.store(limit.burst > 0 ? limit.burst : 1, std::memory_order_relaxed);
+    m_coalesceRepeats.store(limit.coalesceRepeats, std::memory_order_relaxed);
+}
+
+LogSuppressionStats Logger::GetSuppressionStats() const {
+    LogSuppressionStats stats;
+    stats.repeats = m_suppressedRepeats.load(std::memory_order_relaxed);
+    stats.rateLimited = m_suppressedRateLimited.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t Logger::GetSuppressedCount() const {
+    return m_suppressedRepeats.load(std::memory_order_relaxed) +
+           m_suppressedRateLimited.load(std::memory_order_relaxed);
+}
+
+void Logger::Flush() {
+    if (!m_running.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        FlushSink();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    uint64_t target = ++m_flushRequests;
+    m_wakePending = true;
+    m_wakeCv.notify_one();
+    m_flushedCv.wait(lock, [&] {
+        return m_flushesDone >= target || !m_running.load(std::memory_order_acquire);
+    });
+}
+
+void Logger::Shutdown() {
+    if (!m_running.exchange(false, std::memory_order_seq_cst)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakePending = true;
+    }
+    m_wakeCv.notify_one();
+
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    // Producers that saw m_running before it was cleared may still be
+    // pushing; once they're out, nothing else reaches the queue
+    while (m_producers.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    // Pick up records pushed while the writer was exiting. Anything logged
+    // after this point goes through the synchronous path in PushRecord.
+    std::string batch;
+    bool sawError = false;
+    DrainQueue(batch, sawError);
+    ReportSuppressed(batch);
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        FlushSink();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+    }
+    m_flushedCv.notify_all();
+}
+
+uint16_t Logger::RegisterFormat(const char* format, const logfmt::ArgKind* kinds, size_t count) {
+    FormatEntry entry;
+    entry.format = format;
+    entry.length = static_cast<uint32_t>(strlen(format));
+    entry.argCount = static_cast<uint8_t>(count);
+    std::memcpy(entry.kinds, kinds, count * sizeof(logfmt::ArgKind));
+
+    std::lock_guard<std::mutex> lock(m_formatMutex);
+    if (m_formatCount >= MAX_FORMATS) {
+        return logfmt::PREFORMATTED_ID;
+    }
+    // The id reaches the writer through the queue (release/acquire), so
+    // the entry is visible there before any record that uses it
+    m_formats[m_formatCount] = entry;
+    return static_cast<uint16_t>(m_formatCount++);
 }
 
 void Logger::Log(LogLevel level, const char* format, ...) {
-    if (level < m_minLevel) {
+    if (level < m_minLevel.load(std::memory_order_relaxed)) {
         return;
     }
 
-    char buffer[1024];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LogV(level, format, args);
     va_end(args);
-
-    WriteLog(level, buffer);
 }
 
 void Logger::Debug(const char* format, ...) {
-    if (LogLevel::Debug < m_minLevel) {
+    if (LogLevel::Debug < m_minLevel.load(std::memory_order_relaxed)) {
         return;
     }
 
-    char buffer[1024];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LogV(LogLevel::Debug, format, args);
     va_end(args);
-
-    WriteLog(LogLevel::Debug, buffer);
 }
 
 void Logger::Info(const char* format, ...) {
-    if (LogLevel::Info < m_minLevel) {
+    if (LogLevel::Info < m_minLevel.load(std::memory_order_relaxed)) {
         return;
     }
 
-    char buffer[1024];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LogV(LogLevel::Info, format, args);
     va_end(args);
-
-    WriteLog(LogLevel::Info, buffer);
 }
 
 void Logger::Warning(const char* format, ...) {
-    if (LogLevel::Warning < m_minLevel) {
+    if (LogLevel::Warning < m_minLevel.load(std::memory_order_relaxed)) {
         return;
     }
 
-    char buffer[1024];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LogV(LogLevel::Warning, format, args);
     va_end(args);
-
-    WriteLog(LogLevel::Warning, buffer);
 }
 
 void Logger::Error(const char* format, ...) {
-    char buffer[1024];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    LogV(LogLevel::Error, format, args);
     va_end(args);
+}
+
+void Logger::LogV(LogLevel level, const char* format, va_list args) {
+    // Body of a pre-formatted record: u32 length + text
+    const size_t prefix = sizeof(uint32_t);
+    const size_t maxText = m_queue->GetCapacityBytes() - sizeof(RecordHead) - prefix;
+
+    char stackBuffer[1024];
+    std::string heapBuffer;
+    char* body = stackBuffer;
 
-    WriteLog(LogLevel::Error, buffer);
+    va_list measureArgs;
+    va_copy(measureArgs, args);
+    int needed = vsnprintf(stackBuffer + prefix, sizeof(stackBuffer) - prefix, format, measureArgs);
+    va_end(measureArgs);
+    if (needed < 0) {
+        return;
+    }
+
+    size_t length = static_cast<size_t>(needed);
+    if (length >= sizeof(stackBuffer) - prefix) {
+        // Too long for the stack buffer: format again into the heap rather
+        // than truncating
+        length = (length < maxText) ? length : maxText;
+        heapBuffer.resize(prefix + length + 1);
+        body = &heapBuffer[0];
+        vsnprintf(body + prefix, length + 1, format, args);
+    }
+
+    uint32_t length32 = static_cast<uint32_t>(length);
+    std::memcpy(body, &length32, prefix);
+    PushRecord(level, logfmt::PREFORMATTED_ID, reinterpret_cast<const unsigned char*>(body), prefix + length,
+               Now());
 }
 
-void Logger::WriteLog(LogLevel level, const char* message) {
-    // Get current time
-    time_t now = time(nullptr);
-    struct tm timeinfo;
-    localtime_s(&timeinfo, &now);
+void Logger::PushCaptured(LogLevel level, uint16_t formatId, const char* format,
+                          const logfmt::ArgKind* kinds, size_t count,
+                          const unsigned char* body, size_t bodySize) {
+    int64_t timestamp = Now();
+    if (formatId != logfmt::PREFORMATTED_ID && !AdmitRecord(level, formatId, body, bodySize, timestamp)) {
+        return;
+    }
 
-    char timeStr[32];
-    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    if (formatId != logfmt::PREFORMATTED_ID &&
+        bodySize + sizeof(RecordHead) <= m_queue->GetCapacityBytes()) {
+        PushRecord(level, formatId, body, bodySize, timestamp);
+        return;
+    }
 
-    // Format log entry
-    char logEntry[1200];
-    snprintf(logEntry, sizeof(logEntry), "[%s] [%s] %s\n",
-             timeStr, GetLevelString(level), message);
+    // Format table full or the record can never fit in the queue: render
+    // here and send it as (clamped) text
+    const size_t prefix = sizeof(uint32_t);
+    const size_t maxText = m_queue->GetCapacityBytes() - sizeof(RecordHead) - prefix;
 
-    // Write to file
-    if (m_file.is_open()) {
-        m_file << logEntry;
+    std::string text(prefix, '\0');
+    if (!logfmt::RenderFormat(format, strlen(format), kinds, count, body, bodySize, text)) {
+        return;
+    }
+    if (text.size() - prefix > maxText) {
+        text.resize(prefix + maxText);
+    }
+    uint32_t length = static_cast<uint32_t>(text.size() - prefix);
+    std::memcpy(&text[0], &length, prefix);
+    PushRecord(level, logfmt::PREFORMATTED_ID, reinterpret_cast<const unsigned char*>(text.data()), text.size(),
+               timestamp);
+}
+
+bool Logger::AdmitRecord(LogLevel level, uint16_t formatId, const unsigned char* body, size_t bodySize,
+                         int64_t timestamp) {
+    bool coalesce = m_coalesceRepeats.load(std::memory_order_relaxed);
+    uint32_t perSecond = m_ratePerSecond.load(std::memory_order_relaxed);
+    if (!coalesce && perSecond == 0) {
+        return true;
+    }
+
+    uint64_t hash = coalesce ? HashBytes(body, bodySize) : 0;
+    uint64_t repeats = 0;
+    uint64_t rateLimited = 0;
+
+    SiteState& site = m_sites[formatId];
+    while (site.lock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    // A repeat run lasts as long as the sweep interval; an identical record
+    // after that is written again, as it would be after a sweep summary
+    bool admit = true;
+    if (coalesce && site.hasLast && site.lastHash == hash &&
+        timestamp - site.lastWritten < SUPPRESSED_REPORT_NANOS) {
+        ++site.repeats;
+        m_suppressedRepeats.fetch_add(1, std::memory_order_relaxed);
+        admit = false;
+    } else if (perSecond != 0) {
+        double burst = static_cast<double>(m_rateBurst.load(std::memory_order_relaxed));
+        if (site.lastRefill == 0) {
+            site.tokens = burst;
+        } else {
+            site.tokens += static_cast<double>(timestamp - site.lastRefill) * perSecond / 1e9;
+            site.tokens = site.tokens < burst ? site.tokens : burst;
+        }
+        site.lastRefill = timestamp;
+
+        if (site.tokens < 1.0) {
+            ++site.rateLimited;
+            m_suppressedRateLimited.fetch_add(1, std::memory_order_relaxed);
+            admit = false;
+        } else {
+            site.tokens -= 1.0;
+        }
+    }
+
+    if (admit) {
+        site.level = static_cast<uint8_t>(level);
+        site.hasLast = coalesce;
+        site.lastHash = hash;
+        site.lastWritten = timestamp;
+        repeats = site.repeats;
+        rateLimited = site.rateLimited;
+        site.repeats = 0;
+        site.rateLimited = 0;
+    }
+    site.lock.clear(std::memory_order_release);
+
+    // Summaries go right before the record that ended the run
+    if (repeats != 0) {
+        std::string summary = MakeSummaryBody(repeats, formatId);
+        PushRecord(level, m_repeatFormatId, reinterpret_cast<const unsigned char*>(summary.data()),
+                   summary.size(), timestamp);
+    }
+    if (rateLimited != 0) {
+        std::string summary = MakeSummaryBody(rateLimited, formatId);
+        PushRecord(level, m_rateLimitFormatId, reinterpret_cast<const unsigned char*>(summary.data()),
+                   summary.size(), timestamp);
+    }
+    return admit;
+}
+
+std::string Logger::MakeSummaryBody(uint64_t count, uint16_t formatId) const {
+    // Arguments of REPEAT_FORMAT / RATE_LIMIT_FORMAT: count, site format
+    std::string_view format(m_formats[formatId].format, m_formats[formatId].length);
+    std::string body(logfmt::ArgWriter<logfmt::ArgKind::Int64>::Size(count) +
+                     logfmt::ArgWriter<logfmt::ArgKind::String>::Size(format), '\0');
+    unsigned char* out = reinterpret_cast<unsigned char*>(&body[0]);
+    out = logfmt::ArgWriter<logfmt::ArgKind::Int64>::Put(out, count);
+    logfmt::ArgWriter<logfmt::ArgKind::String>::Put(out, format);
+    return body;
+}
+
+void Logger::PushRecord(LogLevel level, uint16_t formatId, const unsigned char* body, size_t bodySize,
+                        int64_t timestamp) {
+    RecordHead head;
+    head.size = static_cast<uint32_t>(sizeof(head) + bodySize);
+    head.formatId = formatId;
+    head.level = static_cast<uint8_t>(level);
+    head.reserved = 0;
+    head.timestamp = timestamp;
+
+    // Announce the push before checking m_running: Shutdown() clears the
+    // flag and then waits for this count to drop, so a record is either
+    // queued before its final drain or written inline here
+    m_producers.fetch_add(1, std::memory_order_seq_cst);
+
+    // Writer thread is gone (shutdown / static destruction): write inline
+    if (!m_running.load(std::memory_order_seq_cst)) {
+        m_producers.fetch_sub(1, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        std::string batch;
+        TimeCache cache;
+        WriteRecord(batch, cache, head, body);
+        if (!batch.empty() && m_file.is_open()) {
+            m_file.write(batch.data(), batch.size());
+        }
+        FlushSink();
+        return;
+    }
+
+    while (!m_queue->TryPush(&head, sizeof(head), body, bodySize)) {
+        if (m_overflow.load(std::memory_order_relaxed) == LogOverflow::Drop ||
+            !m_running.load(std::memory_order_acquire)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            m_producers.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        std::this_thread::yield();
+    }
+    m_producers.fetch_sub(1, std::memory_order_release);
+
+    // Errors skip the poll interval so they reach the disk promptly
+    if (level == LogLevel::Error) {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wakePending = true;
+        }
+        m_wakeCv.notify_one();
+    }
+}
+
+void Logger::WriterLoop() {
+    std::string batch;
+    batch.reserve(BATCH_WRITE_SIZE * 2);
+    auto lastFlush = std::chrono::steady_clock::now();
+    int64_t lastReport = Now();
+    size_t drained = 0;
+
+    for (;;) {
+        uint64_t flushTarget;
+        LogFlushPolicy policy;
+        {
+            // Only sleep once the queue ran dry; under load keep draining
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (drained == 0) {
+                m_wakeCv.wait_for(lock, std::chrono::milliseconds(WRITER_POLL_MS), [this] { return m_wakePending; });
+            }
+            m_wakePending = false;
+            flushTarget = m_flushRequests;
+            policy = m_flushPolicy;
+        }
+
+        // Read before draining so the final pass sees everything pushed
+        // before Shutdown() cleared the flag
+        bool running = m_running.load(std::memory_order_acquire);
+
+        bool sawError = false;
+        drained = DrainQueue(batch, sawError);
+
+        auto now = std::chrono::steady_clock::now();
+        bool intervalDue = policy.intervalMs != 0 &&
+            now - lastFlush >= std::chrono::milliseconds(policy.intervalMs);
+        bool flushRequested = flushTarget != m_flushesDone;
+
+        if (running && Now() - lastReport >= SUPPRESSED_REPORT_NANOS) {
+            ReportSuppressed(batch);
+            lastReport = Now();
+        }
+
+        if (flushRequested || intervalDue || !running || (sawError && policy.onError)) {
+            std::lock_guard<std::mutex> lock(m_fileMutex);
+            FlushSink();
+            lastFlush = now;
+        }
+
+        if (flushRequested) {
+            {
+                std::lock_guard<std::mutex> lock(m_wakeMutex);
+                m_flushesDone = flushTarget;
+            }
+            m_flushedCv.notify_all();
+        }
+
+        if (!running) {
+            break;
+        }
+    }
+}
+
+size_t Logger::DrainQueue(std::string& batch, bool& sawError) {
+    if (m_queue->IsEmpty()) {
+        return 0;
+    }
+
+    // Held for the whole drain so SetLogFile can't switch files (or the
+    // binary format table) between building a batch and writing it
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+
+    auto writeBatch = [&]() {
+        if (!batch.empty() && m_file.is_open()) {
+            m_file.write(batch.data(), batch.size());
+        }
+        batch.clear();
+    };
+
+    size_t count = m_queue->Drain([&](const unsigned char* data, size_t) {
+        RecordHead head;
+        std::memcpy(&head, data, sizeof(head));
+        if (head.level == static_cast<uint8_t>(LogLevel::Error)) {
+            sawError = true;
+        }
+
+        WriteRecord(batch, m_timeCache, head, data + sizeof(head));
+        if (batch.size() >= BATCH_WRITE_SIZE) {
+            writeBatch();
+        }
+    });
+
+    writeBatch();
+    return count;
+}
+
+void Logger::ReportSuppressed(std::string& batch) {
+    // Nothing new since the last report: skip the walk over every site
+    uint64_t total = GetSuppressedCount();
+    if (total == m_reportedSuppressed) {
+        return;
+    }
+    m_reportedSuppressed = total;
+
+    uint32_t siteCount;
+    {
+        std::lock_guard<std::mutex> lock(m_formatMutex);
+        siteCount = m_formatCount;
+    }
+
+    int64_t timestamp = Now();
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+
+    for (uint32_t id = 0; id < siteCount; ++id) {
+        SiteState& site = m_sites[id];
+        while (site.lock.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        uint8_t level = site.level;
+        uint64_t repeats = site.repeats;
+        uint64_t rateLimited = site.rateLimited;
+        site.repeats = 0;
+        site.rateLimited = 0;
+        // A repeat run ends with its summary; the next identical record
+        // is written in full and starts a new one
+        if (repeats != 0) {
+            site.hasLast = false;
+        }
+        site.lock.clear(std::memory_order_release);
+
+        const std::pair<uint16_t, uint64_t> summaries[] = {
+            {m_repeatFormatId, repeats},
+            {m_rateLimitFormatId, rateLimited},
+        };
+        for (const auto& summary : summaries) {
+            if (summary.second == 0) {
+                continue;
+            }
+            std::string body = MakeSummaryBody(summary.second, static_cast<uint16_t>(id));
+            RecordHead head;
+            head.size = static_cast<uint32_t>(sizeof(head) + body.size());
+            head.formatId = summary.first;
+            head.level = level;
+            head.reserved = 0;
+            head.timestamp = timestamp;
+            WriteRecord(batch, m_timeCache, head, reinterpret_cast<const unsigned char*>(body.data()));
+        }
+    }
+
+    if (!batch.empty() && m_file.is_open()) {
+        m_file.write(batch.data(), batch.size());
+    }
+    batch.clear();
+}
+
+void Logger::WriteRecord(std::string& batch, TimeCache& cache, const RecordHead& head, const unsigned char* body) {
+    if (m_segments) {
+        WriteSegmentRecord(cache, head, body);
+    } else {
+        AppendRecord(batch, cache, head, body);
+    }
+}
+
+void Logger::WriteSegmentRecord(TimeCache& cache, const RecordHead& head, const unsigned char* body) {
+    // Second pass runs in a fresh segment, which must repeat the session
+    // header and format definitions
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        m_recordScratch.clear();
+        if (m_fileFormat == LogFileFormat::Binary && m_segmentSessionPending) {
+            AppendSessionHeader(m_recordScratch);
+        }
+        AppendRecord(m_recordScratch, cache, head, body);
+
+        if (m_segments->Append(m_recordScratch.data(), m_recordScratch.size())) {
+            m_segmentSessionPending = false;
+            return;
+        }
+
+        if (m_segments->IsEmpty()) {
+            // Larger than a whole segment: keep what fits of a text line,
+            // a cut binary record would be unreadable
+            if (m_fileFormat == LogFileFormat::Text) {
+                m_recordScratch.resize(m_segments->GetCapacity() - 1);
+                m_recordScratch += '\n';
+                m_segments->Append(m_recordScratch.data(), m_recordScratch.size());
+            } else {
+                m_formatWritten[head.formatId] = false;
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        if (!m_segments->Rotate()) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_formatWritten.assign(MAX_FORMATS, false);
+        m_segmentSessionPending = true;
+    }
+}
+
+void Logger::FlushSink() {
+    if (m_segments) {
+        m_segments->Flush();
+    } else {
         m_file.flush();
     }
+}
+
+void Logger::AppendSessionHeader(std::string& out) {
+    logfmt::SessionHeader header;
+    std::memcpy(header.magic, logfmt::BLOG_MAGIC, sizeof(header.magic));
+    header.version = logfmt::BLOG_VERSION;
+    header.wallBaseMicros = m_wallBaseMicros;
+    header.monoBaseNanos = m_monoBaseNanos;
+    AppendPod(out, header);
+}
 
-    // Also output to debug console in debug builds
-#ifdef _DEBUG
-    OutputDebugStringA(logEntry);
+void Logger::AppendRecord(std::string& batch, TimeCache& cache, const RecordHead& head, const unsigned char* body) {
+    if (m_fileFormat == LogFileFormat::Binary) {
+        AppendBinary(batch, head, body);
+#if defined(_DEBUG) && defined(_WIN32)
+        std::string line;
+        AppendText(line, cache, head, body);
+        OutputDebugStringA(line.c_str());
 #endif
+        return;
+    }
+
+#if defined(_DEBUG) && defined(_WIN32)
+    size_t start = batch.size();
+    AppendText(batch, cache, head, body);
+    OutputDebugStringA(batch.c_str() + start);
+#else
+    AppendText(batch, cache, head, body);
+#endif
+}
+
+void Logger::AppendText(std::string& batch, TimeCache& cache, const RecordHead& head, const unsigned char* body) {
+    // Get record time (localtime_s/strftime only when the second changes)
+    int64_t wallMicros = m_wallBaseMicros + (head.timestamp - m_monoBaseNanos) / 1000;
+    int64_t second = wallMicros / 1000000;
+    if (second != cache.second) {
+        time_t t = static_cast<time_t>(second);
+        struct tm timeinfo;
+#ifdef _WIN32
+        localtime_s(&timeinfo, &t);
+#else
+        localtime_r(&t, &timeinfo);
+#endif
+        strftime(cache.text, sizeof(cache.text), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        cache.second = second;
+    }
+
+    // Format log entry: [time] [LEVEL] message
+    batch += '[';
+    batch += cache.text;
+    batch += "] [";
+    batch += logfmt::LevelName(head.level);
+    batch += "] ";
+
+    const FormatEntry& entry = m_formats[head.formatId];
+    size_t start = batch.size();
+    if (!logfmt::RenderFormat(entry.format, entry.length, entry.kinds, entry.argCount,
+                              body, head.size - sizeof(head), batch)) {
+        batch.resize(start);
+        batch += "<malformed log record>";
+    }
+    batch += '\n';
 }
 
-const char* Logger::GetLevelString(LogLevel level) {
-    switch (level) {
-        case LogLevel::Debug:   return "DEBUG";
-        case LogLevel::Info:    return "INFO";
-        case LogLevel::Warning: return "WARN";
-        case LogLevel::Error:   return "ERROR";
-        default:                return "UNKNOWN";
+void Logger::AppendBinary(std::string& batch, const RecordHead& head, const unsigned char* body) {
+    // Define the format the first time this file sees it
+    if (!m_formatWritten[head.formatId]) {
+        const FormatEntry& entry = m_formats[head.formatId];
+        AppendPod(batch, logfmt::TAG_FORMAT);
+        AppendPod(batch, head.formatId);
+        AppendPod(batch, entry.argCount);
+        batch.append(reinterpret_cast<const char*>(entry.kinds), entry.argCount);
+        AppendPod(batch, entry.length);
+        batch.append(entry.format, entry.length);
+        m_formatWritten[head.formatId] = true;
     }
+
+    uint32_t argBytes = head.size - static_cast<uint32_t>(sizeof(head));
+    AppendPod(batch, logfmt::TAG_RECORD);
+    AppendPod(batch, head.level);
+    AppendPod(batch, head.formatId);
+    AppendPod(batch, head.timestamp);
+    AppendPod(batch, argBytes);
+    batch.append(reinterpret_cast<const char*>(body), argBytes);
 }
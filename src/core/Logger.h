@@ -2,6 +2,25 @@
 
 #include <string>
 #include <fstream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstdarg>
+#include "LogFormat.h"
+#include "LogSegments.h"
+
+class LogQueue;
+
+// Calls below this level are compiled out of LOG_* entirely
+// (0 = Debug, 1 = Info, 2 = Warning, 3 = Error)
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 0
+#endif
 
 enum class LogLevel {
     Debug,
@@ -10,12 +29,83 @@ enum class LogLevel {
     Error
 };
 
+// What a producer does when the log queue is full
+enum class LogOverflow {
+    Drop,   // Discard the record and bump the dropped counter
+    Block   // Spin until the writer thread frees space
+};
+
+// On-disk representation of the log file
+enum class LogFileFormat {
+    Text,   // "[time] [LEVEL] message" lines
+    Binary  // .blog: format ids + raw arguments, rendered by LogDecoder
+};
+
+// Per-call-site throttling for LOG_* records, aimed at code that runs
+// every frame. Suppressed records are summarized in the log instead.
+struct LogRateLimit {
+    uint32_t perSecond = 20;       // Sustained records per second per call site, 0 = unlimited
+    uint32_t burst = 50;           // Records a call site may log back to back before limiting
+    bool coalesceRepeats = true;   // Drop records identical to the call site's previous one
+};
+
+struct LogSuppressionStats {
+    uint64_t repeats = 0;       // Identical to the previous record from the same call site
+    uint64_t rateLimited = 0;   // Over the call site's rate limit
+};
+
+// When the writer thread flushes the file (shutdown always flushes)
+struct LogFlushPolicy {
+    bool onError = true;          // Flush as soon as an Error record is written
+    uint32_t intervalMs = 1000;   // Periodic flush, 0 = only on Error/shutdown
+};
+
 class Logger {
 public:
     static Logger& Instance();
 
-    void SetLogFile(const std::string& path);
-    void SetMinLevel(LogLevel level) { m_minLevel = level; }
+    void SetLogFile(const std::string& path, LogFileFormat format = LogFileFormat::Text);
+
+    // Log into rotating memory-mapped segment files instead of one stream.
+    // Records are committed to the mapping one at a time, so a crash loses
+    // only what was still queued for the writer thread.
+    bool SetLogSegments(const LogSegmentConfig& config, LogFileFormat format = LogFileFormat::Text);
+    void SetMinLevel(LogLevel level) { m_minLevel.store(level, std::memory_order_relaxed); }
+    bool IsEnabled(LogLevel level) const { return level >= m_minLevel.load(std::memory_order_relaxed); }
+
+    void SetFlushPolicy(const LogFlushPolicy& policy);
+    void SetOverflowPolicy(LogOverflow policy) { m_overflow.store(policy, std::memory_order_relaxed); }
+    void SetRateLimit(const LogRateLimit& limit);
+
+    // Monotonic nanoseconds behind record timestamps, rate limits, repeat
+    // runs and the suppression sweep; nullptr restores steady_clock. Lets
+    // tests drive time.
+    void SetClock(int64_t (*now)());
+
+    // Block until every record logged before this call is on disk
+    void Flush();
+
+    // Drain the queue, flush and stop the writer thread
+    void Shutdown();
+
+    // Records discarded because the queue was full (LogOverflow::Drop)
+    uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // LOG_* records held back by SetRateLimit(); the plain Log()/Info()/...
+    // functions have no call site id and are never suppressed
+    LogSuppressionStats GetSuppressionStats() const;
+    uint64_t GetSuppressedCount() const;
+
+    // Called once per LOG_* call site; format must have static storage.
+    // The id also keys the site's rate limit state. Returns
+    // logfmt::PREFORMATTED_ID (not rate limited) once the table is full.
+    uint16_t RegisterFormat(const char* format, const logfmt::ArgKind* kinds, size_t count);
+
+    // LOG_* entry point. Format is a type whose Get() returns the call
+    // site's literal, so it can be checked against Args at compile time.
+    // The level must already have passed IsEnabled().
+    template <typename Format, typename... Args>
+    void Write(LogLevel level, const Args&... args);
 
     void Log(LogLevel level, const char* format, ...);
 
@@ -25,18 +115,163 @@ public:
     void Error(const char* format, ...);
 
 private:
-    Logger() = default;
+    Logger();
     ~Logger();
 
-    void WriteLog(LogLevel level, const char* message);
-    const char* GetLevelString(LogLevel level);
+    struct RecordHead;
+    struct SiteState;
+
+    int64_t Now() const;
+
+    // Producer side: format now (vsnprintf) or capture arguments, then hand
+    // the record to the writer thread
+    void LogV(LogLevel level, const char* format, va_list args);
+    void PushCaptured(LogLevel level, uint16_t formatId, const char* format,
+                      const logfmt::ArgKind* kinds, size_t count,
+                      const unsigned char* body, size_t bodySize);
+    void PushRecord(LogLevel level, uint16_t formatId, const unsigned char* body, size_t bodySize, int64_t timestamp);
 
+    // Rate limit / repeat check for a call site. Pushes the site's pending
+    // suppression summary ahead of an admitted record.
+    bool AdmitRecord(LogLevel level, uint16_t formatId, const unsigned char* body, size_t bodySize, int64_t timestamp);
+    std::string MakeSummaryBody(uint64_t count, uint16_t formatId) const;
+
+    template <typename Format, typename... Args, size_t... I>
+    void Capture(LogLevel level, uint16_t formatId, std::index_sequence<I...>, const Args&... args);
+
+    // Writer thread
+    void WriterLoop();
+    size_t DrainQueue(std::string& batch, bool& sawError);
+    void ReportSuppressed(std::string& batch);
+
+    // strftime result reused while records stay within the same second
+    struct TimeCache {
+        int64_t second = -1;
+        char text[32] = {};
+    };
+    // Caller holds m_fileMutex. Segments get the record immediately; the
+    // stream sink gets it via batch.
+    void WriteRecord(std::string& batch, TimeCache& cache, const RecordHead& head, const unsigned char* body);
+    void WriteSegmentRecord(TimeCache& cache, const RecordHead& head, const unsigned char* body);
+    void FlushSink();
+
+    void AppendRecord(std::string& batch, TimeCache& cache, const RecordHead& head, const unsigned char* body);
+    void AppendSessionHeader(std::string& out);
+    void AppendText(std::string& batch, TimeCache& cache, const RecordHead& head, const unsigned char* body);
+    void AppendBinary(std::string& batch, const RecordHead& head, const unsigned char* body);
+
+    struct FormatEntry {
+        const char* format = nullptr;
+        uint32_t length = 0;
+        uint8_t argCount = 0;
+        logfmt::ArgKind kinds[logfmt::MAX_ARGS] = {};
+    };
+    static constexpr size_t MAX_FORMATS = 4096;
+
+    // Registered call-site formats; entries never change once published
+    std::unique_ptr<FormatEntry[]> m_formats;
+    uint32_t m_formatCount = 0;
+    std::mutex m_formatMutex;
+
+    // Suppression state per call site, indexed by format id
+    std::unique_ptr<SiteState[]> m_sites;
+    uint16_t m_repeatFormatId = 0;
+    uint16_t m_rateLimitFormatId = 0;
+    std::atomic<uint32_t> m_ratePerSecond{0};
+    std::atomic<uint32_t> m_rateBurst{0};
+    std::atomic<bool> m_coalesceRepeats{false};
+    std::atomic<uint64_t> m_suppressedRepeats{0};
+    std::atomic<uint64_t> m_suppressedRateLimited{0};
+    std::atomic<int64_t (*)()> m_clock{nullptr};
+    uint64_t m_reportedSuppressed = 0;  // Writer thread only
+
+    // Maps monotonic record timestamps back to wall-clock time
+    int64_t m_wallBaseMicros = 0;
+    int64_t m_monoBaseNanos = 0;
+
+    // Guarded by m_fileMutex
     std::ofstream m_file;
-    LogLevel m_minLevel = LogLevel::Info;
+    LogFileFormat m_fileFormat = LogFileFormat::Text;
+    std::vector<bool> m_formatWritten;  // Binary: format definitions already in this file
+    std::unique_ptr<LogSegmentStore> m_segments;
+    bool m_segmentSessionPending = false;  // Binary: segment needs a session header first
+    std::string m_recordScratch;
+    std::mutex m_fileMutex;
+    std::atomic<LogLevel> m_minLevel{LogLevel::Info};
+
+    std::unique_ptr<LogQueue> m_queue;
+    std::thread m_writer;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint32_t> m_producers{0};  // Threads inside PushRecord's queued path
+    std::atomic<LogOverflow> m_overflow{LogOverflow::Drop};
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Writer wake-up and Flush() handshake
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    std::condition_variable m_flushedCv;
+    uint64_t m_flushRequests = 0;
+    uint64_t m_flushesDone = 0;
+    bool m_wakePending = false;
+    LogFlushPolicy m_flushPolicy;
+    TimeCache m_timeCache;  // Writer thread only
 };
 
+// Compiled argument kinds for one call site's format
+template <typename Format, typename... Args>
+struct LogCallSite {
+    static constexpr auto compiled = logfmt::CompileFormat<Args...>(Format::Get());
+};
+
+template <typename Format, typename... Args>
+void Logger::Write(LogLevel level, const Args&... args) {
+    using Site = LogCallSite<Format, Args...>;
+    static_assert(sizeof...(Args) <= logfmt::MAX_ARGS, "Too many LOG_* arguments");
+    static_assert(Site::compiled.ok, "LOG_* format string does not match its arguments");
+
+    static const uint16_t formatId = RegisterFormat(Format::Get(), Site::compiled.kinds, sizeof...(Args));
+    Capture<Format>(level, formatId, std::index_sequence_for<Args...>{}, args...);
+}
+
+template <typename Format, typename... Args, size_t... I>
+void Logger::Capture(LogLevel level, uint16_t formatId, std::index_sequence<I...>, const Args&... args) {
+    using Site = LogCallSite<Format, Args...>;
+    constexpr size_t INLINE_BYTES = 256;
+
+    size_t bodySize = (size_t(0) + ... + logfmt::ArgWriter<Site::compiled.kinds[I]>::Size(args));
+
+    unsigned char stackBody[INLINE_BYTES];
+    std::unique_ptr<unsigned char[]> heapBody;
+    unsigned char* body = stackBody;
+    if (bodySize > INLINE_BYTES) {
+        heapBody.reset(new unsigned char[bodySize]);
+        body = heapBody.get();
+    }
+
+    unsigned char* out = body;
+    ((out = logfmt::ArgWriter<Site::compiled.kinds[I]>::Put(out, args)), ...);
+    (void)out;
+
+    PushCaptured(level, formatId, Format::Get(), Site::compiled.kinds, sizeof...(Args), body, bodySize);
+}
+
+#define LOGGER_LEVEL_ENABLED(level) (static_cast<int>(level) >= LOGGER_MIN_LEVEL)
+
+// Levels below LOGGER_MIN_LEVEL compile to nothing (arguments are not
+// evaluated); the rest cost one relaxed load when disabled at runtime.
+// The format must be a string literal.
+#define LOGGER_CALL(level, format, ...) \
+    do { \
+        if constexpr (LOGGER_LEVEL_ENABLED(level)) { \
+            if (Logger::Instance().IsEnabled(level)) { \
+                struct LoggerFormat { static constexpr const char* Get() { return format; } }; \
+                Logger::Instance().Write<LoggerFormat>(level, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
 // Convenience macros
-#define LOG_DEBUG(...) Logger::Instance().Debug(__VA_ARGS__)
-#define LOG_INFO(...) Logger::Instance().Info(__VA_ARGS__)
-#define LOG_WARNING(...) Logger::Instance().Warning(__VA_ARGS__)
-#define LOG_ERROR(...) Logger::Instance().Error(__VA_ARGS__)
+#define LOG_DEBUG(format, ...) LOGGER_CALL(LogLevel::Debug, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOGGER_CALL(LogLevel::Info, format, ##__VA_ARGS__)
+#define LOG_WARNING(format, ...) LOGGER_CALL(LogLevel::Warning, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOGGER_CALL(LogLevel::Error, format, ##__VA_ARGS__)
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Fails for missing or empty files
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return m_view != nullptr; }
+    const unsigned char* GetData() const { return m_view; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    void* m_file = nullptr;      // HANDLE
+    void* m_mapping = nullptr;   // HANDLE
+    const unsigned char* m_view = nullptr;
+    size_t m_size = 0;
+};
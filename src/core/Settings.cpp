@@ -0,0 +1,124 @@
+#include "Settings.h"
+#include <cstring>
+
+namespace {
+
+bool InRange(const SettingRule& rule, double value) {
+    return value >= rule.min && value <= rule.max;
+}
+
+} // namespace
+
+ConfigSnapshot::ConfigSnapshot() {
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        const SettingInfo& info = SETTING_INFO[i];
+        SettingSlot& slot = m_slots[i];
+        switch (info.type) {
+            case SettingType::Bool:
+                slot.boolValue = info.defaultBool;
+                break;
+            case SettingType::Int:
+                slot.intValue = info.defaultInt;
+                break;
+            case SettingType::Float:
+                slot.floatValue = info.defaultFloat;
+                break;
+            case SettingType::String:
+                slot.stringOffset = static_cast<uint32_t>(m_strings.size());
+                slot.stringLength = static_cast<uint32_t>(strlen(info.defaultString));
+                m_strings += info.defaultString;
+                break;
+        }
+    }
+}
+
+std::string_view ConfigSnapshot::GetString(SettingId id) const {
+    const SettingSlot& slot = Slot(id);
+    return std::string_view(m_strings.data() + slot.stringOffset, slot.stringLength);
+}
+
+bool ConfigSnapshot::SetBool(SettingId id, bool value) {
+    Slot(id).boolValue = value;
+    return true;
+}
+
+bool ConfigSnapshot::SetInt(SettingId id, int32_t value) {
+    if (!InRange(GetSettingInfo(id).rule, value)) {
+        return false;
+    }
+    Slot(id).intValue = value;
+    return true;
+}
+
+bool ConfigSnapshot::SetFloat(SettingId id, float value) {
+    if (!InRange(GetSettingInfo(id).rule, value)) {
+        return false;
+    }
+    Slot(id).floatValue = value;
+    return true;
+}
+
+bool ConfigSnapshot::SetString(SettingId id, std::string_view value) {
+    if (GetSettingInfo(id).rule.nonEmpty && value.empty()) {
+        return false;
+    }
+
+    // Append, and repack once replaced values outweigh live ones, so
+    // setting n strings stays linear
+    SettingSlot& slot = Slot(id);
+    m_staleBytes += slot.stringLength;
+    if (m_staleBytes <= m_strings.size() / 2) {
+        // value may point into m_strings; append() copes with that
+        slot.stringOffset = static_cast<uint32_t>(m_strings.size());
+        slot.stringLength = static_cast<uint32_t>(value.size());
+        m_strings.append(value.data(), value.size());
+        return true;
+    }
+
+    std::string strings;
+    strings.reserve(m_strings.size() - m_staleBytes + value.size());
+    for (size_t i = 0; i < SETTING_COUNT; ++i) {
+        if (SETTING_INFO[i].type != SettingType::String) {
+            continue;
+        }
+        SettingId current = static_cast<SettingId>(i);
+        std::string_view text = (current == id) ? value : GetString(current);
+        m_slots[i].stringOffset = static_cast<uint32_t>(strings.size());
+        m_slots[i].stringLength = static_cast<uint32_t>(text.size());
+        strings.append(text.data(), text.size());
+    }
+    m_strings = std::move(strings);
+    m_staleBytes = 0;
+    return true;
+}
+
+bool ConfigSnapshot::Equals(SettingId id, const ConfigSnapshot& other) const {
+    switch (GetSettingInfo(id).type) {
+        case SettingType::Bool:
+            return GetBool(id) == other.GetBool(id);
+        case SettingType::Int:
+            return GetInt(id) == other.GetInt(id);
+        case SettingType::Float:
+            return GetFloat(id) == other.GetFloat(id);
+        case SettingType::String:
+            return GetString(id) == other.GetString(id);
+    }
+    return false;
+}
+
+void ConfigSnapshot::CopyFrom(SettingId id, const ConfigSnapshot& other) {
+    switch (GetSettingInfo(id).type) {
+        case SettingType::Bool:
+            SetBool(id, other.GetBool(id));
+            break;
+        case SettingType::Int:
+            SetInt(id, other.GetInt(id));
+            break;
+        case SettingType::Float:
+            SetFloat(id, other.GetFloat(id));
+            break;
+        case SettingType::String:
+            SetString(id, other.GetString(id));
+            break;
+    }
+}
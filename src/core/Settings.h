@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Every persisted setting, declared once:
+//   X(name, type, "json.path", default, rule)
+// type is bool, int32_t, float or std::string. Config::Load/Save walk this
+// table, and settings::<name> is the typed handle used to read and write it.
+#define CONFIG_SETTINGS(X) \
+    X(ApiBaseUrl,            std::string, "api.baseUrl",              "https://api.example.com/v1", NonEmpty())      \
+    X(Language,              std::string, "ui.language",              "zh-CN",                      NonEmpty())      \
+    X(UiScale,               float,       "ui.scale",                 1.0f,                         Range(0.5, 3.0)) \
+    X(LoginVideoPath,        std::string, "video.loginBackground",    "assets/videos/login_bg.mp4", Any())           \
+    X(CheckUpdatesOnStartup, bool,        "updates.checkOnStartup",   true,                         Any())           \
+    X(ProductsVersion,       int32_t,     "products.selectedVersion", 0,                            Range(0, 3))     \
+    X(ProductsRegion,        int32_t,     "products.selectedRegion",  0,                            Range(0, 1))     /* 0 = CN, 1 = International */ \
+    X(TextureAtlasEnabled,   bool,        "graphics.textureAtlas",    true,                         Any())           \
+    X(TextureBudgetMB,       int32_t,     "graphics.textureBudgetMB", 256,                          Range(16, 4096))
+
+enum class SettingId : uint16_t {
+#define SETTING_ID(name, type, key, value, rule) name,
+    CONFIG_SETTINGS(SETTING_ID)
+#undef SETTING_ID
+    Count
+};
+
+constexpr size_t SETTING_COUNT = static_cast<size_t>(SettingId::Count);
+
+enum class SettingType : uint8_t {
+    Bool,
+    Int,
+    Float,
+    String
+};
+
+// Validation applied on Set and on load; a rejected value leaves the
+// previous one in place
+struct SettingRule {
+    double min;
+    double max;
+    bool nonEmpty;
+};
+
+constexpr SettingRule Any() { return {-1e300, 1e300, false}; }
+constexpr SettingRule NonEmpty() { return {-1e300, 1e300, true}; }
+constexpr SettingRule Range(double min, double max) { return {min, max, false}; }
+
+struct SettingInfo {
+    const char* key;
+    SettingType type;
+    bool defaultBool;
+    int32_t defaultInt;
+    float defaultFloat;
+    const char* defaultString;
+    SettingRule rule;
+};
+
+template <typename T>
+struct SettingTraits;
+
+template <> struct SettingTraits<bool> {
+    static constexpr SettingType type = SettingType::Bool;
+    using Read = bool;
+};
+template <> struct SettingTraits<int32_t> {
+    static constexpr SettingType type = SettingType::Int;
+    using Read = int32_t;
+};
+template <> struct SettingTraits<float> {
+    static constexpr SettingType type = SettingType::Float;
+    using Read = float;
+};
+template <> struct SettingTraits<std::string> {
+    static constexpr SettingType type = SettingType::String;
+    using Read = std::string_view;
+};
+
+template <typename T, typename D>
+constexpr SettingInfo MakeSettingInfo(const char* key, D value, SettingRule rule) {
+    SettingInfo info = {key, SettingTraits<T>::type, false, 0, 0.0f, "", rule};
+    if constexpr (std::is_same_v<T, bool>) {
+        info.defaultBool = value;
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        info.defaultInt = value;
+    } else if constexpr (std::is_same_v<T, float>) {
+        info.defaultFloat = value;
+    } else {
+        info.defaultString = value;
+    }
+    return info;
+}
+
+inline constexpr SettingInfo SETTING_INFO[] = {
+#define SETTING_INFO_ENTRY(name, type, key, value, rule) MakeSettingInfo<type>(key, value, rule),
+    CONFIG_SETTINGS(SETTING_INFO_ENTRY)
+#undef SETTING_INFO_ENTRY
+};
+
+inline const SettingInfo& GetSettingInfo(SettingId id) {
+    return SETTING_INFO[static_cast<size_t>(id)];
+}
+
+// Typed handle; T picks the accessor so a mismatched read doesn't compile
+template <typename T>
+struct SettingKey {
+    SettingId id;
+};
+
+namespace settings {
+#define SETTING_KEY(name, type, key, value, rule) inline constexpr SettingKey<type> name{SettingId::name};
+    CONFIG_SETTINGS(SETTING_KEY)
+#undef SETTING_KEY
+}
+
+// One immutable set of setting values in a flat table. String values share
+// a single buffer, so reading any setting is an index and never allocates.
+class ConfigSnapshot {
+public:
+    ConfigSnapshot();
+
+    template <typename T>
+    typename SettingTraits<T>::Read Get(SettingKey<T> key) const;
+
+    // Untyped access for the JSON and change-detection code
+    bool GetBool(SettingId id) const { return Slot(id).boolValue; }
+    int32_t GetInt(SettingId id) const { return Slot(id).intValue; }
+    float GetFloat(SettingId id) const { return Slot(id).floatValue; }
+    std::string_view GetString(SettingId id) const;
+
+    // Return false (changing nothing) if the rule rejects the value
+    bool SetBool(SettingId id, bool value);
+    bool SetInt(SettingId id, int32_t value);
+    bool SetFloat(SettingId id, float value);
+    bool SetString(SettingId id, std::string_view value);
+
+    bool Equals(SettingId id, const ConfigSnapshot& other) const;
+
+    // Take other's value for one setting
+    void CopyFrom(SettingId id, const ConfigSnapshot& other);
+
+private:
+    struct SettingSlot {
+        union {
+            bool boolValue = false;
+            int32_t intValue;
+            float floatValue;
+        };
+        uint32_t stringOffset = 0;
+        uint32_t stringLength = 0;
+    };
+
+    const SettingSlot& Slot(SettingId id) const { return m_slots[static_cast<size_t>(id)]; }
+    SettingSlot& Slot(SettingId id) { return m_slots[static_cast<size_t>(id)]; }
+
+    SettingSlot m_slots[SETTING_COUNT];
+    std::string m_strings;       // Every string value back to back
+    size_t m_staleBytes = 0;     // Replaced values still in m_strings
+};
+
+template <typename T>
+typename SettingTraits<T>::Read ConfigSnapshot::Get(SettingKey<T> key) const {
+    if constexpr (std::is_same_v<T, bool>) {
+        return GetBool(key.id);
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        return GetInt(key.id);
+    } else if constexpr (std::is_same_v<T, float>) {
+        return GetFloat(key.id);
+    } else {
+        return GetString(key.id);
+    }
+}
@@ -0,0 +1,114 @@
+#include "AtlasPacker.h"
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+bool Contains(const AtlasRect& outer, const AtlasRect& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width &&
+           inner.y + inner.height <= outer.y + outer.height;
+}
+
+bool Overlaps(const AtlasRect& a, const AtlasRect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+           a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+} // namespace
+
+AtlasPacker::AtlasPacker(int width, int height)
+    : m_width(width), m_height(height) {
+    Reset();
+}
+
+void AtlasPacker::Reset() {
+    m_free.clear();
+    m_free.push_back(AtlasRect{0, 0, m_width, m_height});
+    m_usedArea = 0;
+}
+
+bool AtlasPacker::Insert(int width, int height, AtlasRect& out) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // Best short side fit, ties to best long side fit
+    const AtlasRect* best = nullptr;
+    int bestShort = INT_MAX;
+    int bestLong = INT_MAX;
+    for (const AtlasRect& free : m_free) {
+        if (free.width < width || free.height < height) {
+            continue;
+        }
+        int leftoverX = free.width - width;
+        int leftoverY = free.height - height;
+        int shortSide = std::min(leftoverX, leftoverY);
+        int longSide = std::max(leftoverX, leftoverY);
+        if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+            best = &free;
+            bestShort = shortSide;
+            bestLong = longSide;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+
+    out = AtlasRect{best->x, best->y, width, height};
+    SplitFreeRects(out);
+    PruneFreeRects();
+    m_usedArea += uint64_t(width) * height;
+    return true;
+}
+
+void AtlasPacker::Remove(const AtlasRect& rect) {
+    m_free.push_back(rect);
+    PruneFreeRects();
+    m_usedArea -= uint64_t(rect.width) * rect.height;
+}
+
+void AtlasPacker::SplitFreeRects(const AtlasRect& used) {
+    m_split.clear();
+    for (const AtlasRect& free : m_free) {
+        if (!Overlaps(free, used)) {
+            m_split.push_back(free);
+            continue;
+        }
+
+        // Up to four maximal pieces: the bands left, right, above and below used
+        if (used.x > free.x) {
+            m_split.push_back(AtlasRect{free.x, free.y, used.x - free.x, free.height});
+        }
+        if (used.x + used.width < free.x + free.width) {
+            int x = used.x + used.width;
+            m_split.push_back(AtlasRect{x, free.y, free.x + free.width - x, free.height});
+        }
+        if (used.y > free.y) {
+            m_split.push_back(AtlasRect{free.x, free.y, free.width, used.y - free.y});
+        }
+        if (used.y + used.height < free.y + free.height) {
+            int y = used.y + used.height;
+            m_split.push_back(AtlasRect{free.x, y, free.width, free.y + free.height - y});
+        }
+    }
+    m_free.swap(m_split);
+}
+
+void AtlasPacker::PruneFreeRects() {
+    for (size_t i = 0; i < m_free.size(); ++i) {
+        for (size_t j = i + 1; j < m_free.size();) {
+            if (Contains(m_free[i], m_free[j])) {
+                m_free[j] = m_free.back();
+                m_free.pop_back();
+            } else if (Contains(m_free[j], m_free[i])) {
+                m_free[i] = m_free[j];
+                m_free[j] = m_free.back();
+                m_free.pop_back();
+                j = i + 1;   // m_free[i] changed; recheck everything after it
+            } else {
+                ++j;
+            }
+        }
+    }
+}
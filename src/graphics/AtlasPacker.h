@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct AtlasRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// MaxRects bin packer: keeps every maximal free rectangle of the bin and
+// places each new rectangle in the free one it fits most tightly (best
+// short side fit). Packs mixed sizes far denser than shelves, and takes
+// rectangles back for reuse. No pixels; TextureAtlas owns those.
+class AtlasPacker {
+public:
+    AtlasPacker(int width, int height);
+
+    // Place a width x height rectangle; false if no free space fits it
+    bool Insert(int width, int height, AtlasRect& out);
+
+    // Return a rectangle from Insert() to the free space. Free space split
+    // by removals isn't merged back together; Reset() and reinsert the
+    // live rectangles to defragment.
+    void Remove(const AtlasRect& rect);
+
+    // Empty the bin
+    void Reset();
+
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    uint64_t GetUsedArea() const { return m_usedArea; }
+    uint64_t GetFreeArea() const { return uint64_t(m_width) * m_height - m_usedArea; }
+
+private:
+    // Split every free rectangle overlapping used into the parts outside it
+    void SplitFreeRects(const AtlasRect& used);
+    // Drop free rectangles contained in another
+    void PruneFreeRects();
+
+    int m_width;
+    int m_height;
+    uint64_t m_usedArea = 0;
+    std::vector<AtlasRect> m_free;
+    std::vector<AtlasRect> m_split;   // Scratch for SplitFreeRects()
+};
@@ -0,0 +1,499 @@
+#include "BlockCompress.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int BLOCK_PIXELS = 16;
+constexpr uint8_t TRANSPARENT_BELOW = 128;      // BC1 alpha threshold
+constexpr int POWER_ITERATIONS = 8;
+
+// BC7 4-bit index weights, out of 64
+constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+constexpr uint8_t BC7_MODE6 = 1 << 6;
+
+// End points of the line through the included pixels' first `channels`
+// channels that best fits them: the principal axis, by power iteration
+// from the bounding box diagonal, cut at the extreme projections
+void FitLine(const uint8_t block[64], int channels, const bool* include, float lo[4], float hi[4]) {
+    float mean[4] = {};
+    float minimum[4] = { 255, 255, 255, 255 };
+    float maximum[4] = {};
+    int count = 0;
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        if (include && !include[i]) {
+            continue;
+        }
+        for (int c = 0; c < channels; ++c) {
+            float v = block[i * 4 + c];
+            mean[c] += v;
+            minimum[c] = std::min(minimum[c], v);
+            maximum[c] = std::max(maximum[c], v);
+        }
+        ++count;
+    }
+    if (count == 0) {
+        std::fill(lo, lo + 4, 0.0f);
+        std::fill(hi, hi + 4, 0.0f);
+        return;
+    }
+    for (int c = 0; c < channels; ++c) {
+        mean[c] /= count;
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        if (include && !include[i]) {
+            continue;
+        }
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                covariance[a][b] += (block[i * 4 + a] - mean[a]) * (block[i * 4 + b] - mean[b]);
+            }
+        }
+    }
+
+    float axis[4] = {};
+    for (int c = 0; c < channels; ++c) {
+        axis[c] = maximum[c] - minimum[c];
+    }
+    for (int iteration = 0; iteration < POWER_ITERATIONS; ++iteration) {
+        float next[4] = {};
+        float largest = 0.0f;
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            largest = std::max(largest, std::fabs(next[a]));
+        }
+        if (largest == 0.0f) {
+            break;
+        }
+        for (int c = 0; c < channels; ++c) {
+            axis[c] = next[c] / largest;
+        }
+    }
+
+    float length = 0.0f;
+    for (int c = 0; c < channels; ++c) {
+        length += axis[c] * axis[c];
+    }
+    if (length == 0.0f) {
+        std::copy(mean, mean + 4, lo);
+        std::copy(mean, mean + 4, hi);
+        return;
+    }
+
+    float tMin = 0.0f, tMax = 0.0f;
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        if (include && !include[i]) {
+            continue;
+        }
+        float t = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            t += (block[i * 4 + c] - mean[c]) * axis[c];
+        }
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < 4; ++c) {
+        float a = c < channels ? axis[c] / length : 0.0f;
+        lo[c] = std::clamp(mean[c] + a * tMin, 0.0f, 255.0f);
+        hi[c] = std::clamp(mean[c] + a * tMax, 0.0f, 255.0f);
+    }
+}
+
+int Distance(const uint8_t* pixel, const int* color, int channels) {
+    int sum = 0;
+    for (int c = 0; c < channels; ++c) {
+        int d = pixel[c] - color[c];
+        sum += d * d;
+    }
+    return sum;
+}
+
+uint16_t To565(const float color[4]) {
+    int r = std::clamp(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = std::clamp(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = std::clamp(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void From565(uint16_t value, int color[4]) {
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+    color[3] = 255;
+}
+
+// Four colors (or three and transparent) the BC1 color block decodes to.
+// BC3 color blocks are always the four-color kind.
+int ColorPalette(uint16_t c0, uint16_t c1, bool alwaysFourColors, int palette[4][4]) {
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+    if (c0 > c1 || alwaysFourColors) {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        palette[2][3] = palette[3][3] = 255;
+        return 4;
+    }
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        palette[3][c] = 0;
+    }
+    palette[2][3] = 255;
+    palette[3][3] = 0;
+    return 3;
+}
+
+void EncodeColorBlock(const uint8_t block[64], bool bc1, uint8_t out[8]) {
+    bool include[BLOCK_PIXELS];
+    bool transparent = false;
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        include[i] = !bc1 || block[i * 4 + 3] >= TRANSPARENT_BELOW;
+        transparent |= !include[i];
+    }
+
+    float lo[4], hi[4];
+    FitLine(block, 3, include, lo, hi);
+    uint16_t c0 = To565(hi);
+    uint16_t c1 = To565(lo);
+
+    // BC1 picks its mode from the end point order: c0 > c1 for four
+    // colors, c0 <= c1 for three plus transparent
+    if (transparent ? c0 > c1 : c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    int palette[4][4];
+    int colors = ColorPalette(c0, c1, !bc1, palette);
+    uint32_t indices = 0;
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        int best = 3;
+        if (include[i]) {
+            int bestDistance = INT32_MAX;
+            for (int p = 0; p < colors; ++p) {
+                int distance = Distance(block + i * 4, palette[p], 3);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+        }
+        indices |= uint32_t(best) << (i * 2);
+    }
+
+    out[0] = static_cast<uint8_t>(c0);
+    out[1] = static_cast<uint8_t>(c0 >> 8);
+    out[2] = static_cast<uint8_t>(c1);
+    out[3] = static_cast<uint8_t>(c1 >> 8);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+void DecodeColorBlock(const uint8_t in[8], bool bc1, uint8_t block[64]) {
+    uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    uint16_t c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+    uint32_t indices;
+    std::memcpy(&indices, in + 4, 4);
+
+    int palette[4][4];
+    ColorPalette(c0, c1, !bc1, palette);
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        const int* color = palette[(indices >> (i * 2)) & 3];
+        for (int c = 0; c < 4; ++c) {
+            block[i * 4 + c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+// Eight alphas from a0 > a1; a0 == a1 decodes index 0 as a0 either way
+void AlphaPalette(int a0, int a1, int palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int k = 1; k <= 6; ++k) {
+            palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+        }
+    } else {
+        for (int k = 1; k <= 4; ++k) {
+            palette[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void EncodeAlphaBlock(const uint8_t block[64], uint8_t out[8]) {
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        a0 = std::max<int>(a0, block[i * 4 + 3]);
+        a1 = std::min<int>(a1, block[i * 4 + 3]);
+    }
+
+    int palette[8];
+    AlphaPalette(a0, a1, palette);
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        for (int i = 0; i < BLOCK_PIXELS; ++i) {
+            int alpha = block[i * 4 + 3];
+            int best = 0;
+            for (int p = 1; p < 8; ++p) {
+                if (std::abs(palette[p] - alpha) < std::abs(palette[best] - alpha)) {
+                    best = p;
+                }
+            }
+            indices |= uint64_t(best) << (i * 3);
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(a0);
+    out[1] = static_cast<uint8_t>(a1);
+    for (int b = 0; b < 6; ++b) {
+        out[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+    }
+}
+
+void DecodeAlphaBlock(const uint8_t in[8], uint8_t block[64]) {
+    int palette[8];
+    AlphaPalette(in[0], in[1], palette);
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; ++b) {
+        indices |= uint64_t(in[2 + b]) << (b * 8);
+    }
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        block[i * 4 + 3] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+    }
+}
+
+// 128-bit little-endian bit stream, as BC7 blocks are laid out
+struct BitWriter {
+    uint8_t* out;
+    int position = 0;
+
+    void Write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position) {
+            if (value & (1u << i)) {
+                out[position >> 3] |= uint8_t(1u << (position & 7));
+            }
+        }
+    }
+};
+
+struct BitReader {
+    const uint8_t* in;
+    int position = 0;
+
+    uint32_t Read(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; ++i, ++position) {
+            value |= uint32_t((in[position >> 3] >> (position & 7)) & 1) << i;
+        }
+        return value;
+    }
+};
+
+// 7 bits per channel plus a p-bit shared by the end point's channels,
+// whichever p-bit lands closer
+int QuantizeBC7Endpoint(const float color[4], int quantized[4]) {
+    int bestP = 0;
+    float bestError = -1.0f;
+    for (int p = 0; p < 2; ++p) {
+        int q[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            q[c] = std::clamp(static_cast<int>((color[c] - p) / 2.0f + 0.5f), 0, 127);
+            float d = float((q[c] << 1) | p) - color[c];
+            error += d * d;
+        }
+        if (bestError < 0.0f || error < bestError) {
+            bestError = error;
+            bestP = p;
+            std::copy(q, q + 4, quantized);
+        }
+    }
+    return bestP;
+}
+
+void BC7Palette(const int e0[4], const int e1[4], int palette[16][4]) {
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            palette[i][c] = ((64 - BC7_WEIGHTS[i]) * e0[c] + BC7_WEIGHTS[i] * e1[c] + 32) >> 6;
+        }
+    }
+}
+
+void EncodeBC7Block(const uint8_t block[64], uint8_t out[16]) {
+    float lo[4], hi[4];
+    FitLine(block, 4, nullptr, lo, hi);
+
+    int q0[4], q1[4];
+    int p0 = QuantizeBC7Endpoint(lo, q0);
+    int p1 = QuantizeBC7Endpoint(hi, q1);
+    int e0[4], e1[4];
+    for (int c = 0; c < 4; ++c) {
+        e0[c] = (q0[c] << 1) | p0;
+        e1[c] = (q1[c] << 1) | p1;
+    }
+
+    int palette[16][4];
+    BC7Palette(e0, e1, palette);
+    int indices[BLOCK_PIXELS];
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        int bestDistance = INT32_MAX;
+        for (int p = 0; p < 16; ++p) {
+            int distance = Distance(block + i * 4, palette[p], 4);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                indices[i] = p;
+            }
+        }
+    }
+
+    // The first pixel's index is stored without its top bit, so it must be
+    // in the lower half; swapping the end points mirrors every index
+    if (indices[0] & 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (int& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter bits{out};
+    bits.Write(BC7_MODE6, 7);
+    for (int c = 0; c < 4; ++c) {
+        bits.Write(q0[c], 7);
+        bits.Write(q1[c], 7);
+    }
+    bits.Write(p0, 1);
+    bits.Write(p1, 1);
+    bits.Write(indices[0], 3);
+    for (int i = 1; i < BLOCK_PIXELS; ++i) {
+        bits.Write(indices[i], 4);
+    }
+}
+
+void DecodeBC7Block(const uint8_t in[16], uint8_t block[64]) {
+    BitReader bits{in};
+    if (bits.Read(7) != BC7_MODE6) {
+        std::memset(block, 0, 64);
+        return;
+    }
+
+    int q0[4], q1[4];
+    for (int c = 0; c < 4; ++c) {
+        q0[c] = static_cast<int>(bits.Read(7));
+        q1[c] = static_cast<int>(bits.Read(7));
+    }
+    int p0 = static_cast<int>(bits.Read(1));
+    int p1 = static_cast<int>(bits.Read(1));
+    int e0[4], e1[4];
+    for (int c = 0; c < 4; ++c) {
+        e0[c] = (q0[c] << 1) | p0;
+        e1[c] = (q1[c] << 1) | p1;
+    }
+
+    int palette[16][4];
+    BC7Palette(e0, e1, palette);
+    for (int i = 0; i < BLOCK_PIXELS; ++i) {
+        const int* color = palette[bits.Read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c) {
+            block[i * 4 + c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+void EncodeBlock(PixelFormat format, const uint8_t block[64], uint8_t* out) {
+    switch (format) {
+    case PixelFormat::BC1:
+        EncodeColorBlock(block, true, out);
+        break;
+    case PixelFormat::BC3:
+        EncodeAlphaBlock(block, out);
+        EncodeColorBlock(block, false, out + 8);
+        break;
+    case PixelFormat::BC7:
+        EncodeBC7Block(block, out);
+        break;
+    default:
+        break;
+    }
+}
+
+void DecodeBlock(PixelFormat format, const uint8_t* in, uint8_t block[64]) {
+    switch (format) {
+    case PixelFormat::BC1:
+        DecodeColorBlock(in, true, block);
+        break;
+    case PixelFormat::BC3:
+        DecodeColorBlock(in + 8, false, block);
+        DecodeAlphaBlock(in, block);
+        break;
+    case PixelFormat::BC7:
+        DecodeBC7Block(in, block);
+        break;
+    default:
+        std::memset(block, 0, 64);
+        break;
+    }
+}
+
+} // namespace
+
+size_t GetBlockSize(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::BC1: return 8;
+    case PixelFormat::BC3: return 16;
+    case PixelFormat::BC7: return 16;
+    default: return 0;
+    }
+}
+
+size_t GetBlockRowPitch(PixelFormat format, int width) {
+    return size_t((width + 3) / 4) * GetBlockSize(format);
+}
+
+size_t GetBlockCompressedSize(PixelFormat format, int width, int height) {
+    return GetBlockRowPitch(format, width) * size_t((height + 3) / 4);
+}
+
+void CompressImage(PixelFormat format, const uint8_t* rgba, int width, int height, uint8_t* out) {
+    const size_t blockSize = GetBlockSize(format);
+    uint8_t block[64];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int y = 0; y < 4; ++y) {
+                int sy = std::min(by + y, height - 1);
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + (size_t(sy) * width + sx) * 4, 4);
+                }
+            }
+            EncodeBlock(format, block, out);
+            out += blockSize;
+        }
+    }
+}
+
+void DecompressImage(PixelFormat format, const uint8_t* blocks, int width, int height, uint8_t* rgba) {
+    const size_t blockSize = GetBlockSize(format);
+    uint8_t block[64];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            DecodeBlock(format, blocks, block);
+            blocks += blockSize;
+            for (int y = 0; y < 4 && by + y < height; ++y) {
+                for (int x = 0; x < 4 && bx + x < width; ++x) {
+                    std::memcpy(rgba + (size_t(by + y) * width + bx + x) * 4, block + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ImageDecoder.h"
+#include <cstddef>
+#include <cstdint>
+
+// CPU encoders for the D3D block-compressed formats, so textures can be
+// compressed once at load time and kept that way in the disk cache. Each
+// 4x4 block is fitted along the principal axis of its colors: quick, and
+// close enough for UI images. BC7 is written in mode 6 only (one subset,
+// RGBA endpoints, 16 levels), which suits the smooth photos and gradients
+// the launcher shows. No GPU dependency.
+
+// Bytes per 4x4 block; 0 for RGBA8
+size_t GetBlockSize(PixelFormat format);
+
+// Bytes per row of blocks, and for the whole level; partial blocks count
+// whole
+size_t GetBlockRowPitch(PixelFormat format, int width);
+size_t GetBlockCompressedSize(PixelFormat format, int width, int height);
+
+// Compress a width x height RGBA8 image (any size; edge blocks repeat the
+// last row and column) into GetBlockCompressedSize() bytes of out
+void CompressImage(PixelFormat format, const uint8_t* rgba, int width, int height, uint8_t* out);
+
+// Back to RGBA8 as the GPU would sample it, for checking the encoders
+// headless. Only reads the BC7 mode the encoder writes; blocks in other
+// modes come out transparent black.
+void DecompressImage(PixelFormat format, const uint8_t* blocks, int width, int height, uint8_t* rgba);
@@ -0,0 +1,178 @@
+#include "GlyphCache.h"
+#include <algorithm>
+#include <cstring>
+
+GlyphCache::GlyphCache(std::unique_ptr<GlyphRasterizer> rasterizer, const GlyphCacheConfig& config)
+    : m_rasterizer(std::move(rasterizer)), m_config(config) {
+    m_pages.reserve(m_config.maxPages);
+}
+
+const CachedGlyph* GlyphCache::Acquire(uint32_t codepoint) {
+    auto it = m_glyphs.find(codepoint);
+    if (it != m_glyphs.end()) {
+        ++m_stats.hits;
+        if (it->second.page >= 0) {
+            m_pages[it->second.page].lastUsedFrame = m_frame;
+        }
+        return &it->second;
+    }
+
+    if (m_missing.count(codepoint) || !m_rasterizer->Rasterize(codepoint, m_scratch)) {
+        m_missing.insert(codepoint);
+        return nullptr;
+    }
+
+    CachedGlyph glyph;
+    glyph.codepoint = codepoint;
+    glyph.width = m_scratch.width;
+    glyph.height = m_scratch.height;
+    glyph.offsetX = m_scratch.offsetX;
+    glyph.offsetY = m_scratch.offsetY;
+    glyph.advanceX = m_scratch.advanceX;
+
+    if (glyph.width > 0 && glyph.height > 0) {
+        int padding = m_config.padding;
+        int x = 0;
+        int y = 0;
+        if (!Allocate(glyph.width + padding * 2, glyph.height + padding * 2, glyph.page, x, y)) {
+            return nullptr;   // Retried on a later frame
+        }
+        glyph.x = x + padding;
+        glyph.y = y + padding;
+
+        Page& page = m_pages[glyph.page];
+        for (int row = 0; row < glyph.height; ++row) {
+            std::memcpy(&page.pixels[(glyph.y + row) * m_config.pageSize + glyph.x],
+                        &m_scratch.alpha[row * glyph.width], glyph.width);
+        }
+        page.glyphs.push_back(codepoint);
+        page.lastUsedFrame = m_frame;
+        MarkDirty(glyph.page, glyph.x, glyph.y, glyph.x + glyph.width, glyph.y + glyph.height);
+    }
+
+    ++m_stats.rasterized;
+    return &m_glyphs.emplace(codepoint, glyph).first->second;
+}
+
+const CachedGlyph* GlyphCache::AcquirePinned(uint32_t codepoint) {
+    const CachedGlyph* glyph = Acquire(codepoint);
+    if (glyph && glyph->page >= 0) {
+        m_pages[glyph->page].pinned = true;
+    }
+    return glyph;
+}
+
+void GlyphCache::UnpinAll() {
+    for (Page& page : m_pages) {
+        page.pinned = false;
+    }
+}
+
+void GlyphCache::TakeDirtyRects(std::vector<GlyphDirtyRect>& out) {
+    out.clear();
+    for (Page& page : m_pages) {
+        if (page.dirty) {
+            out.push_back(page.dirtyRect);
+            page.dirty = false;
+        }
+    }
+}
+
+void GlyphCache::TakeEvicted(std::vector<uint32_t>& out) {
+    out.swap(m_evicted);
+    m_evicted.clear();
+}
+
+bool GlyphCache::Allocate(int width, int height, int& page, int& x, int& y) {
+    if (width > m_config.pageSize || height > m_config.pageSize) {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        if (AllocateInPage(m_pages[i], width, height, x, y)) {
+            page = static_cast<int>(i);
+            return true;
+        }
+    }
+
+    if (static_cast<int>(m_pages.size()) < m_config.maxPages) {
+        Page fresh;
+        fresh.pixels.assign(size_t(m_config.pageSize) * m_config.pageSize, 0);
+        m_pages.push_back(std::move(fresh));
+        page = static_cast<int>(m_pages.size()) - 1;
+        return AllocateInPage(m_pages.back(), width, height, x, y);
+    }
+
+    page = EvictPage();
+    return page >= 0 && AllocateInPage(m_pages[page], width, height, x, y);
+}
+
+bool GlyphCache::AllocateInPage(Page& page, int width, int height, int& x, int& y) {
+    // Best fitting shelf that still has room
+    Shelf* best = nullptr;
+    for (Shelf& shelf : page.shelves) {
+        if (shelf.height >= height && shelf.x + width <= m_config.pageSize &&
+            (!best || shelf.height < best->height)) {
+            best = &shelf;
+        }
+    }
+
+    if (!best) {
+        int top = page.shelves.empty() ? 0 : page.shelves.back().y + page.shelves.back().height;
+        if (top + height > m_config.pageSize) {
+            return false;
+        }
+        page.shelves.push_back(Shelf{top, height, 0});
+        best = &page.shelves.back();
+    }
+
+    x = best->x;
+    y = best->y;
+    best->x += width;
+    return true;
+}
+
+int GlyphCache::EvictPage() {
+    int victim = -1;
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        const Page& page = m_pages[i];
+        if (page.pinned || page.lastUsedFrame == m_frame) {
+            continue;   // Pinned, or still referenced by this frame's draw data
+        }
+        if (victim < 0 || page.lastUsedFrame < m_pages[victim].lastUsedFrame) {
+            victim = static_cast<int>(i);
+        }
+    }
+    if (victim < 0) {
+        return -1;
+    }
+
+    Page& page = m_pages[victim];
+    for (uint32_t codepoint : page.glyphs) {
+        m_glyphs.erase(codepoint);
+        m_evicted.push_back(codepoint);
+    }
+    m_stats.evictedGlyphs += page.glyphs.size();
+    ++m_stats.evictedPages;
+
+    page.glyphs.clear();
+    page.shelves.clear();
+    std::fill(page.pixels.begin(), page.pixels.end(), uint8_t(0));
+    page.lastUsedFrame = m_frame;
+    MarkDirty(victim, 0, 0, m_config.pageSize, m_config.pageSize);
+    return victim;
+}
+
+void GlyphCache::MarkDirty(int pageIndex, int x0, int y0, int x1, int y1) {
+    Page& page = m_pages[pageIndex];
+    if (!page.dirty) {
+        page.dirty = true;
+        page.dirtyRect = GlyphDirtyRect{pageIndex, x0, y0, x1, y1};
+        return;
+    }
+    GlyphDirtyRect& rect = page.dirtyRect;
+    rect.x0 = std::min(rect.x0, x0);
+    rect.y0 = std::min(rect.y0, y0);
+    rect.x1 = std::max(rect.x1, x1);
+    rect.y1 = std::max(rect.y1, y1);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Distance-field glyphs hold this value on the outline, rising inside
+constexpr uint8_t SDF_ON_EDGE = 128;
+
+// One rasterized glyph: alpha coverage, or a signed distance field
+struct GlyphBitmap {
+    int width = 0;
+    int height = 0;
+    int offsetX = 0;        // Top-left corner relative to the pen on the baseline
+    int offsetY = 0;
+    float advanceX = 0.0f;
+    std::vector<uint8_t> alpha;   // width * height
+};
+
+// Source of glyph bitmaps at a fixed pixel size
+class GlyphRasterizer {
+public:
+    virtual ~GlyphRasterizer() = default;
+
+    // False if the font has no glyph for codepoint
+    virtual bool Rasterize(uint32_t codepoint, GlyphBitmap& out) = 0;
+};
+
+struct GlyphCacheConfig {
+    int pageSize = 256;     // Pages are pageSize x pageSize alpha8
+    int maxPages = 4;
+    int padding = 1;        // Empty pixels kept around each glyph
+};
+
+struct CachedGlyph {
+    uint32_t codepoint = 0;
+    int page = -1;          // -1 for glyphs with nothing to draw (spaces)
+    int x = 0;              // Position in the page
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int offsetX = 0;
+    int offsetY = 0;
+    float advanceX = 0.0f;
+};
+
+struct GlyphDirtyRect {
+    int page;
+    int x0, y0, x1, y1;     // Exclusive max
+};
+
+struct GlyphCacheStats {
+    uint64_t hits = 0;
+    uint64_t rasterized = 0;
+    uint64_t evictedPages = 0;
+    uint64_t evictedGlyphs = 0;
+};
+
+// Glyphs rasterized on first use into fixed-size pages, packed in shelves.
+// When the page budget is full, the least recently used page that wasn't
+// touched this frame or pinned is cleared and reused, so glyphs drawn this frame
+// never move under the renderer. No GPU or ImGui dependency: the owner
+// uploads dirty rectangles and drops evicted glyphs from its font.
+class GlyphCache {
+public:
+    explicit GlyphCache(std::unique_ptr<GlyphRasterizer> rasterizer, const GlyphCacheConfig& config = {});
+
+    // Start a new frame for the LRU
+    void BeginFrame() { ++m_frame; }
+
+    // Glyph for codepoint, rasterizing it on a miss, and mark it used this
+    // frame. nullptr if the font lacks it or every page is in use this
+    // frame. The pointer is valid until the next Acquire().
+    const CachedGlyph* Acquire(uint32_t codepoint);
+
+    // Acquire, and keep the glyph's page from eviction until UnpinAll(),
+    // for text shown without being acquired every frame. Once pinned pages
+    // fill the budget, glyphs that need a new page fail to load.
+    const CachedGlyph* AcquirePinned(uint32_t codepoint);
+    void UnpinAll();
+
+    bool Contains(uint32_t codepoint) const { return m_glyphs.count(codepoint) != 0; }
+
+    // Page pixels, pageSize * pageSize alpha8
+    const uint8_t* GetPagePixels(int page) const { return m_pages[page].pixels.data(); }
+    int GetPageCount() const { return static_cast<int>(m_pages.size()); }
+    int GetPageSize() const { return m_config.pageSize; }
+
+    // Written areas since the last call, one rectangle per page
+    void TakeDirtyRects(std::vector<GlyphDirtyRect>& out);
+
+    // Codepoints evicted since the last call
+    void TakeEvicted(std::vector<uint32_t>& out);
+
+    const GlyphCacheStats& GetStats() const { return m_stats; }
+
+private:
+    struct Shelf {
+        int y;
+        int height;
+        int x;              // Next free column
+    };
+
+    struct Page {
+        std::vector<uint8_t> pixels;
+        std::vector<Shelf> shelves;
+        std::vector<uint32_t> glyphs;
+        uint64_t lastUsedFrame = 0;
+        bool pinned = false;
+        bool dirty = false;
+        GlyphDirtyRect dirtyRect = {};
+    };
+
+    bool Allocate(int width, int height, int& page, int& x, int& y);
+    bool AllocateInPage(Page& page, int width, int height, int& x, int& y);
+    int EvictPage();
+    void MarkDirty(int page, int x0, int y0, int x1, int y1);
+
+    std::unique_ptr<GlyphRasterizer> m_rasterizer;
+    GlyphCacheConfig m_config;
+    uint64_t m_frame = 1;
+
+    std::unordered_map<uint32_t, CachedGlyph> m_glyphs;
+    std::unordered_set<uint32_t> m_missing;   // Not in the font; don't retry
+    std::vector<Page> m_pages;
+    std::vector<uint32_t> m_evicted;
+    GlyphBitmap m_scratch;
+    GlyphCacheStats m_stats;
+};
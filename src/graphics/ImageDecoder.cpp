@@ -0,0 +1,61 @@
+#include "ImageDecoder.h"
+#include "BlockCompress.h"
+#include "MipGenerator.h"
+#include <cstring>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+bool DecodeImageFile(const std::string& path, DecodedImage& out) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        return false;
+    }
+
+    out = DecodedImage();
+    out.width = width;
+    out.height = height;
+    out.pixels.resize(size_t(width) * height * 4);
+    std::memcpy(out.pixels.data(), data, out.pixels.size());
+    stbi_image_free(data);
+
+    ImageLevel level;
+    level.width = width;
+    level.height = height;
+    level.rowPitch = uint32_t(width) * 4;
+    level.size = out.pixels.size();
+    out.levels.push_back(level);
+    return true;
+}
+
+void PrepareImage(DecodedImage& image, const TextureDecodeOptions& options) {
+    if (options.mipmaps) {
+        GenerateMips(image, options.premultipliedAlpha);
+    }
+
+    if (options.format == PixelFormat::RGBA8 || image.format != PixelFormat::RGBA8 ||
+        image.width % 4 != 0 || image.height % 4 != 0) {
+        return;
+    }
+
+    std::vector<uint8_t> compressed;
+    std::vector<ImageLevel> levels;
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        const ImageLevel& source = image.levels[i];
+        ImageLevel level;
+        level.width = source.width;
+        level.height = source.height;
+        level.rowPitch = static_cast<uint32_t>(GetBlockRowPitch(options.format, source.width));
+        level.offset = compressed.size();
+        level.size = GetBlockCompressedSize(options.format, source.width, source.height);
+        compressed.resize(level.offset + level.size);
+        CompressImage(options.format, image.GetLevelData(i), source.width, source.height,
+                      compressed.data() + level.offset);
+        levels.push_back(level);
+    }
+
+    image.format = options.format;
+    image.levels = std::move(levels);
+    image.pixels = std::move(compressed);
+}
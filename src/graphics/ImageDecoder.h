@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+enum class PixelFormat : uint8_t {
+    RGBA8,
+    BC1,        // 4x4 blocks of 8 bytes: RGB, 1-bit alpha
+    BC3,        // 4x4 blocks of 16 bytes: RGB plus interpolated alpha
+    BC7         // 4x4 blocks of 16 bytes: RGBA, higher quality
+};
+
+// One mip level's place in DecodedImage data
+struct ImageLevel {
+    int width = 0;
+    int height = 0;
+    uint32_t rowPitch = 0;      // Bytes per row of pixels, or of blocks
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+// A decoded image, ready to upload: one or more levels, largest first,
+// back to back. The bytes are in pixels, or in mapped when the image came
+// straight from the disk cache.
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    PixelFormat format = PixelFormat::RGBA8;
+    std::vector<ImageLevel> levels;
+    std::vector<uint8_t> pixels;
+    std::shared_ptr<MappedFile> mapped;
+    const uint8_t* mappedData = nullptr;
+    uint64_t contentHash = 0;   // Of the levels, when the decoder's owner computed it
+
+    const uint8_t* GetData() const { return mappedData ? mappedData : pixels.data(); }
+    const uint8_t* GetLevelData(size_t level) const { return GetData() + levels[level].offset; }
+    size_t GetByteSize() const { return levels.empty() ? 0 : levels.back().offset + levels.back().size; }
+};
+
+// How the decode step prepares an image; part of the disk cache key
+struct TextureDecodeOptions {
+    PixelFormat format = PixelFormat::RGBA8;   // BC formats need width and height multiples of 4; others stay RGBA8
+    bool mipmaps = true;                       // Full chain, see GenerateMips()
+    bool premultipliedAlpha = false;           // Source colors are already multiplied by alpha
+};
+
+// PNG, JPG, BMP, TGA, ... via stb_image, to one RGBA8 level. Safe to call
+// from any thread.
+bool DecodeImageFile(const std::string& path, DecodedImage& out);
+
+// Turn a decoded RGBA8 image into what options ask for: mips, then
+// block compression of every level
+void PrepareImage(DecodedImage& image, const TextureDecodeOptions& options);
@@ -0,0 +1,325 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIP_SIMD_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+constexpr int CHANNELS = 4;
+constexpr uint32_t LINEAR_MAX = 65535;
+
+// 8-bit sRGB to 16-bit linear, and back
+struct GammaTables {
+    uint16_t toLinear[256];
+    uint8_t toSrgb[LINEAR_MAX + 1];
+
+    GammaTables() {
+        for (int i = 0; i < 256; ++i) {
+            double c = i / 255.0;
+            double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            toLinear[i] = static_cast<uint16_t>(linear * LINEAR_MAX + 0.5);
+        }
+        for (uint32_t i = 0; i <= LINEAR_MAX; ++i) {
+            double linear = double(i) / LINEAR_MAX;
+            double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+            toSrgb[i] = static_cast<uint8_t>(std::clamp(c * 255.0 + 0.5, 0.0, 255.0));
+        }
+    }
+};
+
+const GammaTables& GetGammaTables() {
+    static const GammaTables tables;
+    return tables;
+}
+
+// Levels are filtered as premultiplied linear RGB plus alpha, 16 bits each
+void ToLinear(const uint8_t* rgba, size_t pixelCount, bool premultiplied, uint16_t* linear) {
+    const GammaTables& tables = GetGammaTables();
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const uint8_t* src = rgba + i * CHANNELS;
+        uint16_t* dst = linear + i * CHANNELS;
+        uint32_t alpha = src[3];
+        if (alpha == 255) {
+            dst[0] = tables.toLinear[src[0]];
+            dst[1] = tables.toLinear[src[1]];
+            dst[2] = tables.toLinear[src[2]];
+            dst[3] = static_cast<uint16_t>(LINEAR_MAX);
+            continue;
+        }
+        for (int c = 0; c < 3; ++c) {
+            uint32_t color = src[c];
+            if (premultiplied) {
+                color = alpha ? std::min(255u, (color * 255 + alpha / 2) / alpha) : 0;
+            }
+            dst[c] = static_cast<uint16_t>((tables.toLinear[color] * alpha + 127) / 255);
+        }
+        dst[3] = static_cast<uint16_t>(alpha * 257);
+    }
+}
+
+void FromLinear(const uint16_t* linear, size_t pixelCount, bool premultiplied, uint8_t* rgba) {
+    const GammaTables& tables = GetGammaTables();
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const uint16_t* src = linear + i * CHANNELS;
+        uint8_t* dst = rgba + i * CHANNELS;
+        uint32_t alpha16 = src[3];
+        uint32_t alpha = (alpha16 + 128) / 257;
+        for (int c = 0; c < 3; ++c) {
+            uint32_t color = 0;
+            if (alpha16 == LINEAR_MAX) {
+                color = tables.toSrgb[src[c]];
+            } else if (alpha16 != 0) {
+                // Fits 32 bits: at most 65535 * 65535 + 32767
+                uint32_t straight = std::min<uint32_t>(LINEAR_MAX, (src[c] * LINEAR_MAX + alpha16 / 2) / alpha16);
+                color = tables.toSrgb[straight];
+                if (premultiplied) {
+                    color = (color * alpha + 127) / 255;
+                }
+            }
+            dst[c] = static_cast<uint8_t>(color);
+        }
+        dst[3] = static_cast<uint8_t>(alpha);
+    }
+}
+
+// Source taps of one output pixel along one axis. Halving an odd size n
+// = 2m + 1 gives m pixels, each covering 2 + 1/m source pixels: the
+// middle one whole and its neighbours in part.
+struct Taps {
+    int first;
+    int count;
+    uint32_t weights[3];
+    uint32_t total;
+};
+
+Taps GetTaps(int index, int srcSize, int dstSize) {
+    if (srcSize == 1) {
+        return {0, 1, {1, 0, 0}, 1};
+    }
+    if (srcSize % 2 == 0) {
+        return {index * 2, 2, {1, 1, 0}, 2};
+    }
+    uint32_t m = static_cast<uint32_t>(dstSize);
+    uint32_t i = static_cast<uint32_t>(index);
+    return {index * 2, 3, {m - i, m, i + 1}, 2 * m + 1};
+}
+
+// One output row from its ty.count source rows, one pixel at a time; odd
+// sizes and 1-wide levels
+void DownsampleRowGeneral(const uint16_t* const rows[3], const Taps& ty, int srcWidth, uint16_t* dst, int dstWidth) {
+    for (int x = 0; x < dstWidth; ++x) {
+        Taps tx = GetTaps(x, srcWidth, dstWidth);
+        uint64_t total = uint64_t(tx.total) * ty.total;
+        uint64_t sums[CHANNELS] = {};
+        for (int j = 0; j < ty.count; ++j) {
+            for (int i = 0; i < tx.count; ++i) {
+                uint64_t weight = uint64_t(ty.weights[j]) * tx.weights[i];
+                const uint16_t* pixel = rows[j] + size_t(tx.first + i) * CHANNELS;
+                for (int c = 0; c < CHANNELS; ++c) {
+                    sums[c] += weight * pixel[c];
+                }
+            }
+        }
+        for (int c = 0; c < CHANNELS; ++c) {
+            dst[x * CHANNELS + c] = static_cast<uint16_t>((sums[c] + total / 2) / total);
+        }
+    }
+}
+
+// 2x2 box over one pair of source rows, from output pixel x on
+void Downsample2x2RowScalar(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, int x, int dstWidth) {
+    for (; x < dstWidth; ++x) {
+        const uint16_t* a = row0 + x * 2 * CHANNELS;
+        const uint16_t* b = row1 + x * 2 * CHANNELS;
+        for (int c = 0; c < CHANNELS; ++c) {
+            uint32_t sum = uint32_t(a[c]) + a[c + CHANNELS] + b[c] + b[c + CHANNELS];
+            dst[x * CHANNELS + c] = static_cast<uint16_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+#ifdef MIP_SIMD_X86
+
+__m128i Average2x2Sse2(const uint16_t* row0, const uint16_t* row1) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+    __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+    __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(top, zero), _mm_unpackhi_epi16(top, zero)),
+                                _mm_add_epi32(_mm_unpacklo_epi16(bottom, zero), _mm_unpackhi_epi16(bottom, zero)));
+    return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(2)), 2);
+}
+
+// Two output pixels per step. SSE2 has no unsigned 32 -> 16 pack, so the
+// averages are biased into signed range and back.
+void Downsample2x2RowSse2(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, int dstWidth) {
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    const __m128i bias16 = _mm_set1_epi16(-32768);
+
+    int x = 0;
+    for (; x + 2 <= dstWidth; x += 2) {
+        const size_t src = size_t(x) * 2 * CHANNELS;
+        __m128i first = _mm_sub_epi32(Average2x2Sse2(row0 + src, row1 + src), bias32);
+        __m128i second = _mm_sub_epi32(Average2x2Sse2(row0 + src + 2 * CHANNELS, row1 + src + 2 * CHANNELS), bias32);
+        __m128i packed = _mm_xor_si128(_mm_packs_epi32(first, second), bias16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * CHANNELS), packed);
+    }
+    Downsample2x2RowScalar(row0, row1, dst, x, dstWidth);
+}
+
+TARGET_AVX2 __m256i Average2x2Avx2(const uint16_t* row0, const uint16_t* row1) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i top = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0));
+    __m256i bottom = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1));
+    __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(top, zero), _mm256_unpackhi_epi16(top, zero)),
+                                   _mm256_add_epi32(_mm256_unpacklo_epi16(bottom, zero), _mm256_unpackhi_epi16(bottom, zero)));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(2)), 2);
+}
+
+// Four output pixels per step. Unpacking works within 128-bit lanes, so
+// the packed pixels come out as 0 2 1 3 and are put back in order.
+TARGET_AVX2 void Downsample2x2RowAvx2(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, int dstWidth) {
+    int x = 0;
+    for (; x + 4 <= dstWidth; x += 4) {
+        const size_t src = size_t(x) * 2 * CHANNELS;
+        __m256i first = Average2x2Avx2(row0 + src, row1 + src);
+        __m256i second = Average2x2Avx2(row0 + src + 4 * CHANNELS, row1 + src + 4 * CHANNELS);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * CHANNELS), packed);
+    }
+    Downsample2x2RowScalar(row0, row1, dst, x, dstWidth);
+}
+
+bool CpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // AVX state must also be enabled by the OS
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // MIP_SIMD_X86
+
+void DownsampleRow(const uint16_t* const rows[3], const Taps& ty, int srcWidth, uint16_t* dst, int dstWidth, MipKernel kernel) {
+    if (ty.count != 2 || srcWidth % 2 != 0) {
+        DownsampleRowGeneral(rows, ty, srcWidth, dst, dstWidth);
+        return;
+    }
+    switch (kernel) {
+#ifdef MIP_SIMD_X86
+    case MipKernel::Avx2:
+        Downsample2x2RowAvx2(rows[0], rows[1], dst, dstWidth);
+        break;
+    case MipKernel::Sse2:
+        Downsample2x2RowSse2(rows[0], rows[1], dst, dstWidth);
+        break;
+#endif
+    default:
+        Downsample2x2RowScalar(rows[0], rows[1], dst, 0, dstWidth);
+        break;
+    }
+}
+
+} // namespace
+
+MipKernel GetBestMipKernel() {
+#ifdef MIP_SIMD_X86
+    static const MipKernel best = CpuHasAvx2() ? MipKernel::Avx2 : MipKernel::Sse2;
+    return best;
+#else
+    return MipKernel::Scalar;
+#endif
+}
+
+void GenerateMips(DecodedImage& image, bool premultiplied, MipKernel kernel) {
+    if (image.format != PixelFormat::RGBA8 || image.levels.size() != 1 || image.mappedData) {
+        return;
+    }
+#ifdef MIP_SIMD_X86
+    if (kernel == MipKernel::Avx2 && !CpuHasAvx2()) {
+        kernel = MipKernel::Sse2;
+    }
+#endif
+
+    int width = image.width;
+    int height = image.height;
+
+    // Grown once; level 0 keeps its original bytes
+    size_t totalSize = image.pixels.size();
+    for (int w = width, h = height; w > 1 || h > 1;) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        totalSize += size_t(w) * h * CHANNELS;
+    }
+    image.pixels.reserve(totalSize);
+
+    // Level 0 is converted to linear a few rows at a time, as they are
+    // needed, rather than as a whole: at 8 bytes a pixel it would be the
+    // largest buffer of all
+    std::vector<uint16_t> sourceRows(size_t(width) * 3 * CHANNELS);
+    std::vector<uint16_t> source, target;
+    bool fromBytes = true;
+
+    while (width > 1 || height > 1) {
+        int dstWidth = std::max(1, width / 2);
+        int dstHeight = std::max(1, height / 2);
+        target.resize(size_t(dstWidth) * dstHeight * CHANNELS);
+
+        const size_t srcPitch = size_t(width) * CHANNELS;
+        const size_t dstPitch = size_t(dstWidth) * CHANNELS;
+        for (int y = 0; y < dstHeight; ++y) {
+            Taps ty = GetTaps(y, height, dstHeight);
+            const uint16_t* rows[3] = {};
+            for (int j = 0; j < ty.count; ++j) {
+                size_t row = size_t(ty.first + j);
+                if (fromBytes) {
+                    uint16_t* converted = sourceRows.data() + j * srcPitch;
+                    ToLinear(image.pixels.data() + row * srcPitch, width, premultiplied, converted);
+                    rows[j] = converted;
+                } else {
+                    rows[j] = source.data() + row * srcPitch;
+                }
+            }
+            DownsampleRow(rows, ty, width, target.data() + y * dstPitch, dstWidth, kernel);
+        }
+
+        ImageLevel level;
+        level.width = dstWidth;
+        level.height = dstHeight;
+        level.rowPitch = uint32_t(dstPitch);
+        level.offset = image.pixels.size();
+        level.size = dstPitch * dstHeight;
+        image.pixels.resize(level.offset + level.size);
+        FromLinear(target.data(), size_t(dstWidth) * dstHeight, premultiplied, image.pixels.data() + level.offset);
+        image.levels.push_back(level);
+
+        source.swap(target);
+        fromBytes = false;
+        width = dstWidth;
+        height = dstHeight;
+    }
+}
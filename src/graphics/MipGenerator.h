@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ImageDecoder.h"
+
+// Box-filter kernels for the 2x2 downsample, the bulk of mip generation.
+// All give identical output; Scalar is the reference.
+enum class MipKernel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Fastest kernel this CPU runs
+MipKernel GetBestMipKernel();
+
+// Replace the single RGBA8 level of image with a full chain down to 1x1.
+// Filtering is gamma-correct (sRGB decoded to linear) and weighted by
+// alpha, so transparent pixels don't darken the edges around them. Each
+// level is built from the previous one at 16 bits per channel, and
+// rounded to 8 only for output. Odd sizes halve rounding down, as D3D
+// expects, through a three-tap filter that covers the whole source.
+// premultiplied says the colors are already multiplied by alpha; output
+// levels keep the input's convention.
+void GenerateMips(DecodedImage& image, bool premultiplied, MipKernel kernel = GetBestMipKernel());
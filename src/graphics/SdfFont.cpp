@@ -0,0 +1,160 @@
+#include "SdfFont.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float EDGE = SDF_ON_EDGE / 255.0f;
+constexpr float MIN_WIDTH = 1.0f / 1024.0f;   // Keeps smoothstep defined where the field is flat
+constexpr uint32_t REPLACEMENT_CHAR = 0xFFFD;
+
+// Next codepoint of UTF-8 text; malformed bytes come out as U+FFFD
+uint32_t DecodeUtf8(const char*& text, const char* textEnd) {
+    auto byte = [&](size_t i) { return static_cast<unsigned char>(text[i]); };
+    unsigned char lead = byte(0);
+    int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || (textEnd && textEnd - text < length)) {
+        ++text;
+        return REPLACEMENT_CHAR;
+    }
+
+    uint32_t c = length == 1 ? lead : lead & (0xFF >> (length + 1));
+    for (int i = 1; i < length; ++i) {
+        if ((byte(i) & 0xC0) != 0x80) {
+            text += i;
+            return REPLACEMENT_CHAR;
+        }
+        c = (c << 6) | (byte(i) & 0x3F);
+    }
+    text += length;
+    return c;
+}
+
+bool AtEnd(const char* text, const char* textEnd) {
+    return textEnd ? text >= textEnd : *text == '\0';
+}
+
+} // namespace
+
+SdfFont::SdfFont(std::unique_ptr<GlyphRasterizer> rasterizer, float baseSize, float ascent,
+                 const GlyphCacheConfig& config)
+    : m_cache(std::move(rasterizer), config), m_config(config), m_baseSize(baseSize), m_ascent(ascent) {
+}
+
+float SdfFont::Layout(const char* text, const char* textEnd, float size, float x, float y, std::vector<SdfQuad>& out) {
+    const float scale = size / m_baseSize;
+    const float invWidth = 1.0f / GetAtlasWidth();
+    const float invHeight = 1.0f / GetAtlasHeight();
+    const float top = y + m_ascent * scale;
+
+    float penX = x;
+    while (!AtEnd(text, textEnd)) {
+        uint32_t c = DecodeUtf8(text, textEnd);
+        const CachedGlyph* glyph = m_cache.Acquire(c);
+        if (!glyph) {
+            glyph = m_cache.Acquire(REPLACEMENT_CHAR);
+            if (!glyph) {
+                continue;
+            }
+        }
+
+        if (glyph->page >= 0) {
+            float atlasY = float(glyph->page * m_config.pageSize + glyph->y);
+            SdfQuad quad;
+            quad.x0 = penX + glyph->offsetX * scale;
+            quad.y0 = top + glyph->offsetY * scale;
+            quad.x1 = quad.x0 + glyph->width * scale;
+            quad.y1 = quad.y0 + glyph->height * scale;
+            quad.u0 = glyph->x * invWidth;
+            quad.v0 = atlasY * invHeight;
+            quad.u1 = (glyph->x + glyph->width) * invWidth;
+            quad.v1 = (atlasY + glyph->height) * invHeight;
+            out.push_back(quad);
+        }
+        penX += glyph->advanceX * scale;
+    }
+    return penX - x;
+}
+
+float SdfFont::Measure(const char* text, const char* textEnd, float size) {
+    m_quads.clear();
+    return Layout(text, textEnd, size, 0.0f, 0.0f, m_quads);
+}
+
+float SdfFont::Coverage(float distance, float width) {
+    // smoothstep(EDGE - w, EDGE + w, d), as in HLSL
+    width = std::max(width, MIN_WIDTH);
+    float t = std::clamp((distance - (EDGE - width)) / (2.0f * width), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+void SdfFont::RenderReference(const char* text, float size, float x, float y, uint8_t* image, int width, int height) {
+    m_quads.clear();
+    Layout(text, nullptr, size, x, y, m_quads);
+
+    for (const SdfQuad& quad : m_quads) {
+        const float du = (quad.u1 - quad.u0) / (quad.x1 - quad.x0);
+        const float dv = (quad.v1 - quad.v0) / (quad.y1 - quad.y0);
+        const int left = std::max(0, static_cast<int>(std::floor(quad.x0)));
+        const int right = std::min(width, static_cast<int>(std::ceil(quad.x1)));
+        const int upper = std::max(0, static_cast<int>(std::floor(quad.y0)));
+        const int lower = std::min(height, static_cast<int>(std::ceil(quad.y1)));
+
+        for (int py = upper; py < lower; ++py) {
+            float cy = py + 0.5f;
+            if (cy < quad.y0 || cy >= quad.y1) {
+                continue;
+            }
+            for (int px = left; px < right; ++px) {
+                float cx = px + 0.5f;
+                if (cx < quad.x0 || cx >= quad.x1) {
+                    continue;
+                }
+
+                // Forward differences one pixel over stand in for ddx/ddy
+                float u = quad.u0 + (cx - quad.x0) * du;
+                float v = quad.v0 + (cy - quad.y0) * dv;
+                float d = Sample(u, v);
+                float fwidth = std::fabs(Sample(u + du, v) - d) + std::fabs(Sample(u, v + dv) - d);
+                float alpha = Coverage(d, fwidth);
+
+                uint8_t& dst = image[size_t(py) * width + px];
+                dst = static_cast<uint8_t>(dst + alpha * (255 - dst) + 0.5f);
+            }
+        }
+    }
+}
+
+void SdfFont::TakeDirtyRects(std::vector<GlyphDirtyRect>& out) {
+    m_cache.TakeDirtyRects(out);
+    for (GlyphDirtyRect& rect : out) {
+        rect.y0 += rect.page * m_config.pageSize;
+        rect.y1 += rect.page * m_config.pageSize;
+    }
+}
+
+float SdfFont::Sample(float u, float v) const {
+    // Texel centers at +0.5, as the GPU samples
+    const int size = m_config.pageSize;
+    const int atlasHeight = GetAtlasHeight();
+    float tx = u * size - 0.5f;
+    float ty = v * atlasHeight - 0.5f;
+    int x0 = static_cast<int>(std::floor(tx));
+    int y0 = static_cast<int>(std::floor(ty));
+    float fx = tx - x0;
+    float fy = ty - y0;
+
+    auto texel = [&](int x, int y) {
+        x = std::clamp(x, 0, size - 1);
+        y = std::clamp(y, 0, atlasHeight - 1);
+        int page = y / size;
+        if (page >= m_cache.GetPageCount()) {
+            return 0.0f;   // Never allocated; zero on the GPU too
+        }
+        return m_cache.GetPagePixels(page)[(y % size) * size + x] / 255.0f;
+    };
+
+    float top = texel(x0, y0) + (texel(x0 + 1, y0) - texel(x0, y0)) * fx;
+    float bottom = texel(x0, y0 + 1) + (texel(x0 + 1, y0 + 1) - texel(x0, y0 + 1)) * fx;
+    return top + (bottom - top) * fy;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "GlyphCache.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One glyph placed on screen, with its UVs in the SdfFont atlas
+struct SdfQuad {
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+};
+
+// Signed distance field glyphs: each is rasterized once at baseSize and
+// drawn at any size by thresholding the interpolated distance at
+// SDF_ON_EDGE, so a new text size or UI scale costs no rebake. The atlas
+// is the GlyphCache pages stacked vertically. No GPU or ImGui dependency;
+// SdfText draws it through ImGui, RenderReference on the CPU.
+class SdfFont {
+public:
+    // rasterizer must produce distance fields at baseSize px (see
+    // TrueTypeRasterizer::SetSdf); ascent is at baseSize too
+    SdfFont(std::unique_ptr<GlyphRasterizer> rasterizer, float baseSize, float ascent,
+            const GlyphCacheConfig& config = {});
+
+    void BeginFrame() { m_cache.BeginFrame(); }
+
+    // Place one line of UTF-8 text (to textEnd, or NUL if nullptr) at size
+    // px with its top-left corner at (x, y). Appends the visible glyphs to
+    // out and returns the line width.
+    float Layout(const char* text, const char* textEnd, float size, float x, float y, std::vector<SdfQuad>& out);
+
+    // Line width without placing anything
+    float Measure(const char* text, const char* textEnd, float size);
+
+    // Alpha coverage at a pixel from the interpolated distance d and its
+    // screen-space rate of change (fwidth). The SDF pixel shader computes
+    // exactly this.
+    static float Coverage(float distance, float width);
+
+    // CPU version of the GPU path, for headless checks: draws text into an
+    // alpha8 image (width * height) with bilinear sampling and the shader's
+    // coverage, compositing over what's there
+    void RenderReference(const char* text, float size, float x, float y, uint8_t* image, int width, int height);
+
+    int GetAtlasWidth() const { return m_config.pageSize; }
+    int GetAtlasHeight() const { return m_config.pageSize * m_config.maxPages; }
+
+    // Written atlas areas since the last call, in atlas pixels
+    void TakeDirtyRects(std::vector<GlyphDirtyRect>& out);
+    const uint8_t* GetPagePixels(int page) const { return m_cache.GetPagePixels(page); }
+
+    const GlyphCacheStats& GetStats() const { return m_cache.GetStats(); }
+
+private:
+    // Bilinear, clamped, in atlas UVs; 0..1
+    float Sample(float u, float v) const;
+
+    GlyphCache m_cache;
+    GlyphCacheConfig m_config;
+    float m_baseSize;
+    float m_ascent;
+    std::vector<SdfQuad> m_quads;   // RenderReference scratch
+};
@@ -0,0 +1,228 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+TextureAtlas::TextureAtlas(const TextureAtlasConfig& config)
+    : m_config(config) {
+    m_pages.reserve(m_config.maxPages);
+}
+
+bool TextureAtlas::Accepts(int width, int height) const {
+    return width > 0 && height > 0 &&
+           width <= m_config.maxImageSize && height <= m_config.maxImageSize &&
+           width + m_config.padding * 2 <= m_config.pageSize &&
+           height + m_config.padding * 2 <= m_config.pageSize;
+}
+
+const AtlasEntry* TextureAtlas::Insert(const std::string& name, const uint8_t* pixels, int width, int height,
+                                       uint32_t rowPitch) {
+    Remove(name);
+    if (!Accepts(width, height)) {
+        return nullptr;
+    }
+
+    int padding = m_config.padding;
+    Slot slot;
+    if (!Allocate(width + padding * 2, height + padding * 2, slot.entry.page, slot.rect)) {
+        ++m_stats.rejected;
+        return nullptr;
+    }
+    slot.entry.x = slot.rect.x + padding;
+    slot.entry.y = slot.rect.y + padding;
+    slot.entry.width = width;
+    slot.entry.height = height;
+
+    Page& page = m_pages[slot.entry.page];
+    Blit(page, slot.rect, pixels, width, height, rowPitch);
+    ++page.imageCount;
+    MarkDirty(slot.entry.page, slot.rect.x, slot.rect.y,
+              slot.rect.x + slot.rect.width, slot.rect.y + slot.rect.height);
+
+    ++m_stats.inserted;
+    return &m_slots.emplace(name, slot).first->second.entry;
+}
+
+void TextureAtlas::Remove(const std::string& name) {
+    auto it = m_slots.find(name);
+    if (it == m_slots.end()) {
+        return;
+    }
+
+    // The pixels stay until something is written over them; nothing samples them
+    Page& page = m_pages[it->second.entry.page];
+    page.unpackableArea = UINT64_MAX;
+    if (--page.imageCount == 0) {
+        page.packer.Reset();
+    } else {
+        page.packer.Remove(it->second.rect);
+    }
+    m_slots.erase(it);
+    ++m_stats.removed;
+
+    // Free empty pages at the end; the others keep their index
+    while (!m_pages.empty() && m_pages.back().imageCount == 0) {
+        m_pages.pop_back();
+    }
+}
+
+const AtlasEntry* TextureAtlas::Find(const std::string& name) const {
+    auto it = m_slots.find(name);
+    return it != m_slots.end() ? &it->second.entry : nullptr;
+}
+
+void TextureAtlas::Clear() {
+    m_slots.clear();
+    m_pages.clear();
+    m_moved.clear();
+}
+
+float TextureAtlas::GetPageUsage(int page) const {
+    const AtlasPacker& packer = m_pages[page].packer;
+    return float(packer.GetUsedArea()) / (float(packer.GetWidth()) * packer.GetHeight());
+}
+
+void TextureAtlas::TakeDirtyRects(std::vector<AtlasDirtyRect>& out) {
+    out.clear();
+    for (Page& page : m_pages) {
+        if (page.dirty) {
+            out.push_back(page.dirtyRect);
+            page.dirty = false;
+        }
+    }
+}
+
+void TextureAtlas::TakeMoved(std::vector<std::string>& out) {
+    out.swap(m_moved);
+    m_moved.clear();
+}
+
+bool TextureAtlas::Allocate(int width, int height, int& page, AtlasRect& rect) {
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        if (m_pages[i].packer.Insert(width, height, rect)) {
+            page = static_cast<int>(i);
+            return true;
+        }
+    }
+
+    if (static_cast<int>(m_pages.size()) < m_config.maxPages) {
+        m_pages.emplace_back(m_config.pageSize);
+        page = static_cast<int>(m_pages.size()) - 1;
+        return m_pages.back().packer.Insert(width, height, rect);
+    }
+
+    // Every page is full or fragmented. Repack the ones with enough free
+    // area in total, emptiest first.
+    std::vector<int> candidates;
+    uint64_t area = uint64_t(width) * height;
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        const Page& page = m_pages[i];
+        if (page.packer.GetFreeArea() >= area && area < page.unpackableArea) {
+            candidates.push_back(static_cast<int>(i));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+        return m_pages[a].packer.GetFreeArea() > m_pages[b].packer.GetFreeArea();
+    });
+    for (int candidate : candidates) {
+        if (Defragment(candidate, width, height, rect)) {
+            page = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TextureAtlas::Defragment(int pageIndex, int width, int height, AtlasRect& rect) {
+    Page& page = m_pages[pageIndex];
+
+    // Largest first packs tightest; nullptr stands for the new image
+    std::vector<std::pair<const std::string*, Slot*>> images;
+    images.reserve(page.imageCount + 1);
+    for (auto& [name, slot] : m_slots) {
+        if (slot.entry.page == pageIndex) {
+            images.emplace_back(&name, &slot);
+        }
+    }
+    images.emplace_back(nullptr, nullptr);
+    auto sizeOf = [&](const std::pair<const std::string*, Slot*>& image) {
+        return image.second ? std::make_pair(std::max(image.second->rect.width, image.second->rect.height),
+                                             image.second->rect.width * image.second->rect.height)
+                            : std::make_pair(std::max(width, height), width * height);
+    };
+    std::sort(images.begin(), images.end(), [&](const auto& a, const auto& b) {
+        return sizeOf(a) > sizeOf(b);
+    });
+
+    AtlasPacker packer(m_config.pageSize, m_config.pageSize);
+    std::vector<AtlasRect> placed(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        int w = images[i].second ? images[i].second->rect.width : width;
+        int h = images[i].second ? images[i].second->rect.height : height;
+        if (!packer.Insert(w, h, placed[i])) {
+            page.unpackableArea = uint64_t(width) * height;
+            return false;   // Page left as it was
+        }
+    }
+
+    // Move the pixels, padding included, from a copy of the old layout
+    std::vector<uint8_t> previous = page.pixels;
+    std::fill(page.pixels.begin(), page.pixels.end(), uint8_t(0));
+    const size_t pagePitch = size_t(m_config.pageSize) * 4;
+    for (size_t i = 0; i < images.size(); ++i) {
+        Slot* slot = images[i].second;
+        if (!slot) {
+            rect = placed[i];
+            continue;
+        }
+        const AtlasRect& from = slot->rect;
+        const AtlasRect& to = placed[i];
+        for (int row = 0; row < from.height; ++row) {
+            std::memcpy(&page.pixels[(to.y + row) * pagePitch + size_t(to.x) * 4],
+                        &previous[(from.y + row) * pagePitch + size_t(from.x) * 4], size_t(from.width) * 4);
+        }
+        if (to.x != from.x || to.y != from.y) {
+            slot->entry.x += to.x - from.x;
+            slot->entry.y += to.y - from.y;
+            slot->rect = to;
+            m_moved.push_back(*images[i].first);
+        }
+    }
+
+    page.packer = std::move(packer);
+    MarkDirty(pageIndex, 0, 0, m_config.pageSize, m_config.pageSize);
+    ++m_stats.defragmentations;
+    return true;
+}
+
+void TextureAtlas::Blit(Page& page, const AtlasRect& rect, const uint8_t* pixels, int width, int height,
+                        uint32_t rowPitch) {
+    const int padding = m_config.padding;
+    const size_t pagePitch = size_t(m_config.pageSize) * 4;
+    for (int row = 0; row < rect.height; ++row) {
+        int sourceRow = std::clamp(row - padding, 0, height - 1);
+        const uint8_t* source = pixels + size_t(sourceRow) * rowPitch;
+        uint8_t* dest = &page.pixels[(rect.y + row) * pagePitch + size_t(rect.x) * 4];
+
+        for (int x = 0; x < padding; ++x) {
+            std::memcpy(dest + x * 4, source, 4);
+        }
+        std::memcpy(dest + padding * 4, source, size_t(width) * 4);
+        for (int x = padding + width; x < rect.width; ++x) {
+            std::memcpy(dest + x * 4, source + size_t(width - 1) * 4, 4);
+        }
+    }
+}
+
+void TextureAtlas::MarkDirty(int pageIndex, int x0, int y0, int x1, int y1) {
+    Page& page = m_pages[pageIndex];
+    if (!page.dirty) {
+        page.dirty = true;
+        page.dirtyRect = AtlasDirtyRect{pageIndex, x0, y0, x1, y1};
+        return;
+    }
+    AtlasDirtyRect& rect = page.dirtyRect;
+    rect.x0 = std::min(rect.x0, x0);
+    rect.y0 = std::min(rect.y0, y0);
+    rect.x1 = std::max(rect.x1, x1);
+    rect.y1 = std::max(rect.y1, y1);
+}
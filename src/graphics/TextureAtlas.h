@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AtlasPacker.h"
+
+struct TextureAtlasConfig {
+    int pageSize = 1024;    // Pages are pageSize x pageSize RGBA8
+    int maxPages = 4;
+    int maxImageSize = 128; // Images larger on either side don't go in
+    int padding = 1;        // Edge pixels repeated around each image, so filtering doesn't bleed
+};
+
+// Where an image sits: its pixels, without padding
+struct AtlasEntry {
+    int page = -1;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct AtlasDirtyRect {
+    int page;
+    int x0, y0, x1, y1;     // Exclusive max
+};
+
+struct TextureAtlasStats {
+    uint64_t inserted = 0;
+    uint64_t removed = 0;
+    uint64_t rejected = 0;          // No room even after defragmenting
+    uint64_t defragmentations = 0;
+};
+
+// Small RGBA8 images packed into shared pages, so UI drawing many of them
+// binds one texture instead of one each, and ImGui can batch their quads
+// into a single draw call. Images come and go at any time: removal frees
+// the space for reuse, and when a page is too fragmented for a new image
+// its remaining images are repacked. Like GlyphCache, no GPU dependency:
+// the owner uploads dirty rectangles and updates the UVs of moved images.
+class TextureAtlas {
+public:
+    explicit TextureAtlas(const TextureAtlasConfig& config = {});
+
+    // Whether an image this size belongs in the atlas at all
+    bool Accepts(int width, int height) const;
+
+    // Copy an RGBA8 image in under name, replacing any image already there.
+    // nullptr if it's not Accepts() or there's no room. The pointer is valid
+    // until the next Insert() or Remove().
+    const AtlasEntry* Insert(const std::string& name, const uint8_t* pixels, int width, int height,
+                             uint32_t rowPitch);
+    void Remove(const std::string& name);
+    const AtlasEntry* Find(const std::string& name) const;
+
+    // Remove every image and page. Remove() frees pages left empty at the
+    // end of the list.
+    void Clear();
+
+    // Page pixels, pageSize * pageSize RGBA8
+    const uint8_t* GetPagePixels(int page) const { return m_pages[page].pixels.data(); }
+    int GetPageCount() const { return static_cast<int>(m_pages.size()); }
+    int GetPageSize() const { return m_config.pageSize; }
+    // Fraction of the page's area in use, padding included
+    float GetPageUsage(int page) const;
+
+    // Written areas since the last call, one rectangle per page
+    void TakeDirtyRects(std::vector<AtlasDirtyRect>& out);
+
+    // Names of images moved by defragmentation since the last call
+    void TakeMoved(std::vector<std::string>& out);
+
+    const TextureAtlasStats& GetStats() const { return m_stats; }
+
+private:
+    struct Slot {
+        AtlasEntry entry;
+        AtlasRect rect;     // Entry plus padding, as allocated
+    };
+
+    struct Page {
+        std::vector<uint8_t> pixels;
+        AtlasPacker packer;
+        int imageCount = 0;
+        uint64_t unpackableArea = UINT64_MAX;   // Defragmenting failed for this much; reset by Remove()
+        bool dirty = false;
+        AtlasDirtyRect dirtyRect = {};
+
+        explicit Page(int size) : pixels(size_t(size) * size * 4, 0), packer(size, size) {}
+    };
+
+    bool Allocate(int width, int height, int& page, AtlasRect& rect);
+    // Repack page's images with room for one more width x height
+    bool Defragment(int page, int width, int height, AtlasRect& rect);
+    // Write width x height pixels into rect, extruding the edges into the padding
+    void Blit(Page& page, const AtlasRect& rect, const uint8_t* pixels, int width, int height,
+              uint32_t rowPitch);
+    void MarkDirty(int page, int x0, int y0, int x1, int y1);
+
+    TextureAtlasConfig m_config;
+    std::unordered_map<std::string, Slot> m_slots;
+    std::vector<Page> m_pages;
+    std::vector<std::string> m_moved;
+    TextureAtlasStats m_stats;
+};
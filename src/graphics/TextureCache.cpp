@@ -0,0 +1,290 @@
+#include "TextureCache.h"
+#include "BlockCompress.h"
+#include "../core/Hash.h"
+#include "../core/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'E', 'X', 'C'};
+constexpr uint32_t VERSION = 2;
+constexpr const char* EXTENSION = ".tex";
+constexpr size_t LEVEL_ALIGNMENT = 16;
+constexpr int MAX_TEXTURE_SIZE = 16384;
+constexpr uint32_t MAX_LEVELS = 15;         // 16384 down to 1
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    uint32_t format;
+    uint32_t levelCount;
+    uint64_t contentHash;       // The image's, as stored; 0 if it had none
+};
+
+struct LevelRecord {
+    int32_t width;
+    int32_t height;
+    uint32_t rowPitch;
+    uint32_t reserved;
+    uint64_t offset;            // From the start of the file
+    uint64_t size;
+};
+
+size_t AlignUp(size_t value) {
+    return (value + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+}
+
+// Size a level of format must have; guards the upload against a
+// record that would read past its data
+bool IsLevelConsistent(PixelFormat format, const LevelRecord& level) {
+    if (level.width <= 0 || level.height <= 0 || level.width > MAX_TEXTURE_SIZE || level.height > MAX_TEXTURE_SIZE) {
+        return false;
+    }
+    if (format == PixelFormat::RGBA8) {
+        return level.rowPitch == uint32_t(level.width) * 4 &&
+               level.size == uint64_t(level.rowPitch) * level.height;
+    }
+    return level.rowPitch == GetBlockRowPitch(format, level.width) &&
+           level.size == GetBlockCompressedSize(format, level.width, level.height);
+}
+
+} // namespace
+
+TextureCache::TextureCache(std::string directory, uint64_t maxBytes)
+    : m_directory(std::move(directory)), m_maxBytes(maxBytes) {
+}
+
+uint64_t TextureCache::MakeKey(const std::string& path, const TextureDecodeOptions& options) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec) {
+        return 0;
+    }
+    int64_t writeTime = fs::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) {
+        return 0;
+    }
+
+    uint64_t key = HashString(path);
+    key = HashBytes(&size, sizeof(size), key);
+    key = HashBytes(&writeTime, sizeof(writeTime), key);
+    uint8_t fields[] = {
+        static_cast<uint8_t>(options.format),
+        static_cast<uint8_t>(options.mipmaps),
+        static_cast<uint8_t>(options.premultipliedAlpha)
+    };
+    key = HashBytes(fields, sizeof(fields), key);
+    key = HashBytes(&VERSION, sizeof(VERSION), key);
+    return key != 0 ? key : 1;
+}
+
+bool TextureCache::Load(uint64_t key, DecodedImage& out) {
+    auto mapped = std::make_shared<MappedFile>();
+    if (key == 0 || !mapped->Open(GetPath(key))) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.misses;
+        return false;
+    }
+
+    const unsigned char* data = mapped->GetData();
+    const size_t fileSize = mapped->GetSize();
+    Header header;
+    bool valid = fileSize >= sizeof(Header);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+                header.key == key && header.format <= uint32_t(PixelFormat::BC7) &&
+                header.levelCount >= 1 && header.levelCount <= MAX_LEVELS &&
+                fileSize >= sizeof(Header) + header.levelCount * sizeof(LevelRecord);
+    }
+
+    DecodedImage image;
+    for (uint32_t i = 0; valid && i < header.levelCount; ++i) {
+        LevelRecord record;
+        std::memcpy(&record, data + sizeof(Header) + i * sizeof(LevelRecord), sizeof(record));
+        valid = IsLevelConsistent(PixelFormat(header.format), record) &&
+                record.offset <= fileSize && record.size <= fileSize - record.offset;
+
+        ImageLevel level;
+        level.width = record.width;
+        level.height = record.height;
+        level.rowPitch = record.rowPitch;
+        level.offset = static_cast<size_t>(record.offset);
+        level.size = static_cast<size_t>(record.size);
+        image.levels.push_back(level);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!valid || image.levels[0].width != header.width || image.levels[0].height != header.height) {
+        ++m_stats.misses;
+        return false;
+    }
+    ++m_stats.hits;
+    ScanLocked();
+    TouchLocked(key, fileSize);
+
+    // Persist the use for the next launch's LRU order
+    std::error_code ec;
+    fs::last_write_time(GetPath(key), fs::file_time_type::clock::now(), ec);
+
+    image.width = header.width;
+    image.height = header.height;
+    image.format = PixelFormat(header.format);
+    image.contentHash = header.contentHash;
+    image.mappedData = data;
+    image.mapped = std::move(mapped);
+    out = std::move(image);
+    return true;
+}
+
+bool TextureCache::Store(uint64_t key, const DecodedImage& image) {
+    if (key == 0 || image.levels.empty()) {
+        return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key = key;
+    header.width = image.width;
+    header.height = image.height;
+    header.format = uint32_t(image.format);
+    header.levelCount = static_cast<uint32_t>(image.levels.size());
+    header.contentHash = image.contentHash;
+
+    std::vector<LevelRecord> records;
+    size_t offset = AlignUp(sizeof(Header) + image.levels.size() * sizeof(LevelRecord));
+    for (const ImageLevel& level : image.levels) {
+        LevelRecord record = {};
+        record.width = level.width;
+        record.height = level.height;
+        record.rowPitch = level.rowPitch;
+        record.offset = offset;
+        record.size = level.size;
+        records.push_back(record);
+        offset = AlignUp(offset + level.size);
+    }
+
+    // Written aside and renamed over, so a reader never maps half a file.
+    // Workers store concurrently, so each gets its own temp file.
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    std::string path = GetPath(key);
+    std::string tempPath = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        static const char padding[LEVEL_ALIGNMENT] = {};
+        size_t written = sizeof(Header) + records.size() * sizeof(LevelRecord);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(LevelRecord));
+        for (size_t i = 0; i < records.size(); ++i) {
+            file.write(padding, records[i].offset - written);
+            file.write(reinterpret_cast<const char*>(image.GetLevelData(i)), image.levels[i].size);
+            written = records[i].offset + image.levels[i].size;
+        }
+        if (!file) {
+            file.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ScanLocked();
+    TouchLocked(key, records.back().offset + records.back().size);
+    ++m_stats.stores;
+    TrimLocked();
+    return true;
+}
+
+TextureCacheStats TextureCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string TextureCache::GetPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return (fs::path(m_directory) / (std::string(name) + EXTENSION)).string();
+}
+
+void TextureCache::ScanLocked() {
+    if (m_scanned) {
+        return;
+    }
+    m_scanned = true;
+
+    struct Found {
+        uint64_t key;
+        uint64_t size;
+        fs::file_time_type writeTime;
+    };
+    std::vector<Found> found;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(m_directory, ec)) {
+        const fs::path& path = entry.path();
+        if (path.extension() != EXTENSION) {
+            continue;
+        }
+        std::string stem = path.stem().string();
+        char* end = nullptr;
+        uint64_t key = std::strtoull(stem.c_str(), &end, 16);
+        std::error_code entryError;
+        uint64_t size = entry.file_size(entryError);
+        fs::file_time_type writeTime = entry.last_write_time(entryError);
+        if (stem.size() == 16 && end && *end == '\0' && !entryError) {
+            found.push_back({key, size, writeTime});
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.writeTime < b.writeTime; });
+    for (const Found& file : found) {
+        TouchLocked(file.key, file.size);
+    }
+}
+
+void TextureCache::TouchLocked(uint64_t key, uint64_t size) {
+    auto [it, inserted] = m_entries.try_emplace(key, Entry{size, 0});
+    if (!inserted) {
+        m_stats.bytes -= it->second.size;
+        it->second.size = size;
+    }
+    m_stats.bytes += size;
+    it->second.lastUse = ++m_useClock;
+}
+
+void TextureCache::TrimLocked() {
+    while (m_stats.bytes > m_maxBytes && m_entries.size() > 1) {
+        auto oldest = std::min_element(m_entries.begin(), m_entries.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+
+        // An image mapped from the file keeps its data; only the name goes
+        std::error_code ec;
+        fs::remove(GetPath(oldest->first), ec);
+        m_stats.bytes -= oldest->second.size;
+        ++m_stats.evictions;
+        m_entries.erase(oldest);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ImageDecoder.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct TextureCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t evictions = 0;
+    uint64_t bytes = 0;         // On disk now
+};
+
+// Decoded textures kept on disk, so later launches map the prepared
+// levels (mips, block compression) and upload them with no decode. One
+// file per key under the directory, least recently used deleted first
+// once the total passes maxBytes; a hit refreshes the file's write time,
+// which is what orders the files on the next launch. Thread-safe; no GPU
+// dependency.
+// File layout, host byte order:
+//   Header | LevelRecord[levelCount] | level data, each at a 16-byte offset
+class TextureCache {
+public:
+    TextureCache(std::string directory, uint64_t maxBytes);
+
+    // Key of path decoded with options: the path, the file's size and
+    // write time, and the options. 0 if the file can't be read.
+    static uint64_t MakeKey(const std::string& path, const TextureDecodeOptions& options);
+
+    // Map the entry for key into out; its levels point into the mapping,
+    // which out keeps open, and its contentHash is the one stored. False
+    // if missing, stale or damaged.
+    bool Load(uint64_t key, DecodedImage& out);
+
+    // Save a prepared image, with its contentHash, under key, then trim
+    // to maxBytes
+    bool Store(uint64_t key, const DecodedImage& image);
+
+    TextureCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        uint64_t size;
+        uint64_t lastUse;
+    };
+
+    std::string GetPath(uint64_t key) const;
+
+    // Index the directory once, oldest write time first
+    void ScanLocked();
+    void TouchLocked(uint64_t key, uint64_t size);
+    void TrimLocked();
+
+    std::string m_directory;
+    uint64_t m_maxBytes;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    uint64_t m_useClock = 0;
+    bool m_scanned = false;
+    TextureCacheStats m_stats;
+};
@@ -0,0 +1,185 @@
+#include "TextureIndex.h"
+#include "../core/MappedFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGIC[4] = {'T', 'I', 'D', 'X'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t MAX_PATH_BYTES = 32768;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+// Followed by pathBytes of path
+struct Record {
+    uint64_t fileSize;
+    int64_t writeTime;
+    uint64_t contentHash;
+    uint32_t pathBytes;
+    uint32_t reserved;
+};
+
+bool StatFile(const std::string& path, uint64_t& size, int64_t& writeTime) {
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    writeTime = fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+} // namespace
+
+TextureIndex::TextureIndex(std::string path)
+    : m_path(std::move(path)) {
+}
+
+bool TextureIndex::Load() {
+    m_entries.clear();
+    m_dirty = false;
+
+    MappedFile file;
+    if (!file.Open(m_path) || file.GetSize() < sizeof(Header)) {
+        return false;
+    }
+
+    const unsigned char* data = file.GetData();
+    size_t remaining = file.GetSize() - sizeof(Header);
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        return false;
+    }
+    data += sizeof(Header);
+
+    for (uint32_t i = 0; i < header.count; ++i) {
+        Record record;
+        if (remaining < sizeof(Record)) {
+            m_entries.clear();
+            return false;
+        }
+        std::memcpy(&record, data, sizeof(record));
+        data += sizeof(Record);
+        remaining -= sizeof(Record);
+        if (record.pathBytes > MAX_PATH_BYTES || record.pathBytes > remaining) {
+            m_entries.clear();
+            return false;
+        }
+        std::string path(reinterpret_cast<const char*>(data), record.pathBytes);
+        data += record.pathBytes;
+        remaining -= record.pathBytes;
+        m_entries[std::move(path)] = Entry{record.fileSize, record.writeTime, record.contentHash};
+    }
+    return true;
+}
+
+bool TextureIndex::Save() {
+    if (!m_dirty) {
+        return true;
+    }
+
+    std::string body;
+    uint32_t count = 0;
+    for (const auto& [path, entry] : m_entries) {
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+        if (!StatFile(path, size, writeTime)) {
+            continue;   // Deleted since
+        }
+        Record record = {};
+        record.fileSize = entry.fileSize;
+        record.writeTime = entry.writeTime;
+        record.contentHash = entry.contentHash;
+        record.pathBytes = static_cast<uint32_t>(path.size());
+        body.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        body.append(path);
+        ++count;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.count = count;
+
+    // Written aside and renamed over, so a reader never sees half a file
+    std::error_code ec;
+    fs::path target(m_path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+    }
+    std::string tempPath = m_path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(body.data(), body.size());
+        if (!file) {
+            file.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, target, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+bool TextureIndex::Find(const std::string& path, uint64_t& contentHash) const {
+    auto it = m_entries.find(path);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    uint64_t size = 0;
+    int64_t writeTime = 0;
+    if (!StatFile(path, size, writeTime) || size != it->second.fileSize || writeTime != it->second.writeTime) {
+        return false;
+    }
+    contentHash = it->second.contentHash;
+    return true;
+}
+
+void TextureIndex::Set(const std::string& path, uint64_t contentHash) {
+    Entry entry = {};
+    entry.contentHash = contentHash;
+    if (!StatFile(path, entry.fileSize, entry.writeTime)) {
+        return;
+    }
+    auto it = m_entries.find(path);
+    if (it != m_entries.end() && it->second.fileSize == entry.fileSize &&
+        it->second.writeTime == entry.writeTime && it->second.contentHash == contentHash) {
+        return;
+    }
+    m_entries[path] = entry;
+    m_dirty = true;
+}
+
+std::string TextureIndex::Canonicalize(const std::string& path) {
+    // Absolute first: with no leading component on disk weakly_canonical
+    // leaves a relative path merely normalized
+    std::error_code ec;
+    fs::path absolute = fs::absolute(path, ec);
+    if (ec) {
+        absolute = path;
+    }
+    fs::path canonical = fs::weakly_canonical(absolute, ec);
+    if (ec) {
+        canonical = absolute.lexically_normal();
+    }
+    return canonical.generic_string();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Content hash of every texture file decoded, by canonical path, kept
+// across launches. A path whose file is unchanged since maps straight to
+// its hash, so a copy of a texture that's already resident is shared
+// without being decoded. Render thread only.
+class TextureIndex {
+public:
+    explicit TextureIndex(std::string path);
+
+    // Read the saved index; a missing or damaged file leaves it empty
+    bool Load();
+
+    // Write the index back if it changed, dropping files that are gone.
+    // Written aside and renamed over.
+    bool Save();
+
+    // Hash recorded for path, if the file still has the size and write
+    // time it had then
+    bool Find(const std::string& path, uint64_t& contentHash) const;
+    void Set(const std::string& path, uint64_t contentHash);
+
+    size_t GetSize() const { return m_entries.size(); }
+
+    // The key for a file: absolute, symlinks resolved, normalized, forward
+    // slashes, so every spelling of one path ("./a.png", "dir/../a.png")
+    // gets the same entry
+    static std::string Canonicalize(const std::string& path);
+
+private:
+    struct Entry {
+        uint64_t fileSize;
+        int64_t writeTime;
+        uint64_t contentHash;
+    };
+
+    std::string m_path;
+    std::unordered_map<std::string, Entry> m_entries;
+    bool m_dirty = false;
+};
@@ -0,0 +1,143 @@
+#include "TextureLoader.h"
+#include <algorithm>
+#include <chrono>
+
+TextureLoader::TextureLoader(DecodeFunction decode, int threadCount)
+    : m_decode(std::move(decode)) {
+    if (threadCount <= 0) {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back(&TextureLoader::WorkerLoop, this);
+    }
+}
+
+TextureLoader::~TextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_jobs.clear();
+    }
+    m_cv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+uint32_t TextureLoader::Request(const std::string& path) {
+    uint32_t id = m_nextId++;
+    if (m_nextId == 0) {
+        m_nextId = 1;
+    }
+    m_states[id] = TextureState::Loading;
+    ++m_loading;
+    ++m_stats.requested;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back({id, path});
+    }
+    m_cv.notify_one();
+    return id;
+}
+
+void TextureLoader::Cancel(uint32_t id) {
+    auto it = m_states.find(id);
+    if (it == m_states.end()) {
+        return;
+    }
+    if (it->second == TextureState::Loading) {
+        --m_loading;
+        ++m_stats.canceled;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto job = std::find_if(m_jobs.begin(), m_jobs.end(), [id](const Job& j) { return j.id == id; });
+        if (job != m_jobs.end()) {
+            m_jobs.erase(job);
+        }
+    }
+    // A decode already running finishes; Update() drops it
+    m_states.erase(it);
+}
+
+TextureState TextureLoader::GetState(uint32_t id) const {
+    auto it = m_states.find(id);
+    return it != m_states.end() ? it->second : TextureState::Failed;
+}
+
+int TextureLoader::Update(TextureUploader& uploader, const TextureUploadBudget& budget) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Result& result : m_finished) {
+            m_uploads.push_back(std::move(result));
+        }
+        m_finished.clear();
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    size_t bytes = 0;
+    int uploaded = 0;
+
+    while (!m_uploads.empty()) {
+        Result& result = m_uploads.front();
+        auto state = m_states.find(result.id);
+        if (state == m_states.end()) {
+            m_uploads.pop_front();   // Canceled while decoding
+            continue;
+        }
+
+        if (result.decoded) {
+            size_t size = result.image.GetByteSize();
+            if (uploaded > 0) {
+                double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                if (bytes + size > budget.bytes || elapsed >= budget.milliseconds) {
+                    ++m_stats.deferredFrames;
+                    break;
+                }
+            }
+            if (uploader.Upload(result.id, result.image)) {
+                state->second = TextureState::Ready;
+                bytes += size;
+                ++uploaded;
+                ++m_stats.uploaded;
+                m_stats.uploadedBytes += size;
+            } else {
+                state->second = TextureState::Failed;
+            }
+        } else {
+            state->second = TextureState::Failed;
+        }
+
+        if (state->second == TextureState::Failed) {
+            ++m_stats.failed;
+            uploader.OnLoadFailed(result.id);
+        }
+        --m_loading;
+        m_uploads.pop_front();
+    }
+    return uploaded;
+}
+
+size_t TextureLoader::GetPendingCount() const {
+    return m_loading;
+}
+
+void TextureLoader::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this] { return !m_running || !m_jobs.empty(); });
+        if (!m_running) {
+            return;
+        }
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+
+        lock.unlock();
+        Result result{job.id, false, {}};
+        result.decoded = m_decode(job.path, result.image);
+        lock.lock();
+
+        m_finished.push_back(std::move(result));
+    }
+}
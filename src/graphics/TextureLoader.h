@@ -0,0 +1,130 @@
+#pragma once
+
+#include "ImageDecoder.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class TextureState : uint8_t {
+    Loading,    // Queued, decoding, or waiting for its upload
+    Ready,
+    Failed
+};
+
+// Render-thread half of a texture load: turns a decoded image into
+// whatever the renderer draws with
+class TextureUploader {
+public:
+    virtual ~TextureUploader() = default;
+
+    // False marks the load Failed
+    virtual bool Upload(uint32_t id, const DecodedImage& image) = 0;
+
+    // Decode or upload failed; id will not come back
+    virtual void OnLoadFailed(uint32_t id) { (void)id; }
+};
+
+// Uploads nothing, only counts; for running the loader headless
+class NullTextureUploader : public TextureUploader {
+public:
+    bool Upload(uint32_t, const DecodedImage& image) override {
+        ++uploads;
+        bytes += image.GetByteSize();
+        return true;
+    }
+
+    uint64_t uploads = 0;
+    uint64_t bytes = 0;
+};
+
+// How much Update() may upload in one frame. The first upload of a call
+// always goes ahead, so an image over the budget still loads.
+struct TextureUploadBudget {
+    size_t bytes = 8 * 1024 * 1024;
+    double milliseconds = 2.0;
+};
+
+struct TextureLoaderStats {
+    uint64_t requested = 0;
+    uint64_t uploaded = 0;
+    uint64_t failed = 0;
+    uint64_t canceled = 0;
+    uint64_t uploadedBytes = 0;
+    uint64_t deferredFrames = 0;    // Update() calls that hit the budget with uploads left
+};
+
+// Decodes images on a worker pool and hands them to a TextureUploader
+// under a per-frame budget. Request() returns at once, so a frame never
+// waits on a decode and never uploads more than the budget allows.
+// Everything but the workers runs on one thread (the render thread); no
+// GPU dependency.
+class TextureLoader {
+public:
+    using DecodeFunction = std::function<bool(const std::string& path, DecodedImage& out)>;
+
+    // threadCount 0 picks one less than the hardware threads, at least one
+    explicit TextureLoader(DecodeFunction decode = DecodeImageFile, int threadCount = 0);
+
+    // Joins the workers; unfinished loads are dropped
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Queue path for decoding; ids are never 0
+    uint32_t Request(const std::string& path);
+
+    // Forget a load: nothing is uploaded for id, and a decode that hasn't
+    // started is skipped. Ready loads just drop their state.
+    void Cancel(uint32_t id);
+
+    // Failed for ids that were canceled or never requested
+    TextureState GetState(uint32_t id) const;
+
+    // Once per frame: uploads finished decodes, oldest first, until the
+    // budget is spent. Returns how many were uploaded.
+    int Update(TextureUploader& uploader, const TextureUploadBudget& budget = {});
+
+    // Loads still queued, decoding or waiting for upload
+    size_t GetPendingCount() const;
+
+    int GetThreadCount() const { return static_cast<int>(m_workers.size()); }
+    const TextureLoaderStats& GetStats() const { return m_stats; }
+
+private:
+    struct Job {
+        uint32_t id;
+        std::string path;
+    };
+
+    struct Result {
+        uint32_t id;
+        bool decoded;
+        DecodedImage image;
+    };
+
+    void WorkerLoop();
+
+    DecodeFunction m_decode;
+    std::vector<std::thread> m_workers;
+
+    // Guarded by m_mutex
+    std::deque<Job> m_jobs;
+    std::vector<Result> m_finished;
+    bool m_running = true;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    // Render thread only
+    std::deque<Result> m_uploads;               // Decoded, over last frame's budget
+    std::unordered_map<uint32_t, TextureState> m_states;
+    uint32_t m_nextId = 1;
+    size_t m_loading = 0;                       // m_states entries still Loading
+    TextureLoaderStats m_stats;
+};
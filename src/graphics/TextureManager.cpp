@@ -1,97 +1,566 @@
 #include "TextureManager.h"
+#include "../core/ContentHash.h"
+#include "../core/Hash.h"
+#include "../core/Logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+namespace {
+
+// Prepared textures from earlier launches; see TextureCache.h
+const char* TEXTURE_CACHE_PATH = "cache/textures";
+constexpr uint64_t TEXTURE_CACHE_BYTES = 256ull * 1024 * 1024;
+// Content hash of each file from earlier launches; see TextureIndex.h
+const char* TEXTURE_INDEX_PATH = "cache/texture_index.bin";
+
+DXGI_FORMAT ToDxgiFormat(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+    case PixelFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+    case PixelFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+    default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+// Identity of the prepared levels, whatever file or cache entry they came
+// from. The cache file's header sits before and between its levels, so
+// each level is hashed on its own.
+uint64_t HashImage(const DecodedImage& image) {
+    const uint32_t shape[] = {
+        uint32_t(image.width), uint32_t(image.height), uint32_t(image.format), uint32_t(image.levels.size())
+    };
+    uint64_t hash = HashBytes(shape, sizeof(shape));
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        hash = HashContent(image.GetLevelData(i), image.levels[i].size, hash);
+    }
+    return hash != 0 ? hash : 1;
+}
+
+// Atlas images are keyed by content
+std::string GetAtlasName(uint64_t contentHash) {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(contentHash));
+    return name;
+}
+
+} // namespace
+
+TextureHandle::TextureHandle(TextureEntry* entry)
+    : m_entry(entry) {
+    if (m_entry) {
+        ++m_entry->refs;
+    }
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other)
+    : TextureHandle(other.m_entry) {
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept
+    : m_entry(other.m_entry) {
+    other.m_entry = nullptr;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle other) noexcept {
+    std::swap(m_entry, other.m_entry);
+    return *this;
+}
+
+TextureHandle::~TextureHandle() {
+    if (m_entry) {
+        --m_entry->refs;
+    }
+}
+
+const Texture& TextureHandle::Get() const {
+    return TextureManager::Instance().Use(*m_entry);
+}
 
 TextureManager& TextureManager::Instance() {
     static TextureManager instance;
     return instance;
 }
 
-void TextureManager::Initialize(ID3D11Device* device) {
+void TextureManager::Initialize(ID3D11Device* device, const TextureDecodeOptions& options) {
     m_device = device;
+    m_device->GetImmediateContext(m_context.ReleaseAndGetAddressOf());
+    m_decodeOptions = options;
+    m_atlas = std::make_unique<TextureAtlas>();
+    m_cache = std::make_unique<TextureCache>(TEXTURE_CACHE_PATH, TEXTURE_CACHE_BYTES);
+    m_index = std::make_unique<TextureIndex>(TEXTURE_INDEX_PATH);
+    m_index->Load();
+    m_loader = std::make_unique<TextureLoader>([this](const std::string& path, DecodedImage& out) {
+        return DecodeTexture(path, out);
+    });
+
+    // Loading textures draw this
+    DecodedImage transparent;
+    transparent.width = 1;
+    transparent.height = 1;
+    transparent.pixels.assign(4, 0);
+    transparent.levels.push_back({1, 1, 4, 0, 4});
+    CreateTexture(transparent, m_placeholder);
 }
 
 void TextureManager::Shutdown() {
+    // Cancels the loads in flight while the loader is still there, then
+    // joins the workers before the textures they'd upload to go away
     ClearAll();
+    m_loader.reset();
+    m_loading.clear();
+    m_cache.reset();
+    if (m_index) {
+        m_index->Save();
+        m_index.reset();
+    }
+    m_atlas.reset();
+    m_placeholder = Texture();
+    m_context.Reset();
     m_device = nullptr;
 }
 
-Texture* TextureManager::LoadTexture(const std::string& path) {
-    // Check if already loaded
-    auto it = m_textures.find(path);
-    if (it != m_textures.end()) {
-        return &it->second;
+TextureHandle TextureManager::LoadTexture(const std::string& rawPath) {
+    const std::string& path = Canonicalize(rawPath);
+    bool resident = false;
+    TextureEntry* entry = FindOrAddEntry(path, resident);
+    if (!entry || resident || ShareKnownContent(*entry)) {
+        return TextureHandle(entry);    // Already loaded (or loading)
+    }
+
+    DecodedImage image;
+    if (!DecodeTexture(path, image) || !PlaceTexture(*entry, image)) {
+        if (entry->refs == 0) {
+            m_textures.erase(path);
+        } else {
+            entry->texture = Texture();
+            entry->texture.state = TextureState::Failed;
+            entry->evicted = false;     // Don't retry on every Get()
+        }
+        return TextureHandle();
     }
+    entry->evicted = false;
+    return TextureHandle(entry);
+}
 
+TextureHandle TextureManager::LoadTextureAsync(const std::string& rawPath) {
+    if (!m_loader) {
+        return TextureHandle();
+    }
+    bool resident = false;
+    TextureEntry* entry = FindOrAddEntry(Canonicalize(rawPath), resident);
+    if (entry && !resident && !ShareKnownContent(*entry)) {
+        RequestEntry(*entry);
+    }
+    return TextureHandle(entry);
+}
+
+void TextureManager::Update() {
+    if (m_loader && !m_loading.empty()) {
+        m_loader->Update(*this, m_uploadBudget);
+    }
+    Trim();
+    ++m_frame;
+}
+
+TextureHandle TextureManager::GetTexture(const std::string& path) {
+    auto it = m_textures.find(Canonicalize(path));
+    if (it == m_textures.end() || it->second.evicted) {
+        return TextureHandle();
+    }
+    it->second.lastUsedFrame = m_frame;
+    return TextureHandle(&it->second);
+}
+
+void TextureManager::UnloadTexture(const std::string& path) {
+    auto it = m_textures.find(Canonicalize(path));
+    if (it == m_textures.end()) {
+        return;
+    }
+    if (it->second.refs > 0) {
+        it->second.lastUsedFrame = 0;   // First to go once unreferenced
+        return;
+    }
+    Evict(it->second);
+    m_textures.erase(it);
+}
+
+void TextureManager::ClearAll() {
+    for (auto it = m_textures.begin(); it != m_textures.end();) {
+        Evict(it->second);
+        it = it->second.refs > 0 ? std::next(it) : m_textures.erase(it);
+    }
+    if (m_atlas) {
+        m_atlas->Clear();
+    }
+    m_atlasPages.clear();
+}
+
+TextureResidencyStats TextureManager::GetResidencyStats() const {
+    TextureResidencyStats stats = m_stats;
+    stats.gpuBytes = GetGpuBytes();
+    stats.cpuBytes = GetCpuBytes();
+    stats.resources = static_cast<uint32_t>(m_contents.size());
+    for (const auto& [path, entry] : m_textures) {
+        if (!entry.evicted) {
+            ++stats.textures;
+        }
+    }
+    return stats;
+}
+
+const std::string& TextureManager::Canonicalize(const std::string& path) {
+    auto it = m_canonicalPaths.find(path);
+    if (it != m_canonicalPaths.end()) {
+        return it->second;
+    }
+    return m_canonicalPaths.emplace(path, TextureIndex::Canonicalize(path)).first->second;
+}
+
+TextureEntry* TextureManager::FindOrAddEntry(const std::string& path, bool& resident) {
     if (!m_device) {
         return nullptr;
     }
 
-    // Load image data
-    int width, height, channels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    auto [it, added] = m_textures.try_emplace(path);
+    TextureEntry& entry = it->second;
+    entry.lastUsedFrame = m_frame;
+    resident = !added && !entry.evicted;
+    if (resident) {
+        ++m_stats.hits;
+        return &entry;
+    }
+
+    ++m_stats.misses;
+    if (added) {
+        entry.path = path;
+        entry.evicted = true;           // Until loaded
+    } else {
+        ++m_stats.reloads;
+    }
+    return &entry;
+}
 
-    if (!data) {
-        return nullptr;
+const Texture& TextureManager::Use(TextureEntry& entry) {
+    entry.lastUsedFrame = m_frame;
+    if (entry.evicted && m_loader) {
+        ++m_stats.misses;
+        ++m_stats.reloads;
+        if (!ShareKnownContent(entry)) {
+            RequestEntry(entry);
+        }
     }
+    return entry.texture;
+}
+
+bool TextureManager::ShareKnownContent(TextureEntry& entry) {
+    uint64_t contentHash = 0;
+    if (!m_index || !m_index->Find(entry.path, contentHash)) {
+        return false;
+    }
+    auto it = m_contents.find(contentHash);
+    if (it == m_contents.end()) {
+        return false;
+    }
+    ++m_stats.shared;
+    ++m_stats.decodesSkipped;
+    Attach(entry, contentHash, it->second);
+    return true;
+}
+
+void TextureManager::Attach(TextureEntry& entry, uint64_t contentHash, SharedTexture& shared) {
+    Detach(entry);
+    entry.texture = shared.texture;
+    entry.contentHash = contentHash;
+    entry.evicted = false;
+    ++shared.users;
+}
+
+void TextureManager::Detach(TextureEntry& entry) {
+    auto it = m_contents.find(entry.contentHash);
+    entry.contentHash = 0;
+    if (it == m_contents.end() || --it->second.users > 0) {
+        return;
+    }
+
+    SharedTexture& shared = it->second;
+    if (shared.atlased) {
+        m_atlas->Remove(GetAtlasName(it->first));
+        if (static_cast<int>(m_atlasPages.size()) > m_atlas->GetPageCount()) {
+            m_atlasPages.resize(m_atlas->GetPageCount());
+        }
+    }
+    m_textureBytes -= shared.gpuBytes;
+    m_contents.erase(it);
+}
+
+void TextureManager::RequestEntry(TextureEntry& entry) {
+    entry.texture = Texture();
+    entry.texture.srv = m_placeholder.srv;
+    entry.texture.state = TextureState::Loading;
+    entry.evicted = false;
+    m_loading[m_loader->Request(entry.path)] = entry.path;
+}
+
+void TextureManager::Evict(TextureEntry& entry) {
+    if (entry.evicted) {
+        return;
+    }
+
+    for (auto it = m_loading.begin(); it != m_loading.end(); ++it) {
+        if (it->second == entry.path) {
+            if (m_loader) {
+                m_loader->Cancel(it->first);
+            }
+            m_loading.erase(it);
+            break;
+        }
+    }
+    Detach(entry);
+    entry.texture = Texture();
+    entry.texture.state = TextureState::Loading;
+    entry.evicted = true;
+    ++m_stats.evictions;
+}
+
+void TextureManager::Trim() {
+    auto withinBudget = [this]() {
+        return GetGpuBytes() <= m_budget.gpuBytes && GetCpuBytes() <= m_budget.cpuBytes;
+    };
+    if (withinBudget()) {
+        return;
+    }
+
+    // Textures used this frame may still be in ImGui's draw data
+    std::vector<TextureEntry*> candidates;
+    for (auto& [path, entry] : m_textures) {
+        if (entry.refs == 0 && !entry.evicted && entry.lastUsedFrame != m_frame) {
+            candidates.push_back(&entry);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const TextureEntry* a, const TextureEntry* b) {
+        return a->lastUsedFrame < b->lastUsedFrame;
+    });
+    for (TextureEntry* entry : candidates) {
+        if (withinBudget()) {
+            break;
+        }
+        Evict(*entry);
+    }
+}
+
+uint64_t TextureManager::GetGpuBytes() const {
+    uint64_t pageBytes = m_atlas ? uint64_t(m_atlas->GetPageSize()) * m_atlas->GetPageSize() * 4 : 0;
+    return m_textureBytes + m_atlasPages.size() * pageBytes;
+}
+
+uint64_t TextureManager::GetCpuBytes() const {
+    return m_atlas ? uint64_t(m_atlas->GetPageCount()) * m_atlas->GetPageSize() * m_atlas->GetPageSize() * 4 : 0;
+}
+
+bool TextureManager::DecodeTexture(const std::string& path, DecodedImage& out) {
+    uint64_t key = TextureCache::MakeKey(path, m_decodeOptions);
+    if (m_cache && m_cache->Load(key, out)) {
+        return true;    // Hashed when stored; PlaceTexture hashes if not
+    }
+    if (!DecodeImageFile(path, out)) {
+        return false;
+    }
+    PrepareImage(out, m_decodeOptions);
+    out.contentHash = HashImage(out);
+    if (m_cache) {
+        m_cache->Store(key, out);
+    }
+    return true;
+}
+
+bool TextureManager::CreateTexture(const DecodedImage& image, Texture& out) {
+    const UINT levelCount = static_cast<UINT>(image.levels.size());
+    const DXGI_FORMAT format = ToDxgiFormat(image.format);
 
-    // Create texture
     D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = width;
-    desc.Height = height;
-    desc.MipLevels = 1;
+    desc.Width = image.width;
+    desc.Height = image.height;
+    desc.MipLevels = levelCount;
     desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.Format = format;
     desc.SampleDesc.Count = 1;
     desc.Usage = D3D11_USAGE_DEFAULT;
     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem = data;
-    initData.SysMemPitch = width * 4;
-
-    Texture texture;
-    texture.width = width;
-    texture.height = height;
-
-    HRESULT hr = m_device->CreateTexture2D(&desc, &initData, texture.texture.GetAddressOf());
-
-    stbi_image_free(data);
+    // Uploaded straight from the decoded levels, or from the cache mapping
+    std::vector<D3D11_SUBRESOURCE_DATA> initData(levelCount);
+    for (UINT i = 0; i < levelCount; ++i) {
+        initData[i].pSysMem = image.GetLevelData(i);
+        initData[i].SysMemPitch = image.levels[i].rowPitch;
+    }
 
+    ComPtr<ID3D11Texture2D> texture;
+    HRESULT hr = m_device->CreateTexture2D(&desc, initData.data(), texture.GetAddressOf());
     if (FAILED(hr)) {
-        return nullptr;
+        return false;
     }
 
     // Create shader resource view
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    srvDesc.Format = format;
     srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-
-    hr = m_device->CreateShaderResourceView(texture.texture.Get(), &srvDesc, texture.srv.GetAddressOf());
+    srvDesc.Texture2D.MipLevels = levelCount;
 
+    ComPtr<ID3D11ShaderResourceView> srv;
+    hr = m_device->CreateShaderResourceView(texture.Get(), &srvDesc, srv.GetAddressOf());
     if (FAILED(hr)) {
-        return nullptr;
+        return false;
     }
 
-    // Store and return
-    m_textures[path] = std::move(texture);
-    return &m_textures[path];
+    out.texture = std::move(texture);
+    out.srv = std::move(srv);
+    out.width = image.width;
+    out.height = image.height;
+    out.state = TextureState::Ready;
+    out.u0 = 0.0f;
+    out.v0 = 0.0f;
+    out.u1 = 1.0f;
+    out.v1 = 1.0f;
+    return true;
 }
 
-Texture* TextureManager::GetTexture(const std::string& path) {
-    auto it = m_textures.find(path);
-    if (it != m_textures.end()) {
-        return &it->second;
+bool TextureManager::PlaceTexture(TextureEntry& entry, const DecodedImage& image) {
+    const uint64_t contentHash = image.contentHash ? image.contentHash : HashImage(image);
+    if (m_index) {
+        m_index->Set(entry.path, contentHash);
+    }
+    auto found = m_contents.find(contentHash);
+    if (found != m_contents.end()) {
+        ++m_stats.shared;
+        Attach(entry, contentHash, found->second);
+        return true;
     }
-    return nullptr;
+
+    SharedTexture shared;
+    const AtlasEntry* placed = nullptr;
+
+    // Level 0 only: atlas images draw at about their own size
+    if (m_atlasEnabled && m_atlas && image.format == PixelFormat::RGBA8 &&
+        m_atlas->Accepts(image.width, image.height)) {
+        const std::string name = GetAtlasName(contentHash);
+        placed = m_atlas->Insert(name, image.GetLevelData(0), image.width, image.height,
+                                 image.levels[0].rowPitch);
+        if (placed) {
+            FlushAtlas();
+        }
+        if (placed && placed->page >= static_cast<int>(m_atlasPages.size())) {
+            m_atlas->Remove(name);          // Page texture creation failed
+            placed = nullptr;
+        }
+    }
+
+    if (placed) {
+        const Texture& page = m_atlasPages[placed->page];
+        shared.texture.texture = page.texture;
+        shared.texture.srv = page.srv;
+        shared.texture.width = image.width;
+        shared.texture.height = image.height;
+        shared.texture.state = TextureState::Ready;
+        SetAtlasUVs(*placed, shared.texture);
+        shared.atlased = true;
+    } else {
+        if (!CreateTexture(image, shared.texture)) {
+            return false;
+        }
+        for (const ImageLevel& level : image.levels) {
+            shared.gpuBytes += level.size;  // GetByteSize() counts a cache file's header too
+        }
+        m_textureBytes += shared.gpuBytes;
+    }
+
+    Attach(entry, contentHash, m_contents.emplace(contentHash, std::move(shared)).first->second);
+    return true;
 }
 
-void TextureManager::UnloadTexture(const std::string& path) {
-    m_textures.erase(path);
+void TextureManager::FlushAtlas() {
+    const int pageSize = m_atlas->GetPageSize();
+    while (static_cast<int>(m_atlasPages.size()) < m_atlas->GetPageCount()) {
+        DecodedImage page;
+        page.width = pageSize;
+        page.height = pageSize;
+        page.mappedData = m_atlas->GetPagePixels(static_cast<int>(m_atlasPages.size()));
+        page.levels.push_back({pageSize, pageSize, uint32_t(pageSize) * 4, 0, size_t(pageSize) * pageSize * 4});
+        Texture texture;
+        if (!CreateTexture(page, texture)) {
+            LOG_WARNING("Failed to create texture atlas page");
+            break;
+        }
+        m_atlasPages.push_back(std::move(texture));
+    }
+
+    // Page rows are contiguous, so each rect uploads straight from the page
+    m_atlas->TakeDirtyRects(m_atlasDirtyRects);
+    for (const AtlasDirtyRect& rect : m_atlasDirtyRects) {
+        if (rect.page >= static_cast<int>(m_atlasPages.size())) {
+            continue;
+        }
+        const uint8_t* page = m_atlas->GetPagePixels(rect.page);
+        D3D11_BOX box = { UINT(rect.x0), UINT(rect.y0), 0, UINT(rect.x1), UINT(rect.y1), 1 };
+        m_context->UpdateSubresource(m_atlasPages[rect.page].texture.Get(), 0, &box,
+                                     page + (size_t(rect.y0) * pageSize + rect.x0) * 4, pageSize * 4, 0);
+    }
+
+    m_atlas->TakeMoved(m_atlasMoved);
+    if (m_atlasMoved.empty()) {
+        return;
+    }
+    std::unordered_set<uint64_t> moved;
+    for (const std::string& name : m_atlasMoved) {
+        uint64_t contentHash = std::strtoull(name.c_str(), nullptr, 16);
+        auto it = m_contents.find(contentHash);
+        const AtlasEntry* entry = m_atlas->Find(name);
+        if (it != m_contents.end() && entry) {
+            SetAtlasUVs(*entry, it->second.texture);
+            moved.insert(contentHash);
+        }
+    }
+    for (auto& [path, entry] : m_textures) {
+        if (entry.contentHash && moved.count(entry.contentHash)) {
+            const Texture& shared = m_contents[entry.contentHash].texture;
+            entry.texture.u0 = shared.u0;
+            entry.texture.v0 = shared.v0;
+            entry.texture.u1 = shared.u1;
+            entry.texture.v1 = shared.v1;
+        }
+    }
 }
 
-void TextureManager::ClearAll() {
-    m_textures.clear();
+void TextureManager::SetAtlasUVs(const AtlasEntry& entry, Texture& out) const {
+    const float scale = 1.0f / m_atlas->GetPageSize();
+    out.u0 = entry.x * scale;
+    out.v0 = entry.y * scale;
+    out.u1 = (entry.x + entry.width) * scale;
+    out.v1 = (entry.y + entry.height) * scale;
+}
+
+bool TextureManager::Upload(uint32_t id, const DecodedImage& image) {
+    auto loading = m_loading.find(id);
+    if (loading == m_loading.end()) {
+        return false;
+    }
+    auto it = m_textures.find(loading->second);
+    if (it == m_textures.end() || !PlaceTexture(it->second, image)) {
+        return false;   // OnLoadFailed() follows
+    }
+    m_loading.erase(loading);
+    return true;
+}
+
+void TextureManager::OnLoadFailed(uint32_t id) {
+    auto loading = m_loading.find(id);
+    if (loading == m_loading.end()) {
+        return;
+    }
+    LOG_WARNING("Failed to load texture %s", loading->second.c_str());
+    auto it = m_textures.find(loading->second);
+    if (it != m_textures.end()) {
+        it->second.texture.state = TextureState::Failed;
+    }
+    m_loading.erase(loading);
 }
@@ -2,41 +2,207 @@
 
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "TextureIndex.h"
+#include "TextureLoader.h"
 
 using Microsoft::WRL::ComPtr;
 
 struct Texture {
     ComPtr<ID3D11Texture2D> texture;
-    ComPtr<ID3D11ShaderResourceView> srv;
-    int width = 0;
+    ComPtr<ID3D11ShaderResourceView> srv;    // A transparent placeholder until Ready
+    int width = 0;                           // 0 until Ready
     int height = 0;
+    TextureState state = TextureState::Ready;
+    // Where the image sits in texture: all of it, or its rectangle in a
+    // shared atlas page. Draw with these, e.g. AddImage(srv, p0, p1, uv0, uv1).
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 1.0f;
+    float v1 = 1.0f;
 };
 
-class TextureManager {
+struct TextureBudget {
+    uint64_t gpuBytes = 256ull * 1024 * 1024;  // Textures and atlas pages
+    uint64_t cpuBytes = 32ull * 1024 * 1024;   // Atlas page copies kept for updates
+};
+
+struct TextureResidencyStats {
+    uint64_t gpuBytes = 0;          // Resident now
+    uint64_t cpuBytes = 0;
+    uint32_t textures = 0;          // Resident paths
+    uint32_t resources = 0;         // Distinct images behind them
+    uint64_t hits = 0;              // Loads served by a resident texture
+    uint64_t misses = 0;            // Loads that decoded, or read the disk cache
+    uint64_t reloads = 0;           // Misses for textures evicted earlier
+    uint64_t shared = 0;            // Misses whose image another path had resident
+    uint64_t decodesSkipped = 0;    // Of those, known from TextureIndex without decoding
+    uint64_t evictions = 0;
+};
+
+// TextureManager's record of one canonical path; TextureHandles point at it
+struct TextureEntry {
+    std::string path;
+    Texture texture;
+    uint32_t refs = 0;
+    uint64_t lastUsedFrame = 0;
+    uint64_t contentHash = 0;       // The shared image it draws; 0 while it has none
+    bool evicted = false;           // Resources released; reloaded on next use
+};
+
+// Keeps a texture resident: TextureManager evicts only textures no handle
+// refers to. Copy to share. Use on the render thread only.
+class TextureHandle {
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other) noexcept;
+    TextureHandle& operator=(TextureHandle other) noexcept;
+    ~TextureHandle();
+
+    // The texture, marked used this frame. If it was unloaded since (see
+    // ClearAll()) it's reloaded in the background, and Loading meanwhile.
+    const Texture& Get() const;
+    const Texture* operator->() const { return &Get(); }
+
+    explicit operator bool() const { return m_entry != nullptr; }
+    const std::string& GetPath() const { return m_entry->path; }
+
+private:
+    friend class TextureManager;
+    explicit TextureHandle(TextureEntry* entry);
+
+    TextureEntry* m_entry = nullptr;
+};
+
+class TextureManager : private TextureUploader {
 public:
     static TextureManager& Instance();
 
-    void Initialize(ID3D11Device* device);
+    // options apply to every texture loaded afterwards, and key the disk
+    // cache (TextureCache)
+    void Initialize(ID3D11Device* device, const TextureDecodeOptions& options = {});
     void Shutdown();
 
-    // Load texture from file (supports PNG, JPG, BMP via stb_image)
-    Texture* LoadTexture(const std::string& path);
+    // Load texture from file (supports PNG, JPG, BMP via stb_image), or
+    // from the disk cache with no decode. Empty handle on failure.
+    // Paths are canonicalized, so spellings of one file share a texture,
+    // and so do files with identical decoded content (see TextureIndex).
+    TextureHandle LoadTexture(const std::string& path);
 
-    // Get already loaded texture
-    Texture* GetTexture(const std::string& path);
+    // Returns at once; the image is decoded on the loader's workers and
+    // uploaded by a later Update(). Until then the texture is Loading and
+    // draws as a transparent placeholder; it stays that way if Failed.
+    TextureHandle LoadTextureAsync(const std::string& path);
 
-    // Unload texture
+    // Call once per frame on the render thread: uploads finished decodes
+    // within the upload budget, then evicts down to the memory budget
+    void Update();
+    void SetUploadBudget(const TextureUploadBudget& budget) { m_uploadBudget = budget; }
+
+    // When resident textures go over budget, the ones no handle refers to
+    // are evicted, least recently used first. Textures used this frame
+    // stay, as ImGui may still draw them.
+    void SetBudget(const TextureBudget& budget) { m_budget = budget; }
+    const TextureBudget& GetBudget() const { return m_budget; }
+
+    // Put small uncompressed images loaded from now on into shared atlas
+    // pages (TextureAtlas) instead of textures of their own, so ImGui draws
+    // them without breaking its batches. On by default.
+    void SetAtlasEnabled(bool enabled) { m_atlasEnabled = enabled; }
+    bool IsAtlasEnabled() const { return m_atlasEnabled && m_atlas; }
+
+    // Already loaded texture; empty if it isn't resident
+    TextureHandle GetTexture(const std::string& path);
+
+    // Evict the texture now, or once its last handle goes
     void UnloadTexture(const std::string& path);
 
-    // Clear all textures
+    // Evict every texture. Ones with handles reload on their next Get().
     void ClearAll();
 
+    TextureResidencyStats GetResidencyStats() const;
+    const TextureLoaderStats* GetLoaderStats() const { return m_loader ? &m_loader->GetStats() : nullptr; }
+    TextureCacheStats GetCacheStats() const { return m_cache ? m_cache->GetStats() : TextureCacheStats(); }
+    const TextureAtlasStats* GetAtlasStats() const { return m_atlas ? &m_atlas->GetStats() : nullptr; }
+
 private:
+    friend class TextureHandle;
+
     TextureManager() = default;
     ~TextureManager() = default;
 
+    // One GPU texture, or atlas image, for every path with its content
+    struct SharedTexture {
+        Texture texture;
+        uint32_t users = 0;
+        uint64_t gpuBytes = 0;      // Of a texture of its own; atlas pages count separately
+        bool atlased = false;
+    };
+
+    // TextureIndex::Canonicalize(), remembered per spelling
+    const std::string& Canonicalize(const std::string& path);
+    // Entry for canonical path, counting the hit or miss; nullptr if there's no device
+    TextureEntry* FindOrAddEntry(const std::string& path, bool& resident);
+    // Point entry at an already resident copy of its image, if the index
+    // knows its content
+    bool ShareKnownContent(TextureEntry& entry);
+    void Attach(TextureEntry& entry, uint64_t contentHash, SharedTexture& shared);
+    // Drop entry's use of its shared image, releasing it after the last
+    void Detach(TextureEntry& entry);
+    // Mark used this frame, and start reloading it if evicted
+    const Texture& Use(TextureEntry& entry);
+    void RequestEntry(TextureEntry& entry);
+    // Release entry's resources, keeping the entry for handles and stats
+    void Evict(TextureEntry& entry);
+    // Evict unreferenced textures, least recently used first, until within m_budget
+    void Trim();
+    uint64_t GetGpuBytes() const;
+    uint64_t GetCpuBytes() const;
+
+    // Decode and prepare path per m_decodeOptions, through the disk cache;
+    // runs on the loader's workers
+    bool DecodeTexture(const std::string& path, DecodedImage& out);
+    bool CreateTexture(const DecodedImage& image, Texture& out);
+    // Share a resident copy of image, else create one: into the atlas when
+    // it takes the image, else CreateTexture()
+    bool PlaceTexture(TextureEntry& entry, const DecodedImage& image);
+    // Create new atlas pages, upload changed areas and move the UVs of
+    // images the atlas repacked
+    void FlushAtlas();
+    void SetAtlasUVs(const AtlasEntry& entry, Texture& out) const;
+
+    // TextureUploader, called from Update()
+    bool Upload(uint32_t id, const DecodedImage& image) override;
+    void OnLoadFailed(uint32_t id) override;
+
     ID3D11Device* m_device = nullptr;
-    std::unordered_map<std::string, Texture> m_textures;
+    ComPtr<ID3D11DeviceContext> m_context;
+    std::unordered_map<std::string, TextureEntry> m_textures;   // Nodes stay put; handles point at them
+    std::unordered_map<uint64_t, SharedTexture> m_contents;     // By content hash
+    std::unordered_map<std::string, std::string> m_canonicalPaths;
+    std::unique_ptr<TextureIndex> m_index;
+
+    TextureBudget m_budget;
+    TextureResidencyStats m_stats;
+    uint64_t m_frame = 1;
+    uint64_t m_textureBytes = 0;    // Sum of m_contents' gpuBytes
+
+    TextureDecodeOptions m_decodeOptions;
+    std::unique_ptr<TextureCache> m_cache;
+    std::unique_ptr<TextureLoader> m_loader;
+    std::unordered_map<uint32_t, std::string> m_loading;   // Loader id -> path
+    TextureUploadBudget m_uploadBudget;
+    Texture m_placeholder;
+
+    bool m_atlasEnabled = true;
+    std::unique_ptr<TextureAtlas> m_atlas;
+    std::vector<Texture> m_atlasPages;
+    std::vector<AtlasDirtyRect> m_atlasDirtyRects;
+    std::vector<std::string> m_atlasMoved;
 };
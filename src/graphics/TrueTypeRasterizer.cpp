@@ -0,0 +1,78 @@
+#include "TrueTypeRasterizer.h"
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+TrueTypeRasterizer::TrueTypeRasterizer() = default;
+TrueTypeRasterizer::~TrueTypeRasterizer() = default;
+
+bool TrueTypeRasterizer::Load(const std::string& path, float pixelHeight) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    auto font = std::make_unique<stbtt_fontinfo>();
+    int offset = stbtt_GetFontOffsetForIndex(m_data.data(), 0);
+    if (offset < 0 || !stbtt_InitFont(font.get(), m_data.data(), offset)) {
+        m_data.clear();
+        return false;
+    }
+
+    m_font = std::move(font);
+    m_scale = stbtt_ScaleForPixelHeight(m_font.get(), pixelHeight);
+
+    int ascent = 0, descent = 0, lineGap = 0;
+    stbtt_GetFontVMetrics(m_font.get(), &ascent, &descent, &lineGap);
+    m_ascent = std::ceil(ascent * m_scale);
+    return true;
+}
+
+bool TrueTypeRasterizer::Rasterize(uint32_t codepoint, GlyphBitmap& out) {
+    if (!m_font) {
+        return false;
+    }
+
+    int glyph = stbtt_FindGlyphIndex(m_font.get(), static_cast<int>(codepoint));
+    if (glyph == 0) {
+        return false;
+    }
+
+    int advance = 0;
+    int leftBearing = 0;
+    stbtt_GetGlyphHMetrics(m_font.get(), glyph, &advance, &leftBearing);
+
+    out.advanceX = advance * m_scale;
+
+    if (m_sdfSpread > 0) {
+        // nullptr for glyphs with no outline (spaces)
+        int width = 0, height = 0, xoff = 0, yoff = 0;
+        unsigned char* sdf = stbtt_GetGlyphSDF(m_font.get(), m_scale, glyph, m_sdfSpread, SDF_ON_EDGE,
+                                               float(SDF_ON_EDGE) / m_sdfSpread, &width, &height, &xoff, &yoff);
+        out.width = sdf ? width : 0;
+        out.height = sdf ? height : 0;
+        out.offsetX = xoff;
+        out.offsetY = yoff;
+        out.alpha.assign(sdf, sdf + size_t(out.width) * out.height);
+        stbtt_FreeSDF(sdf, nullptr);
+        return true;
+    }
+
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    stbtt_GetGlyphBitmapBox(m_font.get(), glyph, m_scale, m_scale, &x0, &y0, &x1, &y1);
+
+    out.width = x1 - x0;
+    out.height = y1 - y0;
+    out.offsetX = x0;
+    out.offsetY = y0;
+    out.alpha.assign(size_t(out.width) * out.height, 0);
+    if (out.width > 0 && out.height > 0) {
+        stbtt_MakeGlyphBitmap(m_font.get(), out.alpha.data(), out.width, out.height, out.width,
+                              m_scale, m_scale, glyph);
+    }
+    return true;
+}
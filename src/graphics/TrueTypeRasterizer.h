@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GlyphCache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct stbtt_fontinfo;
+
+// GlyphRasterizer over a TrueType/OpenType file via stb_truetype, scaled
+// the way ImGui scales a font of the same pixel size
+class TrueTypeRasterizer : public GlyphRasterizer {
+public:
+    TrueTypeRasterizer();
+    ~TrueTypeRasterizer() override;
+
+    bool Load(const std::string& path, float pixelHeight);
+
+    // Produce signed distance fields instead of coverage, falling off over
+    // spread pixels on each side of the outline. 0 turns it off.
+    void SetSdf(int spread) { m_sdfSpread = spread; }
+
+    // Rounded up, like ImFont::Ascent
+    float GetAscent() const { return m_ascent; }
+
+    bool Rasterize(uint32_t codepoint, GlyphBitmap& out) override;
+
+private:
+    std::vector<unsigned char> m_data;   // stb_truetype reads the file in place
+    std::unique_ptr<stbtt_fontinfo> m_font;
+    float m_scale = 0.0f;
+    float m_ascent = 0.0f;
+    int m_sdfSpread = 0;
+};
@@ -0,0 +1,74 @@
+#include "Catalog.h"
+#include "../core/Logger.h"
+
+namespace i18n {
+
+void Catalog::Build(const lpak::Entries& entries) {
+    std::vector<std::pair<std::string, std::string>> collisions;
+    lpak::BuildTable(entries, m_ownedSlots, m_ownedBlob, collisions);
+    for (const auto& [kept, dropped] : collisions) {
+        LOG_WARNING("Localization keys '%s' and '%s' have the same hash; keeping the first",
+                    kept.c_str(), dropped.c_str());
+    }
+
+    m_file.Close();
+    m_header = nullptr;
+    m_slots = m_ownedSlots.data();
+    m_blob = m_ownedBlob.data();
+    m_blobSize = static_cast<uint32_t>(m_ownedBlob.size());
+    m_mask = m_ownedSlots.size() - 1;
+    m_count = 0;
+    for (const lpak::Slot& slot : m_ownedSlots) {
+        m_count += (slot.offset != lpak::EMPTY);
+    }
+}
+
+bool Catalog::Map(const std::string& path) {
+    // Empty until the pack checks out
+    m_slots = nullptr;
+    m_header = nullptr;
+    m_count = 0;
+    if (!m_file.Open(path)) {
+        return false;
+    }
+
+    const unsigned char* data = m_file.GetData();
+    const lpak::Header* header = lpak::Validate(data, m_file.GetSize());
+    if (!header) {
+        LOG_WARNING("Ignoring malformed language pack %s", path.c_str());
+        m_file.Close();
+        return false;
+    }
+
+    m_ownedSlots.clear();
+    m_ownedBlob.clear();
+    m_header = header;
+    m_slots = reinterpret_cast<const lpak::Slot*>(data + sizeof(lpak::Header));
+    m_blob = reinterpret_cast<const char*>(m_slots + header->slotCount);
+    m_blobSize = header->blobSize;
+    m_mask = header->slotCount - 1;
+    m_count = header->entryCount;
+    return true;
+}
+
+const char* Catalog::Find(uint64_t hash, size_t& slotIndex) const {
+    if (!m_slots) {
+        return nullptr;
+    }
+
+    // A free slot ends the probe; the bound only matters for a damaged pack
+    size_t index = hash & m_mask;
+    for (size_t probe = 0; probe <= m_mask; ++probe, index = (index + 1) & m_mask) {
+        const lpak::Slot& slot = m_slots[index];
+        if (slot.offset == lpak::EMPTY) {
+            return nullptr;
+        }
+        if (slot.hash == hash) {
+            slotIndex = index;
+            return slot.offset < m_blobSize ? m_blob + slot.offset : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace i18n
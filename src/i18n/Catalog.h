@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LangPack.h"
+#include "../core/MappedFile.h"
+
+namespace i18n {
+
+// One language's strings in a flat open-addressing table keyed by the
+// FNV-1a hash of the dotted key, either built in memory or mapped straight
+// from a .lpak. Lookups never allocate, and returned text lives as long as
+// the catalog.
+class Catalog {
+public:
+    Catalog() = default;
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
+
+    // From flattened JSON; see lpak::BuildTable
+    void Build(const lpak::Entries& entries);
+
+    // Map a compiled pack without copying it; false if it isn't one
+    bool Map(const std::string& path);
+
+    // Header of the mapped pack, nullptr for a built catalog
+    const lpak::Header* GetPackHeader() const { return m_header; }
+
+    // Text for the key hash, or nullptr
+    const char* Find(uint64_t hash) const {
+        size_t slot;
+        return Find(hash, slot);
+    }
+    // Also returns the text's slot, unique per entry and below GetSlotCount()
+    const char* Find(uint64_t hash, size_t& slot) const;
+
+    size_t GetSize() const { return m_count; }
+    size_t GetSlotCount() const { return m_slots ? m_mask + 1 : 0; }
+
+private:
+    // Views of m_ownedSlots/m_ownedBlob or of m_file
+    const lpak::Slot* m_slots = nullptr;
+    const char* m_blob = nullptr;
+    uint32_t m_blobSize = 0;
+    size_t m_mask = 0;
+    size_t m_count = 0;
+
+    std::vector<lpak::Slot> m_ownedSlots;
+    std::string m_ownedBlob;
+    MappedFile m_file;
+    const lpak::Header* m_header = nullptr;
+};
+
+} // namespace i18n
@@ -0,0 +1,104 @@
+#include "LangPack.h"
+#include "../core/Hash.h"
+#include <nlohmann/json.hpp>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+namespace lpak {
+
+namespace {
+
+void FlattenJson(const std::string& prefix, const nlohmann::json& obj, Entries& out) {
+    for (auto& [key, value] : obj.items()) {
+        std::string fullKey = prefix.empty() ? key : prefix + "." + key;
+
+        if (value.is_string()) {
+            out.emplace_back(std::move(fullKey), value.get<std::string>());
+        }
+        else if (value.is_object()) {
+            FlattenJson(fullKey, value, out);
+        }
+    }
+}
+
+} // namespace
+
+bool ParseJson(const std::string& text, Entries& out) {
+    try {
+        nlohmann::json j = nlohmann::json::parse(text);
+
+        Entries entries;
+        FlattenJson("", j, entries);
+        out = std::move(entries);
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+void BuildTable(const Entries& entries, std::vector<Slot>& slots, std::string& blob,
+                std::vector<std::pair<std::string, std::string>>& collisions) {
+    size_t capacity = 16;
+    while (capacity < entries.size() * 2) {
+        capacity *= 2;
+    }
+
+    slots.assign(capacity, Slot{0, EMPTY, 0});
+    blob.clear();
+    std::vector<const std::string*> keys(capacity, nullptr);
+    std::unordered_map<std::string_view, uint32_t> textOffsets;
+    size_t mask = capacity - 1;
+
+    for (const auto& [key, value] : entries) {
+        uint64_t hash = HashString(key);
+        size_t index = hash & mask;
+        while (slots[index].offset != EMPTY && slots[index].hash != hash) {
+            index = (index + 1) & mask;
+        }
+
+        if (slots[index].offset != EMPTY && *keys[index] != key) {
+            collisions.emplace_back(*keys[index], key);
+            continue;
+        }
+
+        auto [it, inserted] = textOffsets.try_emplace(value, static_cast<uint32_t>(blob.size()));
+        if (inserted) {
+            blob.append(value);
+            blob.push_back('\0');
+        }
+
+        slots[index] = Slot{hash, it->second, 0};
+        keys[index] = &key;
+    }
+}
+
+const Header* Validate(const unsigned char* data, size_t size) {
+    if (size < sizeof(Header)) {
+        return nullptr;
+    }
+
+    // Mapped views are page aligned
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != VERSION ||
+        header->slotCount == 0 ||
+        (header->slotCount & (header->slotCount - 1)) != 0 ||
+        header->entryCount > header->slotCount / 2) {
+        return nullptr;
+    }
+
+    uint64_t expected = sizeof(Header) + uint64_t(header->slotCount) * sizeof(Slot) + header->blobSize;
+    if (size != expected) {
+        return nullptr;
+    }
+
+    // Every text ends inside the blob
+    if (header->blobSize > 0 && data[size - 1] != '\0') {
+        return nullptr;
+    }
+    return header;
+}
+
+} // namespace lpak
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// .lpak: one language catalog compiled from assets/lang/<code>.json by
+// LangPackCompiler and memory-mapped by Localization. Shared by the app and
+// the tool. Layout, host byte order:
+//   Header | Slot[slotCount] | blob of NUL-terminated UTF-8 texts
+namespace lpak {
+
+constexpr char MAGIC[4] = {'L', 'P', 'A', 'K'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t EMPTY = UINT32_MAX;   // Slot::offset of a free slot
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;    // JSON the pack was compiled from, to spot a stale pack
+    uint64_t sourceHash;    // HashBytes of that JSON
+    uint32_t slotCount;     // Power of two
+    uint32_t entryCount;
+    uint32_t blobSize;
+    uint32_t reserved;
+};
+
+// Open addressing with linear probing on the FNV-1a hash of the dotted key
+// (HashString), at most half full
+struct Slot {
+    uint64_t hash;
+    uint32_t offset;        // Into the blob
+    uint32_t reserved;
+};
+
+using Entries = std::vector<std::pair<std::string, std::string>>;
+
+// Flatten nested JSON objects into (dotted key, text); false on bad JSON
+bool ParseJson(const std::string& text, Entries& out);
+
+// Lay out the table and blob; identical texts are stored once and a
+// repeated key replaces the earlier text. A key whose hash matches a
+// different, earlier key is left out and reported in collisions.
+void BuildTable(const Entries& entries, std::vector<Slot>& slots, std::string& blob,
+                std::vector<std::pair<std::string, std::string>>& collisions);
+
+// Header of a well-formed pack in memory, or nullptr. Checks only the
+// header and sizes, so it costs the same for any pack size.
+const Header* Validate(const unsigned char* data, size_t size);
+
+} // namespace lpak
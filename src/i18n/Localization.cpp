@@ -1,33 +1,65 @@
 #include "Localization.h"
-#include <nlohmann/json.hpp>
+#include "../core/Hash.h"
+#include "../core/Logger.h"
+#include "../core/MappedFile.h"
 #include <fstream>
 #include <filesystem>
+#include <iterator>
+#include <set>
 
 namespace fs = std::filesystem;
 
 namespace i18n {
 
-// Local helper function to parse nested JSON
-static void ParseNestedJsonHelper(const std::string& prefix, const nlohmann::json& obj,
-                                   std::unordered_map<std::string, std::string>& strings) {
-    for (auto& [key, value] : obj.items()) {
-        std::string fullKey = prefix.empty() ? key : prefix + "." + key;
+namespace {
 
-        if (value.is_string()) {
-            strings[fullKey] = value.get<std::string>();
-        }
-        else if (value.is_object()) {
-            ParseNestedJsonHelper(fullKey, value, strings);
-        }
+// Use <code>.lpak unless the JSON next to it has changed since the pack
+// was compiled. Hashing the JSON is allocation-free and far cheaper than
+// parsing it.
+bool LoadPack(const std::string& packPath, const std::string& jsonPath, Catalog& catalog) {
+    if (!catalog.Map(packPath)) {
+        return false;
+    }
+
+    MappedFile source;
+    if (!source.Open(jsonPath)) {
+        return true;   // Shipped without the JSON
     }
+
+    const lpak::Header* header = catalog.GetPackHeader();
+    if (source.GetSize() != header->sourceSize ||
+        HashBytes(source.GetData(), source.GetSize()) != header->sourceHash) {
+        LOG_INFO("Language pack %s is stale, loading %s", packPath.c_str(), jsonPath.c_str());
+        return false;
+    }
+    return true;
 }
 
+bool LoadJson(const std::string& jsonPath, Catalog& catalog) {
+    std::ifstream file(jsonPath, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    lpak::Entries strings;
+    if (!lpak::ParseJson(text, strings)) {
+        return false;
+    }
+
+    catalog.Build(strings);
+    return true;
+}
+
+} // namespace
+
 Localization& Localization::Instance() {
     static Localization instance;
     return instance;
 }
 
-Localization::Localization() {
+Localization::Localization()
+    : m_catalog(std::make_unique<Catalog>()) {
     m_availableLanguages = {
         {"zh-CN", "Chinese (Simplified)", "\xe7\xae\x80\xe4\xbd\x93\xe4\xb8\xad\xe6\x96\x87"},
         {"zh-TW", "Chinese (Traditional)", "\xe7\xb9\x81\xe9\xab\x94\xe4\xb8\xad\xe6\x96\x87"},
@@ -35,68 +67,232 @@ Localization::Localization() {
     };
 }
 
+Localization::~Localization() {
+    Shutdown();
+}
+
+void Localization::SetTextObserver(TextObserver observer) {
+    m_textObserver = observer;
+    m_observerThread = std::this_thread::get_id();
+    m_observed.assign(m_catalog->GetSlotCount(), 0);
+}
+
+void Localization::SetBasePath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_loaderMutex);
+    m_basePath = path;
+}
+
 bool Localization::LoadLanguage(const std::string& langCode) {
-    std::string filePath = m_basePath + "/" + langCode + ".json";
+    std::string basePath;
+    {
+        std::lock_guard<std::mutex> lock(m_loaderMutex);
+        basePath = m_basePath;
+    }
 
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
+    std::unique_ptr<Catalog> catalog = ReadCatalog(basePath, langCode);
+    if (!catalog) {
         return false;
     }
+    Install(std::move(catalog), langCode);
+    return true;
+}
+
+void Localization::RequestLanguage(const std::string& langCode) {
+    std::lock_guard<std::mutex> lock(m_loaderMutex);
+    StartLoader();
+    m_requestedLanguage = langCode;
+    m_loaderCv.notify_one();
+}
 
-    try {
-        nlohmann::json j;
-        file >> j;
+void Localization::RequestLanguageScan() {
+    std::lock_guard<std::mutex> lock(m_loaderMutex);
+    StartLoader();
+    m_scanRequested = true;
+    m_loaderCv.notify_one();
+}
 
-        m_strings.clear();
-        ParseNestedJsonHelper("", j, m_strings);
+void Localization::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_loaderMutex);
+        if (!m_loaderRunning) {
+            return;
+        }
+        m_loaderRunning = false;
+        m_requestedLanguage.clear();
+        m_scanRequested = false;
+    }
+    m_loaderCv.notify_one();
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+}
+
+std::unique_ptr<Catalog> Localization::ReadCatalog(const std::string& basePath, const std::string& langCode) {
+    std::string path = basePath + "/" + langCode;
 
-        m_currentLanguage = langCode;
-        return true;
+    auto catalog = std::make_unique<Catalog>();
+    if (!LoadPack(path + ".lpak", path + ".json", *catalog) &&
+        !LoadJson(path + ".json", *catalog)) {
+        return nullptr;
     }
-    catch (const std::exception&) {
-        return false;
+    return catalog;
+}
+
+void Localization::Install(std::unique_ptr<Catalog> catalog, const std::string& langCode) {
+    // Text from the old catalog may still be in use this frame
+    m_retired.push_back(std::move(m_catalog));
+    m_catalog = std::move(catalog);
+    ++m_generation;
+
+    m_currentLanguage = langCode;
+
+    m_observed.assign(m_catalog->GetSlotCount(), 0);
+    if (m_textObserver) {
+        m_textObserver(nullptr);
     }
 }
 
-const char* Localization::Get(const std::string& key) const {
-    auto it = m_strings.find(key);
-    if (it != m_strings.end()) {
-        return it->second.c_str();
+// Caller holds m_loaderMutex
+void Localization::StartLoader() {
+    if (m_loaderRunning) {
+        return;
+    }
+    if (m_loader.joinable()) {
+        m_loader.join();   // Left over from an earlier Shutdown()
     }
+    m_loaderRunning = true;
+    m_loader = std::thread(&Localization::LoaderLoop, this);
+}
+
+void Localization::LoaderLoop() {
+    std::unique_lock<std::mutex> lock(m_loaderMutex);
+    while (true) {
+        m_loaderCv.wait(lock, [this] {
+            return !m_loaderRunning || m_scanRequested || !m_requestedLanguage.empty();
+        });
+        if (!m_loaderRunning) {
+            return;
+        }
+        std::string basePath = m_basePath;
+
+        // A pending switch is what the user is waiting for; scan after it
+        if (!m_requestedLanguage.empty()) {
+            std::string langCode = std::move(m_requestedLanguage);
+            m_requestedLanguage.clear();
+
+            lock.unlock();
+            std::unique_ptr<Catalog> catalog = ReadCatalog(basePath, langCode);
+            lock.lock();
 
-    m_fallback = "[" + key + "]";
-    return m_fallback.c_str();
+            if (!catalog) {
+                LOG_WARNING("Failed to load language %s", langCode.c_str());
+            } else if (m_requestedLanguage.empty()) {
+                m_loadedCatalog = std::move(catalog);
+                m_loadedLanguage = std::move(langCode);
+                m_resultReady.store(true, std::memory_order_release);
+            }
+            continue;
+        }
+
+        m_scanRequested = false;
+        lock.unlock();
+        std::vector<LanguageInfo> languages = ScanAvailableLanguages(basePath);
+        lock.lock();
+
+        // Keep the built-in list if the directory held nothing usable
+        if (!languages.empty()) {
+            m_scannedLanguages = std::move(languages);
+            m_scanFinished = true;
+            m_resultReady.store(true, std::memory_order_release);
+        }
+    }
 }
 
-void Localization::ScanAvailableLanguages() {
-    m_availableLanguages.clear();
+const char* Localization::Get(Key key) const {
+    size_t slot = 0;
+    if (const char* text = m_catalog->Find(key.hash, slot)) {
+        if (m_textObserver && std::this_thread::get_id() == m_observerThread && !m_observed[slot]) {
+            m_observed[slot] = 1;
+            m_textObserver(text);
+        }
+        return text;
+    }
+    return Miss(key);
+}
 
-    if (!fs::exists(m_basePath)) {
+const char* Localization::Miss(Key key) const {
+    std::lock_guard<std::mutex> lock(m_missMutex);
+    ++m_missCount;
+
+    auto [it, inserted] = m_misses.try_emplace(key.hash, MissEntry{nullptr, 0});
+    if (inserted) {
+        it->second.text = m_missText.Intern(std::string("[") + key.text + "]");
+        LOG_WARNING("Missing localization key '%s' (%s)", key.text, m_currentLanguage.c_str());
+    }
+    ++it->second.count;
+    return it->second.text;
+}
+
+void Localization::BeginFrame() {
+    m_retired.clear();
+    if (!m_resultReady.load(std::memory_order_acquire)) {
         return;
     }
 
-    for (const auto& entry : fs::directory_iterator(m_basePath)) {
-        if (entry.path().extension() == ".json") {
-            std::string code = entry.path().stem().string();
-
-            std::ifstream file(entry.path());
-            if (file.is_open()) {
-                try {
-                    nlohmann::json j;
-                    file >> j;
-
-                    LanguageInfo info;
-                    info.code = code;
-                    info.name = j.value("_language_name", code);
-                    info.nativeName = j.value("_language_native", code);
-                    m_availableLanguages.push_back(info);
-                }
-                catch (...) {
-                    m_availableLanguages.push_back({code, code, code});
-                }
+    std::lock_guard<std::mutex> lock(m_loaderMutex);
+    m_resultReady.store(false, std::memory_order_relaxed);
+    if (m_loadedCatalog) {
+        Install(std::move(m_loadedCatalog), m_loadedLanguage);
+    }
+    if (m_scanFinished) {
+        m_availableLanguages = std::move(m_scannedLanguages);
+        m_scannedLanguages.clear();
+        m_scanFinished = false;
+    }
+}
+
+uint64_t Localization::GetMissCount() const {
+    std::lock_guard<std::mutex> lock(m_missMutex);
+    return m_missCount;
+}
+
+std::vector<MissingKey> Localization::GetMissingKeys() const {
+    std::lock_guard<std::mutex> lock(m_missMutex);
+    std::vector<MissingKey> keys;
+    keys.reserve(m_misses.size());
+    for (const auto& [hash, entry] : m_misses) {
+        // Strip the brackets back off
+        std::string_view text(entry.text);
+        keys.push_back({std::string(text.substr(1, text.size() - 2)), entry.count});
+    }
+    return keys;
+}
+
+std::vector<LanguageInfo> Localization::ScanAvailableLanguages(const std::string& basePath) {
+    std::vector<LanguageInfo> languages;
+
+    std::error_code ec;
+    std::set<std::string> codes;   // A language may have both a pack and JSON
+    for (fs::directory_iterator it(basePath, ec), end; !ec && it != end; it.increment(ec)) {
+        fs::path extension = it->path().extension();
+        if (extension == ".json" || extension == ".lpak") {
+            codes.insert(it->path().stem().string());
+        }
+    }
+
+    for (const std::string& code : codes) {
+        LanguageInfo info = {code, code, code};
+        if (std::unique_ptr<Catalog> catalog = ReadCatalog(basePath, code)) {
+            if (const char* name = catalog->Find(I18N_KEY("_language_name").hash)) {
+                info.name = name;
+            }
+            if (const char* nativeName = catalog->Find(I18N_KEY("_language_native").hash)) {
+                info.nativeName = nativeName;
             }
         }
+        languages.push_back(std::move(info));
     }
+    return languages;
 }
 
 } // namespace i18n
@@ -1,53 +1,152 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
+#include "Catalog.h"
+#include "StringPool.h"
+#include "../core/Hash.h"
 
 namespace i18n {
 
+// Catalog key: T(I18N_KEY("login.tab_cardkey"))
+struct Key {
+    uint64_t hash;
+    const char* text;   // Shown as "[key]" when the catalog lacks it
+};
+
+// Key for a literal, hashed at compile time. The hash is passed through a
+// template argument because C++17 only has to fold a constexpr call in a
+// constant context; passed straight to T() it may run at runtime, and
+// does under MSVC /Od.
+#define I18N_KEY(text) (::i18n::Key{std::integral_constant<uint64_t, ::HashString(text)>::value, text})
+
 struct LanguageInfo {
     std::string code;
     std::string name;
     std::string nativeName;
 };
 
+struct MissingKey {
+    std::string key;
+    uint64_t count;   // Lookups that fell back to "[key]"
+};
+
 class Localization {
 public:
     static Localization& Instance();
 
+    // Load on the calling thread; for startup, before the first frame
     bool LoadLanguage(const std::string& langCode);
 
+    // Build the language's catalog on the loader thread. The current one
+    // stays in use until the BeginFrame() after the new one is ready; a
+    // newer request supersedes one still loading.
+    void RequestLanguage(const std::string& langCode);
+
+    // Rescan the base path for .lpak/.json languages on the loader thread;
+    // GetAvailableLanguages() changes at a BeginFrame()
+    void RequestLanguageScan();
+
+    // Stop the loader thread, dropping unfinished requests
+    void Shutdown();
+
     const std::string& GetCurrentLanguage() const { return m_currentLanguage; }
 
     const std::vector<LanguageInfo>& GetAvailableLanguages() const { return m_availableLanguages; }
 
-    const char* Get(const std::string& key) const;
+    // Returned text stays valid until the next BeginFrame(), even across a
+    // language switch. A missing key yields "[key]", valid for good.
+    const char* Get(Key key) const;
+    // Keys built at runtime; literals should use I18N_KEY
+    const char* Get(const std::string& key) const { return Get(Key{HashString(key), key.c_str()}); }
+
+    // Call once per frame before any lookup. Installs what the loader
+    // thread finished and frees catalogs replaced during the previous frame.
+    void BeginFrame();
 
-    void SetBasePath(const std::string& path) { m_basePath = path; }
+    // Bumped by every language change; text fetched under an older generation
+    // must not be kept past the frame
+    uint64_t GetGeneration() const { return m_generation; }
+
+    uint64_t GetMissCount() const;
+    std::vector<MissingKey> GetMissingKeys() const;
+
+    // Sees each catalog text once, the first time Get() returns it on the
+    // thread that set the observer (lookups on other threads aren't
+    // reported), and nullptr when a language change replaces the catalog.
+    // The font uses it to keep the glyphs of UI text loaded.
+    using TextObserver = void (*)(const char* text);
+    void SetTextObserver(TextObserver observer);
+
+    void SetBasePath(const std::string& path);
 
 private:
     Localization();
-    ~Localization() = default;
+    ~Localization();
+
+    static std::unique_ptr<Catalog> ReadCatalog(const std::string& basePath, const std::string& langCode);
+    static std::vector<LanguageInfo> ScanAvailableLanguages(const std::string& basePath);
+
+    void Install(std::unique_ptr<Catalog> catalog, const std::string& langCode);
+    void StartLoader();
+    void LoaderLoop();
 
-    void ScanAvailableLanguages();
+    const char* Miss(Key key) const;
 
-    std::string m_basePath = "assets/lang";
+    std::string m_basePath = "assets/lang";   // Guarded by m_loaderMutex
     std::string m_currentLanguage;
-    std::unordered_map<std::string, std::string> m_strings;
+    std::unique_ptr<Catalog> m_catalog;
+    std::vector<std::unique_ptr<Catalog>> m_retired;   // Replaced this frame
+    uint64_t m_generation = 0;
     std::vector<LanguageInfo> m_availableLanguages;
-
-    mutable std::string m_fallback;
+    TextObserver m_textObserver = nullptr;
+    std::thread::id m_observerThread;
+    mutable std::vector<uint8_t> m_observed;   // Catalog slots already reported
+
+    // "[key]" text per missing key hash, allocated once per key
+    struct MissEntry {
+        const char* text;
+        uint64_t count;
+    };
+    mutable std::unordered_map<uint64_t, MissEntry> m_misses;
+    mutable StringPool m_missText;
+    mutable uint64_t m_missCount = 0;
+    mutable std::mutex m_missMutex;
+
+    // Loader thread. Requests and results are guarded by m_loaderMutex;
+    // m_resultReady lets BeginFrame skip the lock when nothing finished.
+    std::thread m_loader;
+    bool m_loaderRunning = false;
+    std::string m_requestedLanguage;            // Empty if none pending
+    bool m_scanRequested = false;
+    std::unique_ptr<Catalog> m_loadedCatalog;
+    std::string m_loadedLanguage;
+    std::vector<LanguageInfo> m_scannedLanguages;
+    bool m_scanFinished = false;
+    std::atomic<bool> m_resultReady{false};
+    std::mutex m_loaderMutex;
+    std::condition_variable m_loaderCv;
 };
 
-// Convenience function
+// Convenience functions
+inline const char* T(Key key) {
+    return Localization::Instance().Get(key);
+}
+
 inline const char* T(const std::string& key) {
     return Localization::Instance().Get(key);
 }
 
-// Set language
-inline bool SetLanguage(const std::string& langCode) {
-    return Localization::Instance().LoadLanguage(langCode);
+// Switch language in the background; takes effect at a frame boundary
+inline void SetLanguage(const std::string& langCode) {
+    Localization::Instance().RequestLanguage(langCode);
 }
 
 // Get current language
@@ -0,0 +1,74 @@
+#include "StringPool.h"
+#include "../core/Hash.h"
+#include <cstring>
+
+namespace i18n {
+
+const char* StringPool::Intern(std::string_view text) {
+    if ((m_count + 1) * 2 > m_entries.size()) {
+        Grow();
+    }
+
+    uint64_t hash = HashString(text);
+    size_t mask = m_entries.size() - 1;
+    size_t index = hash & mask;
+    for (; m_entries[index].text; index = (index + 1) & mask) {
+        const Entry& entry = m_entries[index];
+        if (entry.hash == hash && std::string_view(entry.text, entry.length) == text) {
+            return entry.text;
+        }
+    }
+
+    char* copy = Allocate(text.size() + 1);
+    std::memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+
+    m_entries[index] = Entry{hash, copy, text.size()};
+    ++m_count;
+    return copy;
+}
+
+void StringPool::Clear() {
+    m_blocks.clear();
+    m_block = nullptr;
+    m_blockUsed = BLOCK_SIZE;
+    m_bytesUsed = 0;
+    m_entries.clear();
+    m_count = 0;
+}
+
+char* StringPool::Allocate(size_t size) {
+    m_bytesUsed += size;
+    if (size > BLOCK_SIZE / 4) {
+        // Own block, so the current one keeps filling with small strings
+        m_blocks.push_back(std::make_unique<char[]>(size));
+        return m_blocks.back().get();
+    }
+
+    if (m_blockUsed + size > BLOCK_SIZE) {
+        m_blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+        m_block = m_blocks.back().get();
+        m_blockUsed = 0;
+    }
+    char* out = m_block + m_blockUsed;
+    m_blockUsed += size;
+    return out;
+}
+
+void StringPool::Grow() {
+    std::vector<Entry> entries(m_entries.empty() ? 64 : m_entries.size() * 2, Entry{0, nullptr, 0});
+    size_t mask = entries.size() - 1;
+    for (const Entry& entry : m_entries) {
+        if (!entry.text) {
+            continue;
+        }
+        size_t index = entry.hash & mask;
+        while (entries[index].text) {
+            index = (index + 1) & mask;
+        }
+        entries[index] = entry;
+    }
+    m_entries = std::move(entries);
+}
+
+} // namespace i18n
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace i18n {
+
+// Append-only arena of NUL-terminated strings. Identical strings are
+// stored once, and returned pointers stay valid until Clear() or the
+// pool is destroyed.
+class StringPool {
+public:
+    const char* Intern(std::string_view text);
+    void Clear();
+
+    size_t GetCount() const { return m_count; }
+    size_t GetBytesUsed() const { return m_bytesUsed; }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        const char* text;   // nullptr for a free slot
+        size_t length;
+    };
+
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    char* Allocate(size_t size);
+    void Grow();
+
+    // Blocks never move; long strings get a block of their own
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char* m_block = nullptr;   // Block small strings are carved from
+    size_t m_blockUsed = BLOCK_SIZE;
+    size_t m_bytesUsed = 0;
+
+    // Dedup table, power of two, at most half full
+    std::vector<Entry> m_entries;
+    size_t m_count = 0;
+};
+
+} // namespace i18n
@@ -0,0 +1,357 @@
+#include "FontAtlasBuilder.h"
+#include <imgui.h>
+#include <imgui_internal.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// ImGui's own copies of stb_rect_pack and stb_truetype, configured as in
+// imgui_draw.cpp so packing and rasterization match its builder. Allocation
+// goes to malloc: ImGui::MemAlloc updates context counters and isn't safe
+// from the workers.
+#define STBRP_STATIC
+#define STBRP_ASSERT(x)     do { IM_ASSERT(x); } while (0)
+#define STBRP_SORT          ImQsort
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+#define STBTT_malloc(x, u)  ((void)(u), malloc(x))
+#define STBTT_free(x, u)    ((void)(u), free(x))
+#define STBTT_assert(x)     do { IM_ASSERT(x); } while (0)
+#define STBTT_fmod(x, y)    ImFmod(x, y)
+#define STBTT_sqrt(x)       ImSqrt(x)
+#define STBTT_pow(x, y)     ImPow(x, y)
+#define STBTT_fabs(x)       ImFabs(x)
+#define STBTT_ifloor(x)     ((int)ImFloor(x))
+#define STBTT_iceil(x)      ((int)ImCeil(x))
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+
+namespace fontbuild {
+
+namespace {
+
+// Glyphs per unit of work; small enough to balance, large enough that the
+// shared counter isn't contended
+constexpr int GLYPHS_PER_JOB = 64;
+constexpr int TEX_HEIGHT_MAX = 1024 * 32;
+
+std::atomic<int> g_threadCount{0};
+std::atomic<int> g_lastThreadCount{0};
+
+// One ImFontConfig
+struct SourceFont {
+    stbtt_fontinfo fontInfo = {};
+    stbtt_pack_range packRange = {};
+    stbrp_rect* rects = nullptr;
+    stbtt_packedchar* packedChars = nullptr;
+    const ImWchar* ranges = nullptr;
+    int dstIndex = -1;
+    int glyphsHighest = 0;
+    int glyphsCount = 0;
+    ImBitVector glyphsSet;
+    ImVector<int> glyphsList;
+};
+
+// One ImFont, fed by one or more merged sources
+struct DestFont {
+    int glyphsHighest = 0;
+    int glyphsCount = 0;
+    ImBitVector glyphsSet;
+};
+
+struct RenderJob {
+    int source;
+    int first;
+    int count;
+};
+
+void UnpackBitVector(const ImBitVector& bits, ImVector<int>& out) {
+    const ImU32* begin = bits.Storage.begin();
+    for (const ImU32* it = begin; it < bits.Storage.end(); ++it) {
+        if (ImU32 entries = *it) {
+            for (ImU32 bit = 0; bit < 32; ++bit) {
+                if (entries & (ImU32(1) << bit)) {
+                    out.push_back(static_cast<int>(((it - begin) << 5) + bit));
+                }
+            }
+        }
+    }
+}
+
+// Same defaults as ImGui: 0 means automatic
+void GetOversample(const ImFontConfig& cfg, int& h, int& v) {
+    h = cfg.OversampleH != 0 ? cfg.OversampleH : (cfg.SizePixels * cfg.RasterizerDensity > 36.0f || cfg.PixelSnapH) ? 1 : 2;
+    v = cfg.OversampleV != 0 ? cfg.OversampleV : 1;
+}
+
+void RenderJobGlyphs(const stbtt_pack_context& shared, SourceFont& src, const ImFontConfig& cfg,
+                     const RenderJob& job, ImFontAtlas* atlas) {
+    // Rendering writes the oversampling into the context, so each job has its own
+    stbtt_pack_context spc = shared;
+    stbtt_pack_range range = src.packRange;
+    range.array_of_unicode_codepoints = src.glyphsList.Data + job.first;
+    range.num_chars = job.count;
+    range.chardata_for_range = src.packedChars + job.first;
+    stbrp_rect* rects = src.rects + job.first;
+    stbtt_PackFontRangesRenderIntoRects(&spc, &src.fontInfo, &range, 1, rects);
+
+    if (cfg.RasterizerMultiply != 1.0f) {
+        unsigned char multiplyTable[256];
+        ImFontAtlasBuildMultiplyCalcLookupTable(multiplyTable, cfg.RasterizerMultiply);
+        for (int i = 0; i < job.count; ++i) {
+            const stbrp_rect& r = rects[i];
+            if (r.was_packed) {
+                ImFontAtlasBuildMultiplyRectAlpha8(multiplyTable, atlas->TexPixelsAlpha8, r.x, r.y, r.w, r.h, atlas->TexWidth);
+            }
+        }
+    }
+}
+
+// Follows ImGui's ImFontAtlasBuildWithStbTruetype step for step; only the
+// rendering loop differs
+bool Build(ImFontAtlas* atlas) {
+    IM_ASSERT(atlas->ConfigData.Size > 0);
+
+    ImFontAtlasBuildInit(atlas);
+
+    atlas->TexID = (ImTextureID)0;
+    atlas->TexWidth = atlas->TexHeight = 0;
+    atlas->TexUvScale = ImVec2(0.0f, 0.0f);
+    atlas->TexUvWhitePixel = ImVec2(0.0f, 0.0f);
+    atlas->ClearTexData();
+
+    std::vector<SourceFont> sources(atlas->ConfigData.Size);
+    std::vector<DestFont> dests(atlas->Fonts.Size);
+
+    // 1. Open the font data and find the highest codepoint wanted
+    for (int srcIndex = 0; srcIndex < atlas->ConfigData.Size; ++srcIndex) {
+        SourceFont& src = sources[srcIndex];
+        ImFontConfig& cfg = atlas->ConfigData[srcIndex];
+        for (int i = 0; i < atlas->Fonts.Size && src.dstIndex == -1; ++i) {
+            if (cfg.DstFont == atlas->Fonts[i]) {
+                src.dstIndex = i;
+            }
+        }
+        if (src.dstIndex == -1) {
+            return false;
+        }
+
+        const int fontOffset = stbtt_GetFontOffsetForIndex(static_cast<unsigned char*>(cfg.FontData), cfg.FontNo);
+        if (fontOffset < 0 || !stbtt_InitFont(&src.fontInfo, static_cast<unsigned char*>(cfg.FontData), fontOffset)) {
+            return false;
+        }
+
+        DestFont& dst = dests[src.dstIndex];
+        src.ranges = cfg.GlyphRanges ? cfg.GlyphRanges : atlas->GetGlyphRangesDefault();
+        for (const ImWchar* range = src.ranges; range[0] && range[1]; range += 2) {
+            src.glyphsHighest = ImMax(src.glyphsHighest, static_cast<int>(range[1]));
+        }
+        dst.glyphsHighest = ImMax(dst.glyphsHighest, src.glyphsHighest);
+    }
+
+    // 2. Keep the codepoints the font has; with merged sources the first wins
+    int totalGlyphs = 0;
+    for (SourceFont& src : sources) {
+        DestFont& dst = dests[src.dstIndex];
+        src.glyphsSet.Create(src.glyphsHighest + 1);
+        if (dst.glyphsSet.Storage.empty()) {
+            dst.glyphsSet.Create(dst.glyphsHighest + 1);
+        }
+
+        for (const ImWchar* range = src.ranges; range[0] && range[1]; range += 2) {
+            for (unsigned int codepoint = range[0]; codepoint <= range[1]; ++codepoint) {
+                if (dst.glyphsSet.TestBit(codepoint) || !stbtt_FindGlyphIndex(&src.fontInfo, codepoint)) {
+                    continue;
+                }
+                ++src.glyphsCount;
+                ++dst.glyphsCount;
+                src.glyphsSet.SetBit(codepoint);
+                dst.glyphsSet.SetBit(codepoint);
+                ++totalGlyphs;
+            }
+        }
+    }
+
+    // 3. Flat, sorted codepoint list per source
+    for (SourceFont& src : sources) {
+        src.glyphsList.reserve(src.glyphsCount);
+        UnpackBitVector(src.glyphsSet, src.glyphsList);
+        src.glyphsSet.Clear();
+        IM_ASSERT(src.glyphsList.Size == src.glyphsCount);
+    }
+    dests.clear();
+
+    ImVector<stbrp_rect> rects;
+    ImVector<stbtt_packedchar> packedChars;
+    rects.resize(totalGlyphs);
+    packedChars.resize(totalGlyphs);
+    std::memset(rects.Data, 0, static_cast<size_t>(rects.size_in_bytes()));
+    std::memset(packedChars.Data, 0, static_cast<size_t>(packedChars.size_in_bytes()));
+
+    // 4. Measure every glyph
+    int totalSurface = 0;
+    int rectsUsed = 0;
+    const int padding = atlas->TexGlyphPadding;
+    for (int srcIndex = 0; srcIndex < static_cast<int>(sources.size()); ++srcIndex) {
+        SourceFont& src = sources[srcIndex];
+        if (src.glyphsCount == 0) {
+            continue;
+        }
+        src.rects = &rects[rectsUsed];
+        src.packedChars = &packedChars[rectsUsed];
+        rectsUsed += src.glyphsCount;
+
+        ImFontConfig& cfg = atlas->ConfigData[srcIndex];
+        int oversampleH = 0;
+        int oversampleV = 0;
+        GetOversample(cfg, oversampleH, oversampleV);
+        src.packRange.font_size = cfg.SizePixels * cfg.RasterizerDensity;
+        src.packRange.first_unicode_codepoint_in_range = 0;
+        src.packRange.array_of_unicode_codepoints = src.glyphsList.Data;
+        src.packRange.num_chars = src.glyphsList.Size;
+        src.packRange.chardata_for_range = src.packedChars;
+        src.packRange.h_oversample = static_cast<unsigned char>(oversampleH);
+        src.packRange.v_oversample = static_cast<unsigned char>(oversampleV);
+
+        const float scale = cfg.SizePixels > 0.0f
+            ? stbtt_ScaleForPixelHeight(&src.fontInfo, cfg.SizePixels * cfg.RasterizerDensity)
+            : stbtt_ScaleForMappingEmToPixels(&src.fontInfo, -cfg.SizePixels * cfg.RasterizerDensity);
+        for (int i = 0; i < src.glyphsList.Size; ++i) {
+            int x0, y0, x1, y1;
+            const int glyphIndex = stbtt_FindGlyphIndex(&src.fontInfo, src.glyphsList[i]);
+            stbtt_GetGlyphBitmapBoxSubpixel(&src.fontInfo, glyphIndex, scale * oversampleH, scale * oversampleV,
+                                            0, 0, &x0, &y0, &x1, &y1);
+            src.rects[i].w = static_cast<stbrp_coord>(x1 - x0 + padding + oversampleH - 1);
+            src.rects[i].h = static_cast<stbrp_coord>(y1 - y0 + padding + oversampleV - 1);
+            totalSurface += src.rects[i].w * src.rects[i].h;
+        }
+    }
+    for (const ImFontAtlasCustomRect& rect : atlas->CustomRects) {
+        totalSurface += (rect.Width + padding) * (rect.Height + padding);
+    }
+
+    const int surfaceSqrt = static_cast<int>(ImSqrt(static_cast<float>(totalSurface))) + 1;
+    atlas->TexHeight = 0;
+    if (atlas->TexDesiredWidth > 0) {
+        atlas->TexWidth = atlas->TexDesiredWidth;
+    } else {
+        atlas->TexWidth = (surfaceSqrt >= 4096 * 0.7f) ? 4096 : (surfaceSqrt >= 2048 * 0.7f) ? 2048 : (surfaceSqrt >= 1024 * 0.7f) ? 1024 : 512;
+    }
+
+    // 5. Pack custom rects first (top-left), then 6. every source
+    stbtt_pack_context spc = {};
+    stbtt_PackBegin(&spc, nullptr, atlas->TexWidth, TEX_HEIGHT_MAX, 0, 0, nullptr);
+    spc.padding = atlas->TexGlyphPadding;
+    ImFontAtlasBuildPackCustomRects(atlas, spc.pack_info);
+
+    for (SourceFont& src : sources) {
+        if (src.glyphsCount == 0) {
+            continue;
+        }
+        stbrp_pack_rects(static_cast<stbrp_context*>(spc.pack_info), src.rects, src.glyphsCount);
+        for (int i = 0; i < src.glyphsCount; ++i) {
+            if (src.rects[i].was_packed) {
+                atlas->TexHeight = ImMax(atlas->TexHeight, src.rects[i].y + src.rects[i].h);
+            }
+        }
+    }
+
+    // 7. Allocate the texture
+    atlas->TexHeight = (atlas->Flags & ImFontAtlasFlags_NoPowerOfTwoHeight) ? (atlas->TexHeight + 1) : ImUpperPowerOfTwo(atlas->TexHeight);
+    atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+    atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(atlas->TexWidth * atlas->TexHeight));
+    std::memset(atlas->TexPixelsAlpha8, 0, atlas->TexWidth * atlas->TexHeight);
+    spc.pixels = atlas->TexPixelsAlpha8;
+    spc.height = atlas->TexHeight;
+
+    // 8. Rasterize. Packed rects don't overlap, so runs of glyphs render
+    // independently; the caller works through the queue too.
+    std::vector<RenderJob> jobs;
+    for (int srcIndex = 0; srcIndex < static_cast<int>(sources.size()); ++srcIndex) {
+        for (int first = 0; first < sources[srcIndex].glyphsCount; first += GLYPHS_PER_JOB) {
+            jobs.push_back({srcIndex, first, ImMin(GLYPHS_PER_JOB, sources[srcIndex].glyphsCount - first)});
+        }
+    }
+
+    int threadCount = g_threadCount.load();
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threadCount = ImClamp(threadCount, 1, ImMax(1, static_cast<int>(jobs.size())));
+    g_lastThreadCount = threadCount;
+
+    std::atomic<size_t> nextJob{0};
+    auto worker = [&] {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+            const RenderJob& job = jobs[i];
+            RenderJobGlyphs(spc, sources[job.source], atlas->ConfigData[job.source], job, atlas);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    stbtt_PackEnd(&spc);
+    rects.clear();
+
+    // 9. Register the glyphs with their fonts
+    for (int srcIndex = 0; srcIndex < static_cast<int>(sources.size()); ++srcIndex) {
+        SourceFont& src = sources[srcIndex];
+        ImFontConfig& cfg = atlas->ConfigData[srcIndex];
+        ImFont* dstFont = cfg.DstFont;
+
+        const float fontScale = stbtt_ScaleForPixelHeight(&src.fontInfo, cfg.SizePixels);
+        int unscaledAscent, unscaledDescent, unscaledLineGap;
+        stbtt_GetFontVMetrics(&src.fontInfo, &unscaledAscent, &unscaledDescent, &unscaledLineGap);
+
+        const float ascent = ImCeil(unscaledAscent * fontScale);
+        const float descent = ImFloor(unscaledDescent * fontScale);
+        ImFontAtlasBuildSetupFont(atlas, dstFont, &cfg, ascent, descent);
+        const float offsetX = cfg.GlyphOffset.x;
+        const float offsetY = cfg.GlyphOffset.y + IM_ROUND(dstFont->Ascent);
+        const float invDensity = 1.0f / cfg.RasterizerDensity;
+
+        for (int i = 0; i < src.glyphsCount; ++i) {
+            const stbtt_packedchar& pc = src.packedChars[i];
+            stbtt_aligned_quad q;
+            float unusedX = 0.0f;
+            float unusedY = 0.0f;
+            stbtt_GetPackedQuad(src.packedChars, atlas->TexWidth, atlas->TexHeight, i, &unusedX, &unusedY, &q, 0);
+            dstFont->AddGlyph(&cfg, static_cast<ImWchar>(src.glyphsList[i]),
+                              q.x0 * invDensity + offsetX, q.y0 * invDensity + offsetY,
+                              q.x1 * invDensity + offsetX, q.y1 * invDensity + offsetY,
+                              q.s0, q.t0, q.s1, q.t1, pc.xadvance * invDensity);
+        }
+    }
+
+    ImFontAtlasBuildFinish(atlas);
+    return true;
+}
+
+const ImFontBuilderIO BUILDER_IO = { &Build };
+
+} // namespace
+
+const ImFontBuilderIO* GetBuilderIO() {
+    return &BUILDER_IO;
+}
+
+void SetThreadCount(int count) {
+    g_threadCount = count;
+}
+
+int GetLastThreadCount() {
+    return g_lastThreadCount;
+}
+
+} // namespace fontbuild
@@ -0,0 +1,21 @@
+#pragma once
+
+struct ImFontBuilderIO;
+
+// ImGui's stb_truetype atlas builder with glyph rasterization spread over
+// worker threads. Glyphs are packed first, as in the serial builder, and
+// each worker renders runs of glyphs into their own disjoint rects of the
+// texture, so the atlas is bit-identical to ImGui's whatever the thread
+// count. Install with io.Fonts->FontBuilderIO before Build().
+namespace fontbuild {
+
+const ImFontBuilderIO* GetBuilderIO();
+
+// Threads used by the next build, including the caller; 0 (default) means
+// one per core, 1 builds serially
+void SetThreadCount(int count);
+
+// Threads the last build actually used
+int GetLastThreadCount();
+
+} // namespace fontbuild
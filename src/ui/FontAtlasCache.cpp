@@ -0,0 +1,341 @@
+#include "FontAtlasCache.h"
+#include "../core/Hash.h"
+#include "../core/MappedFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace fontcache {
+
+namespace {
+
+// sfnt offset table plus room for ~250 table records
+constexpr size_t FONT_DIRECTORY_BYTES = 4096;
+constexpr int MAX_TEXTURE_SIZE = 16384;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t bodyHash;          // Everything after the header; catches a torn write
+    int32_t texWidth;
+    int32_t texHeight;
+    uint32_t fontCount;
+    uint32_t rectCount;
+    float texUvWhitePixel[2];
+    float texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1][4];
+    int32_t packIdMouseCursors;
+    int32_t packIdLines;
+};
+
+struct FontRecord {
+    float fontSize;
+    float scale;
+    float ascent;
+    float descent;
+    float fallbackAdvanceX;
+    float ellipsisWidth;
+    float ellipsisCharStep;
+    int32_t metricsTotalSurface;
+    uint32_t fallbackChar;
+    uint32_t ellipsisChar;
+    int32_t ellipsisCharCount;
+    uint32_t fallbackGlyph;     // Index into the font's glyphs
+    uint32_t glyphCount;
+    uint32_t lookupCount;
+    uint8_t used4kPagesMap[sizeof(ImFont::Used4kPagesMap)];
+};
+
+struct RectRecord {
+    uint16_t width;
+    uint16_t height;
+    uint16_t x;
+    uint16_t y;
+    uint32_t glyphId;
+    uint32_t glyphColored;
+    float glyphAdvanceX;
+    float glyphOffset[2];
+    int32_t font;               // Index into the atlas fonts, -1 for none
+};
+
+// Bounds-checked cursor over the mapped body
+struct Reader {
+    const unsigned char* data;
+    size_t size;
+
+    bool Read(void* out, size_t bytes) {
+        if (bytes > size) {
+            return false;
+        }
+        std::memcpy(out, data, bytes);
+        data += bytes;
+        size -= bytes;
+        return true;
+    }
+};
+
+void Append(std::string& out, const void* data, size_t bytes) {
+    out.append(static_cast<const char*>(data), bytes);
+}
+
+void DeleteFonts(std::vector<ImFont*>& fonts) {
+    for (ImFont* font : fonts) {
+        IM_DELETE(font);
+    }
+    fonts.clear();
+}
+
+bool ReadFont(Reader& in, ImFontAtlas* atlas, ImFont* font) {
+    FontRecord record;
+    if (!in.Read(&record, sizeof(record)) || record.glyphCount == 0 ||
+        record.fallbackGlyph >= record.glyphCount ||
+        record.lookupCount > IM_UNICODE_CODEPOINT_MAX + 1u) {
+        return false;
+    }
+
+    font->Glyphs.resize(static_cast<int>(record.glyphCount));
+    font->IndexLookup.resize(static_cast<int>(record.lookupCount));
+    font->IndexAdvanceX.resize(static_cast<int>(record.lookupCount));
+    if (!in.Read(font->Glyphs.Data, record.glyphCount * sizeof(ImFontGlyph)) ||
+        !in.Read(font->IndexLookup.Data, record.lookupCount * sizeof(ImU16)) ||
+        !in.Read(font->IndexAdvanceX.Data, record.lookupCount * sizeof(float))) {
+        return false;
+    }
+    for (ImU16 index : font->IndexLookup) {
+        if (index != (ImU16)-1 && index >= record.glyphCount) {
+            return false;
+        }
+    }
+
+    font->ContainerAtlas = atlas;
+    font->FontSize = record.fontSize;
+    font->Scale = record.scale;
+    font->Ascent = record.ascent;
+    font->Descent = record.descent;
+    font->FallbackAdvanceX = record.fallbackAdvanceX;
+    font->EllipsisWidth = record.ellipsisWidth;
+    font->EllipsisCharStep = record.ellipsisCharStep;
+    font->MetricsTotalSurface = record.metricsTotalSurface;
+    font->FallbackChar = static_cast<ImWchar>(record.fallbackChar);
+    font->EllipsisChar = static_cast<ImWchar>(record.ellipsisChar);
+    font->EllipsisCharCount = static_cast<short>(record.ellipsisCharCount);
+    font->FallbackGlyph = &font->Glyphs[static_cast<int>(record.fallbackGlyph)];
+    std::memcpy(font->Used4kPagesMap, record.used4kPagesMap, sizeof(font->Used4kPagesMap));
+    font->DirtyLookupTables = false;
+    return true;
+}
+
+} // namespace
+
+uint64_t HashFontFile(const std::string& path, uint64_t hash) {
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return HashString(path, hash);
+    }
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+    hash = HashBytes(&size, sizeof(size), hash);
+
+    char directory[FONT_DIRECTORY_BYTES];
+    file.seekg(0);
+    file.read(directory, sizeof(directory));
+    return HashBytes(directory, static_cast<size_t>(file.gcount()), hash);
+}
+
+uint64_t BaseKey() {
+    const uint32_t parts[] = {
+        VERSION,
+        IMGUI_VERSION_NUM,
+        sizeof(ImWchar),
+        sizeof(ImFontGlyph),
+        sizeof(FontRecord),
+        sizeof(RectRecord),
+        IM_DRAWLIST_TEX_LINES_WIDTH_MAX
+    };
+    return HashBytes(parts, sizeof(parts));
+}
+
+bool Load(const std::string& path, uint64_t key, ImFontAtlas* atlas) {
+    if (!atlas->Fonts.empty() || !atlas->CustomRects.empty() || !atlas->ConfigData.empty()) {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.Open(path) || file.GetSize() < sizeof(Header)) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    Reader in = {file.GetData() + sizeof(header), file.GetSize() - sizeof(header)};
+    if (std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != VERSION ||
+        header.key != key ||
+        header.fontCount == 0 ||
+        header.texWidth <= 0 || header.texWidth > MAX_TEXTURE_SIZE ||
+        header.texHeight <= 0 || header.texHeight > MAX_TEXTURE_SIZE ||
+        HashBytes(in.data, in.size) != header.bodyHash) {
+        return false;
+    }
+
+    std::vector<ImFont*> fonts;
+    for (uint32_t i = 0; i < header.fontCount; ++i) {
+        fonts.push_back(IM_NEW(ImFont)());
+        if (!ReadFont(in, atlas, fonts.back())) {
+            DeleteFonts(fonts);
+            return false;
+        }
+    }
+
+    std::vector<ImFontAtlasCustomRect> rects(header.rectCount);
+    for (ImFontAtlasCustomRect& rect : rects) {
+        RectRecord record;
+        if (!in.Read(&record, sizeof(record)) ||
+            record.font < -1 || record.font >= static_cast<int32_t>(fonts.size())) {
+            DeleteFonts(fonts);
+            return false;
+        }
+        rect.Width = record.width;
+        rect.Height = record.height;
+        rect.X = record.x;
+        rect.Y = record.y;
+        rect.GlyphID = record.glyphId;
+        rect.GlyphColored = record.glyphColored;
+        rect.GlyphAdvanceX = record.glyphAdvanceX;
+        rect.GlyphOffset = ImVec2(record.glyphOffset[0], record.glyphOffset[1]);
+        rect.Font = record.font >= 0 ? fonts[record.font] : nullptr;
+    }
+
+    size_t pixelBytes = size_t(header.texWidth) * header.texHeight;
+    if (in.size != pixelBytes) {
+        DeleteFonts(fonts);
+        return false;
+    }
+
+    // ImGui owns and frees the pixels, so they're copied out of the mapping
+    atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixelBytes));
+    std::memcpy(atlas->TexPixelsAlpha8, in.data, pixelBytes);
+    atlas->TexPixelsUseColors = false;
+    atlas->TexWidth = header.texWidth;
+    atlas->TexHeight = header.texHeight;
+    atlas->TexUvScale = ImVec2(1.0f / header.texWidth, 1.0f / header.texHeight);
+    atlas->TexUvWhitePixel = ImVec2(header.texUvWhitePixel[0], header.texUvWhitePixel[1]);
+    for (int i = 0; i <= IM_DRAWLIST_TEX_LINES_WIDTH_MAX; ++i) {
+        const float* uv = header.texUvLines[i];
+        atlas->TexUvLines[i] = ImVec4(uv[0], uv[1], uv[2], uv[3]);
+    }
+    atlas->PackIdMouseCursors = header.packIdMouseCursors;
+    atlas->PackIdLines = header.packIdLines;
+    for (const ImFontAtlasCustomRect& rect : rects) {
+        atlas->CustomRects.push_back(rect);
+    }
+    for (ImFont* font : fonts) {
+        atlas->Fonts.push_back(font);
+    }
+    atlas->TexReady = true;
+    return true;
+}
+
+bool Store(const std::string& path, uint64_t key, ImFontAtlas* atlas) {
+    if (!atlas->IsBuilt() || atlas->TexPixelsUseColors || !atlas->TexPixelsAlpha8) {
+        return false;
+    }
+
+    std::string body;
+    for (ImFont* font : atlas->Fonts) {
+        if (!font->FallbackGlyph || font->Glyphs.empty()) {
+            return false;
+        }
+
+        FontRecord record = {};
+        record.fontSize = font->FontSize;
+        record.scale = font->Scale;
+        record.ascent = font->Ascent;
+        record.descent = font->Descent;
+        record.fallbackAdvanceX = font->FallbackAdvanceX;
+        record.ellipsisWidth = font->EllipsisWidth;
+        record.ellipsisCharStep = font->EllipsisCharStep;
+        record.metricsTotalSurface = font->MetricsTotalSurface;
+        record.fallbackChar = font->FallbackChar;
+        record.ellipsisChar = font->EllipsisChar;
+        record.ellipsisCharCount = font->EllipsisCharCount;
+        record.fallbackGlyph = static_cast<uint32_t>(font->FallbackGlyph - font->Glyphs.Data);
+        record.glyphCount = static_cast<uint32_t>(font->Glyphs.Size);
+        record.lookupCount = static_cast<uint32_t>(font->IndexLookup.Size);
+        std::memcpy(record.used4kPagesMap, font->Used4kPagesMap, sizeof(record.used4kPagesMap));
+
+        Append(body, &record, sizeof(record));
+        Append(body, font->Glyphs.Data, font->Glyphs.size_in_bytes());
+        Append(body, font->IndexLookup.Data, font->IndexLookup.size_in_bytes());
+        Append(body, font->IndexAdvanceX.Data, font->IndexAdvanceX.size_in_bytes());
+    }
+
+    for (const ImFontAtlasCustomRect& rect : atlas->CustomRects) {
+        RectRecord record = {};
+        record.width = rect.Width;
+        record.height = rect.Height;
+        record.x = rect.X;
+        record.y = rect.Y;
+        record.glyphId = rect.GlyphID;
+        record.glyphColored = rect.GlyphColored;
+        record.glyphAdvanceX = rect.GlyphAdvanceX;
+        record.glyphOffset[0] = rect.GlyphOffset.x;
+        record.glyphOffset[1] = rect.GlyphOffset.y;
+        record.font = rect.Font ? atlas->Fonts.index_from_ptr(atlas->Fonts.find(rect.Font)) : -1;
+        Append(body, &record, sizeof(record));
+    }
+
+    Append(body, atlas->TexPixelsAlpha8, size_t(atlas->TexWidth) * atlas->TexHeight);
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.key = key;
+    header.bodyHash = HashBytes(body.data(), body.size());
+    header.texWidth = atlas->TexWidth;
+    header.texHeight = atlas->TexHeight;
+    header.fontCount = static_cast<uint32_t>(atlas->Fonts.Size);
+    header.rectCount = static_cast<uint32_t>(atlas->CustomRects.Size);
+    header.texUvWhitePixel[0] = atlas->TexUvWhitePixel.x;
+    header.texUvWhitePixel[1] = atlas->TexUvWhitePixel.y;
+    for (int i = 0; i <= IM_DRAWLIST_TEX_LINES_WIDTH_MAX; ++i) {
+        const ImVec4& uv = atlas->TexUvLines[i];
+        header.texUvLines[i][0] = uv.x;
+        header.texUvLines[i][1] = uv.y;
+        header.texUvLines[i][2] = uv.z;
+        header.texUvLines[i][3] = uv.w;
+    }
+    header.packIdMouseCursors = atlas->PackIdMouseCursors;
+    header.packIdLines = atlas->PackIdLines;
+
+    // Written aside and renamed over, so a reader never sees half a file
+    std::error_code ec;
+    fs::path target(path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+    }
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(body.data(), body.size());
+        if (!file) {
+            file.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, target, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace fontcache
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <imgui.h>
+#include <cstdint>
+#include <string>
+
+// A built ImFontAtlas saved to disk, so later launches skip rasterization:
+// alpha8 pixels plus each font's glyphs and lookup tables and the atlas
+// custom rects. Fonts come back without their ImFontConfig, so a restored
+// atlas can't be rebuilt; glyphs are added at runtime instead (GlyphCache).
+// Layout, host byte order:
+//   Header | per font: FontRecord, ImFontGlyph[glyphCount],
+//   ImU16 lookup[lookupCount], float advance[lookupCount] |
+//   RectRecord[rectCount] | alpha8 pixels[texWidth * texHeight]
+namespace fontcache {
+
+constexpr char MAGIC[4] = {'F', 'A', 'T', 'L'};
+constexpr uint32_t VERSION = 1;
+
+// Fingerprint of a font file, fed into the cache key. Hashes the size and
+// the sfnt table directory, which carries a checksum of every table, so it
+// changes with the content without reading the whole file.
+uint64_t HashFontFile(const std::string& path, uint64_t hash);
+
+// Key parts every cache shares: ImGui version and the layouts stored raw
+uint64_t BaseKey();
+
+// Restore a built atlas into an empty one. False, leaving the atlas
+// empty, if the file is missing, written under another key or damaged.
+bool Load(const std::string& path, uint64_t key, ImFontAtlas* atlas);
+
+// Save a freshly built atlas; false if it has color glyphs or the write
+// fails. Nothing is kept on failure.
+bool Store(const std::string& path, uint64_t key, ImFontAtlas* atlas);
+
+} // namespace fontcache
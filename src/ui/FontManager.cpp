@@ -0,0 +1,355 @@
+#include "FontManager.h"
+#include "FontAtlasBuilder.h"
+#include "FontAtlasCache.h"
+#include "IconsFontAwesome6.h"
+#include "../core/Hash.h"
+#include "../core/Logger.h"
+#include "../graphics/TrueTypeRasterizer.h"
+#include "../i18n/Localization.h"
+#include <imgui_internal.h>
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+// The atlas code here and in FontAtlasBuilder, FontAtlasCache and SdfText
+// works on ImGui 1.91's font internals: FontBuilderIO, TexPixelsAlpha8 and
+// the glyph tables on ImFont. 1.92 moved the tables to ImFontBaked and
+// loads glyphs on demand itself, so a port would replace GlyphCache rather
+// than patch this.
+#if IMGUI_VERSION_NUM >= 19200
+#error "BigAppLauncher needs ImGui 1.91.x; setup_deps.ps1 checks out v1.91.9"
+#endif
+
+using Microsoft::WRL::ComPtr;
+namespace fs = std::filesystem;
+
+namespace {
+
+// UI glyph table, generated at build time by tools/GlyphRangeScanner
+#if __has_include("UiGlyphRanges.inc")
+const ImWchar UI_GLYPH_RANGES[] = {
+#include "UiGlyphRanges.inc"
+    0
+};
+#define HAVE_UI_GLYPH_RANGES 1
+#endif
+
+// Tried in order
+const char* FONT_PATHS[] = {
+    "assets/fonts/NotoSansSC-Regular.otf",
+    "assets/fonts/NotoSansSC-Regular.ttf",
+    "assets/fonts/NotoSansCJKsc-Regular.otf"
+};
+
+const char* ICON_FONT_PATH = "assets/fonts/fa-solid-900.ttf";
+constexpr float FONT_SIZE = 18.0f;
+constexpr float ICON_FONT_SIZE = 14.0f;
+
+// Icons the sources use, generated at build time by tools/IconRangeScanner;
+// the whole Font Awesome block otherwise
+const ImWchar ICON_RANGES[] = {
+#if __has_include("IconGlyphRanges.inc")
+#include "IconGlyphRanges.inc"
+#else
+    ICON_MIN_FA, ICON_MAX_FA,
+#endif
+    0
+};
+
+// Built atlas from an earlier launch; see FontAtlasCache.h
+const char* ATLAS_CACHE_PATH = "cache/fonts.atlas";
+
+} // namespace
+
+FontManager& FontManager::Instance() {
+    static FontManager instance;
+    return instance;
+}
+
+bool FontManager::LoadFonts(ImGuiIO& io, ID3D11DeviceContext* context) {
+    m_context = context;
+
+    // Without the generated table only Latin is baked; the glyph cache
+    // covers everything else
+    ImFontGlyphRangesBuilder rangeBuilder;
+#ifdef HAVE_UI_GLYPH_RANGES
+    rangeBuilder.AddRanges(UI_GLYPH_RANGES);
+#else
+    rangeBuilder.AddRanges(io.Fonts->GetGlyphRangesDefault());
+#endif
+    m_ranges.clear();
+    rangeBuilder.BuildRanges(&m_ranges);
+
+    std::error_code ec;
+    m_fontPath = nullptr;
+    for (const char* fontPath : FONT_PATHS) {
+        if (fs::exists(fontPath, ec)) {
+            m_fontPath = fontPath;
+            break;
+        }
+    }
+
+    // Runtime glyph pages are reserved in the atlas only with a font file
+    // to rasterize from
+    GlyphCacheConfig pageConfig;
+    int pageCount = m_fontPath ? pageConfig.maxPages : 0;
+    uint64_t key = AtlasKey(io, pageConfig.pageSize, pageCount);
+
+    auto start = std::chrono::steady_clock::now();
+    m_atlasFromCache = fontcache::Load(ATLAS_CACHE_PATH, key, io.Fonts);
+    if (m_atlasFromCache) {
+        // The pages were the first custom rects when the cache was written
+        for (int i = 0; i < pageCount; ++i) {
+            m_pageRectIds.push_back(i);
+        }
+    } else {
+        AddFonts(io);
+        for (int i = 0; i < pageCount; ++i) {
+            m_pageRectIds.push_back(io.Fonts->AddCustomRectRegular(pageConfig.pageSize, pageConfig.pageSize));
+        }
+        io.Fonts->FontBuilderIO = fontbuild::GetBuilderIO();
+        io.Fonts->Build();
+        if (m_fontPath && !fontcache::Store(ATLAS_CACHE_PATH, key, io.Fonts)) {
+            LOG_WARNING("Could not write font atlas cache %s", ATLAS_CACHE_PATH);
+        }
+    }
+    m_lastBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    m_glyphCount = io.Fonts->Fonts.empty() ? 0 : io.Fonts->Fonts[0]->Glyphs.Size;
+    m_atlasWidth = io.Fonts->TexWidth;
+    m_atlasHeight = io.Fonts->TexHeight;
+    if (m_atlasFromCache) {
+        LOG_INFO("Font atlas: %d glyphs, %dx%d, loaded from cache in %.1f ms",
+                 m_glyphCount, m_atlasWidth, m_atlasHeight, m_lastBuildMs);
+    } else {
+        LOG_INFO("Font atlas: %d glyphs, %dx%d, built on %d threads in %.1f ms",
+                 m_glyphCount, m_atlasWidth, m_atlasHeight, fontbuild::GetLastThreadCount(), m_lastBuildMs);
+    }
+
+    auto rasterizer = std::make_unique<TrueTypeRasterizer>();
+    if (pageCount > 0 && m_fontPath && rasterizer->Load(m_fontPath, FONT_SIZE)) {
+        for (int id : m_pageRectIds) {
+            const ImFontAtlasCustomRect* rect = io.Fonts->GetCustomRectByIndex(id);
+            m_pageOrigins.emplace_back(rect->X, rect->Y);
+        }
+        m_glyphCache = std::make_unique<GlyphCache>(std::move(rasterizer), pageConfig);
+        m_font = io.Fonts->Fonts[0];
+        if (m_font->FallbackGlyph) {
+            m_fallbackIndex = static_cast<int>(m_font->FallbackGlyph - m_font->Glyphs.Data);
+        }
+        i18n::Localization::Instance().SetTextObserver(&FontManager::ObserveText);
+    }
+    return m_fontPath != nullptr;
+}
+
+void FontManager::BeginFrame() {
+    if (!m_glyphCache) {
+        return;
+    }
+    m_glyphCache->BeginFrame();
+
+    // Characters typed since the last frame, not yet consumed by widgets
+    for (ImWchar c : ImGui::GetIO().InputQueueCharacters) {
+        UseChar(c);
+    }
+}
+
+void FontManager::EndFrame() {
+    // The CPU copy of the atlas stays alpha8. The backend's RGBA32 copy is
+    // only needed to create the texture; after a device reset it is made
+    // again from the alpha8 pixels.
+    ImGuiIO& io = ImGui::GetIO();
+    if (io.Fonts->TexPixelsRGBA32 && io.Fonts->TexID) {
+        IM_FREE(io.Fonts->TexPixelsRGBA32);
+        io.Fonts->TexPixelsRGBA32 = nullptr;
+    }
+
+    if (!m_glyphCache) {
+        return;
+    }
+    m_glyphCache->TakeDirtyRects(m_dirtyRects);
+    if (m_dirtyRects.empty()) {
+        return;
+    }
+
+    unsigned char* atlasPixels = nullptr;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    io.Fonts->GetTexDataAsAlpha8(&atlasPixels, &atlasWidth, &atlasHeight);
+
+    // Created by the DX11 backend on its first NewFrame
+    ComPtr<ID3D11Texture2D> texture;
+    if (auto* srv = (ID3D11ShaderResourceView*)(intptr_t)io.Fonts->TexID) {
+        ComPtr<ID3D11Resource> resource;
+        srv->GetResource(&resource);
+        resource.As(&texture);
+    }
+
+    int pageSize = m_glyphCache->GetPageSize();
+    for (const GlyphDirtyRect& rect : m_dirtyRects) {
+        const uint8_t* page = m_glyphCache->GetPagePixels(rect.page);
+        int originX = m_pageOrigins[rect.page].first;
+        int originY = m_pageOrigins[rect.page].second;
+        int width = rect.x1 - rect.x0;
+        int height = rect.y1 - rect.y0;
+
+        // The texture is RGBA32 (white, coverage in alpha) for the backend's shader
+        m_uploadPixels.resize(size_t(width) * height);
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* src = page + (rect.y0 + y) * pageSize + rect.x0;
+            std::memcpy(atlasPixels + (originY + rect.y0 + y) * atlasWidth + originX + rect.x0, src, width);
+            ImU32* dst = &m_uploadPixels[size_t(y) * width];
+            for (int x = 0; x < width; ++x) {
+                dst[x] = IM_COL32(255, 255, 255, src[x]);
+            }
+        }
+
+        if (texture && m_context) {
+            D3D11_BOX box = {
+                UINT(originX + rect.x0), UINT(originY + rect.y0), 0,
+                UINT(originX + rect.x1), UINT(originY + rect.y1), 1
+            };
+            m_context->UpdateSubresource(texture.Get(), 0, &box, m_uploadPixels.data(), width * 4, 0);
+        }
+    }
+}
+
+void FontManager::UseText(const char* utf8, bool pin) {
+    if (!m_glyphCache) {
+        return;
+    }
+    while (*utf8) {
+        if (static_cast<unsigned char>(*utf8) < 0x80) {
+            ++utf8;   // ASCII is always baked
+            continue;
+        }
+        unsigned int c = 0;
+        utf8 += ImTextCharFromUtf8(&c, utf8, nullptr);
+        if (c <= IM_UNICODE_CODEPOINT_MAX) {
+            UseChar(static_cast<ImWchar>(c), pin);
+        }
+    }
+}
+
+void FontManager::ObserveText(const char* text) {
+    FontManager& fonts = Instance();
+    if (!text) {
+        fonts.m_glyphCache->UnpinAll();   // The previous language's strings
+        return;
+    }
+    fonts.UseText(text, true);
+}
+
+void FontManager::UseChar(ImWchar c, bool pin) {
+    if (!m_glyphCache || c < 0x80) {
+        return;
+    }
+
+    bool dynamic = m_dynamicSlots.count(c) != 0;
+    if (!dynamic && m_font->FindGlyphNoFallback(c)) {
+        return;   // Baked into the atlas
+    }
+
+    // A hit only refreshes the glyph's page for the LRU
+    const CachedGlyph* glyph = pin ? m_glyphCache->AcquirePinned(c) : m_glyphCache->Acquire(c);
+    DropEvicted();
+    if (glyph && !dynamic) {
+        AddDynamicGlyph(*glyph);
+    }
+}
+
+void FontManager::AddDynamicGlyph(const CachedGlyph& glyph) {
+    int slot = 0;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        m_font->Glyphs.push_back(ImFontGlyph());
+        slot = m_font->Glyphs.Size - 1;
+        if (m_fallbackIndex >= 0) {
+            m_font->FallbackGlyph = &m_font->Glyphs[m_fallbackIndex];
+        }
+    }
+
+    // Same placement ImGui's own builder uses: rows start at the rounded ascent
+    float top = std::floor(m_font->Ascent + 0.5f);
+    ImVec2 uvScale = m_font->ContainerAtlas->TexUvScale;
+    int pageX = glyph.page >= 0 ? m_pageOrigins[glyph.page].first + glyph.x : 0;
+    int pageY = glyph.page >= 0 ? m_pageOrigins[glyph.page].second + glyph.y : 0;
+
+    ImFontGlyph& out = m_font->Glyphs[slot];
+    out.Codepoint = glyph.codepoint;
+    out.Visible = glyph.width > 0 && glyph.height > 0;
+    out.Colored = 0;
+    out.AdvanceX = glyph.advanceX;
+    out.X0 = static_cast<float>(glyph.offsetX);
+    out.Y0 = top + glyph.offsetY;
+    out.X1 = out.X0 + glyph.width;
+    out.Y1 = out.Y0 + glyph.height;
+    out.U0 = pageX * uvScale.x;
+    out.V0 = pageY * uvScale.y;
+    out.U1 = (pageX + glyph.width) * uvScale.x;
+    out.V1 = (pageY + glyph.height) * uvScale.y;
+
+    ImWchar c = static_cast<ImWchar>(glyph.codepoint);
+    if (c >= m_font->IndexLookup.Size) {
+        m_font->IndexLookup.resize(c + 1, (ImU16)-1);
+        m_font->IndexAdvanceX.resize(c + 1, m_font->FallbackAdvanceX);
+    }
+    m_font->IndexLookup[c] = static_cast<ImU16>(slot);
+    m_font->IndexAdvanceX[c] = out.AdvanceX;
+    m_dynamicSlots[c] = slot;
+}
+
+void FontManager::DropEvicted() {
+    m_glyphCache->TakeEvicted(m_evicted);
+    for (uint32_t codepoint : m_evicted) {
+        ImWchar c = static_cast<ImWchar>(codepoint);
+        auto it = m_dynamicSlots.find(c);
+        if (it == m_dynamicSlots.end()) {
+            continue;
+        }
+
+        // Draws as the fallback until used again
+        m_font->IndexLookup[c] = (ImU16)-1;
+        m_font->IndexAdvanceX[c] = m_font->FallbackAdvanceX;
+        m_font->Glyphs[it->second].Visible = 0;
+        m_freeSlots.push_back(it->second);
+        m_dynamicSlots.erase(it);
+    }
+}
+
+uint64_t FontManager::AtlasKey(const ImGuiIO& io, int pageSize, int pageCount) const {
+    uint64_t key = fontcache::BaseKey();
+    key = fontcache::HashFontFile(m_fontPath ? m_fontPath : "", key);
+    key = fontcache::HashFontFile(ICON_FONT_PATH, key);
+
+    const float sizes[] = { FONT_SIZE, ICON_FONT_SIZE };
+    const int layout[] = { pageSize, pageCount, io.Fonts->Flags, io.Fonts->TexGlyphPadding, io.Fonts->TexDesiredWidth };
+    key = HashBytes(sizes, sizeof(sizes), key);
+    key = HashBytes(layout, sizeof(layout), key);
+    key = HashBytes(m_ranges.Data, m_ranges.size_in_bytes(), key);
+    return HashBytes(ICON_RANGES, sizeof(ICON_RANGES), key);
+}
+
+void FontManager::AddFonts(ImGuiIO& io) {
+    ImFont* font = nullptr;
+    if (m_fontPath) {
+        font = io.Fonts->AddFontFromFileTTF(m_fontPath, FONT_SIZE, nullptr, m_ranges.Data);
+    }
+
+    if (!font) {
+        // Fallback to default font
+        m_fontPath = nullptr;
+        font = io.Fonts->AddFontDefault();
+    }
+
+    // Load FontAwesome icons and merge with main font
+    ImFontConfig iconsConfig;
+    iconsConfig.MergeMode = true;
+    iconsConfig.PixelSnapH = true;
+    io.Fonts->AddFontFromFileTTF(ICON_FONT_PATH, ICON_FONT_SIZE, &iconsConfig, ICON_RANGES);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <imgui.h>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../graphics/GlyphCache.h"
+
+struct ID3D11DeviceContext;
+
+// Owns the ImGui font atlas: the UI font plus the merged icon font. The
+// glyphs GlyphRangeScanner found in the UI are baked; any other character
+// is rasterized on first use into GlyphCache pages reserved in the same
+// atlas texture and spliced into the ImFont.
+class FontManager {
+public:
+    static FontManager& Instance();
+
+    // Add the fonts to io.Fonts and build the atlas, or restore it from
+    // the cache an earlier launch wrote; the DX11 backend uploads it on its
+    // first NewFrame. context receives later glyph uploads.
+    bool LoadFonts(ImGuiIO& io, ID3D11DeviceContext* context);
+
+    // Call before the backends' NewFrame: advances the glyph LRU and picks
+    // up characters typed since the last frame
+    void BeginFrame();
+
+    // Call before ImGui::Render(): uploads the glyphs rasterized this frame
+    void EndFrame();
+
+    // Make text drawable this frame. Other runtime text (server messages,
+    // user names) should be passed every frame it is shown, or its glyphs
+    // may be evicted. i18n::T() text needs nothing: Localization reports
+    // each catalog string once and its glyphs stay until the language
+    // changes.
+    void UseText(const char* utf8) { UseText(utf8, false); }
+
+    int GetGlyphCount() const { return m_glyphCount; }
+    int GetAtlasWidth() const { return m_atlasWidth; }
+    int GetAtlasHeight() const { return m_atlasHeight; }
+    double GetLastBuildMs() const { return m_lastBuildMs; }
+    bool IsAtlasFromCache() const { return m_atlasFromCache; }
+
+    // UI font file, nullptr when running on ImGui's default font
+    const char* GetFontPath() const { return m_fontPath; }
+
+    // nullptr when glyphs can't be added at runtime (no font file)
+    const GlyphCacheStats* GetGlyphCacheStats() const { return m_glyphCache ? &m_glyphCache->GetStats() : nullptr; }
+
+private:
+    FontManager() = default;
+    ~FontManager() = default;
+
+    // Localization text observer
+    static void ObserveText(const char* text);
+
+    // Everything the built atlas depends on
+    uint64_t AtlasKey(const ImGuiIO& io, int pageSize, int pageCount) const;
+    void AddFonts(ImGuiIO& io);
+
+    // pin keeps the glyphs until the next language change
+    void UseText(const char* utf8, bool pin);
+    void UseChar(ImWchar c, bool pin = false);
+    void AddDynamicGlyph(const CachedGlyph& glyph);
+    void DropEvicted();
+
+    ImVector<ImWchar> m_ranges;
+    const char* m_fontPath = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+
+    // Runtime glyphs. Cache page i is the atlas custom rect m_pageRectIds[i].
+    std::unique_ptr<GlyphCache> m_glyphCache;
+    std::vector<int> m_pageRectIds;
+    std::vector<std::pair<int, int>> m_pageOrigins;   // Atlas pixel position of each page
+    ImFont* m_font = nullptr;
+    int m_fallbackIndex = -1;                          // FallbackGlyph, re-pointed when Glyphs grows
+    std::unordered_map<ImWchar, int> m_dynamicSlots;   // Codepoint -> index in m_font->Glyphs
+    std::vector<int> m_freeSlots;                      // Glyphs entries left by evictions
+    std::vector<GlyphDirtyRect> m_dirtyRects;
+    std::vector<uint32_t> m_evicted;
+    std::vector<ImU32> m_uploadPixels;
+
+    int m_glyphCount = 0;
+    int m_atlasWidth = 0;
+    int m_atlasHeight = 0;
+    double m_lastBuildMs = 0.0;
+    bool m_atlasFromCache = false;
+};
@@ -0,0 +1,177 @@
+#include "SdfText.h"
+#include "../core/Logger.h"
+#include "../graphics/TrueTypeRasterizer.h"
+#include <d3dcompiler.h>
+#include <cfloat>
+#include <cstring>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+namespace {
+
+// Distance fields are rasterized at this size; larger text is magnified
+constexpr float BASE_SIZE = 32.0f;
+constexpr int SPREAD = 4;
+
+// Replaces the ImGui backend's pixel shader; same inputs. Coverage as in
+// SdfFont::Coverage().
+const char* g_sdfPS = R"HLSL(
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float4 col : COLOR0;
+    float2 uv  : TEXCOORD0;
+};
+
+sampler sampler0;
+Texture2D texture0;
+
+static const float EDGE = 128.0 / 255.0;
+static const float MIN_WIDTH = 1.0 / 1024.0;
+
+float4 main(PS_INPUT input) : SV_Target {
+    float d = texture0.Sample(sampler0, input.uv).r;
+    float w = max(fwidth(d), MIN_WIDTH);
+    float a = smoothstep(EDGE - w, EDGE + w, d);
+    return float4(input.col.rgb, input.col.a * a);
+}
+)HLSL";
+
+} // namespace
+
+SdfText& SdfText::Instance() {
+    static SdfText instance;
+    return instance;
+}
+
+bool SdfText::Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const char* fontPath) {
+    m_device = device;
+    m_context = context;
+
+    auto rasterizer = std::make_unique<TrueTypeRasterizer>();
+    if (!fontPath || !rasterizer->Load(fontPath, BASE_SIZE)) {
+        LOG_WARNING("SDF text unavailable: no font to rasterize");
+        return false;
+    }
+    rasterizer->SetSdf(SPREAD);
+    float ascent = rasterizer->GetAscent();
+
+    GlyphCacheConfig config;
+    config.pageSize = 512;
+    config.maxPages = 2;
+    m_font = std::make_unique<SdfFont>(std::move(rasterizer), BASE_SIZE, ascent, config);
+    if (!CreateShader() || !CreateTexture()) {
+        LOG_WARNING("SDF text unavailable: could not create GPU resources");
+        Shutdown();
+        return false;
+    }
+    return true;
+}
+
+void SdfText::Shutdown() {
+    m_font.reset();
+    m_textureSRV.Reset();
+    m_texture.Reset();
+    m_pixelShader.Reset();
+}
+
+void SdfText::BeginFrame() {
+    if (m_font) {
+        m_font->BeginFrame();
+    }
+}
+
+void SdfText::EndFrame() {
+    if (!m_font) {
+        return;
+    }
+    m_font->TakeDirtyRects(m_dirtyRects);
+
+    // Page rows are contiguous, so each rect uploads straight from the page
+    int pageSize = m_font->GetAtlasWidth();
+    for (const GlyphDirtyRect& rect : m_dirtyRects) {
+        const uint8_t* page = m_font->GetPagePixels(rect.page);
+        int pageTop = rect.page * pageSize;
+        D3D11_BOX box = { UINT(rect.x0), UINT(rect.y0), 0, UINT(rect.x1), UINT(rect.y1), 1 };
+        m_context->UpdateSubresource(m_texture.Get(), 0, &box,
+                                     page + (rect.y0 - pageTop) * pageSize + rect.x0, pageSize, 0);
+    }
+}
+
+void SdfText::AddText(ImDrawList* drawList, float size, const ImVec2& pos, ImU32 col,
+                      const char* text, const char* textEnd) {
+    if (!m_font) {
+        drawList->AddText(ImGui::GetFont(), size, pos, col, text, textEnd);
+        return;
+    }
+    if ((col & IM_COL32_A_MASK) == 0) {
+        return;
+    }
+
+    m_quads.clear();
+    m_font->Layout(text, textEnd, size, pos.x, pos.y, m_quads);
+    if (m_quads.empty()) {
+        return;
+    }
+
+    drawList->AddCallback(&SdfText::SetSdfShader, nullptr);
+    drawList->PushTextureID((ImTextureID)(intptr_t)m_textureSRV.Get());
+    drawList->PrimReserve(static_cast<int>(m_quads.size()) * 6, static_cast<int>(m_quads.size()) * 4);
+    for (const SdfQuad& quad : m_quads) {
+        drawList->PrimRectUV(ImVec2(quad.x0, quad.y0), ImVec2(quad.x1, quad.y1),
+                             ImVec2(quad.u0, quad.v0), ImVec2(quad.u1, quad.v1), col);
+    }
+    drawList->PopTextureID();
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+ImVec2 SdfText::CalcTextSize(float size, const char* text, const char* textEnd) {
+    if (!m_font) {
+        return ImGui::GetFont()->CalcTextSizeA(size, FLT_MAX, 0.0f, text, textEnd);
+    }
+    return ImVec2(m_font->Measure(text, textEnd, size), size);
+}
+
+bool SdfText::CreateShader() {
+    ComPtr<ID3DBlob> psBlob, errorBlob;
+    HRESULT hr = D3DCompile(g_sdfPS, strlen(g_sdfPS), "SdfTextPS", nullptr, nullptr,
+                            "main", "ps_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0,
+                            &psBlob, &errorBlob);
+    if (FAILED(hr)) {
+        return false;
+    }
+
+    hr = m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(),
+                                     nullptr, &m_pixelShader);
+    return SUCCEEDED(hr);
+}
+
+bool SdfText::CreateTexture() {
+    // Zeroed: distance 0 is outside every glyph
+    std::vector<uint8_t> zeros(size_t(m_font->GetAtlasWidth()) * m_font->GetAtlasHeight(), 0);
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = zeros.data();
+    initData.SysMemPitch = m_font->GetAtlasWidth();
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width = m_font->GetAtlasWidth();
+    texDesc.Height = m_font->GetAtlasHeight();
+    texDesc.MipLevels = 1;
+    texDesc.ArraySize = 1;
+    texDesc.Format = DXGI_FORMAT_R8_UNORM;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    HRESULT hr = m_device->CreateTexture2D(&texDesc, &initData, &m_texture);
+    if (FAILED(hr)) return false;
+
+    hr = m_device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_textureSRV);
+    return SUCCEEDED(hr);
+}
+
+void SdfText::SetSdfShader(const ImDrawList*, const ImDrawCmd*) {
+    // The backend binds each command's texture itself; ResetRenderState
+    // after the text puts its own shader back
+    SdfText& self = Instance();
+    self.m_context->PSSetShader(self.m_pixelShader.Get(), nullptr, 0);
+}
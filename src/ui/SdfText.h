@@ -0,0 +1,56 @@
+#pragma once
+
+#include <imgui.h>
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "../graphics/SdfFont.h"
+
+using Microsoft::WRL::ComPtr;
+
+// Scalable text for headings and other large sizes: glyphs come from an
+// SdfFont atlas and are drawn through ImGui with a distance-field pixel
+// shader, set by a draw-list callback around the text. Sharp at any size
+// or UI scale with one atlas, where the ImGui font is baked for 18 px.
+class SdfText {
+public:
+    static SdfText& Instance();
+
+    // fontPath is the UI font (FontManager::GetFontPath()). False leaves
+    // AddText() falling back to the ImGui font.
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context, const char* fontPath);
+    void Shutdown();
+
+    // Call before the frame's first AddText(); advances the glyph LRU
+    void BeginFrame();
+
+    // Call before ImGui::Render(): uploads glyphs rasterized this frame
+    void EndFrame();
+
+    // Same as drawList->AddText(font, size, pos, col, text) at any size
+    void AddText(ImDrawList* drawList, float size, const ImVec2& pos, ImU32 col, const char* text, const char* textEnd = nullptr);
+    ImVec2 CalcTextSize(float size, const char* text, const char* textEnd = nullptr);
+
+    bool IsAvailable() const { return m_font != nullptr; }
+
+private:
+    SdfText() = default;
+    ~SdfText() = default;
+
+    bool CreateShader();
+    bool CreateTexture();
+
+    // ImDrawCallback: swap in the SDF pixel shader
+    static void SetSdfShader(const ImDrawList* drawList, const ImDrawCmd* cmd);
+
+    ID3D11Device* m_device = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    ComPtr<ID3D11PixelShader> m_pixelShader;
+    ComPtr<ID3D11Texture2D> m_texture;            // R8 distance field atlas
+    ComPtr<ID3D11ShaderResourceView> m_textureSRV;
+
+    std::unique_ptr<SdfFont> m_font;
+    std::vector<SdfQuad> m_quads;
+    std::vector<GlyphDirtyRect> m_dirtyRects;
+};
@@ -38,21 +38,21 @@ void LoginScreen::HandleLoginAttempt() {
 
     switch (m_loginResult) {
         case LoginResult::Success:
-            m_successMessage = i18n::T("login.success");
+            m_successMessage = i18n::T(I18N_KEY("login.success"));
             m_loginPending = true;
             m_loginDelayTimer = 1.0f;  // 1 second delay
             break;
 
         case LoginResult::ConnectionError:
-            m_errorMessage = i18n::T("login.error_connection");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_connection"));
             break;
 
         case LoginResult::WrongCredentials:
-            m_errorMessage = i18n::T("login.error_credentials");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_credentials"));
             break;
 
         case LoginResult::Expired:
-            m_errorMessage = i18n::T("login.error_expired");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_expired"));
             break;
     }
 }
@@ -90,7 +90,7 @@ void LoginScreen::Render(int windowWidth, int windowHeight) {
         // App title
         ImGui::SetCursorPos(ImVec2(0, 30));
         ImGui::PushFont(ImGui::GetIO().Fonts->Fonts[0]); // Assuming first font is larger
-        Widgets::TextCentered(i18n::T("app_name"));
+        Widgets::TextCentered(i18n::T(I18N_KEY("app_name")));
         ImGui::PopFont();
 
         ImGui::Spacing();
@@ -101,12 +101,12 @@ void LoginScreen::Render(int windowWidth, int windowHeight) {
         int tabCount = 0;
 
         if (m_loginMode == LoginMode::CardKey) {
-            tabs[tabCount++] = i18n::T("login.tab_cardkey");
+            tabs[tabCount++] = i18n::T(I18N_KEY("login.tab_cardkey"));
         } else {
-            tabs[tabCount++] = i18n::T("login.tab_account");
+            tabs[tabCount++] = i18n::T(I18N_KEY("login.tab_account"));
         }
-        tabs[tabCount++] = i18n::T("login.tab_register");
-        tabs[tabCount++] = i18n::T("login.tab_password");
+        tabs[tabCount++] = i18n::T(I18N_KEY("login.tab_register"));
+        tabs[tabCount++] = i18n::T(I18N_KEY("login.tab_password"));
 
         ImGui::SetCursorPosX(20);
         ImGui::PushItemWidth(panelWidth - 40);
@@ -200,8 +200,8 @@ void LoginScreen::RenderCardKeyTab() {
     ImGui::Spacing();
     ImGui::Spacing();
 
-    StyleUI::TextInput(i18n::T("login.input_cardkey"), m_cardKey, sizeof(m_cardKey),
-                       StyleUI::TextInputLabelMode::Above, i18n::T("login.input_cardkey"));
+    StyleUI::TextInput(i18n::T(I18N_KEY("login.input_cardkey")), m_cardKey, sizeof(m_cardKey),
+                       StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_cardkey")));
 
     ImGui::Spacing();
     ImGui::Spacing();
@@ -215,10 +215,10 @@ void LoginScreen::RenderCardKeyTab() {
         ImGui::BeginDisabled();
     }
 
-    if (StyleUI::ButtonGradient(i18n::T("login.btn_login"), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
+    if (StyleUI::ButtonGradient(i18n::T(I18N_KEY("login.btn_login")), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
         // Validate
         if (strlen(m_cardKey) == 0) {
-            m_errorMessage = i18n::T("login.error_empty_cardkey");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_empty_cardkey"));
         } else {
             HandleLoginAttempt();
         }
@@ -232,23 +232,23 @@ void LoginScreen::RenderCardKeyTab() {
 void LoginScreen::RenderAccountTab() {
     ImGui::Spacing();
 
-    StyleUI::TextInput(i18n::T("login.input_username"), m_username, sizeof(m_username),
-                       StyleUI::TextInputLabelMode::Above, i18n::T("login.input_username"));
+    StyleUI::TextInput(i18n::T(I18N_KEY("login.input_username")), m_username, sizeof(m_username),
+                       StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_username")));
 
     ImGui::Spacing();
 
-    StyleUI::PasswordInput(i18n::T("login.input_password"), m_password, sizeof(m_password),
-                           StyleUI::TextInputLabelMode::Above, i18n::T("login.input_password"));
+    StyleUI::PasswordInput(i18n::T(I18N_KEY("login.input_password")), m_password, sizeof(m_password),
+                           StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_password")));
 
     ImGui::Spacing();
 
     // Remember me checkbox (classic style - checkbox on left)
-    StyleUI::CheckboxClassic(i18n::T("login.remember_me"), &m_rememberMe);
+    StyleUI::CheckboxClassic(i18n::T(I18N_KEY("login.remember_me")), &m_rememberMe);
 
     ImGui::SameLine();
     ImGui::SetCursorPosX(ImGui::GetContentRegionAvail().x - 80);
     ImGui::PushStyleColor(ImGuiCol_Text, Theme::Colors::Primary);
-    ImGui::Text("%s", i18n::T("login.forgot_password"));
+    ImGui::Text("%s", i18n::T(I18N_KEY("login.forgot_password")));
     ImGui::PopStyleColor();
 
     ImGui::Spacing();
@@ -262,11 +262,11 @@ void LoginScreen::RenderAccountTab() {
         ImGui::BeginDisabled();
     }
 
-    if (StyleUI::ButtonGradient(i18n::T("login.btn_login"), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
+    if (StyleUI::ButtonGradient(i18n::T(I18N_KEY("login.btn_login")), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
         if (strlen(m_username) == 0) {
-            m_errorMessage = i18n::T("login.error_empty_username");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_empty_username"));
         } else if (strlen(m_password) == 0) {
-            m_errorMessage = i18n::T("login.error_empty_password");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_empty_password"));
         } else {
             HandleLoginAttempt();
         }
@@ -280,39 +280,39 @@ void LoginScreen::RenderAccountTab() {
 void LoginScreen::RenderRegisterTab() {
     ImGui::Spacing();
 
-    StyleUI::TextInput(i18n::T("login.input_username"), m_username, sizeof(m_username),
-                       StyleUI::TextInputLabelMode::Above, i18n::T("login.input_username"));
+    StyleUI::TextInput(i18n::T(I18N_KEY("login.input_username")), m_username, sizeof(m_username),
+                       StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_username")));
 
     ImGui::Spacing();
 
-    StyleUI::TextInput(i18n::T("login.input_email"), m_email, sizeof(m_email),
-                       StyleUI::TextInputLabelMode::Above, i18n::T("login.input_email"));
+    StyleUI::TextInput(i18n::T(I18N_KEY("login.input_email")), m_email, sizeof(m_email),
+                       StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_email")));
 
     ImGui::Spacing();
 
-    StyleUI::PasswordInput(i18n::T("login.input_password"), m_password, sizeof(m_password),
-                           StyleUI::TextInputLabelMode::Above, i18n::T("login.input_password"));
+    StyleUI::PasswordInput(i18n::T(I18N_KEY("login.input_password")), m_password, sizeof(m_password),
+                           StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_password")));
 
     ImGui::Spacing();
 
-    StyleUI::PasswordInput(i18n::T("login.input_confirm_password"), m_confirmPassword, sizeof(m_confirmPassword),
-                           StyleUI::TextInputLabelMode::Above, i18n::T("login.input_confirm_password"));
+    StyleUI::PasswordInput(i18n::T(I18N_KEY("login.input_confirm_password")), m_confirmPassword, sizeof(m_confirmPassword),
+                           StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_confirm_password")));
 
     ImGui::Spacing();
     ImGui::Spacing();
 
     // Register button
     float buttonWidth = ImGui::GetContentRegionAvail().x;
-    if (StyleUI::ButtonGradient(i18n::T("login.btn_register"), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
+    if (StyleUI::ButtonGradient(i18n::T(I18N_KEY("login.btn_register")), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
         if (strlen(m_username) == 0) {
-            m_errorMessage = i18n::T("login.error_empty_username");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_empty_username"));
         } else if (strlen(m_password) == 0) {
-            m_errorMessage = i18n::T("login.error_empty_password");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_empty_password"));
         } else if (strcmp(m_password, m_confirmPassword) != 0) {
-            m_errorMessage = i18n::T("login.error_password_mismatch");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_password_mismatch"));
         } else {
             m_errorMessage.clear();
-            m_successMessage = i18n::T("login.register_success");
+            m_successMessage = i18n::T(I18N_KEY("login.register_success"));
         }
     }
 }
@@ -321,32 +321,32 @@ void LoginScreen::RenderPasswordTab() {
     ImGui::Spacing();
     ImGui::Spacing();
 
-    StyleUI::PasswordInput(i18n::T("login.input_old_password"), m_oldPassword, sizeof(m_oldPassword),
-                           StyleUI::TextInputLabelMode::Above, i18n::T("login.input_old_password"));
+    StyleUI::PasswordInput(i18n::T(I18N_KEY("login.input_old_password")), m_oldPassword, sizeof(m_oldPassword),
+                           StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_old_password")));
 
     ImGui::Spacing();
 
-    StyleUI::PasswordInput(i18n::T("login.input_new_password"), m_newPassword, sizeof(m_newPassword),
-                           StyleUI::TextInputLabelMode::Above, i18n::T("login.input_new_password"));
+    StyleUI::PasswordInput(i18n::T(I18N_KEY("login.input_new_password")), m_newPassword, sizeof(m_newPassword),
+                           StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_new_password")));
 
     ImGui::Spacing();
 
-    StyleUI::PasswordInput(i18n::T("login.input_confirm_password"), m_confirmPassword, sizeof(m_confirmPassword),
-                           StyleUI::TextInputLabelMode::Above, i18n::T("login.input_confirm_password"));
+    StyleUI::PasswordInput(i18n::T(I18N_KEY("login.input_confirm_password")), m_confirmPassword, sizeof(m_confirmPassword),
+                           StyleUI::TextInputLabelMode::Above, i18n::T(I18N_KEY("login.input_confirm_password")));
 
     ImGui::Spacing();
     ImGui::Spacing();
 
     // Change password button
     float buttonWidth = ImGui::GetContentRegionAvail().x;
-    if (StyleUI::ButtonGradient(i18n::T("login.btn_change_password"), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
+    if (StyleUI::ButtonGradient(i18n::T(I18N_KEY("login.btn_change_password")), ImVec2(buttonWidth, Theme::Size::ButtonHeight))) {
         if (strlen(m_oldPassword) == 0 || strlen(m_newPassword) == 0) {
-            m_errorMessage = i18n::T("login.error_empty_password");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_empty_password"));
         } else if (strcmp(m_newPassword, m_confirmPassword) != 0) {
-            m_errorMessage = i18n::T("login.error_password_mismatch");
+            m_errorMessage = i18n::T(I18N_KEY("login.error_password_mismatch"));
         } else {
             m_errorMessage.clear();
-            m_successMessage = i18n::T("login.password_changed");
+            m_successMessage = i18n::T(I18N_KEY("login.password_changed"));
         }
     }
 }
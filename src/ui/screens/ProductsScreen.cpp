@@ -1,8 +1,10 @@
 #include "ProductsScreen.h"
 #include "../Theme.h"
 #include "../Widgets.h"
+#include "../SdfText.h"
 #include "../IconsFontAwesome6.h"
 #include "../../i18n/Localization.h"
+#include "../../core/Config.h"
 #include <imgui.h>
 
 ProductsScreen::ProductsScreen() {
@@ -80,7 +82,7 @@ void ProductsScreen::RenderSidebar(float width, float height) {
 
         // Draw "B" letter as placeholder
         ImVec2 textPos(windowPos.x + iconX + 15, windowPos.y + iconY + 10);
-        drawList->AddText(ImGui::GetFont(), 28.0f, textPos, IM_COL32(255, 255, 255, 255), "B");
+        SdfText::Instance().AddText(drawList, 28.0f, textPos, IM_COL32(255, 255, 255, 255), "B");
 
         // Navigation tabs
         float tabY = iconY + iconSize + 20.0f;
@@ -339,11 +341,11 @@ void ProductsScreen::RenderCarousel(float width, float height) {
         "Community News"
     };
 
-    ImVec2 textSize = ImGui::CalcTextSize(slideTexts[m_carousel.currentSlide]);
-    drawList->AddText(
-        ImGui::GetFont(),
+    ImVec2 textSize = SdfText::Instance().CalcTextSize(24.0f, slideTexts[m_carousel.currentSlide]);
+    SdfText::Instance().AddText(
+        drawList,
         24.0f,
-        ImVec2(slidePos.x + (slideSize.x - textSize.x * 1.3f) * 0.5f, slidePos.y + slideSize.y * 0.4f),
+        ImVec2(slidePos.x + (slideSize.x - textSize.x) * 0.5f, slidePos.y + slideSize.y * 0.4f),
         IM_COL32(255, 255, 255, 255),
         slideTexts[m_carousel.currentSlide]
     );
@@ -521,9 +523,8 @@ void ProductsScreen::RenderProductBanner(float width, float height) {
 
     // Banner title
     const char* title = "Update Information";
-    ImVec2 titleSize = ImGui::CalcTextSize(title);
-    drawList->AddText(
-        ImGui::GetFont(),
+    SdfText::Instance().AddText(
+        drawList,
         28.0f,
         ImVec2(windowPos.x + 30, windowPos.y + startY + height * 0.4f),
         IM_COL32(255, 255, 255, 255),
@@ -597,7 +598,10 @@ void ProductsScreen::RenderProductActions(float width, float height) {
     ImGui::PushItemWidth(buttonWidth);
 
     const char* versions[] = { "v2.1.0 (Latest)", "v2.0.5", "v2.0.0", "v1.9.8" };
-    ImGui::Combo("##Version", &m_selectedVersion, versions, 4);
+    int selectedVersion = Config::Instance().Get(settings::ProductsVersion);
+    if (ImGui::Combo("##Version", &selectedVersion, versions, 4)) {
+        Config::Instance().Set(settings::ProductsVersion, selectedVersion);
+    }
 
     ImGui::PopItemWidth();
 
@@ -611,7 +615,10 @@ void ProductsScreen::RenderProductActions(float width, float height) {
     ImGui::PushItemWidth(buttonWidth);
 
     const char* regions[] = { "CN Server", "International" };
-    ImGui::Combo("##Region", &m_selectedRegion, regions, 2);
+    int selectedRegion = Config::Instance().Get(settings::ProductsRegion);
+    if (ImGui::Combo("##Region", &selectedRegion, regions, 2)) {
+        Config::Instance().Set(settings::ProductsRegion, selectedRegion);
+    }
 
     ImGui::PopItemWidth();
 
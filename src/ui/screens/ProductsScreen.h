@@ -63,8 +63,6 @@ private:
 
     // State
     bool m_shouldLaunch = false;
-    int m_selectedVersion = 0;
-    int m_selectedRegion = 0;  // 0 = CN, 1 = International
     std::string m_username = "TestUser";
 
     // Window controls
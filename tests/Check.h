@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+
+// Bare-bones checks for the test executables: a failed CHECK prints where
+// and carries on, and main returns TestResult() for ctest.
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++TestFailures();                                                   \
+        }                                                                       \
+    } while (0)
+
+inline int TestResult() {
+    if (TestFailures() != 0) {
+        std::printf("%d check(s) failed\n", TestFailures());
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
+
+// Empty scratch directory for one test's files
+inline std::filesystem::path TestDir(const char* name) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "BigAppTests" / name;
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
@@ -0,0 +1,251 @@
+#include "Check.h"
+#include "core/Config.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <csignal>
+#include <spawn.h>
+#include <sys/wait.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void WriteFile(const fs::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+// Readers on several threads while one thread keeps publishing: every
+// snapshot a reader gets must be whole, and readers must keep moving.
+// The two files keep ui.scale == length of ui.language / 2, which a torn
+// snapshot would break.
+void TestConcurrentReaders() {
+    fs::path dir = TestDir("config_readers");
+    fs::path fileA = dir / "a.json";
+    fs::path fileB = dir / "b.json";
+    WriteFile(fileA, R"({"ui":{"language":"aa","scale":1.0}})");
+    WriteFile(fileB, R"({"ui":{"language":"bbbbbb","scale":3.0}})");
+
+    Config& config = Config::Instance();
+    CHECK(config.Load(fileA.string()));
+
+    constexpr int READERS = 4;
+    constexpr int PUBLISHES = 4000;
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+    std::vector<long> reads(READERS, 0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r) {
+        readers.emplace_back([&, r] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::shared_ptr<const ConfigSnapshot> snapshot = config.GetSnapshot();
+                float scale = snapshot->Get(settings::UiScale);
+                size_t length = snapshot->Get(settings::Language).size();
+                if (scale * 2.0f != static_cast<float>(length)) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+                // The hot path readers take, for the sanitizers' benefit
+                volatile int32_t version = config.Get(settings::ProductsVersion);
+                (void)version;
+                ++reads[r];
+            }
+        });
+    }
+
+    // Whole-file publishes alternate A and B; the setter in between adds
+    // single-setting publishes on top
+    for (int i = 0; i < PUBLISHES; ++i) {
+        CHECK(config.Load((i % 2 ? fileA : fileB).string()));
+        config.Set(settings::ProductsVersion, i % 4);
+    }
+    CHECK(config.Load(fileB.string()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    stop.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    CHECK(torn.load() == 0);
+    for (long count : reads) {
+        CHECK(count > 0);
+    }
+    // A reader picks up the last publish on its next read
+    CHECK(config.Get(settings::Language) == "bbbbbb");
+    std::thread([&] { CHECK(config.GetSnapshot()->Get(settings::UiScale) == 3.0f); }).join();
+}
+
+// The watcher parses without holding the writer lock, so setters can
+// publish in the middle of a reload; the reload must still land, on top
+void TestReloadRacingSetters() {
+    fs::path dir = TestDir("config_reload");
+    fs::path path = dir / "config.json";
+    WriteFile(path, R"({"ui":{"language":"en-US"}})");
+
+    Config& config = Config::Instance();
+    CHECK(config.Load(path.string()));
+    CHECK(config.StartWatching(path.string()));
+
+    // Large enough that parsing takes a while, with a change the watcher
+    // has to publish
+    std::string text = R"({"ui":{"language":"de-DE"},"padding":[)";
+    for (int i = 0; i < 200000; ++i) {
+        text += i ? ",1" : "1";
+    }
+    text += "]}";
+    WriteFile(path, text);
+
+    for (int i = 0; i < 300 && config.Get(settings::Language) != "de-DE"; ++i) {
+        CHECK(config.Set(settings::ProductsRegion, i % 2));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(config.Get(settings::Language) == "de-DE");
+    config.StopWatching();
+}
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Pushes a file's mtime forward, so an edit is seen even where the clock
+// is coarser than the test
+void TouchLater(const fs::path& path, int seconds) {
+    std::error_code ec;
+    fs::last_write_time(path, fs::last_write_time(path, ec) + std::chrono::seconds(seconds), ec);
+}
+
+// A save that finds the file edited on disk must keep both: the edit, and
+// the settings Set() since the last save
+void TestSaveMergesDiskEdit() {
+    fs::path dir = TestDir("config_conflict");
+    fs::path path = dir / "config.json";
+    WriteFile(path, R"({"ui":{"language":"en-US"},"products":{"selectedVersion":0,"selectedRegion":0}})");
+
+    Config& config = Config::Instance();
+    CHECK(config.Load(path.string()));
+    CHECK(config.Set(settings::ProductsVersion, 2));
+
+    WriteFile(path, R"({"ui":{"language":"fr-FR"},"products":{"selectedVersion":0}})");
+    TouchLater(path, 2);
+
+    CHECK(config.Save(path.string()));
+    CHECK(config.Get(settings::Language) == "fr-FR");
+    CHECK(config.Get(settings::ProductsVersion) == 2);
+
+    nlohmann::json saved = nlohmann::json::parse(ReadFile(path));
+    CHECK(saved["ui"]["language"] == "fr-FR");
+    CHECK(saved["products"]["selectedVersion"] == 2);
+
+    // The same through the watcher: the reload keeps the pending change
+    CHECK(config.Set(settings::ProductsRegion, 1));
+    WriteFile(path, R"({"ui":{"language":"de-DE"},"products":{"selectedVersion":2,"selectedRegion":0}})");
+    TouchLater(path, 4);
+    CHECK(config.StartWatching(path.string()));
+    for (int i = 0; i < 300 && config.Get(settings::Language) != "de-DE"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    config.StopWatching();
+    CHECK(config.Get(settings::Language) == "de-DE");
+    CHECK(config.Get(settings::ProductsRegion) == 1);
+
+    // Later saves go through as usual
+    CHECK(config.Save(path.string()));
+    CHECK(config.Set(settings::UiScale, 1.5f));
+    CHECK(config.Save(path.string()));
+    saved = nlohmann::json::parse(ReadFile(path));
+    CHECK(saved["ui"]["language"] == "de-DE");
+    CHECK(saved["ui"]["scale"] == 1.5);
+    CHECK(saved["products"]["selectedRegion"] == 1);
+}
+
+// Child side of TestKilledWriter: save a changing config until killed
+int RunSaveLoop(const char* path) {
+    Config& config = Config::Instance();
+    config.Load(path);
+    for (int i = 0;; ++i) {
+        config.Set(settings::ProductsVersion, i % 4);
+        config.Set(settings::LoginVideoPath, std::string(64 + i % 512, 'a' + i % 26));
+        config.Save(path);
+    }
+}
+
+// Start this executable again as RunSaveLoop(path), wait a little, kill it
+bool KillWriterAfter(const char* self, const fs::path& path, int delayMs) {
+#ifdef _WIN32
+    std::wstring command = L"\"" + fs::path(self).wstring() + L"\" --save-loop \"" + path.wstring() + L"\"";
+    STARTUPINFOW startup = {};
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessW(nullptr, &command[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process)) {
+        return false;
+    }
+    Sleep(delayMs);
+    TerminateProcess(process.hProcess, 1);
+    WaitForSingleObject(process.hProcess, INFINITE);
+    CloseHandle(process.hThread);
+    CloseHandle(process.hProcess);
+    return true;
+#else
+    std::string pathText = path.string();
+    char* argv[] = {const_cast<char*>(self), const_cast<char*>("--save-loop"), &pathText[0], nullptr};
+    pid_t child;
+    if (posix_spawn(&child, self, nullptr, nullptr, argv, environ) != 0) {
+        return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    kill(child, SIGKILL);
+    int status;
+    waitpid(child, &status, 0);
+    return true;
+#endif
+}
+
+// Killing the process at any point of a save leaves a whole config file:
+// the previous one or the new one, never a mix or a truncation
+void TestKilledWriter(const char* self) {
+    fs::path dir = TestDir("config_killed");
+    fs::path path = dir / "config.json";
+    WriteFile(path, R"({"ui":{"language":"en-US"}})");
+
+    std::mt19937 random(1234);
+    for (int round = 0; round < 20; ++round) {
+        CHECK(KillWriterAfter(self, path, 20 + static_cast<int>(random() % 60)));
+
+        std::string text = ReadFile(path);
+        bool parsed = false;
+        try {
+            nlohmann::json j = nlohmann::json::parse(text);
+            parsed = j["ui"]["language"] == "en-US";
+        } catch (const std::exception&) {
+        }
+        CHECK(parsed);
+        if (!parsed) {
+            std::printf("round %d left %zu bytes\n", round, text.size());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::strcmp(argv[1], "--save-loop") == 0) {
+        return RunSaveLoop(argv[2]);
+    }
+
+    TestConcurrentReaders();
+    TestReloadRacingSetters();
+    TestSaveMergesDiskEdit();
+    TestKilledWriter(argv[0]);
+    return TestResult();
+}
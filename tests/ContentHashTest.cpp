@@ -0,0 +1,84 @@
+#include "Check.h"
+#include "core/ContentHash.h"
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::vector<unsigned char> RandomBytes(size_t size, unsigned seed) {
+    std::vector<unsigned char> bytes(size);
+    std::mt19937 random(seed);
+    for (unsigned char& byte : bytes) {
+        byte = static_cast<unsigned char>(random());
+    }
+    return bytes;
+}
+
+// HashContent (SSE2 where built with it) gives the scalar reference's hash
+// at every length through a few stripes, around the 1 KB block edges, and
+// from every alignment
+void TestSimdMatchesScalar() {
+    std::vector<size_t> sizes;
+    for (size_t size = 0; size <= 257; ++size) {
+        sizes.push_back(size);
+    }
+    for (size_t size : {1023, 1024, 1025, 1087, 1088, 2047, 2048, 2049, 3100, 65536 + 17}) {
+        sizes.push_back(size);
+    }
+
+    const std::vector<unsigned char> bytes = RandomBytes(65536 + 17 + 16, 1);
+    int mismatches = 0;
+    for (size_t size : sizes) {
+        for (size_t offset = 0; offset < 16; ++offset) {
+            const unsigned char* data = bytes.data() + offset;
+            mismatches += HashContent(data, size) != HashContentScalar(data, size);
+            mismatches += HashContent(data, size, 0x1234567) != HashContentScalar(data, size, 0x1234567);
+        }
+    }
+    CHECK(mismatches == 0);
+
+    // All zeros and all ones take the multiplies through their edge cases
+    for (unsigned char fill : {0x00, 0xFF}) {
+        std::vector<unsigned char> same(4096, fill);
+        for (size_t size : sizes) {
+            if (size <= same.size()) {
+                mismatches += HashContent(same.data(), size) != HashContentScalar(same.data(), size);
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+// Every length and every one-bit change gives a different hash; the zero
+// padding of the last stripe doesn't make "abc" equal "abc\0"
+void TestHashesDiffer() {
+    const std::vector<unsigned char> zeros(2100, 0);
+    std::set<uint64_t> byLength;
+    for (size_t size = 0; size < zeros.size(); ++size) {
+        byLength.insert(HashContent(zeros.data(), size));
+    }
+    CHECK(byLength.size() == zeros.size());
+
+    std::vector<unsigned char> bytes = RandomBytes(1100, 2);
+    std::set<uint64_t> byBit = {HashContent(bytes.data(), bytes.size())};
+    for (size_t bit = 0; bit < bytes.size() * 8; bit += 7) {
+        bytes[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+        byBit.insert(HashContent(bytes.data(), bytes.size()));
+        bytes[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+    }
+    CHECK(byBit.size() == 1 + (bytes.size() * 8 + 6) / 7);
+
+    CHECK(HashContent("abc", 3) != HashContent("abc\0", 4));
+    CHECK(HashContent("abc", 3) != HashContent("abc", 3, 1));
+    CHECK(HashContent("abc", 3) == HashContent(std::vector<char>{'a', 'b', 'c'}.data(), 3));
+}
+
+} // namespace
+
+int main() {
+    TestSimdMatchesScalar();
+    TestHashesDiffer();
+    return TestResult();
+}
@@ -0,0 +1,423 @@
+#include "Check.h"
+#include "i18n/Catalog.h"
+#include "i18n/LangPack.h"
+#include "i18n/Localization.h"
+#include "i18n/StringPool.h"
+#include "graphics/GlyphCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<std::string> g_observed;
+
+void Observe(const char* text) {
+    g_observed.push_back(text ? text : "<replaced>");
+}
+
+void WriteFile(const fs::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Runs LangPackCompiler as the build does
+bool CompilePack(const fs::path& json, const fs::path& pack) {
+    std::string command = "\"" LANG_PACK_COMPILER_PATH "\" \"" + json.string() + "\" \"" + pack.string() + "\"";
+    return std::system(command.c_str()) == 0;
+}
+
+// The observer hears each catalog string once, not on every T(); a new
+// catalog starts over
+void TestObserverOncePerString() {
+    fs::path dir = TestDir("i18n_observer");
+    WriteFile(dir / "aa.json", R"({"login":{"title":"Sign in","ok":"OK"}})");
+    WriteFile(dir / "bb.json", R"({"login":{"title":"Anmelden","ok":"OK"}})");
+
+    i18n::Localization& localization = i18n::Localization::Instance();
+    localization.SetBasePath(dir.string());
+    CHECK(localization.LoadLanguage("aa"));
+    localization.SetTextObserver(&Observe);
+
+    for (int frame = 0; frame < 100; ++frame) {
+        localization.BeginFrame();
+        i18n::T(I18N_KEY("login.title"));
+        i18n::T(I18N_KEY("login.ok"));
+        i18n::T(I18N_KEY("login.missing"));
+    }
+    CHECK((g_observed == std::vector<std::string>{"Sign in", "OK"}));
+
+    // Lookups on other threads aren't reported
+    std::thread([] { i18n::T(I18N_KEY("login.title")); }).join();
+    CHECK(g_observed.size() == 2);
+
+    g_observed.clear();
+    CHECK(localization.LoadLanguage("bb"));
+    for (int frame = 0; frame < 10; ++frame) {
+        localization.BeginFrame();
+        i18n::T(I18N_KEY("login.title"));
+    }
+    CHECK((g_observed == std::vector<std::string>{"<replaced>", "Anmelden"}));
+    localization.SetTextObserver(nullptr);
+}
+
+// Interned text is stored once and never moves, however much is added
+void TestStringPool() {
+    i18n::StringPool pool;
+    const char* hello = pool.Intern("hello");
+    CHECK(std::strcmp(hello, "hello") == 0);
+    CHECK(pool.Intern(std::string("hel") + "lo") == hello);
+    CHECK(pool.Intern("hello world") != hello);
+    CHECK(pool.GetCount() == 2);
+
+    // Enough to grow the table and fill several blocks, plus strings too
+    // long to share one
+    std::vector<const char*> texts;
+    for (int i = 0; i < 5000; ++i) {
+        texts.push_back(pool.Intern("text " + std::to_string(i)));
+    }
+    std::string longText(10000, 'x');
+    const char* longCopy = pool.Intern(longText);
+    CHECK(pool.Intern("hello") == hello);
+    for (int i = 0; i < 5000; ++i) {
+        CHECK(pool.Intern("text " + std::to_string(i)) == texts[i]);
+        CHECK(texts[i] == "text " + std::to_string(i));
+    }
+    CHECK(longCopy == longText);
+    CHECK(pool.GetCount() == 5003);
+
+    // Embedded NULs are part of the key
+    CHECK(pool.Intern(std::string_view("a\0b", 3)) != pool.Intern(std::string_view("a\0c", 3)));
+
+    pool.Clear();
+    CHECK(pool.GetCount() == 0);
+    CHECK(pool.GetBytesUsed() == 0);
+    CHECK(std::strcmp(pool.Intern("hello"), "hello") == 0);
+}
+
+// Text fetched this frame, found or "[key]", stays readable after a
+// switch until the next BeginFrame(); a missing key is interned once and
+// its text is never freed
+void TestTextOutlivesSwitch() {
+    fs::path dir = TestDir("i18n_lifetime");
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Play","quit":"Quit"}})");
+    WriteFile(dir / "bb.json", R"({"menu":{"play":"Spielen"}})");
+
+    i18n::Localization& localization = i18n::Localization::Instance();
+    localization.SetBasePath(dir.string());
+    CHECK(localization.LoadLanguage("aa"));
+    localization.BeginFrame();
+
+    uint64_t generation = localization.GetGeneration();
+    uint64_t misses = localization.GetMissCount();
+    const char* play = i18n::T(I18N_KEY("menu.play"));
+    const char* quit = i18n::T(I18N_KEY("menu.quit"));
+    const char* missing = i18n::T(I18N_KEY("menu.lifetime_missing"));
+    CHECK(std::strcmp(missing, "[menu.lifetime_missing]") == 0);
+
+    CHECK(localization.LoadLanguage("bb"));
+    CHECK(localization.GetGeneration() == generation + 1);
+    CHECK(std::string(i18n::T(I18N_KEY("menu.play"))) == "Spielen");
+    // Read after the switch, in the same frame; ASan catches a freed catalog
+    CHECK(std::string(play) == "Play");
+    CHECK(std::string(quit) == "Quit");
+    CHECK(std::string(missing) == "[menu.lifetime_missing]");
+
+    // Missing in the new language: "[key]", like any miss
+    CHECK(std::string(i18n::T(I18N_KEY("menu.quit"))) == "[menu.quit]");
+
+    // The same miss is the same text, across frames and languages
+    localization.BeginFrame();
+    CHECK(i18n::T(I18N_KEY("menu.lifetime_missing")) == missing);
+    CHECK(i18n::T(std::string("menu.lifetime_missing")) == missing);
+    CHECK(std::string(missing) == "[menu.lifetime_missing]");
+    CHECK(localization.GetMissCount() == misses + 4);
+
+    std::vector<i18n::MissingKey> keys = localization.GetMissingKeys();
+    auto find = [&keys](const std::string& key) {
+        auto it = std::find_if(keys.begin(), keys.end(), [&key](const i18n::MissingKey& entry) {
+            return entry.key == key;
+        });
+        return it == keys.end() ? uint64_t(0) : it->count;
+    };
+    CHECK(find("menu.lifetime_missing") == 3);
+    CHECK(find("menu.quit") == 1);
+    CHECK(find("menu.play") == 0);
+}
+
+// A compiled pack, mapped, holds the same strings as the catalog built
+// from its JSON
+void TestPackMatchesJson() {
+    fs::path dir = TestDir("i18n_pack");
+    std::string json = R"({"_language_name":"Test","menu":{"play":"Play","quit":"Quit","again":"Play"},)"
+                       R"("dialog":{"title":"\u00dcberschrift \u2713","empty":"","nested":{"deep":"Deep text"}},"many":{)";
+    for (int i = 0; i < 1000; ++i) {
+        json += (i ? ",\"k" : "\"k") + std::to_string(i) + "\":\"text " + std::to_string(i % 300) + "\"";
+    }
+    json += "}}";
+    WriteFile(dir / "aa.json", json);
+    CHECK(CompilePack(dir / "aa.json", dir / "aa.lpak"));
+
+    lpak::Entries entries;
+    CHECK(lpak::ParseJson(json, entries));
+    CHECK(entries.size() == 1007);
+    i18n::Catalog built;
+    built.Build(entries);
+    i18n::Catalog mapped;
+    CHECK(mapped.Map((dir / "aa.lpak").string()));
+
+    CHECK(built.GetSize() == entries.size());
+    CHECK(mapped.GetSize() == built.GetSize());
+    int mismatches = 0;
+    for (const auto& [key, text] : entries) {
+        const char* fromJson = built.Find(HashString(key));
+        const char* fromPack = mapped.Find(HashString(key));
+        mismatches += !fromJson || !fromPack || text != fromJson || text != fromPack;
+    }
+    CHECK(mismatches == 0);
+    CHECK(std::string(mapped.Find(HashString("dialog.title"))) == "\xc3\x9c" "berschrift \xe2\x9c\x93");
+    CHECK(std::string(mapped.Find(HashString("dialog.empty"))).empty());
+    CHECK(!built.Find(HashString("menu")) && !mapped.Find(HashString("menu")));
+    CHECK(!built.Find(HashString("menu.missing")) && !mapped.Find(HashString("menu.missing")));
+
+    CHECK(!built.GetPackHeader());
+    const lpak::Header* header = mapped.GetPackHeader();
+    CHECK(header && header->sourceSize == json.size());
+    CHECK(header && header->sourceHash == HashBytes(json.data(), json.size()));
+
+    // The compiler refuses what it can't parse
+    WriteFile(dir / "bad.json", R"({"menu":{"play":)");
+    CHECK(!CompilePack(dir / "bad.json", dir / "bad.lpak"));
+}
+
+// Validate() turns away anything that isn't a whole, current pack
+void TestPackValidate() {
+    fs::path dir = TestDir("i18n_validate");
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Play","quit":"Quit"}})");
+    CHECK(CompilePack(dir / "aa.json", dir / "aa.lpak"));
+    std::string bytes = ReadFile(dir / "aa.lpak");
+
+    // Headers are read in place, so keep the copies 8-byte aligned
+    auto validate = [](const std::string& pack) {
+        std::vector<uint64_t> aligned(pack.size() / 8 + 1);
+        std::memcpy(aligned.data(), pack.data(), pack.size());
+        return lpak::Validate(reinterpret_cast<const unsigned char*>(aligned.data()), pack.size()) != nullptr;
+    };
+    auto withHeader = [&bytes](void (*edit)(lpak::Header&)) {
+        lpak::Header header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        edit(header);
+        std::string pack = bytes;
+        std::memcpy(&pack[0], &header, sizeof(header));
+        return pack;
+    };
+
+    CHECK(validate(bytes));
+    CHECK(!validate(""));
+    CHECK(!validate(bytes.substr(0, sizeof(lpak::Header) - 1)));
+    CHECK(!validate(bytes.substr(0, bytes.size() - 1)));
+    CHECK(!validate(bytes + '\0'));
+    CHECK(!validate(withHeader([](lpak::Header& h) { h.magic[0] = 'X'; })));
+    CHECK(!validate(withHeader([](lpak::Header& h) { h.version = lpak::VERSION + 1; })));
+    CHECK(!validate(withHeader([](lpak::Header& h) { h.slotCount = 0; })));
+    CHECK(!validate(withHeader([](lpak::Header& h) { h.slotCount -= 1; })));
+    CHECK(!validate(withHeader([](lpak::Header& h) { h.entryCount = h.slotCount; })));
+    CHECK(!validate(withHeader([](lpak::Header& h) { h.blobSize += 1; })));
+
+    std::string unterminated = bytes;
+    unterminated.back() = 'x';
+    CHECK(!validate(unterminated));
+}
+
+// Localization maps the pack when it's current, and reads the JSON when
+// the pack is missing, stale or malformed
+void TestPackFallback() {
+    fs::path dir = TestDir("i18n_fallback");
+    i18n::Localization& localization = i18n::Localization::Instance();
+    localization.SetBasePath(dir.string());
+    auto play = [&localization](const char* langCode) -> std::string {
+        if (!localization.LoadLanguage(langCode)) {
+            return "<failed>";
+        }
+        localization.BeginFrame();
+        return i18n::T(I18N_KEY("menu.play"));
+    };
+
+    // No pack
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Play"}})");
+    CHECK(play("aa") == "Play");
+
+    // Only a pack, as shipped without the JSON
+    CHECK(CompilePack(dir / "aa.json", dir / "aa.lpak"));
+    fs::remove(dir / "aa.json");
+    CHECK(play("aa") == "Play");
+
+    // The JSON edited after the pack was compiled, at a different size
+    // and at the same size
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Spielen"}})");
+    CHECK(play("aa") == "Spielen");
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Plat"}})");
+    CHECK(play("aa") == "Plat");
+    CHECK(CompilePack(dir / "aa.json", dir / "aa.lpak"));
+    CHECK(play("aa") == "Plat");
+
+    // A damaged pack
+    std::string pack = ReadFile(dir / "aa.lpak");
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Jouer"}})");
+    WriteFile(dir / "aa.lpak", pack.substr(0, pack.size() / 2));
+    CHECK(play("aa") == "Jouer");
+    WriteFile(dir / "aa.lpak", "LPAK but not really");
+    CHECK(play("aa") == "Jouer");
+
+    // Nothing usable at all keeps the current language
+    fs::remove(dir / "aa.json");
+    CHECK(play("aa") == "<failed>");
+    WriteFile(dir / "bb.json", R"({"menu":{"play":)");
+    CHECK(play("bb") == "<failed>");
+    CHECK(i18n::GetLanguage() == "aa");
+    CHECK(std::string(i18n::T(I18N_KEY("menu.play"))) == "Jouer");
+}
+
+// Runs frames until done() holds, as the UI would while a request loads
+template <typename Done>
+bool RunFramesUntil(Done done) {
+    i18n::Localization& localization = i18n::Localization::Instance();
+    for (int frame = 0; frame < 1000; ++frame) {
+        localization.BeginFrame();
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+// A requested language loads on the loader thread; the current catalog
+// keeps serving lookups until a BeginFrame() installs the new one
+void TestBackgroundSwitch() {
+    fs::path dir = TestDir("i18n_background");
+    WriteFile(dir / "aa.json", R"({"menu":{"play":"Play"}})");
+    WriteFile(dir / "bb.json", R"({"menu":{"play":"Spielen"}})");
+    WriteFile(dir / "cc.json", R"({"menu":{"play":"Jouer"}})");
+
+    i18n::Localization& localization = i18n::Localization::Instance();
+    localization.SetBasePath(dir.string());
+    CHECK(localization.LoadLanguage("aa"));
+    localization.BeginFrame();
+    uint64_t generation = localization.GetGeneration();
+    uint64_t misses = localization.GetMissCount();
+
+    const char* play = i18n::T(I18N_KEY("menu.play"));
+    i18n::SetLanguage("bb");
+    // Long enough for the loader to finish; nothing changes without a frame
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CHECK(i18n::GetLanguage() == "aa");
+    CHECK(localization.GetGeneration() == generation);
+    CHECK(i18n::T(I18N_KEY("menu.play")) == play);
+    CHECK(std::string(play) == "Play");
+
+    // The swap: one new generation, and text from this frame on is the
+    // new language's
+    CHECK(RunFramesUntil([] { return i18n::GetLanguage() == "bb"; }));
+    CHECK(localization.GetGeneration() == generation + 1);
+    CHECK(std::string(i18n::T(I18N_KEY("menu.play"))) == "Spielen");
+
+    // A newer request supersedes an older one, and a language that fails
+    // to load leaves the current one in place
+    i18n::SetLanguage("cc");
+    i18n::SetLanguage("aa");
+    CHECK(RunFramesUntil([] { return i18n::GetLanguage() == "aa"; }));
+    CHECK(std::string(i18n::T(I18N_KEY("menu.play"))) == "Play");
+    generation = localization.GetGeneration();
+
+    // The loader takes a switch before a scan, so once the scan lands the
+    // failed "zz" has been dealt with. The built-in list stands until then.
+    WriteFile(dir / "bb.json", R"({"_language_name":"German","_language_native":"Deutsch","menu":{"play":"Spielen"}})");
+    std::vector<i18n::LanguageInfo> builtIn = localization.GetAvailableLanguages();
+    i18n::SetLanguage("zz");
+    localization.RequestLanguageScan();
+    CHECK(localization.GetAvailableLanguages()[0].code == builtIn[0].code);
+    CHECK(RunFramesUntil([&] { return localization.GetAvailableLanguages()[0].code == "aa"; }));
+    const std::vector<i18n::LanguageInfo>& languages = localization.GetAvailableLanguages();
+    CHECK(languages.size() == 3);
+    if (languages.size() == 3) {
+        CHECK(languages[0].name == "aa");
+        CHECK(languages[1].code == "bb" && languages[1].name == "German" && languages[1].nativeName == "Deutsch");
+        CHECK(languages[2].code == "cc");
+    }
+    CHECK(localization.GetGeneration() == generation);
+    CHECK(localization.GetMissCount() == misses);
+    CHECK(i18n::GetLanguage() == "aa");
+
+    localization.Shutdown();
+}
+
+// Square glyphs, one per codepoint
+class BoxRasterizer : public GlyphRasterizer {
+public:
+    bool Rasterize(uint32_t, GlyphBitmap& out) override {
+        out.width = 60;
+        out.height = 60;
+        out.advanceX = 60.0f;
+        out.alpha.assign(size_t(out.width) * out.height, 255);
+        return true;
+    }
+};
+
+// Pinned glyphs outlive frames without being acquired; everything else
+// is evicted least recently used first
+void TestPinnedGlyphs() {
+    GlyphCacheConfig config;
+    config.pageSize = 128;   // Four 60 px glyphs per page
+    config.maxPages = 2;
+    GlyphCache cache(std::make_unique<BoxRasterizer>(), config);
+
+    for (uint32_t c = 0; c < 4; ++c) {
+        CHECK(cache.AcquirePinned(0x4E00 + c));
+    }
+    for (uint32_t round = 0; round < 5; ++round) {
+        cache.BeginFrame();
+        for (uint32_t c = 0; c < 4; ++c) {
+            CHECK(cache.Acquire(0x5000 + round * 4 + c));
+        }
+    }
+    for (uint32_t c = 0; c < 4; ++c) {
+        CHECK(cache.Contains(0x4E00 + c));
+    }
+    CHECK(!cache.Contains(0x5000));
+
+    // Unpinned, it is the least recently used page and goes first
+    cache.UnpinAll();
+    cache.BeginFrame();
+    for (uint32_t c = 0; c < 8; ++c) {
+        cache.Acquire(0x6000 + c);
+    }
+    CHECK(!cache.Contains(0x4E00));
+}
+
+} // namespace
+
+int main() {
+    TestObserverOncePerString();
+    TestStringPool();
+    TestTextOutlivesSwitch();
+    TestBackgroundSwitch();
+    TestPackMatchesJson();
+    TestPackValidate();
+    TestPackFallback();
+    TestPinnedGlyphs();
+    return TestResult();
+}
@@ -0,0 +1,160 @@
+#include "Check.h"
+#include "core/Logger.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Line {
+    std::string time;
+    std::string level;
+    std::string message;
+};
+
+std::string Printf(const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return buffer;
+}
+
+// Wall clock in the logger's "%Y-%m-%d %H:%M:%S" form, which sorts as text
+std::string NowText() {
+    time_t t = time(nullptr);
+    struct tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &t);
+#else
+    localtime_r(&t, &timeinfo);
+#endif
+    char text[32];
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    return text;
+}
+
+// "[time] [LEVEL] message" lines; a line that doesn't parse keeps its
+// whole text as the message
+std::vector<Line> ReadLines(const fs::path& path) {
+    std::vector<Line> lines;
+    std::ifstream file(path, std::ios::binary);
+    std::string text;
+    while (std::getline(file, text)) {
+        Line line;
+        size_t timeEnd = text.find("] [");
+        size_t levelEnd = timeEnd == std::string::npos ? timeEnd : text.find("] ", timeEnd + 3);
+        if (text.empty() || text[0] != '[' || levelEnd == std::string::npos) {
+            line.message = text;
+        } else {
+            line.time = text.substr(1, timeEnd - 1);
+            line.level = text.substr(timeEnd + 3, levelEnd - timeEnd - 3);
+            line.message = text.substr(levelEnd + 2);
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+// One record per argument kind and then some, with the text printf gives
+// for the same call
+std::vector<Line> LogEveryKind(const std::string& longText) {
+    std::vector<Line> expected;
+    int value = -123456;
+    void* pointer = &value;
+    const char* none = nullptr;
+
+    LOG_INFO("int32 %d %i %u %x %o %c", value, 42, 3000000000u, 0xBEEF, 8, 'k');
+    expected.push_back({"", "INFO", Printf("int32 %d %i %u %x %o %c", value, 42, 3000000000u, 0xBEEF, 8, 'k')});
+
+    LOG_INFO("int64 %lld %llu %llx %zu", -9000000000ll, 18446744073709551615ull, 0x123456789abcull, size_t(77));
+    expected.push_back({"", "INFO", Printf("int64 %lld %llu %llx %zu", -9000000000ll, 18446744073709551615ull,
+                                           0x123456789abcull, size_t(77))});
+
+    LOG_WARNING("double %.3f %g %e %8.2f", 3.14159, 1e-10, 12345.678, 2.5f);
+    expected.push_back({"", "WARN", Printf("double %.3f %g %e %8.2f", 3.14159, 1e-10, 12345.678, 2.5)});
+
+    LOG_INFO("pointer %p", pointer);
+    expected.push_back({"", "INFO", Printf("pointer %p", pointer)});
+
+    LOG_ERROR("string %s|%s|%s|%s", std::string("std"), "literal", std::string_view("view"), none);
+    expected.push_back({"", "ERROR", "string std|literal|view|(null)"});
+
+    LOG_INFO("star %*d|%-*s|%.*s", 6, 42, 5, "ab", 3, "abcdef");
+    expected.push_back({"", "INFO", "star     42|ab   |abc"});
+
+    LOG_INFO("100%% done");
+    expected.push_back({"", "INFO", "100% done"});
+
+    // Longer than the stack buffer the old Logger truncated at
+    LOG_INFO("long %s", longText);
+    expected.push_back({"", "INFO", "long " + longText});
+
+    // The varargs entry point is formatted at the call site
+    Logger::Instance().Info("legacy %s %d", "vararg", 7);
+    expected.push_back({"", "INFO", "legacy vararg 7"});
+    return expected;
+}
+
+// Messages, levels and times of a log against what was logged
+void CheckLines(const std::vector<Line>& lines, const std::vector<Line>& expected,
+                const std::string& start, const std::string& end) {
+    CHECK(lines.size() == expected.size());
+    for (size_t i = 0; i < lines.size() && i < expected.size(); ++i) {
+        CHECK(lines[i].level == expected[i].level);
+        CHECK(lines[i].message == expected[i].message);
+        if (lines[i].message != expected[i].message) {
+            std::printf("  line %zu: got \"%.80s\", expected \"%.80s\"\n", i, lines[i].message.c_str(),
+                        expected[i].message.c_str());
+        }
+        CHECK(lines[i].time >= start && lines[i].time <= end);
+        CHECK(i == 0 || lines[i].time >= lines[i - 1].time);
+    }
+}
+
+// The same records through a text log and through a .blog rendered by
+// LogDecoder must read the same as printf
+void TestRoundTrip() {
+    fs::path dir = TestDir("logdecoder");
+    const std::string longText(5000, 'L');
+
+    Logger& logger = Logger::Instance();
+    LogRateLimit unlimited;
+    unlimited.perSecond = 0;
+    unlimited.coalesceRepeats = false;
+    logger.SetRateLimit(unlimited);
+    logger.SetOverflowPolicy(LogOverflow::Block);
+
+    std::string start = NowText();
+    logger.SetLogFile((dir / "log.txt").string(), LogFileFormat::Text);
+    std::vector<Line> expected = LogEveryKind(longText);
+    logger.SetLogFile((dir / "log.blog").string(), LogFileFormat::Binary);
+    LogEveryKind(longText);
+    logger.Flush();
+    std::string end = NowText();
+
+    std::printf("text log:\n");
+    CheckLines(ReadLines(dir / "log.txt"), expected, start, end);
+
+    std::string command = "\"" LOG_DECODER_PATH "\" \"" + (dir / "log.blog").string() + "\" \"" +
+                          (dir / "decoded.txt").string() + "\"";
+    CHECK(std::system(command.c_str()) == 0);
+    std::printf("decoded .blog:\n");
+    CheckLines(ReadLines(dir / "decoded.txt"), expected, start, end);
+}
+
+} // namespace
+
+int main() {
+    TestRoundTrip();
+    Logger::Instance().Shutdown();
+    return TestResult();
+}
@@ -0,0 +1,196 @@
+#include "Check.h"
+#include "core/LogFormat.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using logfmt::ArgKind;
+using logfmt::CompileFormat;
+
+namespace {
+
+enum class Color { Red, Green };
+
+// Captured arguments as Logger's call sites encode them
+class Args {
+public:
+    Args& Int32(int32_t value) { return Put<ArgKind::Int32>(value); }
+    Args& Int64(int64_t value) { return Put<ArgKind::Int64>(value); }
+    Args& Double(double value) { return Put<ArgKind::Double>(value); }
+    Args& Pointer(const void* value) { return Put<ArgKind::Pointer>(value); }
+    Args& String(std::string_view value) { return Put<ArgKind::String>(value); }
+
+    // Drops trailing bytes, as a damaged record would
+    Args& Truncate(size_t bytes) {
+        m_bytes.resize(m_bytes.size() - bytes);
+        return *this;
+    }
+
+    const std::vector<ArgKind>& Kinds() const { return m_kinds; }
+    const std::vector<unsigned char>& Bytes() const { return m_bytes; }
+
+private:
+    template <ArgKind Kind, typename T>
+    Args& Put(const T& value) {
+        size_t offset = m_bytes.size();
+        m_bytes.resize(offset + logfmt::ArgWriter<Kind>::Size(value));
+        logfmt::ArgWriter<Kind>::Put(m_bytes.data() + offset, value);
+        m_kinds.push_back(Kind);
+        return *this;
+    }
+
+    std::vector<ArgKind> m_kinds;
+    std::vector<unsigned char> m_bytes;
+};
+
+// RenderFormat's text, or "<failed>"
+std::string Render(const char* format, const Args& args = Args()) {
+    std::string out;
+    if (!logfmt::RenderFormat(format, std::string_view(format).size(), args.Kinds().data(), args.Kinds().size(),
+                              args.Bytes().data(), args.Bytes().size(), out)) {
+        return "<failed>";
+    }
+    return out;
+}
+
+// What the compiled format captures, as one string: i(nt32) I(nt64)
+// d(ouble) p(ointer) s(tring), or "-" if the format is rejected
+template <typename... T>
+std::string Captured(const char* format) {
+    auto compiled = CompileFormat<T...>(format);
+    if (!compiled.ok) {
+        return "-";
+    }
+    std::string kinds;
+    for (size_t i = 0; i < sizeof...(T); ++i) {
+        kinds += "iIdps"[static_cast<int>(compiled.kinds[i])];
+    }
+    return kinds;
+}
+
+// Formats the LOG_* static_assert accepts, and how each argument is captured
+void TestCompileAccepts() {
+    CHECK(Captured<>("no conversions") == "");
+    CHECK(Captured<>("100%% done") == "");
+    CHECK((Captured<int, double, const char*>("%d %f %s") == "ids"));
+    CHECK((Captured<unsigned, short, char, bool, Color>("%u %hd %c %d %d") == "iiiii"));
+
+    // Integers are captured at their own width, whatever the length modifier
+    CHECK((Captured<long long, unsigned long long>("%lld %llu") == "II"));
+    CHECK((Captured<int64_t, size_t>("%d %zu") == "II"));
+    CHECK(Captured<int32_t>("%lld") == "i");
+    CHECK(Captured<int64_t>("%I64d") == "I");
+    CHECK(Captured<int64_t>("%c") == "I");
+
+    CHECK((Captured<float, double>("%.2f %g") == "dd"));
+    CHECK((Captured<char*, std::string, std::string_view>("%s%s%s") == "sss"));
+    CHECK((Captured<void*, const char*, std::nullptr_t>("%p %p %p") == "ppp"));
+    CHECK((Captured<int, int, const char*>("%-*.*s") == "iis"));
+    CHECK((Captured<int, int>("%+05d %#x") == "ii"));
+}
+
+// Formats that must fail to compile as LOG_* calls
+void TestCompileRejects() {
+    // Wrong class of argument
+    CHECK(Captured<int>("%s") == "-");
+    CHECK(Captured<const char*>("%d") == "-");
+    CHECK(Captured<double>("%d") == "-");
+    CHECK(Captured<int>("%f") == "-");
+    CHECK(Captured<int>("%p") == "-");
+    CHECK(Captured<std::string>("%p") == "-");
+
+    // Wrong number of arguments
+    CHECK(Captured<int>("%d %d") == "-");
+    CHECK((Captured<int, int>("%d") == "-"));
+    CHECK(Captured<>("%d") == "-");
+
+    // * takes an int, not a wider integer
+    CHECK((Captured<long long, int>("%*d") == "-"));
+    CHECK((Captured<double, int>("%*d") == "-"));
+
+    // Conversions the logger doesn't capture, and a dangling %
+    CHECK(Captured<int*>("%n") == "-");
+    CHECK(Captured<int>("%q") == "-");
+    CHECK(Captured<int>("%d %") == "-");
+}
+
+// Length modifiers are rewritten from the captured kind, so a record
+// renders the same whatever platform wrote it
+void TestRenderRewritesLengths() {
+    // 64-bit capture behind a 32-bit (or no) modifier, and the reverse
+    CHECK(Render("%ld", Args().Int64(-5000000000ll)) == "-5000000000");
+    CHECK(Render("%d", Args().Int64(1ll << 40)) == "1099511627776");
+    CHECK(Render("%lld", Args().Int32(-7)) == "-7");
+    CHECK(Render("%I64d %I32u", Args().Int64(123456789012ll).Int32(5)) == "123456789012 5");
+    CHECK(Render("%zx", Args().Int64(0xabcdef0123ll)) == "abcdef0123");
+
+    // Unsigned conversions read the captured bits as unsigned
+    CHECK(Render("%lu", Args().Int32(static_cast<int32_t>(3000000000u))) == "3000000000");
+    CHECK(Render("%llu", Args().Int64(-1)) == "18446744073709551615");
+    CHECK(Render("%o %X", Args().Int32(8).Int64(0xBEEF)) == "10 BEEF");
+
+    // %c of a 64-bit integer is still one character
+    CHECK(Render("%c%c", Args().Int64('o').Int32('k')) == "ok");
+    CHECK(Render("[%3c]", Args().Int64('x')) == "[  x]");
+}
+
+void TestRenderFields() {
+    CHECK(Render("plain text") == "plain text");
+    CHECK(Render("100%% of %d", Args().Int32(3)) == "100% of 3");
+    CHECK(Render("%08.3f|%-6s|%.2s", Args().Double(3.14159).String("ab").String("abcdef")) ==
+          "0003.142|ab    |ab");
+    CHECK(Render("%*d|%-*d|%.*f", Args().Int32(5).Int32(42).Int32(4).Int32(7).Int32(1).Double(2.375)) ==
+          "   42|7   |2.4");
+    CHECK(Render("%+d %05d %#x", Args().Int32(5).Int32(-42).Int32(255)) == "+5 -0042 0xff");
+
+    // Strings aren't terminated in the record and may hold anything
+    std::string longText(3000, 'z');
+    CHECK(Render("<%s>", Args().String(longText)) == "<" + longText + ">");
+    CHECK(Render("%s", Args().String(std::string_view("a\0b", 3))) == std::string("a\0b", 3));
+
+    int value = 0;
+    char expected[32];
+    std::snprintf(expected, sizeof(expected), "%p", static_cast<void*>(&value));
+    CHECK(Render("%p", Args().Pointer(&value)) == expected);
+}
+
+// A damaged or mismatched record fails instead of reading past its bytes
+void TestRenderRejects() {
+    CHECK(Render("%d") == "<failed>");
+    CHECK(Render("%d %d", Args().Int32(1)) == "<failed>");
+    CHECK(Render("%d", Args().String("1")) == "<failed>");
+    CHECK(Render("%s", Args().Int32(1)) == "<failed>");
+    CHECK(Render("%f", Args().Int64(1)) == "<failed>");
+    CHECK(Render("%p", Args().Int64(1)) == "<failed>");
+    CHECK(Render("%*d", Args().Int64(5).Int32(1)) == "<failed>");
+
+    CHECK(Render("%d", Args().Int32(1).Truncate(1)) == "<failed>");
+    CHECK(Render("%lld", Args().Int64(1).Truncate(4)) == "<failed>");
+    CHECK(Render("%s", Args().String("hello").Truncate(1)) == "<failed>");
+
+    CHECK(Render("%n", Args().Int32(1)) == "<failed>");
+    CHECK(Render("%ls", Args().String("w")) == "<failed>");
+    CHECK(Render("%Lf", Args().Double(1.0)) == "<failed>");
+    CHECK(Render("trailing %", Args()) == "<failed>");
+}
+
+void TestLevelNames() {
+    CHECK(std::string(logfmt::LevelName(0)) == "DEBUG");
+    CHECK(std::string(logfmt::LevelName(1)) == "INFO");
+    CHECK(std::string(logfmt::LevelName(2)) == "WARN");
+    CHECK(std::string(logfmt::LevelName(3)) == "ERROR");
+    CHECK(std::string(logfmt::LevelName(9)) == "UNKNOWN");
+}
+
+} // namespace
+
+int main() {
+    TestCompileAccepts();
+    TestCompileRejects();
+    TestRenderRewritesLengths();
+    TestRenderFields();
+    TestRenderRejects();
+    TestLevelNames();
+    return TestResult();
+}
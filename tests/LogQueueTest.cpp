@@ -0,0 +1,256 @@
+#include "Check.h"
+#include "core/LogQueue.h"
+#include "core/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int PRODUCERS = 4;
+
+// Record layout for the raw queue tests; the queue reads size first
+struct TestHead {
+    uint32_t size;
+    uint32_t producer;
+    uint32_t sequence;
+    uint32_t payload;   // Bytes after the head, each (sequence + i) & 0xFF
+};
+
+// 0..299 payload bytes: records of one to six slots, so some wrap the ring
+uint32_t PayloadSize(uint32_t sequence) {
+    return (sequence * 37) % 300;
+}
+
+bool Push(LogQueue& queue, uint32_t producer, uint32_t sequence) {
+    unsigned char payload[300];
+    TestHead head = {0, producer, sequence, PayloadSize(sequence)};
+    head.size = static_cast<uint32_t>(sizeof(head) + head.payload);
+    for (uint32_t i = 0; i < head.payload; ++i) {
+        payload[i] = static_cast<unsigned char>(sequence + i);
+    }
+    return queue.TryPush(&head, sizeof(head), payload, head.payload);
+}
+
+// What the consumer saw: per producer, the sequences in arrival order
+struct Received {
+    std::vector<std::vector<uint32_t>> sequences = std::vector<std::vector<uint32_t>>(PRODUCERS);
+    int corrupt = 0;
+};
+
+size_t DrainInto(LogQueue& queue, Received& received) {
+    return queue.Drain([&](const unsigned char* data, size_t span) {
+        TestHead head;
+        std::memcpy(&head, data, sizeof(head));
+        bool valid = head.producer < PRODUCERS && head.size == sizeof(head) + head.payload && head.size <= span;
+        for (uint32_t i = 0; valid && i < head.payload; ++i) {
+            valid = data[sizeof(head) + i] == static_cast<unsigned char>(head.sequence + i);
+        }
+        if (!valid) {
+            ++received.corrupt;
+            return;
+        }
+        received.sequences[head.producer].push_back(head.sequence);
+    });
+}
+
+bool StrictlyIncreasing(const std::vector<uint32_t>& sequences) {
+    for (size_t i = 1; i < sequences.size(); ++i) {
+        if (sequences[i] <= sequences[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Without a consumer the queue takes exactly as many records as it has
+// slots for, then refuses; draining frees all of them again
+void TestCapacity() {
+    LogQueue queue(64);
+    CHECK(queue.GetCapacityBytes() == 64 * LogQueue::SLOT_SIZE);
+
+    // 16-byte head + 112 bytes = two slots each
+    std::vector<unsigned char> body(128 - sizeof(TestHead), 0);
+    TestHead head = {128, 0, 0, static_cast<uint32_t>(body.size())};
+    int pushed = 0;
+    while (queue.TryPush(&head, sizeof(head), body.data(), body.size())) {
+        ++pushed;
+    }
+    CHECK(pushed == 32);
+
+    // A record larger than the whole ring can never go in
+    std::vector<unsigned char> huge(queue.GetCapacityBytes());
+    CHECK(!queue.TryPush(&head, sizeof(head), huge.data(), huge.size()));
+
+    CHECK(queue.Drain([](const unsigned char*, size_t) {}) == 32);
+    CHECK(queue.IsEmpty());
+    CHECK(queue.TryPush(&head, sizeof(head), body.data(), body.size()));
+}
+
+// Producers retry a full queue (LogOverflow::Block): every record arrives
+// once, in order per producer, intact. The consumer holds off until the
+// queue has been full, so the producers do wait at capacity.
+void TestBlockAtCapacity() {
+    constexpr uint32_t RECORDS = 20000;
+    LogQueue queue(256);
+    std::atomic<int> fullHits{0};
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (uint32_t i = 0; i < RECORDS; ++i) {
+                while (!Push(queue, p, i)) {
+                    fullHits.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    while (fullHits.load() == 0) {
+        std::this_thread::yield();
+    }
+    Received received;
+    size_t total = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (total < size_t(PRODUCERS) * RECORDS && std::chrono::steady_clock::now() < deadline) {
+        total += DrainInto(queue, received);
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    CHECK(fullHits.load() > 0);
+    CHECK(total == size_t(PRODUCERS) * RECORDS);
+    CHECK(received.corrupt == 0);
+    for (const std::vector<uint32_t>& sequences : received.sequences) {
+        CHECK(sequences.size() == RECORDS);
+        CHECK(StrictlyIncreasing(sequences));
+    }
+    CHECK(queue.IsEmpty());
+}
+
+// Producers give up on a full queue (LogOverflow::Drop): what arrives plus
+// what was refused is everything, and what arrives is still in order
+void TestDropAtCapacity() {
+    constexpr uint32_t RECORDS = 20000;
+    LogQueue queue(256);
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<int> finished{0};
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (uint32_t i = 0; i < RECORDS; ++i) {
+                if (!Push(queue, p, i)) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            ++finished;
+        });
+    }
+
+    // A slow consumer, so the producers overrun it
+    Received received;
+    size_t total = 0;
+    while (finished.load() < PRODUCERS) {
+        total += DrainInto(queue, received);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    total += DrainInto(queue, received);
+
+    CHECK(dropped.load() > 0);
+    CHECK(total + dropped.load() == size_t(PRODUCERS) * RECORDS);
+    CHECK(received.corrupt == 0);
+    for (const std::vector<uint32_t>& sequences : received.sequences) {
+        CHECK(StrictlyIncreasing(sequences));
+    }
+}
+
+// Per producer, the record numbers of the "p<producer> n<number>" lines
+std::vector<std::vector<int>> ReadLoggedRecords(const std::filesystem::path& path, int& otherLines) {
+    std::vector<std::vector<int>> records(PRODUCERS);
+    otherLines = 0;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        int producer = -1;
+        int number = -1;
+        size_t message = line.find("] [INFO] ");
+        if (message == std::string::npos ||
+            std::sscanf(line.c_str() + message, "] [INFO] p%d n%d", &producer, &number) != 2 ||
+            producer < 0 || producer >= PRODUCERS) {
+            ++otherLines;
+            continue;
+        }
+        records[producer].push_back(number);
+    }
+    return records;
+}
+
+// LOG_INFO from several threads with records big enough to fill the
+// logger's queue. Block loses nothing; Drop loses exactly what it counts.
+void TestLoggerOverflow(LogOverflow policy, const char* name) {
+    constexpr int RECORDS = 3000;
+    const std::string padding(4000, 'x');
+    std::filesystem::path path = TestDir(name) / "log.txt";
+
+    Logger& logger = Logger::Instance();
+    logger.SetLogFile(path.string());
+    LogRateLimit unlimited;
+    unlimited.perSecond = 0;
+    unlimited.coalesceRepeats = false;
+    logger.SetRateLimit(unlimited);
+    logger.SetOverflowPolicy(policy);
+    uint64_t droppedBefore = logger.GetDroppedCount();
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < RECORDS; ++i) {
+                LOG_INFO("p%d n%d %s", p, i, padding);
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    logger.Flush();
+
+    uint64_t dropped = logger.GetDroppedCount() - droppedBefore;
+    int otherLines = 0;
+    std::vector<std::vector<int>> records = ReadLoggedRecords(path, otherLines);
+    size_t written = 0;
+    for (const std::vector<int>& numbers : records) {
+        written += numbers.size();
+        bool ordered = true;
+        for (size_t i = 1; i < numbers.size(); ++i) {
+            ordered = ordered && numbers[i] > numbers[i - 1];
+        }
+        CHECK(ordered);
+    }
+    CHECK(otherLines == 0);
+    CHECK(written + dropped == size_t(PRODUCERS) * RECORDS);
+    if (policy == LogOverflow::Block) {
+        CHECK(dropped == 0);
+    }
+    std::printf("%s: %zu written, %llu dropped\n", name, written, static_cast<unsigned long long>(dropped));
+}
+
+} // namespace
+
+int main() {
+    TestCapacity();
+    TestBlockAtCapacity();
+    TestDropAtCapacity();
+    TestLoggerOverflow(LogOverflow::Block, "logqueue_block");
+    TestLoggerOverflow(LogOverflow::Drop, "logqueue_drop");
+    Logger::Instance().Shutdown();
+    return TestResult();
+}
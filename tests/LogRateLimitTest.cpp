@@ -0,0 +1,209 @@
+#include "Check.h"
+#include "core/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int64_t MS = 1000000;
+constexpr int64_t SWEEP_NANOS = 5000 * MS;   // Logger's SUPPRESSED_REPORT_MS
+
+// The logger's clock while these tests run
+std::atomic<int64_t> g_now{0};
+
+int64_t FakeNow() {
+    return g_now.load();
+}
+
+void Advance(int64_t nanos) {
+    g_now += nanos;
+}
+
+// What a log file holds: the record lines of one call site by number,
+// and the counts its suppression summaries add up to
+struct LogContents {
+    std::vector<int> records;
+    uint64_t repeated = 0;
+    uint64_t rateLimited = 0;
+    int summaries = 0;
+    int other = 0;
+};
+
+LogContents ReadLog(const fs::path& path, const char* recordFormat) {
+    LogContents contents;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t message = line.find("] [INFO] ");
+        if (message == std::string::npos) {
+            ++contents.other;
+            continue;
+        }
+        const char* text = line.c_str() + message + 9;
+        int number = 0;
+        unsigned long long count = 0;
+        if (std::sscanf(text, recordFormat, &number) == 1) {
+            contents.records.push_back(number);
+        } else if (std::sscanf(text, "Last message repeated %llu times", &count) == 1) {
+            contents.repeated += count;
+            ++contents.summaries;
+        } else if (std::sscanf(text, "%llu messages rate limited", &count) == 1) {
+            contents.rateLimited += count;
+            ++contents.summaries;
+        } else {
+            ++contents.other;
+        }
+    }
+    return contents;
+}
+
+fs::path StartLog(const char* name, uint32_t perSecond, uint32_t burst, bool coalesce) {
+    fs::path path = TestDir(name) / "log.txt";
+    Logger& logger = Logger::Instance();
+    logger.SetLogFile(path.string());
+    LogRateLimit limit;
+    limit.perSecond = perSecond;
+    limit.burst = burst;
+    limit.coalesceRepeats = coalesce;
+    logger.SetRateLimit(limit);
+    return path;
+}
+
+// Lets the writer's sweep summarize what quiet call sites still hold back
+// and waits until it's in the file
+void FinishLog() {
+    Advance(SWEEP_NANOS + 1000 * MS);
+    Logger::Instance().Flush();
+}
+
+// Each function is one call site, with its own bucket and repeat run
+void LogBucket(int value) {
+    LOG_INFO("bucket %d", value);
+}
+
+void LogRepeat(int value) {
+    LOG_INFO("repeat %d", value);
+}
+
+void LogOtherSite(int value) {
+    LOG_INFO("other site %d", value);
+}
+
+void LogBoth(int value) {
+    LOG_INFO("both %d", value);
+}
+
+// 10 records a second, bursts of 5: a burst gets 5 through, the bucket
+// refills with time up to the burst size, and the rest is counted
+void TestBurstAndRefill() {
+    fs::path path = StartLog("lograte_bucket", 10, 5, false);
+    LogSuppressionStats before = Logger::Instance().GetSuppressionStats();
+
+    int next = 0;
+    for (int i = 0; i < 20; ++i) {
+        LogBucket(next++);        // 0-4 written
+    }
+    Advance(300 * MS);            // 3 tokens
+    for (int i = 0; i < 5; ++i) {
+        LogBucket(next++);        // 20-22 written
+    }
+    Advance(10000 * MS);          // Full again, capped at 5
+    for (int i = 0; i < 10; ++i) {
+        LogBucket(next++);        // 25-29 written
+    }
+
+    LogSuppressionStats after = Logger::Instance().GetSuppressionStats();
+    CHECK(after.rateLimited - before.rateLimited == 15 + 2 + 5);
+    CHECK(after.repeats == before.repeats);
+    FinishLog();
+
+    // Summaries come before the record that ends a limited run or from the
+    // sweep, so only their total is fixed
+    LogContents log = ReadLog(path, "bucket %d");
+    CHECK((log.records == std::vector<int>{0, 1, 2, 3, 4, 20, 21, 22, 25, 26, 27, 28, 29}));
+    CHECK(log.rateLimited == 22);
+    CHECK(log.repeated == 0);
+    CHECK(log.other == 0);
+}
+
+// Identical records from a call site fold into one summary. A different
+// record ends the run, and an identical one long after the last is
+// written again rather than counted as a repeat.
+void TestRepeats() {
+    fs::path path = StartLog("lograte_repeats", 0, 1, true);
+    LogSuppressionStats before = Logger::Instance().GetSuppressionStats();
+
+    for (int i = 0; i < 10; ++i) {
+        LogRepeat(7);             // Written once, 9 repeats
+        Advance(16 * MS);
+    }
+    LogRepeat(8);                 // Ends the run
+
+    // Nothing to summarize, so the sweep leaves this run alone
+    Advance(SWEEP_NANOS + 1000 * MS);
+    LogRepeat(8);
+    Advance(10 * MS);
+    LogRepeat(8);                 // Repeat of that one
+
+    // Sites are independent
+    LogOtherSite(8);
+
+    LogSuppressionStats after = Logger::Instance().GetSuppressionStats();
+    CHECK(after.repeats - before.repeats == 9 + 1);
+    CHECK(after.rateLimited == before.rateLimited);
+    FinishLog();
+
+    LogContents log = ReadLog(path, "repeat %d");
+    CHECK((log.records == std::vector<int>{7, 8, 8}));
+    CHECK(log.repeated == 10);
+    CHECK(log.summaries == 2);
+    CHECK(log.rateLimited == 0);
+    CHECK(log.other == 1);
+}
+
+// Both at once: repeats don't spend tokens, and the API totals match
+// what the log reports
+void TestCountersAdd() {
+    fs::path path = StartLog("lograte_both", 10, 2, true);
+    Logger& logger = Logger::Instance();
+    LogSuppressionStats before = logger.GetSuppressionStats();
+    uint64_t suppressedBefore = logger.GetSuppressedCount();
+
+    for (int i = 0; i < 50; ++i) {
+        LogBoth(1);               // 1 written, 49 repeats
+    }
+    for (int i = 2; i < 6; ++i) {
+        LogBoth(i);               // 2 written, 3-5 rate limited
+    }
+
+    LogSuppressionStats after = logger.GetSuppressionStats();
+    CHECK(after.repeats - before.repeats == 49);
+    CHECK(after.rateLimited - before.rateLimited == 3);
+    CHECK(logger.GetSuppressedCount() - suppressedBefore == 52);
+    FinishLog();
+
+    LogContents log = ReadLog(path, "both %d");
+    CHECK((log.records == std::vector<int>{1, 2}));
+    CHECK(log.repeated == 49);
+    CHECK(log.rateLimited == 3);
+}
+
+} // namespace
+
+int main() {
+    g_now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    Logger::Instance().SetClock(FakeNow);
+    TestBurstAndRefill();
+    TestRepeats();
+    TestCountersAdd();
+    Logger::Instance().SetClock(nullptr);
+    Logger::Instance().Shutdown();
+    return TestResult();
+}
@@ -0,0 +1,225 @@
+#include "Check.h"
+#include "core/LogSegments.h"
+#include "core/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t SEGMENT_SIZE = 64 * 1024;   // LogSegmentStore's minimum
+
+struct SegmentFile {
+    logfmt::SegmentHeader header = {};
+    std::string committed;   // The first commitOffset content bytes
+    std::string tail;        // Everything after them
+};
+
+std::vector<unsigned char> ReadBytes(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+bool ReadSegment(const fs::path& path, SegmentFile& out) {
+    std::vector<unsigned char> bytes = ReadBytes(path);
+    if (bytes.size() < sizeof(out.header)) {
+        return false;
+    }
+    std::memcpy(&out.header, bytes.data(), sizeof(out.header));
+    size_t content = bytes.size() - logfmt::SEGMENT_HEADER_SIZE;
+    if (out.header.commitOffset > content) {
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(bytes.data()) + logfmt::SEGMENT_HEADER_SIZE;
+    out.committed.assign(data, static_cast<size_t>(out.header.commitOffset));
+    out.tail.assign(data + out.header.commitOffset, content - static_cast<size_t>(out.header.commitOffset));
+    return true;
+}
+
+// Sequences of the segment files in dir, ascending
+std::vector<uint64_t> ListSegments(const fs::path& dir, const std::string& prefix) {
+    std::vector<uint64_t> sequences;
+    for (const fs::directory_entry& entry : fs::directory_iterator(dir)) {
+        std::string name = entry.path().filename().string();
+        unsigned long long sequence = 0;
+        if (name.compare(0, prefix.size() + 1, prefix + ".") == 0 &&
+            std::sscanf(name.c_str() + prefix.size(), ".%llu.lseg", &sequence) == 1) {
+            sequences.push_back(sequence);
+        }
+    }
+    std::sort(sequences.begin(), sequences.end());
+    return sequences;
+}
+
+fs::path SegmentPath(const fs::path& dir, const std::string& prefix, uint64_t sequence) {
+    char name[32];
+    std::snprintf(name, sizeof(name), ".%06llu.lseg", static_cast<unsigned long long>(sequence));
+    return dir / (prefix + name);
+}
+
+LogSegmentConfig MakeConfig(const fs::path& dir, uint32_t maxSegments) {
+    LogSegmentConfig config;
+    config.directory = dir.string();
+    config.prefix = "test";
+    config.segmentSize = SEGMENT_SIZE;
+    config.maxSegments = maxSegments;
+    return config;
+}
+
+bool AppendText(LogSegmentStore& store, const std::string& text) {
+    return store.Append(text.data(), text.size());
+}
+
+// A crash mid-record leaves bytes past commitOffset. Reopening keeps the
+// committed records, zeroes the rest and appends right after them.
+void TestRecoverPartialRecord() {
+    fs::path dir = TestDir("logsegments_recover");
+    LogSegmentConfig config = MakeConfig(dir, 4);
+    {
+        LogSegmentStore store;
+        CHECK(store.Open(config, logfmt::SEGMENT_CONTENT_TEXT));
+        CHECK(store.IsEmpty());
+        CHECK(AppendText(store, "first\n"));
+        CHECK(AppendText(store, "second\n"));
+        CHECK(!store.IsEmpty());
+        CHECK(store.GetFreeBytes() == store.GetCapacity() - 13);
+    }
+
+    // What the writer had copied in without committing when it died
+    fs::path path = SegmentPath(dir, "test", 1);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(logfmt::SEGMENT_HEADER_SIZE + 13);
+        file << "third, cut sho";
+    }
+    SegmentFile before;
+    CHECK(ReadSegment(path, before));
+    CHECK(before.committed == "first\nsecond\n");
+    CHECK(before.tail.compare(0, 14, "third, cut sho") == 0);
+
+    LogSegmentStore store;
+    CHECK(store.Open(config, logfmt::SEGMENT_CONTENT_TEXT));
+    CHECK(!store.IsEmpty());
+    CHECK(AppendText(store, "after restart\n"));
+    store.Close();
+
+    SegmentFile after;
+    CHECK(ReadSegment(path, after));
+    CHECK(after.header.sequence == 1);
+    CHECK(after.committed == "first\nsecond\nafter restart\n");
+    CHECK(after.tail.find_first_not_of('\0') == std::string::npos);
+    CHECK((ListSegments(dir, "test") == std::vector<uint64_t>{1}));
+}
+
+// A segment fills up, the next takes over, and only the newest
+// maxSegments stay on disk
+void TestRotateAndEvict() {
+    fs::path dir = TestDir("logsegments_rotate");
+    LogSegmentStore store;
+    CHECK(store.Open(MakeConfig(dir, 3), logfmt::SEGMENT_CONTENT_TEXT));
+
+    const std::string record(1000, 'r');
+    size_t fitted = 0;
+    while (AppendText(store, record)) {
+        ++fitted;
+    }
+    CHECK(fitted == store.GetCapacity() / record.size());
+    CHECK(store.GetFreeBytes() < record.size());
+
+    for (int i = 0; i < 5; ++i) {
+        CHECK(store.Rotate());
+        CHECK(store.IsEmpty());
+        CHECK(AppendText(store, "segment " + std::to_string(i + 2) + "\n"));
+    }
+    store.Close();
+
+    CHECK((ListSegments(dir, "test") == std::vector<uint64_t>{4, 5, 6}));
+    SegmentFile newest;
+    CHECK(ReadSegment(SegmentPath(dir, "test", 6), newest));
+    CHECK(newest.header.sequence == 6);
+    CHECK(newest.committed == "segment 6\n");
+
+    // A record larger than a whole segment never fits
+    std::string huge(static_cast<size_t>(SEGMENT_SIZE), 'h');
+    CHECK(store.Open(MakeConfig(dir, 3), logfmt::SEGMENT_CONTENT_TEXT));
+    CHECK(!AppendText(store, huge));
+}
+
+// Reopening with a smaller maxSegments evicts at once, not at the next
+// rotation; a segment of the other content format isn't continued
+void TestOpenEvictsAndChecksFormat() {
+    fs::path dir = TestDir("logsegments_open");
+    {
+        LogSegmentStore store;
+        CHECK(store.Open(MakeConfig(dir, 8), logfmt::SEGMENT_CONTENT_TEXT));
+        for (int i = 0; i < 4; ++i) {
+            CHECK(store.Rotate());
+        }
+        CHECK(AppendText(store, "newest\n"));
+    }
+    CHECK((ListSegments(dir, "test") == std::vector<uint64_t>{1, 2, 3, 4, 5}));
+
+    {
+        LogSegmentStore store;
+        CHECK(store.Open(MakeConfig(dir, 2), logfmt::SEGMENT_CONTENT_TEXT));
+        CHECK(!store.IsEmpty());
+    }
+    CHECK((ListSegments(dir, "test") == std::vector<uint64_t>{4, 5}));
+
+    {
+        LogSegmentStore store;
+        CHECK(store.Open(MakeConfig(dir, 2), logfmt::SEGMENT_CONTENT_BINARY));
+        CHECK(store.IsEmpty());
+    }
+    CHECK((ListSegments(dir, "test") == std::vector<uint64_t>{5, 6}));
+    SegmentFile binary;
+    CHECK(ReadSegment(SegmentPath(dir, "test", 6), binary));
+    CHECK(binary.header.contentFormat == logfmt::SEGMENT_CONTENT_BINARY);
+
+    // A newest segment with a damaged header is left alone and a new one
+    // started after it
+    {
+        std::fstream file(SegmentPath(dir, "test", 6), std::ios::in | std::ios::out | std::ios::binary);
+        file << "JUNK";
+    }
+    {
+        LogSegmentStore store;
+        CHECK(store.Open(MakeConfig(dir, 2), logfmt::SEGMENT_CONTENT_BINARY));
+        CHECK(store.IsEmpty());
+    }
+    CHECK((ListSegments(dir, "test") == std::vector<uint64_t>{6, 7}));
+}
+
+// Logger's segment sink: each record is committed as the writer takes it
+void TestLoggerSegments() {
+    fs::path dir = TestDir("logsegments_logger");
+    Logger& logger = Logger::Instance();
+    CHECK(logger.SetLogSegments(MakeConfig(dir, 2)));
+    for (int i = 0; i < 3; ++i) {
+        LOG_INFO("segment record %d", i);
+    }
+    logger.Flush();
+
+    SegmentFile segment;
+    CHECK(ReadSegment(SegmentPath(dir, "test", 1), segment));
+    for (int i = 0; i < 3; ++i) {
+        CHECK(segment.committed.find("] [INFO] segment record " + std::to_string(i) + "\n") != std::string::npos);
+    }
+    CHECK(segment.tail.find_first_not_of('\0') == std::string::npos);
+    logger.Shutdown();
+}
+
+} // namespace
+
+int main() {
+    TestRecoverPartialRecord();
+    TestRotateAndEvict();
+    TestOpenEvictsAndChecksFormat();
+    TestLoggerSegments();
+    return TestResult();
+}
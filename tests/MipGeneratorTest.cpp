@@ -0,0 +1,143 @@
+#include "Check.h"
+#include "graphics/MipGenerator.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+const char* KERNEL_NAMES[] = {"Scalar", "SSE2", "AVX2"};
+
+// One RGBA8 level of noise. Alpha mixes fully transparent, fully opaque
+// and everything between, so the alpha weighting takes every path.
+DecodedImage MakeImage(int width, int height, unsigned seed) {
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(size_t(width) * height * 4);
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < image.pixels.size(); i += 4) {
+        uint32_t bits = random();
+        image.pixels[i] = uint8_t(bits);
+        image.pixels[i + 1] = uint8_t(bits >> 8);
+        image.pixels[i + 2] = uint8_t(bits >> 16);
+        uint8_t alpha = uint8_t(bits >> 24);
+        image.pixels[i + 3] = alpha < 64 ? 0 : alpha > 192 ? 255 : alpha;
+    }
+    image.levels.push_back({width, height, uint32_t(width) * 4, 0, image.pixels.size()});
+    return image;
+}
+
+// The chain D3D expects: halving rounding down to 1x1, levels packed
+// back to back, level 0 untouched
+void CheckChain(const DecodedImage& source, const DecodedImage& chain) {
+    CHECK(std::equal(source.pixels.begin(), source.pixels.end(), chain.pixels.begin()));
+    int width = source.width;
+    int height = source.height;
+    size_t offset = 0;
+    for (const ImageLevel& level : chain.levels) {
+        CHECK(level.width == width && level.height == height);
+        CHECK(level.rowPitch == uint32_t(width) * 4);
+        CHECK(level.offset == offset && level.size == size_t(width) * height * 4);
+        offset += level.size;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    CHECK(chain.levels.back().width == 1 && chain.levels.back().height == 1);
+    CHECK(offset == chain.pixels.size());
+}
+
+// Every kernel writes the scalar reference's bytes, for even, odd, 1xN,
+// Nx1 and 1x1 sizes, with straight and premultiplied alpha
+void TestKernelsMatchScalar() {
+    const int sizes[][2] = {
+        {1, 1}, {2, 2}, {1, 7}, {7, 1}, {13, 5}, {16, 16},
+        {37, 64}, {64, 37}, {130, 66}, {256, 256}, {640, 360}, {1023, 17},
+    };
+    if (GetBestMipKernel() != MipKernel::Avx2) {
+        std::printf("no AVX2 on this CPU; its kernel falls back to SSE2\n");
+    }
+
+    for (const auto& size : sizes) {
+        for (bool premultiplied : {false, true}) {
+            DecodedImage source = MakeImage(size[0], size[1], unsigned(size[0] * 1000 + size[1]));
+            DecodedImage reference = source;
+            GenerateMips(reference, premultiplied, MipKernel::Scalar);
+            CheckChain(source, reference);
+
+            for (MipKernel kernel : {MipKernel::Sse2, MipKernel::Avx2}) {
+                DecodedImage image = source;
+                GenerateMips(image, premultiplied, kernel);
+                bool same = image.pixels == reference.pixels;
+                CHECK(same);
+                if (!same) {
+                    std::printf("  %s differs at %dx%d, %s alpha\n", KERNEL_NAMES[int(kernel)], size[0], size[1],
+                                premultiplied ? "premultiplied" : "straight");
+                }
+            }
+        }
+    }
+}
+
+DecodedImage MakeLevel(int width, int height, std::vector<uint8_t> pixels) {
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels = std::move(pixels);
+    image.levels.push_back({width, height, uint32_t(width) * 4, 0, image.pixels.size()});
+    return image;
+}
+
+bool PixelIs(const uint8_t* p, int r, int g, int b, int a) {
+    return p[0] == r && p[1] == g && p[2] == b && p[3] == a;
+}
+
+// What the filter is for: averaging in linear light, and transparent
+// pixels not bleeding their color into the edges
+void TestFiltering() {
+    // Black and white average to linear half grey, 188 in sRGB, not 128
+    DecodedImage checker = MakeLevel(2, 2, {0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255});
+    GenerateMips(checker, false);
+    CHECK(PixelIs(checker.GetLevelData(1), 188, 188, 188, 255));
+
+    // Opaque red next to transparent green stays red, half covered
+    DecodedImage edge = MakeLevel(2, 1, {255, 0, 0, 255, 0, 255, 0, 0});
+    GenerateMips(edge, false);
+    CHECK(PixelIs(edge.GetLevelData(1), 255, 0, 0, 128));
+
+    // The same in premultiplied form keeps that convention
+    DecodedImage premultiplied = MakeLevel(2, 1, {255, 0, 0, 255, 0, 0, 0, 0});
+    GenerateMips(premultiplied, true);
+    CHECK(PixelIs(premultiplied.GetLevelData(1), 128, 0, 0, 128));
+
+    // Uniform images stay uniform down the whole chain, odd sizes included
+    std::vector<uint8_t> flat(size_t(5) * 3 * 4);
+    for (size_t i = 0; i < flat.size(); i += 4) {
+        flat[i] = 10;
+        flat[i + 1] = 120;
+        flat[i + 2] = 240;
+        flat[i + 3] = 200;
+    }
+    DecodedImage uniform = MakeLevel(5, 3, flat);
+    GenerateMips(uniform, false);
+    bool allSame = true;
+    for (size_t i = 0; i < uniform.pixels.size(); i += 4) {
+        allSame = allSame && PixelIs(&uniform.pixels[i], 10, 120, 240, 200);
+    }
+    CHECK(allSame);
+
+    // Only a single RGBA8 level is expanded
+    DecodedImage done = MakeImage(8, 8, 1);
+    GenerateMips(done, false);
+    size_t levels = done.levels.size();
+    GenerateMips(done, false);
+    CHECK(done.levels.size() == levels);
+}
+
+} // namespace
+
+int main() {
+    TestKernelsMatchScalar();
+    TestFiltering();
+    return TestResult();
+}
@@ -0,0 +1,132 @@
+#include "Check.h"
+#include "graphics/SdfFont.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// SdfText's settings
+constexpr float BASE_SIZE = 32.0f;
+constexpr int SPREAD = 4;
+
+constexpr float PI = 3.14159265f;
+constexpr float DISC_RADIUS = 12.0f;   // At BASE_SIZE
+
+// Every glyph is a disc, as a distance field the way stb_truetype writes
+// one: SDF_ON_EDGE on the outline, rising SDF_ON_EDGE / SPREAD per pixel
+// inside. Top-left at the pen, on the line's top (ascent 0).
+class DiscRasterizer : public GlyphRasterizer {
+public:
+    bool Rasterize(uint32_t, GlyphBitmap& out) override {
+        int size = static_cast<int>(2 * (DISC_RADIUS + SPREAD));
+        out.width = size;
+        out.height = size;
+        out.offsetX = 0;
+        out.offsetY = 0;
+        out.advanceX = static_cast<float>(size);
+        out.alpha.resize(size_t(size) * size);
+
+        float center = size * 0.5f;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                float inside = DISC_RADIUS - std::hypot(x + 0.5f - center, y + 0.5f - center);
+                float value = SDF_ON_EDGE + inside * SDF_ON_EDGE / SPREAD;
+                out.alpha[size_t(y) * size + x] = static_cast<uint8_t>(std::clamp(value, 0.0f, 255.0f) + 0.5f);
+            }
+        }
+        return true;
+    }
+};
+
+SdfFont MakeFont() {
+    GlyphCacheConfig config;
+    config.pageSize = 256;
+    config.maxPages = 1;
+    return SdfFont(std::make_unique<DiscRasterizer>(), BASE_SIZE, 0.0f, config);
+}
+
+// The coverage the shader computes is 0.5 on the outline, saturates
+// inside and fades to 0 outside
+void TestCoverage() {
+    const float edge = SDF_ON_EDGE / 255.0f;
+    const float width = 0.05f;
+    CHECK(std::fabs(SdfFont::Coverage(edge, width) - 0.5f) < 1e-4f);
+    CHECK(SdfFont::Coverage(edge + width, width) == 1.0f);
+    CHECK(SdfFont::Coverage(edge - width, width) == 0.0f);
+    CHECK(SdfFont::Coverage(edge + 0.01f, width) > SdfFont::Coverage(edge - 0.01f, width));
+    // A flat field still gives a hard, defined edge
+    CHECK(SdfFont::Coverage(edge + 0.01f, 0.0f) == 1.0f);
+}
+
+// The rendered disc covers pi r^2 at every size, with a solid middle and
+// nothing outside the glyph's box
+void TestAnalyticDisc() {
+    const float sizes[] = {16.0f, 32.0f, 96.0f};
+    for (float size : sizes) {
+        SdfFont font = MakeFont();
+        const int imageSize = 128;
+        std::vector<uint8_t> image(size_t(imageSize) * imageSize, 0);
+        const float origin = 8.0f;
+        font.RenderReference("o", size, origin, origin, image.data(), imageSize, imageSize);
+
+        float scale = size / BASE_SIZE;
+        float radius = DISC_RADIUS * scale;
+        float center = origin + (DISC_RADIUS + SPREAD) * scale;
+
+        double area = 0.0;
+        for (uint8_t alpha : image) {
+            area += alpha / 255.0;
+        }
+        double expected = PI * radius * radius;
+        double error = std::fabs(area - expected) / expected;
+        std::printf("disc at %.0f px: area %.1f, expected %.1f (%.2f%%)\n", size, area, expected, error * 100.0);
+        CHECK(error < 0.01);
+
+        int middle = static_cast<int>(center);
+        CHECK(image[size_t(middle) * imageSize + middle] == 255);
+        int outside = static_cast<int>(center + radius + 2.0f);
+        if (outside < imageSize) {
+            CHECK(image[size_t(middle) * imageSize + outside] == 0);
+        }
+        CHECK(image[0] == 0);
+    }
+}
+
+// Text is laid out glyph after glyph, and RenderReference composites over
+// what is already in the image
+void TestLayoutAndCompositing() {
+    SdfFont font = MakeFont();
+    std::vector<SdfQuad> quads;
+    float width = font.Layout("oo", nullptr, 64.0f, 10.0f, 20.0f, quads);
+    float advance = 2 * (DISC_RADIUS + SPREAD) * 2.0f;
+    CHECK(quads.size() == 2);
+    CHECK(std::fabs(width - 2 * advance) < 1e-3f);
+    CHECK(std::fabs(font.Measure("oo", nullptr, 64.0f) - width) < 1e-3f);
+    if (quads.size() == 2) {
+        CHECK(quads[0].x0 == 10.0f && quads[0].y0 == 20.0f);
+        CHECK(std::fabs(quads[1].x0 - quads[0].x0 - advance) < 1e-3f);
+        CHECK(quads[0].u0 == quads[1].u0 && quads[0].v1 == quads[1].v1);   // One cached glyph
+    }
+    CHECK(font.GetStats().rasterized == 1);
+
+    const int imageSize = 64;
+    std::vector<uint8_t> once(size_t(imageSize) * imageSize, 0);
+    font.RenderReference("o", 32.0f, 8.0f, 8.0f, once.data(), imageSize, imageSize);
+    std::vector<uint8_t> twice = once;
+    font.RenderReference("o", 32.0f, 8.0f, 8.0f, twice.data(), imageSize, imageSize);
+    bool neverDarker = true;
+    for (size_t i = 0; i < once.size(); ++i) {
+        neverDarker = neverDarker && twice[i] >= once[i];
+    }
+    CHECK(neverDarker);
+}
+
+} // namespace
+
+int main() {
+    TestCoverage();
+    TestAnalyticDisc();
+    TestLayoutAndCompositing();
+    return TestResult();
+}
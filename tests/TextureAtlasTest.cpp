@@ -0,0 +1,340 @@
+#include "Check.h"
+#include "graphics/TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    uint32_t rowPitch = 0;
+    std::vector<uint8_t> pixels;
+
+    const uint8_t* At(int x, int y) const { return &pixels[size_t(y) * rowPitch + size_t(x) * 4]; }
+};
+
+// Every pixel different: seed, x, y. Rows padded when rowPadding != 0.
+Image MakeImage(int width, int height, uint8_t seed, uint32_t rowPadding = 0) {
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.rowPitch = uint32_t(width) * 4 + rowPadding;
+    image.pixels.assign(size_t(image.rowPitch) * height, 0xCD);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* pixel = &image.pixels[size_t(y) * image.rowPitch + size_t(x) * 4];
+            pixel[0] = seed;
+            pixel[1] = uint8_t(x);
+            pixel[2] = uint8_t(y);
+            pixel[3] = 255;
+        }
+    }
+    return image;
+}
+
+bool Overlaps(const AtlasRect& a, const AtlasRect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+bool InBounds(const AtlasRect& rect, int width, int height) {
+    return rect.x >= 0 && rect.y >= 0 && rect.x + rect.width <= width && rect.y + rect.height <= height;
+}
+
+// An entry's rectangle with its padding, as allocated
+AtlasRect Padded(const AtlasEntry& entry, int padding) {
+    return AtlasRect{entry.x - padding, entry.y - padding, entry.width + padding * 2, entry.height + padding * 2};
+}
+
+// Whether the page holds the image at its entry, with the edges repeated
+// out through the padding
+bool PageHolds(const TextureAtlas& atlas, const AtlasEntry& entry, const Image& image, int padding) {
+    if (entry.width != image.width || entry.height != image.height) {
+        return false;
+    }
+    const uint8_t* page = atlas.GetPagePixels(entry.page);
+    const size_t pagePitch = size_t(atlas.GetPageSize()) * 4;
+    for (int y = -padding; y < image.height + padding; ++y) {
+        for (int x = -padding; x < image.width + padding; ++x) {
+            const uint8_t* expected = image.At(std::clamp(x, 0, image.width - 1), std::clamp(y, 0, image.height - 1));
+            const uint8_t* actual = &page[(entry.y + y) * pagePitch + size_t(entry.x + x) * 4];
+            if (std::memcmp(expected, actual, 4) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// What TextureManager::SetAtlasUVs gives an atlas texture
+struct Uvs {
+    float u0, v0, u1, v1;
+};
+
+Uvs GetUvs(const TextureAtlas& atlas, const AtlasEntry& entry) {
+    const float scale = 1.0f / atlas.GetPageSize();
+    return Uvs{entry.x * scale, entry.y * scale, (entry.x + entry.width) * scale, (entry.y + entry.height) * scale};
+}
+
+// Placed rectangles stay inside the bin and apart, and the used area adds up
+void TestPackerPlacement() {
+    AtlasPacker packer(512, 512);
+    std::mt19937 random(7);
+    std::vector<AtlasRect> placed;
+    uint64_t area = 0;
+    int failures = 0;
+    while (failures < 20) {
+        int width = 4 + int(random() % 60);
+        int height = 4 + int(random() % 60);
+        AtlasRect rect;
+        if (!packer.Insert(width, height, rect)) {
+            ++failures;
+            continue;
+        }
+        CHECK(rect.width == width && rect.height == height);
+        placed.push_back(rect);
+        area += uint64_t(width) * height;
+    }
+
+    int outside = 0;
+    int overlapping = 0;
+    for (size_t i = 0; i < placed.size(); ++i) {
+        outside += !InBounds(placed[i], 512, 512);
+        for (size_t j = i + 1; j < placed.size(); ++j) {
+            overlapping += Overlaps(placed[i], placed[j]);
+        }
+    }
+    CHECK(outside == 0);
+    CHECK(overlapping == 0);
+    CHECK(packer.GetUsedArea() == area);
+    CHECK(packer.GetFreeArea() == 512 * 512 - area);
+    // MaxRects should fill most of the bin before mixed sizes stop fitting
+    CHECK(area > 512 * 512 * 3 / 4);
+
+    CHECK(!packer.Insert(513, 1, placed[0]));
+    packer.Reset();
+    CHECK(packer.GetUsedArea() == 0);
+}
+
+// Removed space is reused, and split free space isn't merged back
+void TestPackerReuse() {
+    AtlasPacker packer(256, 256);
+    std::vector<AtlasRect> grid;
+    AtlasRect rect;
+    while (packer.Insert(32, 32, rect)) {
+        grid.push_back(rect);
+    }
+    CHECK(grid.size() == 64);
+    CHECK(packer.GetFreeArea() == 0);
+
+    packer.Remove(grid[27]);
+    CHECK(packer.GetFreeArea() == 32 * 32);
+    CHECK(!packer.Insert(33, 32, rect));
+    CHECK(packer.Insert(32, 32, rect));
+    CHECK(rect.x == grid[27].x && rect.y == grid[27].y);
+    packer.Remove(rect);
+
+    // Smaller rectangles fill the hole without spilling out of it
+    AtlasRect quarters[4];
+    for (AtlasRect& quarter : quarters) {
+        CHECK(packer.Insert(16, 16, quarter));
+        CHECK(quarter.x >= grid[27].x && quarter.x + 16 <= grid[27].x + 32);
+        CHECK(quarter.y >= grid[27].y && quarter.y + 16 <= grid[27].y + 32);
+    }
+    CHECK(!packer.Insert(1, 1, rect));
+
+    // Every other cell free: half the bin, but nothing wider than a cell fits
+    for (AtlasRect& quarter : quarters) {
+        packer.Remove(quarter);
+    }
+    for (size_t i = 0; i < grid.size(); ++i) {
+        int column = grid[i].x / 32;
+        int row = grid[i].y / 32;
+        if ((column + row) % 2 == 0 && i != 27) {
+            packer.Remove(grid[i]);
+        }
+    }
+    CHECK(packer.GetFreeArea() >= 256 * 256 / 2);
+    CHECK(!packer.Insert(64, 64, rect));
+}
+
+// Images land inside their page and apart, with their pixels and an
+// extruded border, from any row pitch
+void TestAtlasInsert() {
+    TextureAtlasConfig config;
+    config.pageSize = 256;
+    config.maxPages = 2;
+    config.maxImageSize = 64;
+    config.padding = 2;
+    TextureAtlas atlas(config);
+
+    CHECK(!atlas.Accepts(65, 8));
+    CHECK(!atlas.Accepts(0, 8));
+    CHECK(atlas.Accepts(64, 64));
+    Image tooBig = MakeImage(65, 8, 0);
+    CHECK(!atlas.Insert("big", tooBig.pixels.data(), 65, 8, tooBig.rowPitch));
+
+    std::unordered_map<std::string, Image> images;
+    std::mt19937 random(3);
+    for (int i = 0; i < 40; ++i) {
+        std::string name = "image" + std::to_string(i);
+        images[name] = MakeImage(1 + int(random() % 64), 1 + int(random() % 64), uint8_t(i), i % 3 ? 0 : 12);
+        const Image& image = images[name];
+        const AtlasEntry* entry = atlas.Insert(name, image.pixels.data(), image.width, image.height, image.rowPitch);
+        CHECK(entry && entry->width == image.width && entry->height == image.height);
+    }
+    CHECK(atlas.GetStats().inserted == 40);
+    CHECK(atlas.GetPageCount() == 2);
+
+    int wrong = 0;
+    int outside = 0;
+    int overlapping = 0;
+    for (const auto& [name, image] : images) {
+        const AtlasEntry* entry = atlas.Find(name);
+        wrong += !entry || !PageHolds(atlas, *entry, image, config.padding);
+        outside += entry && !InBounds(Padded(*entry, config.padding), config.pageSize, config.pageSize);
+        for (const auto& [other, otherImage] : images) {
+            const AtlasEntry* otherEntry = atlas.Find(other);
+            overlapping += name < other && entry && otherEntry && entry->page == otherEntry->page &&
+                           Overlaps(Padded(*entry, config.padding), Padded(*otherEntry, config.padding));
+        }
+    }
+    CHECK(wrong == 0);
+    CHECK(outside == 0);
+    CHECK(overlapping == 0);
+
+    // A dirty rectangle per page, covering what was written
+    std::vector<AtlasDirtyRect> dirty;
+    atlas.TakeDirtyRects(dirty);
+    CHECK(dirty.size() == 2);
+    for (const auto& [name, image] : images) {
+        const AtlasEntry* entry = atlas.Find(name);
+        const AtlasDirtyRect* rect = nullptr;
+        for (const AtlasDirtyRect& candidate : dirty) {
+            rect = candidate.page == entry->page ? &candidate : rect;
+        }
+        CHECK(rect && rect->x0 <= entry->x - 2 && rect->y0 <= entry->y - 2 &&
+              rect->x1 >= entry->x + entry->width + 2 && rect->y1 >= entry->y + entry->height + 2);
+    }
+    atlas.TakeDirtyRects(dirty);
+    CHECK(dirty.empty());
+
+    // Reinserting a name replaces its image
+    Image replacement = MakeImage(10, 10, 200);
+    CHECK(atlas.Insert("image0", replacement.pixels.data(), 10, 10, replacement.rowPitch));
+    CHECK(PageHolds(atlas, *atlas.Find("image0"), replacement, config.padding));
+    CHECK(atlas.GetStats().removed == 1);
+
+    // Removing everything on the last page frees it
+    for (const auto& [name, image] : images) {
+        if (atlas.Find(name)->page == 1) {
+            atlas.Remove(name);
+        }
+    }
+    CHECK(atlas.GetPageCount() == 1);
+}
+
+// A page with enough free area but no hole big enough is repacked
+// largest first; moved images keep their pixels, and the moved list
+// names exactly the images whose UVs changed
+void TestAtlasDefragment() {
+    TextureAtlasConfig config;
+    config.pageSize = 256;
+    config.maxPages = 1;
+    config.maxImageSize = 128;
+    config.padding = 1;
+    TextureAtlas atlas(config);
+
+    // 30x30 plus padding tiles the page 8 x 8
+    std::unordered_map<std::string, Image> images;
+    for (int i = 0; i < 64; ++i) {
+        std::string name = "tile" + std::to_string(i);
+        images[name] = MakeImage(30, 30, uint8_t(i));
+        CHECK(atlas.Insert(name, images[name].pixels.data(), 30, 30, images[name].rowPitch));
+    }
+    Image extra = MakeImage(30, 30, 100);
+    CHECK(!atlas.Insert("extra", extra.pixels.data(), 30, 30, extra.rowPitch));
+    CHECK(atlas.GetStats().rejected == 1);
+
+    // Checkerboard: half the page free in 32 x 32 holes
+    for (int i = 0; i < 64; ++i) {
+        std::string name = "tile" + std::to_string(i);
+        const AtlasEntry* entry = atlas.Find(name);
+        if (((entry->x / 32) + (entry->y / 32)) % 2 == 0) {
+            atlas.Remove(name);
+            images.erase(name);
+        }
+    }
+    CHECK(images.size() == 32);
+
+    std::vector<std::string> moved;
+    atlas.TakeMoved(moved);
+    CHECK(moved.empty());
+    std::unordered_map<std::string, Uvs> before;
+    for (const auto& [name, image] : images) {
+        before[name] = GetUvs(atlas, *atlas.Find(name));
+    }
+
+    // Too big for any hole without repacking
+    Image large = MakeImage(100, 100, 150);
+    const AtlasEntry* placed = atlas.Insert("large", large.pixels.data(), 100, 100, large.rowPitch);
+    CHECK(placed != nullptr);
+    CHECK(atlas.GetStats().defragmentations == 1);
+    images["large"] = large;
+
+    atlas.TakeMoved(moved);
+    CHECK(!moved.empty());
+    std::sort(moved.begin(), moved.end());
+    CHECK(std::adjacent_find(moved.begin(), moved.end()) == moved.end());
+
+    std::vector<std::string> changed;
+    for (const auto& [name, uvs] : before) {
+        Uvs after = GetUvs(atlas, *atlas.Find(name));
+        if (after.u0 != uvs.u0 || after.v0 != uvs.v0) {
+            changed.push_back(name);
+            CHECK(after.u1 - after.u0 == uvs.u1 - uvs.u0 && after.v1 - after.v0 == uvs.v1 - uvs.v0);
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    CHECK(moved == changed);
+
+    // Everything where its entry says, border included, and apart
+    int wrong = 0;
+    int overlapping = 0;
+    for (const auto& [name, image] : images) {
+        const AtlasEntry* entry = atlas.Find(name);
+        wrong += !entry || !PageHolds(atlas, *entry, image, config.padding) ||
+                 !InBounds(Padded(*entry, config.padding), config.pageSize, config.pageSize);
+        for (const auto& [other, otherImage] : images) {
+            overlapping += name < other && Overlaps(Padded(*entry, config.padding),
+                                                    Padded(*atlas.Find(other), config.padding));
+        }
+    }
+    CHECK(wrong == 0);
+    CHECK(overlapping == 0);
+
+    // The repack rewrites the page
+    std::vector<AtlasDirtyRect> dirty;
+    atlas.TakeDirtyRects(dirty);
+    CHECK(dirty.size() == 1 && dirty[0].x0 == 0 && dirty[0].y0 == 0 && dirty[0].x1 == 256 && dirty[0].y1 == 256);
+
+    // No repack makes room that isn't there
+    Image huge = MakeImage(128, 128, 250);
+    CHECK(!atlas.Insert("huge", huge.pixels.data(), 128, 128, huge.rowPitch));
+    CHECK(atlas.GetStats().defragmentations == 1);
+    CHECK(PageHolds(atlas, *atlas.Find("large"), large, config.padding));
+}
+
+} // namespace
+
+int main() {
+    TestPackerPlacement();
+    TestPackerReuse();
+    TestAtlasInsert();
+    TestAtlasDefragment();
+    return TestResult();
+}
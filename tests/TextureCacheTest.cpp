@@ -0,0 +1,267 @@
+#include "Check.h"
+#include "graphics/BlockCompress.h"
+#include "graphics/TextureCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Smooth color ramps with a wave on blue and an alpha ramp: the kind of
+// UI artwork the encoders are tuned for
+std::vector<uint8_t> MakeImage(int width, int height, bool opaque) {
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = &rgba[(size_t(y) * width + x) * 4];
+            p[0] = static_cast<uint8_t>(255.0 * x / std::max(width - 1, 1));
+            p[1] = static_cast<uint8_t>(255.0 * y / std::max(height - 1, 1));
+            p[2] = static_cast<uint8_t>(128 + 100 * std::sin(x * 0.3) * std::cos(y * 0.2));
+            p[3] = opaque ? 255 : static_cast<uint8_t>(255.0 * (x + y) / std::max(width + height - 2, 1));
+        }
+    }
+    return rgba;
+}
+
+// Over channels [first, last) of RGBA8 pixels; 99 for identical images
+double Psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int first, int last) {
+    double squared = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        for (int c = first; c < last; ++c) {
+            double diff = double(a[i + c]) - b[i + c];
+            squared += diff * diff;
+            ++count;
+        }
+    }
+    return squared == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 * count / squared);
+}
+
+struct Codec {
+    PixelFormat format;
+    const char* name;
+    double minColorPsnr;
+    double minAlphaPsnr;    // 0 when the format's alpha isn't checked here
+};
+
+// Round trip through each encoder and the reference decoder, on whole
+// blocks and on a size with partial edge blocks
+void TestBlockCompression() {
+    const Codec codecs[] = {
+        {PixelFormat::BC1, "BC1", 28.0, 0.0},
+        {PixelFormat::BC3, "BC3", 28.0, 40.0},
+        {PixelFormat::BC7, "BC7", 30.0, 32.0},
+    };
+    const int sizes[][2] = {{64, 64}, {37, 23}};
+
+    for (const Codec& codec : codecs) {
+        for (const auto& size : sizes) {
+            int width = size[0];
+            int height = size[1];
+            std::vector<uint8_t> source = MakeImage(width, height, codec.format == PixelFormat::BC1);
+            size_t blockBytes = GetBlockCompressedSize(codec.format, width, height);
+            CHECK(blockBytes == ((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(codec.format));
+
+            std::vector<uint8_t> blocks(blockBytes);
+            std::vector<uint8_t> decoded(source.size());
+            CompressImage(codec.format, source.data(), width, height, blocks.data());
+            DecompressImage(codec.format, blocks.data(), width, height, decoded.data());
+
+            double color = Psnr(source, decoded, 0, 3);
+            double alpha = Psnr(source, decoded, 3, 4);
+            std::printf("%s %dx%d: color %.1f dB, alpha %.1f dB\n", codec.name, width, height, color, alpha);
+            CHECK(color >= codec.minColorPsnr);
+            CHECK(alpha >= codec.minAlphaPsnr);
+        }
+    }
+
+    // BC1 keeps cut-out alpha: below half transparent, the rest opaque
+    std::vector<uint8_t> cutout = MakeImage(16, 16, true);
+    for (size_t i = 0; i < cutout.size(); i += 4) {
+        cutout[i + 3] = (i / 4) % 3 == 0 ? 0 : 255;
+    }
+    std::vector<uint8_t> blocks(GetBlockCompressedSize(PixelFormat::BC1, 16, 16));
+    std::vector<uint8_t> decoded(cutout.size());
+    CompressImage(PixelFormat::BC1, cutout.data(), 16, 16, blocks.data());
+    DecompressImage(PixelFormat::BC1, blocks.data(), 16, 16, decoded.data());
+    CHECK(Psnr(cutout, decoded, 3, 4) == 99.0);
+}
+
+// A BC1 image with its full mip chain, levels packed back to back
+DecodedImage MakeCompressedImage(int size) {
+    DecodedImage image;
+    image.width = size;
+    image.height = size;
+    image.format = PixelFormat::BC1;
+    for (int level = size; level >= 1; level /= 2) {
+        std::vector<uint8_t> rgba = MakeImage(level, level, true);
+        ImageLevel record;
+        record.width = level;
+        record.height = level;
+        record.rowPitch = static_cast<uint32_t>(GetBlockRowPitch(image.format, level));
+        record.offset = image.pixels.size();
+        record.size = GetBlockCompressedSize(image.format, level, level);
+        image.pixels.resize(record.offset + record.size);
+        CompressImage(image.format, rgba.data(), level, level, image.pixels.data() + record.offset);
+        image.levels.push_back(record);
+    }
+    return image;
+}
+
+bool SameImage(const DecodedImage& a, const DecodedImage& b) {
+    if (a.width != b.width || a.height != b.height || a.format != b.format || a.levels.size() != b.levels.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.levels.size(); ++i) {
+        const ImageLevel& x = a.levels[i];
+        const ImageLevel& y = b.levels[i];
+        if (x.width != y.width || x.height != y.height || x.rowPitch != y.rowPitch || x.size != y.size ||
+            std::memcmp(a.GetLevelData(i), b.GetLevelData(i), x.size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestRoundTrip() {
+    fs::path dir = TestDir("texcache_roundtrip");
+    DecodedImage image = MakeCompressedImage(64);
+    image.contentHash = 0xfeedfacecafebeefull;
+    {
+        TextureCache cache(dir.string(), 64 * 1024 * 1024);
+        CHECK(cache.Store(0x1234, image));
+        CHECK(cache.GetStats().stores == 1);
+    }
+
+    // A later launch maps the same levels back
+    TextureCache cache(dir.string(), 64 * 1024 * 1024);
+    DecodedImage loaded;
+    CHECK(cache.Load(0x1234, loaded));
+    CHECK(loaded.mapped != nullptr && loaded.pixels.empty());
+    CHECK(SameImage(image, loaded));
+    CHECK(loaded.contentHash == image.contentHash);
+    for (const ImageLevel& level : loaded.levels) {
+        CHECK(level.offset % 16 == 0);
+    }
+
+    DecodedImage missing;
+    CHECK(!cache.Load(0x5678, missing));
+    CHECK(!cache.Load(0, missing));
+    TextureCacheStats stats = cache.GetStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 2);
+    CHECK(stats.bytes == fs::file_size(dir / "0000000000001234.tex"));
+
+    // Keys follow the source file and the options
+    fs::path source = dir / "source.png";
+    std::ofstream(source, std::ios::binary) << "not really a png";
+    TextureDecodeOptions options;
+    uint64_t key = TextureCache::MakeKey(source.string(), options);
+    CHECK(key != 0);
+    CHECK(TextureCache::MakeKey(source.string(), options) == key);
+    options.format = PixelFormat::BC7;
+    CHECK(TextureCache::MakeKey(source.string(), options) != key);
+    CHECK(TextureCache::MakeKey((dir / "nothing.png").string(), options) == 0);
+}
+
+// Over the byte limit, the least recently stored or loaded file goes,
+// in this run by use and on a new launch by file time
+void TestTrim() {
+    fs::path dir = TestDir("texcache_trim");
+    DecodedImage image = MakeCompressedImage(64);
+    uint64_t fileSize = 0;
+    {
+        TextureCache probe(dir.string(), UINT64_MAX);
+        probe.Store(1, image);
+        fileSize = fs::file_size(dir / "0000000000000001.tex");
+    }
+
+    {
+        TextureCache cache(dir.string(), fileSize * 2 + fileSize / 2);   // Two files fit
+        CHECK(cache.Store(2, image));
+        DecodedImage loaded;
+        CHECK(cache.Load(1, loaded));   // 1 is now newer than 2
+        CHECK(cache.Store(3, image));
+        CHECK(fs::exists(dir / "0000000000000001.tex"));
+        CHECK(!fs::exists(dir / "0000000000000002.tex"));
+        CHECK(fs::exists(dir / "0000000000000003.tex"));
+        CHECK(cache.GetStats().evictions == 1);
+        CHECK(cache.GetStats().bytes == fileSize * 2);
+
+        // The image mapped before its file was trimmed stays readable
+        CHECK(cache.Store(4, image));
+        CHECK(cache.Store(5, image));
+        CHECK(SameImage(image, loaded));
+        loaded = DecodedImage();
+        CHECK(!fs::exists(dir / "0000000000000001.tex"));
+    }
+
+    // A new launch orders what it finds by write time
+    auto now = fs::file_time_type::clock::now();
+    fs::last_write_time(dir / "0000000000000004.tex", now - std::chrono::hours(1));
+    fs::last_write_time(dir / "0000000000000005.tex", now - std::chrono::hours(2));
+    TextureCache cache(dir.string(), fileSize * 2 + fileSize / 2);
+    CHECK(cache.Store(6, image));
+    CHECK(fs::exists(dir / "0000000000000004.tex"));
+    CHECK(!fs::exists(dir / "0000000000000005.tex"));
+    CHECK(fs::exists(dir / "0000000000000006.tex"));
+}
+
+std::vector<char> ReadFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const fs::path& path, const std::vector<char>& bytes, size_t size) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), size);
+}
+
+// Cut anywhere, or with a damaged header, a cache file is a miss, never
+// an image with levels past the end of the mapping
+void TestRejectsDamagedFiles() {
+    fs::path dir = TestDir("texcache_damaged");
+    DecodedImage image = MakeCompressedImage(32);
+    TextureCache cache(dir.string(), 64 * 1024 * 1024);
+    CHECK(cache.Store(7, image));
+    fs::path path = dir / "0000000000000007.tex";
+    const std::vector<char> whole = ReadFile(path);
+
+    int accepted = 0;
+    for (size_t size = 0; size < whole.size(); size += (size < 256 ? 1 : 61)) {
+        WriteFile(path, whole, size);
+        DecodedImage loaded;
+        accepted += cache.Load(7, loaded);
+    }
+    CHECK(accepted == 0);
+
+    WriteFile(path, whole, whole.size());
+    DecodedImage loaded;
+    CHECK(cache.Load(7, loaded));
+    CHECK(SameImage(image, loaded));
+    loaded = DecodedImage();
+
+    // Wrong magic, and a file stored under another key
+    std::vector<char> damaged = whole;
+    damaged[0] = 'X';
+    WriteFile(path, damaged, damaged.size());
+    CHECK(!cache.Load(7, loaded));
+    WriteFile(path, whole, whole.size());
+    fs::copy_file(path, dir / "0000000000000008.tex");
+    CHECK(!cache.Load(8, loaded));
+}
+
+} // namespace
+
+int main() {
+    TestBlockCompression();
+    TestRoundTrip();
+    TestTrim();
+    TestRejectsDamagedFiles();
+    return TestResult();
+}
@@ -0,0 +1,151 @@
+#include "Check.h"
+#include "graphics/TextureIndex.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void WriteFile(const fs::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Hashes survive a save and load, and only while each file keeps the size
+// and write time it had when it was hashed
+void TestSaveLoadAndStaleness() {
+    fs::path dir = TestDir("textureindex");
+    const std::string a = TextureIndex::Canonicalize((dir / "a.png").string());
+    const std::string b = TextureIndex::Canonicalize((dir / "b.png").string());
+    const std::string c = TextureIndex::Canonicalize((dir / "c.png").string());
+    WriteFile(a, "aaaa");
+    WriteFile(b, "bbbbbbbb");
+    WriteFile(c, "cc");
+    const std::string indexPath = (dir / "index" / "textures.idx").string();
+
+    {
+        TextureIndex index(indexPath);
+        CHECK(!index.Load());
+        index.Set(a, 0xA);
+        index.Set(b, 0xB);
+        index.Set(c, 0xC);
+        index.Set((dir / "missing.png").string(), 0xD);   // Nothing to stat, not recorded
+        CHECK(index.GetSize() == 3);
+        uint64_t hash = 0;
+        CHECK(index.Find(a, hash) && hash == 0xA);
+        CHECK(!index.Find((dir / "missing.png").string(), hash));
+        CHECK(index.Save());
+    }
+    CHECK(!fs::exists(indexPath + ".tmp"));
+
+    // c is deleted; a grows; b is rewritten at the same size, an hour later
+    fs::remove(c);
+    WriteFile(a, "aaaaa");
+    fs::file_time_type bTime = fs::last_write_time(b);
+    WriteFile(b, "BBBBBBBB");
+    fs::last_write_time(b, bTime + std::chrono::hours(1));
+
+    TextureIndex index(indexPath);
+    CHECK(index.Load());
+    CHECK(index.GetSize() == 3);
+    uint64_t hash = 0;
+    CHECK(!index.Find(a, hash));
+    CHECK(!index.Find(b, hash));
+    CHECK(!index.Find(c, hash));
+
+    // Untouched since: found
+    WriteFile(c, "cc");
+    index.Set(c, 0xCC);
+    fs::last_write_time(b, bTime);
+    CHECK(index.Find(b, hash) && hash == 0xB);
+
+    // A rehash replaces the entry; the save drops files that are gone
+    index.Set(a, 0xAA);
+    fs::remove(c);
+    CHECK(index.Save());
+    TextureIndex reloaded(indexPath);
+    CHECK(reloaded.Load());
+    CHECK(reloaded.GetSize() == 2);
+    CHECK(reloaded.Find(a, hash) && hash == 0xAA);
+    CHECK(reloaded.Find(b, hash) && hash == 0xB);
+
+    // Nothing changed, nothing written
+    reloaded.Set(a, 0xAA);
+    fs::remove(indexPath);
+    CHECK(reloaded.Save());
+    CHECK(!fs::exists(indexPath));
+}
+
+// A damaged or foreign index loads empty rather than half read
+void TestDamagedIndex() {
+    fs::path dir = TestDir("textureindex_damaged");
+    const std::string a = TextureIndex::Canonicalize((dir / "a.png").string());
+    const std::string b = TextureIndex::Canonicalize((dir / "b.png").string());
+    WriteFile(a, "pixels");
+    WriteFile(b, "more pixels");
+    const std::string indexPath = (dir / "textures.idx").string();
+    {
+        TextureIndex index(indexPath);
+        index.Set(a, 1);
+        index.Set(b, 2);
+        CHECK(index.Save());
+    }
+    const std::string bytes = ReadFile(indexPath);
+
+    for (size_t cut : {size_t(0), size_t(8), size_t(16), size_t(20), bytes.size() - 1}) {
+        WriteFile(indexPath, bytes.substr(0, cut));
+        TextureIndex index(indexPath);
+        CHECK(!index.Load());
+        CHECK(index.GetSize() == 0);
+    }
+
+    std::string foreign = bytes;
+    foreign[0] = 'X';
+    WriteFile(indexPath, foreign);
+    TextureIndex index(indexPath);
+    CHECK(!index.Load());
+    CHECK(index.GetSize() == 0);
+
+    WriteFile(indexPath, bytes);
+    CHECK(index.Load());
+    CHECK(index.GetSize() == 2);
+}
+
+// Spellings of one file share a key, whether it exists yet or not
+void TestCanonicalize() {
+    fs::path dir = TestDir("textureindex_paths");
+    fs::create_directories(dir / "sub");
+    WriteFile(dir / "a.png", "a");
+    fs::path previous = fs::current_path();
+    fs::current_path(dir);
+
+    const std::string key = TextureIndex::Canonicalize("a.png");
+    CHECK(fs::path(key).is_absolute());
+    CHECK(key.find('\\') == std::string::npos);
+    CHECK(TextureIndex::Canonicalize("./a.png") == key);
+    CHECK(TextureIndex::Canonicalize("sub/../a.png") == key);
+    CHECK(TextureIndex::Canonicalize("nothere/../a.png") == key);
+    CHECK(TextureIndex::Canonicalize("sub/./.././a.png") == key);
+    CHECK(TextureIndex::Canonicalize((dir / "a.png").string()) == key);
+    CHECK(TextureIndex::Canonicalize("b.png") != key);
+    CHECK(TextureIndex::Canonicalize("sub/new.png") == TextureIndex::Canonicalize("./sub/x/../new.png"));
+
+    fs::current_path(previous);
+}
+
+} // namespace
+
+int main() {
+    TestSaveLoadAndStaleness();
+    TestDamagedIndex();
+    TestCanonicalize();
+    return TestResult();
+}
@@ -0,0 +1,252 @@
+#include "Check.h"
+#include "graphics/TextureLoader.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int IMAGE_SIZE = 512;
+constexpr size_t IMAGE_BYTES = size_t(IMAGE_SIZE) * IMAGE_SIZE * 4;   // 1 MB
+
+// Decodes only once opened, so a test decides what is still queued.
+// Paths starting with "bad" fail; anything else is a 1 MB RGBA8 image.
+class GatedDecoder {
+public:
+    explicit GatedDecoder(bool open = true) : m_open(open) {}
+
+    bool Decode(const std::string& path, DecodedImage& out) {
+        ++started;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_open; });
+        }
+        if (path.compare(0, 3, "bad") == 0) {
+            ++decoded;
+            return false;
+        }
+        out.width = IMAGE_SIZE;
+        out.height = IMAGE_SIZE;
+        out.pixels.assign(IMAGE_BYTES, 0x7F);
+        out.levels.push_back({IMAGE_SIZE, IMAGE_SIZE, IMAGE_SIZE * 4, 0, IMAGE_BYTES});
+        ++decoded;
+        return true;
+    }
+
+    void Open() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_open = true;
+        }
+        m_cv.notify_all();
+    }
+
+    TextureLoader::DecodeFunction Function() {
+        return [this](const std::string& path, DecodedImage& out) { return Decode(path, out); };
+    }
+
+    std::atomic<int> started{0};
+    std::atomic<int> decoded{0};
+
+private:
+    bool m_open;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+// Records failures, and can refuse uploads
+class RecordingUploader : public NullTextureUploader {
+public:
+    bool Upload(uint32_t id, const DecodedImage& image) override {
+        return !rejectUploads && NullTextureUploader::Upload(id, image);
+    }
+    void OnLoadFailed(uint32_t id) override { failedIds.push_back(id); }
+
+    bool rejectUploads = false;
+    std::vector<uint32_t> failedIds;
+};
+
+bool WaitFor(const std::function<bool()>& done) {
+    for (int i = 0; i < 5000 && !done(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
+
+// Update() frames until nothing is pending; the frame count, or -1 on timeout
+int Drain(TextureLoader& loader, TextureUploader& uploader, const TextureUploadBudget& budget = {}) {
+    int frames = 0;
+    bool done = WaitFor([&] {
+        loader.Update(uploader, budget);
+        ++frames;
+        return loader.GetPendingCount() == 0;
+    });
+    return done ? frames : -1;
+}
+
+// Decoded results only reach the render thread at the next Update(); give
+// the workers a moment to hand over what they finished
+void SettleWorkers() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+void TestRequests() {
+    GatedDecoder decoder;
+    TextureLoader loader(decoder.Function(), 3);
+    CHECK(loader.GetThreadCount() == 3);
+
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 10; ++i) {
+        uint32_t id = loader.Request("image" + std::to_string(i));
+        CHECK(id != 0);
+        CHECK(loader.GetState(id) == TextureState::Loading);
+        ids.push_back(id);
+    }
+    CHECK(loader.GetPendingCount() == 10);
+
+    NullTextureUploader uploader;
+    CHECK(Drain(loader, uploader) > 0);
+    for (uint32_t id : ids) {
+        CHECK(loader.GetState(id) == TextureState::Ready);
+    }
+    CHECK(uploader.uploads == 10);
+    CHECK(uploader.bytes == 10 * IMAGE_BYTES);
+
+    const TextureLoaderStats& stats = loader.GetStats();
+    CHECK(stats.requested == 10);
+    CHECK(stats.uploaded == 10);
+    CHECK(stats.uploadedBytes == 10 * IMAGE_BYTES);
+    CHECK(stats.failed == 0 && stats.canceled == 0);
+
+    CHECK(loader.GetState(12345) == TextureState::Failed);
+    loader.Cancel(12345);   // Unknown ids are ignored
+}
+
+// A queued load is never decoded, a running one is never uploaded, and
+// a Ready one just goes away
+void TestCancel() {
+    GatedDecoder decoder(false);
+    TextureLoader loader(decoder.Function(), 1);
+
+    uint32_t running = loader.Request("running");
+    CHECK(WaitFor([&] { return decoder.started == 1; }));
+    uint32_t queued = loader.Request("queued");
+    uint32_t kept = loader.Request("kept");
+
+    loader.Cancel(queued);
+    loader.Cancel(running);
+    CHECK(loader.GetState(queued) == TextureState::Failed);
+    CHECK(loader.GetState(running) == TextureState::Failed);
+    CHECK(loader.GetPendingCount() == 1);
+
+    decoder.Open();
+    RecordingUploader uploader;
+    CHECK(Drain(loader, uploader) > 0);
+    CHECK(loader.GetState(kept) == TextureState::Ready);
+    CHECK(decoder.decoded == 2);   // "running" and "kept"; "queued" skipped
+    CHECK(uploader.uploads == 1);
+    CHECK(uploader.failedIds.empty());
+    CHECK(loader.GetStats().canceled == 2);
+
+    loader.Cancel(kept);
+    CHECK(loader.GetState(kept) == TextureState::Failed);
+    CHECK(loader.GetStats().canceled == 2);
+    CHECK(loader.GetPendingCount() == 0);
+}
+
+// Uploads stop at the byte budget and carry over to the next frame; the
+// first upload of a frame always goes, however large
+void TestBudget() {
+    GatedDecoder decoder;
+    TextureLoader loader(decoder.Function(), 2);
+    for (int i = 0; i < 6; ++i) {
+        loader.Request("image" + std::to_string(i));
+    }
+    CHECK(WaitFor([&] { return decoder.decoded == 6; }));
+    SettleWorkers();
+
+    NullTextureUploader uploader;
+    TextureUploadBudget budget;
+    budget.bytes = IMAGE_BYTES * 5 / 2;   // Two images fit
+    budget.milliseconds = 10000.0;
+    CHECK(loader.Update(uploader, budget) == 2);
+    CHECK(loader.GetStats().deferredFrames == 1);
+    CHECK(loader.Update(uploader, budget) == 2);
+    CHECK(loader.Update(uploader, budget) == 2);
+    CHECK(loader.GetStats().deferredFrames == 2);   // The last frame emptied the queue
+    CHECK(loader.GetPendingCount() == 0);
+
+    // Over the budget on its own: still one per frame
+    budget.bytes = 1;
+    for (int i = 0; i < 3; ++i) {
+        loader.Request("large" + std::to_string(i));
+    }
+    CHECK(WaitFor([&] { return decoder.decoded == 9; }));
+    SettleWorkers();
+    CHECK(loader.Update(uploader, budget) == 1);
+    CHECK(loader.Update(uploader, budget) == 1);
+    CHECK(loader.Update(uploader, budget) == 1);
+    CHECK(loader.GetPendingCount() == 0);
+
+    // The time budget works the same way
+    budget.bytes = IMAGE_BYTES * 100;
+    budget.milliseconds = 0.0;
+    for (int i = 0; i < 2; ++i) {
+        loader.Request("timed" + std::to_string(i));
+    }
+    CHECK(WaitFor([&] { return decoder.decoded == 11; }));
+    SettleWorkers();
+    CHECK(loader.Update(uploader, budget) == 1);
+    CHECK(loader.Update(uploader, budget) == 1);
+    CHECK(uploader.uploads == 11);
+}
+
+// Decode and upload failures both end Failed and reach OnLoadFailed
+void TestLoadFailures() {
+    GatedDecoder decoder;
+    TextureLoader loader(decoder.Function(), 2);
+    RecordingUploader uploader;
+
+    uint32_t bad = loader.Request("bad.png");
+    uint32_t good = loader.Request("good.png");
+    CHECK(Drain(loader, uploader) > 0);
+    CHECK(loader.GetState(bad) == TextureState::Failed);
+    CHECK(loader.GetState(good) == TextureState::Ready);
+    CHECK((uploader.failedIds == std::vector<uint32_t>{bad}));
+
+    uploader.rejectUploads = true;
+    uint32_t rejected = loader.Request("rejected.png");
+    CHECK(Drain(loader, uploader) > 0);
+    CHECK(loader.GetState(rejected) == TextureState::Failed);
+    CHECK((uploader.failedIds == std::vector<uint32_t>{bad, rejected}));
+    CHECK(loader.GetStats().failed == 2);
+    CHECK(loader.GetStats().uploaded == 1);
+}
+
+// Destroying the loader with work queued and decoding doesn't hang
+void TestShutdownWithPendingWork() {
+    GatedDecoder decoder(false);
+    {
+        TextureLoader loader(decoder.Function(), 2);
+        for (int i = 0; i < 20; ++i) {
+            loader.Request("image" + std::to_string(i));
+        }
+        CHECK(WaitFor([&] { return decoder.started == 2; }));
+        decoder.Open();
+    }
+    CHECK(decoder.decoded < 20);
+}
+
+} // namespace
+
+int main() {
+    TestRequests();
+    TestCancel();
+    TestBudget();
+    TestLoadFailures();
+    TestShutdownWithPendingWork();
+    return TestResult();
+}
@@ -0,0 +1,253 @@
+// GlyphRangeScanner: collects every character the UI can show and writes
+// them as ImGui glyph ranges, so the font atlas bakes a few hundred CJK
+// glyphs instead of GetGlyphRangesChineseFull()'s 20k+.
+//
+// Inputs are language files (.json: every key and string value) and C++
+// sources (.cpp/.h: string literals, including \x and \u escapes). The
+// output is a list of "first, last," pairs for FontManager to include.
+//
+// Usage: GlyphRangeScanner <output.inc> <input.json|.cpp|.h>...
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Always baked: ASCII + Latin-1, general punctuation, CJK punctuation,
+// full-width forms and the replacement character
+const uint32_t BASE_RANGES[][2] = {
+    {0x0020, 0x00FF},
+    {0x2000, 0x206F},
+    {0x3000, 0x303F},
+    {0xFF00, 0xFFEF},
+    {0xFFFD, 0xFFFD},
+};
+
+// ImWchar is 16-bit unless ImGui is built with IMGUI_USE_WCHAR32
+constexpr uint32_t MAX_CODEPOINT = 0xFFFF;
+
+// Private use area: ICON_FA_* glyphs, which come from the icon font
+constexpr uint32_t PRIVATE_USE_FIRST = 0xE000;
+constexpr uint32_t PRIVATE_USE_LAST = 0xF8FF;
+
+void AddUtf8(const std::string& text, std::set<uint32_t>& out) {
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        uint32_t codepoint = 0;
+        size_t length = 1;
+        if (c < 0x80) {
+            codepoint = c;
+        } else if ((c & 0xE0) == 0xC0) {
+            codepoint = c & 0x1F;
+            length = 2;
+        } else if ((c & 0xF0) == 0xE0) {
+            codepoint = c & 0x0F;
+            length = 3;
+        } else if ((c & 0xF8) == 0xF0) {
+            codepoint = c & 0x07;
+            length = 4;
+        } else {
+            ++i;   // Stray continuation byte
+            continue;
+        }
+
+        if (i + length > text.size()) {
+            break;
+        }
+        bool valid = true;
+        for (size_t k = 1; k < length; ++k) {
+            unsigned char next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80) {
+                valid = false;
+                break;
+            }
+            codepoint = (codepoint << 6) | (next & 0x3F);
+        }
+        if (!valid) {
+            ++i;
+            continue;
+        }
+
+        bool privateUse = codepoint >= PRIVATE_USE_FIRST && codepoint <= PRIVATE_USE_LAST;
+        if (codepoint >= 0x20 && codepoint <= MAX_CODEPOINT && !privateUse) {
+            out.insert(codepoint);
+        }
+        i += length;
+    }
+}
+
+void AddJson(const nlohmann::json& value, std::set<uint32_t>& out) {
+    if (value.is_string()) {
+        AddUtf8(value.get_ref<const std::string&>(), out);
+    } else if (value.is_object()) {
+        for (auto& [key, child] : value.items()) {
+            AddUtf8(key, out);
+            AddJson(child, out);
+        }
+    } else if (value.is_array()) {
+        for (const auto& child : value) {
+            AddJson(child, out);
+        }
+    }
+}
+
+void AppendUtf8(uint32_t codepoint, std::string& out) {
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Bytes of every string literal in a C++ source, escapes resolved.
+// Comments and character literals are skipped; raw strings are not
+// special-cased (the UI doesn't use them).
+void AddSourceLiterals(const std::string& source, std::set<uint32_t>& out) {
+    size_t i = 0;
+    while (i < source.size()) {
+        char c = source[i];
+        if (c == '/' && i + 1 < source.size() && source[i + 1] == '/') {
+            i = source.find('\n', i);
+            if (i == std::string::npos) {
+                break;
+            }
+        } else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*') {
+            i = source.find("*/", i + 2);
+            if (i == std::string::npos) {
+                break;
+            }
+            i += 2;
+        } else if (c == '\'') {
+            for (++i; i < source.size() && source[i] != '\''; ++i) {
+                if (source[i] == '\\') {
+                    ++i;
+                }
+            }
+            ++i;
+        } else if (c == '"') {
+            std::string literal;
+            for (++i; i < source.size() && source[i] != '"' && source[i] != '\n'; ++i) {
+                if (source[i] != '\\' || i + 1 >= source.size()) {
+                    literal += source[i];
+                    continue;
+                }
+
+                char escape = source[++i];
+                if (escape == 'x') {
+                    int value = 0;
+                    while (i + 1 < source.size() && HexDigit(source[i + 1]) >= 0) {
+                        value = (value << 4) | HexDigit(source[++i]);
+                    }
+                    literal += static_cast<char>(value);
+                } else if (escape == 'u' || escape == 'U') {
+                    int digits = escape == 'u' ? 4 : 8;
+                    uint32_t value = 0;
+                    for (int d = 0; d < digits && i + 1 < source.size() && HexDigit(source[i + 1]) >= 0; ++d) {
+                        value = (value << 4) | HexDigit(source[++i]);
+                    }
+                    AppendUtf8(value, literal);
+                } else {
+                    literal += ' ';   // \n, \t, \" ...: nothing to draw
+                }
+            }
+            ++i;
+            AddUtf8(literal, out);
+        } else {
+            ++i;
+        }
+    }
+}
+
+bool EndsWith(const std::string& text, const char* suffix) {
+    std::string tail(suffix);
+    return text.size() >= tail.size() && text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <output.inc> <input.json|.cpp|.h>...\n", argv[0]);
+        return 1;
+    }
+
+    std::set<uint32_t> codepoints;
+    for (const auto& range : BASE_RANGES) {
+        for (uint32_t c = range[0]; c <= range[1]; ++c) {
+            codepoints.insert(c);
+        }
+    }
+
+    for (int arg = 2; arg < argc; ++arg) {
+        std::string path = argv[arg];
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+            return 1;
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (EndsWith(path, ".json")) {
+            try {
+                AddJson(nlohmann::json::parse(text), codepoints);
+            }
+            catch (const std::exception& e) {
+                std::fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+                return 1;
+            }
+        } else {
+            AddSourceLiterals(text, codepoints);
+        }
+    }
+
+    // Collapse into inclusive ranges
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (uint32_t c : codepoints) {
+        if (!ranges.empty() && ranges.back().second + 1 == c) {
+            ranges.back().second = c;
+        } else {
+            ranges.emplace_back(c, c);
+        }
+    }
+
+    std::string output = "// Generated by GlyphRangeScanner; do not edit\n";
+    char line[64];
+    std::snprintf(line, sizeof(line), "// %zu glyphs in %zu ranges\n", codepoints.size(), ranges.size());
+    output += line;
+    for (const auto& [first, last] : ranges) {
+        std::snprintf(line, sizeof(line), "0x%04X, 0x%04X,\n", first, last);
+        output += line;
+    }
+
+    std::ofstream out(argv[1], std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !out.write(output.data(), output.size())) {
+        std::fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return 1;
+    }
+    std::printf("%zu glyphs in %zu ranges\n", codepoints.size(), ranges.size());
+    return 0;
+}
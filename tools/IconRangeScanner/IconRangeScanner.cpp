@@ -0,0 +1,195 @@
+// IconRangeScanner: finds the ICON_FA_* macros the sources use and writes
+// their codepoints as ImGui glyph ranges, so the atlas bakes a few dozen
+// icons instead of IconsFontAwesome6.h's ~1,400.
+//
+// Fails (and so fails the build) if a source uses an icon the header
+// doesn't define or the icon font has no glyph for, since that icon
+// would draw as '?'.
+//
+// Usage: IconRangeScanner <output.inc> <IconsFontAwesome6.h> <icon-font.ttf> <source.cpp|.h>...
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char ICON_PREFIX[] = "ICON_FA_";
+constexpr size_t ICON_PREFIX_LENGTH = sizeof(ICON_PREFIX) - 1;
+
+struct IconUse {
+    std::string file;
+    int line;
+};
+
+bool ReadFile(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool IsIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// NAME -> codepoint from "#define ICON_FA_NAME "..."	// U+f00d" lines
+std::map<std::string, uint32_t> ParseIconHeader(const std::string& header) {
+    const std::string define = std::string("#define ") + ICON_PREFIX;
+    std::map<std::string, uint32_t> icons;
+    size_t pos = 0;
+    while ((pos = header.find(define, pos)) != std::string::npos) {
+        size_t nameStart = pos + define.size();
+        size_t nameEnd = nameStart;
+        while (nameEnd < header.size() && IsIdentifierChar(header[nameEnd])) {
+            ++nameEnd;
+        }
+        size_t lineEnd = header.find('\n', nameEnd);
+        std::string line = header.substr(nameEnd, lineEnd - nameEnd);
+        size_t codepoint = line.find("U+");
+        if (codepoint != std::string::npos) {
+            icons[header.substr(nameStart, nameEnd - nameStart)] =
+                static_cast<uint32_t>(std::strtoul(line.c_str() + codepoint + 2, nullptr, 16));
+        }
+        pos = nameEnd;
+    }
+    return icons;
+}
+
+// Every ICON_FA_* identifier outside comments and string literals
+void ScanSource(const std::string& path, const std::string& source, std::map<std::string, IconUse>& out) {
+    int line = 1;
+    size_t i = 0;
+    while (i < source.size()) {
+        char c = source[i];
+        if (c == '\n') {
+            ++line;
+            ++i;
+        } else if (c == '/' && i + 1 < source.size() && source[i + 1] == '/') {
+            i = source.find('\n', i);
+            if (i == std::string::npos) {
+                break;
+            }
+        } else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*') {
+            size_t end = source.find("*/", i + 2);
+            if (end == std::string::npos) {
+                break;
+            }
+            for (; i < end; ++i) {
+                line += source[i] == '\n';
+            }
+            i = end + 2;
+        } else if (c == '"' || c == '\'') {
+            for (++i; i < source.size() && source[i] != c && source[i] != '\n'; ++i) {
+                if (source[i] == '\\') {
+                    ++i;
+                }
+            }
+            ++i;
+        } else if (IsIdentifierChar(c)) {
+            size_t start = i;
+            while (i < source.size() && IsIdentifierChar(source[i])) {
+                ++i;
+            }
+            if (i - start > ICON_PREFIX_LENGTH && source.compare(start, ICON_PREFIX_LENGTH, ICON_PREFIX) == 0) {
+                std::string name = source.substr(start + ICON_PREFIX_LENGTH, i - start - ICON_PREFIX_LENGTH);
+                out.emplace(name, IconUse{path, line});
+            }
+        } else {
+            ++i;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        std::fprintf(stderr, "Usage: %s <output.inc> <IconsFontAwesome6.h> <icon-font.ttf> <source.cpp|.h>...\n", argv[0]);
+        return 1;
+    }
+
+    std::string header;
+    std::string fontData;
+    if (!ReadFile(argv[2], header) || !ReadFile(argv[3], fontData)) {
+        return 1;
+    }
+    std::map<std::string, uint32_t> defined = ParseIconHeader(header);
+
+    stbtt_fontinfo font;
+    const unsigned char* fontBytes = reinterpret_cast<const unsigned char*>(fontData.data());
+    int fontOffset = stbtt_GetFontOffsetForIndex(fontBytes, 0);
+    if (fontOffset < 0 || !stbtt_InitFont(&font, fontBytes, fontOffset)) {
+        std::fprintf(stderr, "%s: not a TrueType/OpenType font\n", argv[3]);
+        return 1;
+    }
+
+    std::map<std::string, IconUse> used;
+    for (int arg = 4; arg < argc; ++arg) {
+        std::string source;
+        if (!ReadFile(argv[arg], source)) {
+            return 1;
+        }
+        ScanSource(argv[arg], source, used);
+    }
+
+    // Every problem is reported before failing
+    std::set<uint32_t> codepoints;
+    int errors = 0;
+    for (const auto& [name, use] : used) {
+        auto it = defined.find(name);
+        if (it == defined.end()) {
+            std::fprintf(stderr, "%s:%d: error: %s%s is not defined in %s\n",
+                         use.file.c_str(), use.line, ICON_PREFIX, name.c_str(), argv[2]);
+            ++errors;
+        } else if (!stbtt_FindGlyphIndex(&font, static_cast<int>(it->second))) {
+            std::fprintf(stderr, "%s:%d: error: %s has no glyph for %s%s (U+%04X)\n",
+                         use.file.c_str(), use.line, argv[3], ICON_PREFIX, name.c_str(), it->second);
+            ++errors;
+        } else {
+            codepoints.insert(it->second);
+        }
+    }
+    if (errors > 0) {
+        return 1;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (uint32_t c : codepoints) {
+        if (!ranges.empty() && ranges.back().second + 1 == c) {
+            ranges.back().second = c;
+        } else {
+            ranges.emplace_back(c, c);
+        }
+    }
+
+    std::string output = "// Generated by IconRangeScanner; do not edit\n";
+    char line[64];
+    std::snprintf(line, sizeof(line), "// %zu icons in %zu ranges\n", codepoints.size(), ranges.size());
+    output += line;
+    for (const auto& [first, last] : ranges) {
+        std::snprintf(line, sizeof(line), "0x%04X, 0x%04X,\n", first, last);
+        output += line;
+    }
+
+    std::ofstream out(argv[1], std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !out.write(output.data(), output.size())) {
+        std::fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return 1;
+    }
+    std::printf("%zu icons in %zu ranges\n", codepoints.size(), ranges.size());
+    return 0;
+}
@@ -0,0 +1,72 @@
+// LangPackCompiler: compiles a language file (assets/lang/<code>.json)
+// into the .lpak pack that Localization memory-maps at runtime. The pack
+// records the JSON's size and hash, so an edited JSON wins over an old pack.
+//
+// Usage: LangPackCompiler <input.json> <output.lpak>
+
+#include "core/Hash.h"
+#include "i18n/LangPack.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "Usage: %s <input.json> <output.lpak>\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    std::string source((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    lpak::Entries entries;
+    if (!lpak::ParseJson(source, entries)) {
+        std::fprintf(stderr, "%s: invalid JSON\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<lpak::Slot> slots;
+    std::string blob;
+    std::vector<std::pair<std::string, std::string>> collisions;
+    lpak::BuildTable(entries, slots, blob, collisions);
+    if (!collisions.empty()) {
+        // Lookups go by hash alone, so this has to be fixed in the JSON
+        for (const auto& [kept, dropped] : collisions) {
+            std::fprintf(stderr, "%s: keys '%s' and '%s' have the same hash\n",
+                         argv[1], kept.c_str(), dropped.c_str());
+        }
+        return 1;
+    }
+
+    lpak::Header header = {};
+    std::memcpy(header.magic, lpak::MAGIC, sizeof(header.magic));
+    header.version = lpak::VERSION;
+    header.sourceSize = source.size();
+    header.sourceHash = HashBytes(source.data(), source.size());
+    header.slotCount = static_cast<uint32_t>(slots.size());
+    header.blobSize = static_cast<uint32_t>(blob.size());
+    for (const lpak::Slot& slot : slots) {
+        header.entryCount += (slot.offset != lpak::EMPTY);
+    }
+
+    std::ofstream output(argv[2], std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        std::fprintf(stderr, "Cannot write %s\n", argv[2]);
+        return 1;
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(lpak::Slot));
+    output.write(blob.data(), blob.size());
+    if (!output) {
+        std::fprintf(stderr, "Failed writing %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,209 @@
+// LogDecoder: renders a binary .blog file written by Logger
+// (LogFileFormat::Binary) back into "[time] [LEVEL] message" text.
+// Also accepts memory-mapped .lseg segments (text or binary content);
+// only their committed bytes are read.
+//
+// Usage: LogDecoder <input.blog|input.lseg> [output.txt]
+
+#include "core/LogFormat.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct FormatDef {
+    std::string format;
+    std::vector<logfmt::ArgKind> kinds;
+};
+
+class Reader {
+public:
+    Reader(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+
+    bool AtEnd() const { return m_pos >= m_size; }
+    size_t Remaining() const { return m_size - m_pos; }
+    const unsigned char* Current() const { return m_data + m_pos; }
+
+    template <typename T>
+    bool Read(T& value) {
+        if (Remaining() < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, Current(), sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool Skip(size_t size) {
+        if (Remaining() < size) {
+            return false;
+        }
+        m_pos += size;
+        return true;
+    }
+
+    bool PeekMagic() const {
+        return Remaining() >= sizeof(logfmt::BLOG_MAGIC) &&
+               std::memcmp(Current(), logfmt::BLOG_MAGIC, sizeof(logfmt::BLOG_MAGIC)) == 0;
+    }
+
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+void FormatTime(int64_t wallMicros, char* out, size_t size) {
+    time_t t = static_cast<time_t>(wallMicros / 1000000);
+    struct tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &t);
+#else
+    localtime_r(&t, &timeinfo);
+#endif
+    strftime(out, size, "%Y-%m-%d %H:%M:%S", &timeinfo);
+}
+
+bool DecodeBlog(const unsigned char* data, size_t size, std::ostream& output) {
+    Reader reader(data, size);
+    logfmt::SessionHeader session = {};
+    bool haveSession = false;
+    std::vector<FormatDef> formats;
+    std::string line;
+    size_t records = 0;
+
+    while (!reader.AtEnd()) {
+        // A new session starts whenever the logger reopened the file
+        if (reader.PeekMagic()) {
+            if (!reader.Read(session) || session.version != logfmt::BLOG_VERSION) {
+                std::fprintf(stderr, "Unsupported .blog session header\n");
+                return false;
+            }
+            haveSession = true;
+            formats.clear();
+            continue;
+        }
+        if (!haveSession) {
+            std::fprintf(stderr, "Not a .blog file\n");
+            return false;
+        }
+
+        uint8_t tag = 0;
+        reader.Read(tag);
+
+        if (tag == logfmt::TAG_FORMAT) {
+            uint16_t id = 0;
+            uint8_t argCount = 0;
+            uint32_t length = 0;
+            FormatDef def;
+            if (!reader.Read(id) || !reader.Read(argCount) || reader.Remaining() < argCount) {
+                break;
+            }
+            def.kinds.assign(reinterpret_cast<const logfmt::ArgKind*>(reader.Current()),
+                             reinterpret_cast<const logfmt::ArgKind*>(reader.Current()) + argCount);
+            reader.Skip(argCount);
+            if (!reader.Read(length) || reader.Remaining() < length) {
+                break;
+            }
+            def.format.assign(reinterpret_cast<const char*>(reader.Current()), length);
+            reader.Skip(length);
+
+            if (formats.size() <= id) {
+                formats.resize(id + 1);
+            }
+            formats[id] = std::move(def);
+        } else if (tag == logfmt::TAG_RECORD) {
+            uint8_t level = 0;
+            uint16_t formatId = 0;
+            int64_t timestamp = 0;
+            uint32_t argBytes = 0;
+            if (!reader.Read(level) || !reader.Read(formatId) || !reader.Read(timestamp) ||
+                !reader.Read(argBytes) || reader.Remaining() < argBytes) {
+                break;
+            }
+            const unsigned char* args = reader.Current();
+            reader.Skip(argBytes);
+
+            char timeStr[32];
+            FormatTime(session.wallBaseMicros + (timestamp - session.monoBaseNanos) / 1000, timeStr, sizeof(timeStr));
+
+            line.clear();
+            line += '[';
+            line += timeStr;
+            line += "] [";
+            line += logfmt::LevelName(level);
+            line += "] ";
+
+            size_t start = line.size();
+            const FormatDef* def = formatId < formats.size() ? &formats[formatId] : nullptr;
+            if (!def || !logfmt::RenderFormat(def->format.data(), def->format.size(),
+                                              def->kinds.data(), def->kinds.size(),
+                                              args, argBytes, line)) {
+                line.resize(start);
+                line += "<malformed log record>";
+            }
+            line += '\n';
+            output.write(line.data(), static_cast<std::streamsize>(line.size()));
+            ++records;
+        } else {
+            std::fprintf(stderr, "Corrupt entry after %zu records\n", records);
+            return false;
+        }
+    }
+
+    // A crash can leave a partially written last entry; ignore it
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <input.blog|input.lseg> [output.txt]\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input.is_open()) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    std::ofstream outputFile;
+    if (argc >= 3) {
+        outputFile.open(argv[2], std::ios::out | std::ios::binary);
+        if (!outputFile.is_open()) {
+            std::fprintf(stderr, "Cannot open %s\n", argv[2]);
+            return 1;
+        }
+    }
+    std::ostream& output = outputFile.is_open() ? outputFile : std::cout;
+
+    const unsigned char* content = data.data();
+    size_t contentSize = data.size();
+    bool binary = true;
+
+    // Segment file: skip the header and stop at the commit offset
+    if (data.size() >= sizeof(logfmt::SegmentHeader) &&
+        std::memcmp(data.data(), logfmt::SEGMENT_MAGIC, sizeof(logfmt::SEGMENT_MAGIC)) == 0) {
+        logfmt::SegmentHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        uint64_t available = data.size() - logfmt::SEGMENT_HEADER_SIZE;
+        content = data.data() + logfmt::SEGMENT_HEADER_SIZE;
+        contentSize = static_cast<size_t>(header.commitOffset < available ? header.commitOffset : available);
+        binary = header.contentFormat == logfmt::SEGMENT_CONTENT_BINARY;
+    }
+
+    if (!binary) {
+        output.write(reinterpret_cast<const char*>(content), static_cast<std::streamsize>(contentSize));
+        return 0;
+    }
+    return DecodeBlog(content, contentSize, output) ? 0 : 1;
+}